@@ -0,0 +1,110 @@
+/* Weight aggregates over one key.
+*  "kernel" runs the raw weight kernels of WeightAggregates over a column, the scalar version against the one
+*  this build selected (build with -DAMAZOOM_AVX2=ON, or add -msse4.1, to get a vector one).
+*  "container" runs totalWeight, countWhere and weightHistogram through each container bridge: the columnar
+*  map feeds its weight column to the kernels, the others visit their items one by one.
+*  Usage: aggregate_benchmark [units] [rounds]   (defaults 100000, 200)
+*/
+#include "containers/columnar_multi_hashmap_impl.h"
+#include "containers/flat_multi_hashmap_impl.h"
+#include "containers/multi_hashmap_impl.h"
+#include "containers/sharded_multi_hashmap_impl.h"
+#include "containers/weight_aggregates.h"
+#include "warehouse_etc/item_definition.h"
+#include "warehouse_etc/packed_item.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int KEY = 0;
+const float BIN_WIDTH = 2.5f;
+const int NUM_BINS = 16;
+
+//keeps the compiler from dropping a result nobody reads
+volatile std::uint64_t sink = 0;
+
+template <class T_RUN>
+void time(const char* kind, const char* name, int units, int rounds, const T_RUN& run) {
+	const Clock::time_point start = Clock::now();
+	for (int round = 0; round < rounds; round++) {
+		run();
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::printf("%-10s %-34s %8.1f M weights/s\n", kind, name, static_cast<double>(units) * rounds / seconds / 1e6);
+}
+
+void kernels(const std::vector<std::uint32_t>& weights, int rounds) {
+	const std::uint32_t* data = weights.data();
+	const std::size_t count = weights.size();
+	const int units = static_cast<int>(count);
+	const std::uint32_t minRaw = amazoom::PackedItem::toRawWeight(10.0f);
+	const std::uint32_t maxRaw = amazoom::PackedItem::toRawWeight(30.0f);
+	const double rawBinWidth = static_cast<double>(BIN_WIDTH) * amazoom::PackedItem::WEIGHT_SCALE;
+	std::vector<int> bins(NUM_BINS, 0);
+
+	time("kernel", "sum, scalar", units, rounds, [&]() { sink += amazoom::WeightAggregates::sumRawScalar(data, count); });
+	time("kernel", "sum", units, rounds, [&]() { sink += amazoom::WeightAggregates::sumRaw(data, count); });
+	time("kernel", "count between, scalar", units, rounds, [&]() {
+		sink += amazoom::WeightAggregates::countRawBetweenScalar(data, count, minRaw, maxRaw);
+	});
+	time("kernel", "count between", units, rounds, [&]() {
+		sink += amazoom::WeightAggregates::countRawBetween(data, count, minRaw, maxRaw);
+	});
+	time("kernel", "histogram, scalar", units, rounds, [&]() { amazoom::WeightAggregates::histogramRawScalar(data, count, rawBinWidth, bins); });
+	time("kernel", "histogram", units, rounds, [&]() { amazoom::WeightAggregates::histogramRaw(data, count, rawBinWidth, bins); });
+}
+
+void containers(const char* name, amazoom::WorkerAccessibleContainer& container, const std::vector<float>& weights, int rounds) {
+	std::vector<std::pair<int, amazoom::Item>> pallet;
+	for (float weight : weights) {
+		pallet.emplace_back(KEY, amazoom::Item(KEY, weight));
+	}
+	container.insertItems(pallet);
+
+	const int units = static_cast<int>(weights.size());
+	char label[64];
+	std::snprintf(label, sizeof(label), "%s, total", name);
+	time("container", label, units, rounds, [&]() { sink += static_cast<std::uint64_t>(container.totalWeight(KEY)); });
+	std::snprintf(label, sizeof(label), "%s, count", name);
+	time("container", label, units, rounds, [&]() { sink += container.countWhere(KEY, 10.0f, 30.0f); });
+	std::snprintf(label, sizeof(label), "%s, histogram", name);
+	time("container", label, units, rounds, [&]() { sink += container.weightHistogram(KEY, BIN_WIDTH, NUM_BINS).back(); });
+}
+}
+
+int main(int argc, char** argv) {
+	const int units = argc > 1 ? std::atoi(argv[1]) : 100000;
+	const int rounds = argc > 2 ? std::atoi(argv[2]) : 200;
+
+	std::mt19937 gen(42);
+	std::uniform_real_distribution<float> weight(0.0f, 40.0f);
+	std::vector<float> weights;
+	std::vector<std::uint32_t> rawWeights;
+	for (int i = 0; i < units; i++) {
+		const amazoom::PackedItem packed(i, weight(gen), false);
+		weights.push_back(packed.getWeight());
+		rawWeights.push_back(packed.getRawWeight());
+	}
+
+	std::printf("kernels built for %s\n", amazoom::WeightAggregates::getIsaName());
+	kernels(rawWeights, rounds);
+
+	amazoom::MultiHashmapImpl linked;
+	amazoom::ShardedMultiHashmapImpl sharded(16);
+	amazoom::FlatMultiHashmapImpl flat;
+	amazoom::ColumnarMultiHashmapImpl columnar;
+	containers("multi_hashmap", linked, weights, rounds);
+	containers("sharded_multi_hashmap", sharded, weights, rounds);
+	containers("flat_multi_hashmap", flat, weights, rounds);
+	containers("columnar_multi_hashmap", columnar, weights, rounds);
+	return 0;
+}
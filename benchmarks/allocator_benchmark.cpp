@@ -0,0 +1,106 @@
+/* Compares node allocators for MultiHashmap: std::allocator, NodePoolAllocator and ArenaAllocator.
+*  "churn" keeps a steady population and repeatedly inserts and extracts, "bulk load" fills an empty map.
+*  Usage: allocator_benchmark [operations] [threads]   (defaults 2000000, 4)
+*/
+#include "containers/monotonic_arena.h"
+#include "containers/multi_hashmap.h"
+#include "containers/node_pool_allocator.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int NUM_KEYS = 1000;
+const int POPULATION_PER_KEY = 10;
+
+template <class T_MAP>
+void fill(T_MAP& hashmap, int itemsPerKey) {
+	for (int i = 0; i < itemsPerKey; i++) {
+		for (int key = 0; key < NUM_KEYS; key++) {
+			amazoom::Item item(key, 1.0f);
+			hashmap.insertItem(key, item);
+		}
+	}
+}
+
+//each thread extracts and re-inserts items of its own keys, ops times in total
+template <class T_MAP>
+double churnNsPerOp(T_MAP& hashmap, int ops, int threads) {
+	auto worker = [&hashmap, ops, threads](int thread) {
+		for (int i = 0; i < ops / threads; i++) {
+			const int key = (thread + i * threads) % NUM_KEYS;
+			amazoom::Item item(hashmap.extractItem(key));
+			hashmap.insertItem(key, item);
+		}
+	};
+
+	Clock::time_point start = Clock::now();
+	std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+	for (int i = 0; i < threads; i++) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread(worker, i)));
+	}
+	for (auto& thread : threadPtrs) {
+		thread->join();
+	}
+	return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops;
+}
+
+template <class T_MAP>
+void benchChurn(const char* name, T_MAP& hashmap, int ops, int threads) {
+	fill(hashmap, POPULATION_PER_KEY);
+	std::printf("churn      %-20s %d threads  %7.1f ns/op\n", name, threads, churnNsPerOp(hashmap, ops, threads));
+}
+
+template <class T_MAP>
+void benchBulkLoad(const char* name, T_MAP& hashmap, int ops) {
+	Clock::time_point start = Clock::now();
+	fill(hashmap, ops / NUM_KEYS);
+	std::printf("bulk load  %-20s           %7.1f ns/item\n", name,
+		std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ops);
+}
+}
+
+int main(int argc, char** argv) {
+	const int ops = argc > 1 ? std::atoi(argv[1]) : 2000000;
+	const int threads = argc > 2 ? std::atoi(argv[2]) : 4;
+
+	typedef amazoom::MultiHashmap<int, amazoom::Item> StdHashmap;
+	typedef amazoom::MultiHashmap<int, amazoom::Item, std::unordered_map, amazoom::NodePoolAllocator<amazoom::Item>> PoolHashmap;
+	typedef amazoom::MultiHashmap<int, amazoom::Item, std::unordered_map, amazoom::ArenaAllocator<amazoom::Item>> ArenaHashmap;
+
+	for (int t : { 1, threads }) {
+		{
+			StdHashmap hashmap;
+			benchChurn("std::allocator", hashmap, ops, t);
+		}
+		{
+			PoolHashmap hashmap;
+			benchChurn("NodePoolAllocator", hashmap, ops, t);
+		}
+	}
+
+	{
+		StdHashmap hashmap;
+		benchBulkLoad("std::allocator", hashmap, ops);
+	}
+	{
+		PoolHashmap hashmap;
+		benchBulkLoad("NodePoolAllocator", hashmap, ops);
+	}
+	{
+		amazoom::MonotonicArena arena;
+		ArenaHashmap hashmap{ amazoom::ArenaAllocator<amazoom::Item>(arena) };
+		benchBulkLoad("ArenaAllocator", hashmap, ops);
+	}
+	return 0;
+}
@@ -0,0 +1,102 @@
+/* Memory and bulk moves of MultiHashmap, FlatMultiHashmap and ColumnarMultiHashmap.
+*  "memory" fills each container with units spread over keys and reports heap bytes per unit, counted by
+*  heap_counter. "bulk move" moves every unit of one key to a second container and back, as Items through
+*  extractItems/insertItems, or for the columnar map also as PackedItems.
+*  Usage: columnar_benchmark [units] [keys]   (defaults 10000000, 1000)
+*/
+#include "containers/columnar_multi_hashmap.h"
+#include "containers/flat_multi_hashmap.h"
+#include "containers/multi_hashmap.h"
+#include "warehouse_etc/item_definition.h"
+#include "warehouse_etc/packed_item.h"
+#include "heap_counter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int BULK_KEY = 0;
+const int BULK_ROUNDS = 10;
+
+template <class T_MAP>
+void fill(T_MAP& hashmap, int units, int numKeys) {
+	std::vector<std::pair<int, amazoom::Item>> pallet;
+	for (int i = 0; i < units; i++) {
+		pallet.emplace_back(i % numKeys, amazoom::Item(i % numKeys, 1.0f + (i % 100) * 0.25f));
+		if (pallet.size() == 4096) {
+			hashmap.insertItems(pallet);
+			pallet.clear();
+		}
+	}
+	hashmap.insertItems(pallet);
+}
+
+template <class T_MAP>
+void memory(const char* name, int units, int numKeys) {
+	const long long before = amazoom::heapBytesInUse();
+	std::unique_ptr<T_MAP> hashmap(new T_MAP());
+	fill(*hashmap, units, numKeys);
+	std::printf("memory     %-24s %6.1f bytes/unit\n", name, static_cast<double>(amazoom::heapBytesInUse() - before) / units);
+}
+
+//moves all of BULK_KEY's units from one map to the other and back, BULK_ROUNDS times
+template <class T_MAP, class T_MOVE>
+void bulk(const char* name, int units, const T_MOVE& move) {
+	std::unique_ptr<T_MAP> from(new T_MAP());
+	std::unique_ptr<T_MAP> to(new T_MAP());
+	fill(*from, units, 1);
+
+	const Clock::time_point start = Clock::now();
+	for (int round = 0; round < BULK_ROUNDS; round++) {
+		move(*from, *to, units);
+		move(*to, *from, units);
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::printf("bulk move  %-24s %6.1f M units/s\n", name, 2.0 * BULK_ROUNDS * units / seconds / 1e6);
+}
+
+template <class T_MAP>
+void moveItems(T_MAP& from, T_MAP& to, int units) {
+	std::vector<amazoom::Item> items(from.extractItems(BULK_KEY, units));
+	std::vector<std::pair<int, amazoom::Item>> pallet;
+	pallet.reserve(items.size());
+	for (amazoom::Item& item : items) {
+		pallet.emplace_back(BULK_KEY, std::move(item));
+	}
+	to.insertItems(pallet);
+}
+
+void movePacked(amazoom::ColumnarMultiHashmap<int>& from, amazoom::ColumnarMultiHashmap<int>& to, int units) {
+	to.insertPacked(BULK_KEY, from.extractPacked(BULK_KEY, units));
+}
+}
+
+int main(int argc, char** argv) {
+	const int units = argc > 1 ? std::atoi(argv[1]) : 10000000;
+	const int numKeys = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+	typedef amazoom::MultiHashmap<int, amazoom::Item> Linked;
+	typedef amazoom::FlatMultiHashmap<int, amazoom::Item> Flat;
+	typedef amazoom::ColumnarMultiHashmap<int> Columnar;
+
+	std::printf("sizeof(Item) %zu, sizeof(PackedItem) %zu\n", sizeof(amazoom::Item), sizeof(amazoom::PackedItem));
+	memory<Linked>("multi_hashmap", units, numKeys);
+	memory<Flat>("flat_multi_hashmap", units, numKeys);
+	memory<Columnar>("columnar_multi_hashmap", units, numKeys);
+
+	//MultiHashmap releases a key's nodes recursively, which a million of them would overflow the stack with
+	const int bulkUnits = std::min(units, 100000);
+	bulk<Linked>("multi_hashmap", bulkUnits, moveItems<Linked>);
+	bulk<Flat>("flat_multi_hashmap", bulkUnits, moveItems<Flat>);
+	bulk<Columnar>("columnar, items", bulkUnits, moveItems<Columnar>);
+	bulk<Columnar>("columnar, packed", bulkUnits, movePacked);
+	return 0;
+}
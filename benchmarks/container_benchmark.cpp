@@ -0,0 +1,272 @@
+/* Microbenchmarks for the storage layers: MultiHashmap, MultiHashmapImpl, an ItemContainer and Box.
+*  Every op is timed on its own, so each line reports throughput and p50/p99/p999 latency.
+*  "insert", "contains" and "extract" run single threaded over NUM_KEYS keys.
+*  "mixed" keeps a steady population and has every thread insert, look up and extract at random,
+*  with keys drawn uniformly or from a Zipf distribution (a few hot products), for 1 to maxThreads threads.
+*  "chain" does the same on a single key that already holds CHAIN_LENGTH items.
+*  Usage: container_benchmark [opsPerThread] [maxThreads] [backend]   (defaults 200000, 64, all)
+*         backend is one of multihashmap, impl, container, box
+*/
+#include "containers/box.h"
+#include "containers/item_container.h"
+#include "containers/multi_hashmap.h"
+#include "containers/multi_hashmap_impl.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int NUM_KEYS = 10000;
+const int ITEMS_PER_KEY = 4; //population each mixed run starts from
+const int CHAIN_LENGTH = 10000;
+const double ZIPF_EXPONENT = 0.99;
+
+//Minimal concrete ItemContainer, so the base class is measured without Box's weight accounting
+class Shelf : public amazoom::ItemContainer {
+public:
+	virtual amazoom::Item extractItem(int key) override {
+		return storage_->extractItem(key);
+	}
+
+	virtual void insertItem(amazoom::Item& item) override {
+		storage_->insertItem(item.getID(), item);
+	}
+};
+
+//Uniform adapters over the four layers
+struct HashmapTarget {
+	amazoom::MultiHashmap<int, amazoom::Item> map;
+
+	void insert(int key) {
+		amazoom::Item item(key, 1.0f);
+		map.insertItem(key, item);
+	}
+	bool extract(int key) { return map.tryExtractItem(key).has_value(); }
+	bool contains(int key) { return map.doesContainObj(key); }
+};
+
+struct ImplTarget {
+	amazoom::MultiHashmapImpl impl;
+
+	void insert(int key) {
+		amazoom::Item item(key, 1.0f);
+		impl.insertItem(key, item);
+	}
+	bool extract(int key) { return impl.tryExtractItem(key).has_value(); }
+	bool contains(int key) { return impl.doesContainObj(key); }
+};
+
+template <class T_CONTAINER>
+struct ContainerTarget {
+	T_CONTAINER container;
+
+	template <class... T_ARGS>
+	ContainerTarget(T_ARGS... args) : container(args...) {}
+
+	void insert(int key) {
+		amazoom::Item item(key, 1.0f);
+		container.insertItem(item);
+	}
+	bool extract(int key) { return container.tryExtractItem(key).has_value(); }
+	bool contains(int key) { return container.doesContainItem(key); }
+};
+
+//Box has to be big enough to never refuse an insertion
+struct BoxTarget : ContainerTarget<amazoom::Box> {
+	BoxTarget() : ContainerTarget<amazoom::Box>(1.0e9f) {}
+};
+
+//Draws keys in [0, numKeys) with P(k) proportional to 1 / (k + 1)^exponent, via the inverse of the CDF
+class ZipfKeys {
+public:
+	ZipfKeys(int numKeys, double exponent) : cdf_(numKeys) {
+		double sum = 0;
+		for (int k = 0; k < numKeys; k++) {
+			sum += 1.0 / std::pow(k + 1, exponent);
+			cdf_[k] = sum;
+		}
+		for (double& p : cdf_) {
+			p /= sum;
+		}
+	}
+
+	int operator()(std::mt19937& eng) const {
+		double u = std::uniform_real_distribution<double>(0.0, 1.0)(eng);
+		int key = static_cast<int>(std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin());
+		return std::min(key, static_cast<int>(cdf_.size()) - 1);
+	}
+
+private:
+	std::vector<double> cdf_;
+};
+
+enum class Keys { UNIFORM, ZIPF, SINGLE };
+
+const char* keysName(Keys keys) {
+	switch (keys) {
+	case Keys::UNIFORM: return "uniform";
+	case Keys::ZIPF: return "zipf";
+	default: return "chain";
+	}
+}
+
+struct Latencies {
+	std::vector<std::int64_t> ns;
+
+	template <class T_OP>
+	void time(T_OP op) {
+		Clock::time_point start = Clock::now();
+		op();
+		ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+	}
+};
+
+std::int64_t percentile(std::vector<std::int64_t>& ns, double p) {
+	std::size_t rank = std::min(ns.size() - 1, static_cast<std::size_t>(p * ns.size()));
+	std::nth_element(ns.begin(), ns.begin() + rank, ns.end());
+	return ns[rank];
+}
+
+void report(const char* backend, const char* workload, int numThreads, double seconds, std::vector<std::int64_t>& ns) {
+	std::printf("%-13s %-16s %2d threads  %11.0f ops/s  p50 %7lld ns  p99 %8lld ns  p999 %9lld ns\n",
+		backend, workload, numThreads, ns.size() / seconds,
+		static_cast<long long>(percentile(ns, 0.50)), static_cast<long long>(percentile(ns, 0.99)),
+		static_cast<long long>(percentile(ns, 0.999)));
+}
+
+//Single threaded insert, then lookups, then extraction of every item, each on keys drawn uniformly
+template <class T_TARGET>
+void benchSingleThread(const char* backend, int numOps) {
+	std::unique_ptr<T_TARGET> target(new T_TARGET());
+	std::mt19937 eng(42);
+	std::uniform_int_distribution<int> keyDist(0, NUM_KEYS - 1);
+	std::vector<int> keys(numOps);
+	for (int& key : keys) {
+		key = keyDist(eng);
+	}
+
+	const char* phases[] = { "insert", "contains", "extract" };
+	for (int phase = 0; phase < 3; phase++) {
+		Latencies latencies;
+		latencies.ns.reserve(numOps);
+
+		Clock::time_point start = Clock::now();
+		for (int key : keys) {
+			switch (phase) {
+			case 0: latencies.time([&]() { target->insert(key); }); break;
+			case 1: latencies.time([&]() { target->contains(key); }); break;
+			default: latencies.time([&]() { target->extract(key); }); break;
+			}
+		}
+		const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+		report(backend, phases[phase], 1, seconds, latencies.ns);
+	}
+}
+
+//Each thread runs a 25% insert / 25% extract / 50% contains mix, so the population stays roughly level
+template <class T_TARGET>
+void benchMixed(const char* backend, Keys keys, int numThreads, int opsPerThread) {
+	std::unique_ptr<T_TARGET> target(new T_TARGET());
+	ZipfKeys zipf(NUM_KEYS, ZIPF_EXPONENT);
+
+	if (keys == Keys::SINGLE) {
+		for (int i = 0; i < CHAIN_LENGTH; i++) {
+			target->insert(0);
+		}
+	}
+	else {
+		for (int key = 0; key < NUM_KEYS; key++) {
+			for (int i = 0; i < ITEMS_PER_KEY; i++) {
+				target->insert(key);
+			}
+		}
+	}
+
+	std::vector<Latencies> latencies(numThreads);
+	boost::barrier ready(numThreads + 1);
+
+	std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+	for (int t = 0; t < numThreads; t++) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&, t]() {
+			std::mt19937 eng(1000u + t);
+			std::uniform_int_distribution<int> keyDist(0, NUM_KEYS - 1);
+			std::uniform_int_distribution<int> opDist(0, 3);
+			Latencies& mine = latencies[t];
+			mine.ns.reserve(opsPerThread);
+
+			ready.wait();
+			for (int i = 0; i < opsPerThread; i++) {
+				int key = keys == Keys::SINGLE ? 0 : keys == Keys::ZIPF ? zipf(eng) : keyDist(eng);
+				switch (opDist(eng)) {
+				case 0: mine.time([&]() { target->insert(key); }); break;
+				case 1: mine.time([&]() { target->extract(key); }); break;
+				default: mine.time([&]() { target->contains(key); }); break;
+				}
+			}
+		})));
+	}
+
+	ready.wait();
+	Clock::time_point start = Clock::now();
+	for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+		threadPtr->join();
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::vector<std::int64_t> all;
+	all.reserve(static_cast<std::size_t>(numThreads) * opsPerThread);
+	for (Latencies& l : latencies) {
+		all.insert(all.end(), l.ns.begin(), l.ns.end());
+	}
+
+	char workload[32];
+	std::snprintf(workload, sizeof(workload), "mixed %s", keysName(keys));
+	report(backend, workload, numThreads, seconds, all);
+}
+
+template <class T_TARGET>
+void benchBackend(const char* backend, int opsPerThread, int maxThreads) {
+	benchSingleThread<T_TARGET>(backend, opsPerThread);
+	for (Keys keys : { Keys::UNIFORM, Keys::ZIPF, Keys::SINGLE }) {
+		for (int threads = 1; threads <= maxThreads; threads *= 2) {
+			benchMixed<T_TARGET>(backend, keys, threads, opsPerThread);
+		}
+	}
+	std::printf("\n");
+}
+}
+
+int main(int argc, char** argv) {
+	const int opsPerThread = argc > 1 ? std::atoi(argv[1]) : 200000;
+	const int maxThreads = argc > 2 ? std::atoi(argv[2]) : 64;
+	const char* only = argc > 3 ? argv[3] : nullptr;
+
+	auto selected = [only](const char* backend) { return only == nullptr || std::strcmp(only, backend) == 0; };
+
+	if (selected("multihashmap")) {
+		benchBackend<HashmapTarget>("MultiHashmap", opsPerThread, maxThreads);
+	}
+	if (selected("impl")) {
+		benchBackend<ImplTarget>("Impl", opsPerThread, maxThreads);
+	}
+	if (selected("container")) {
+		benchBackend<ContainerTarget<Shelf>>("ItemContainer", opsPerThread, maxThreads);
+	}
+	if (selected("box")) {
+		benchBackend<BoxTarget>("Box", opsPerThread, maxThreads);
+	}
+	return 0;
+}
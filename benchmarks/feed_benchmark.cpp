@@ -0,0 +1,99 @@
+/* Nightly feed ingestion: reading a CSV feed line by line into one storage with insertItem, against
+*  InventoryFeedLoader on CSV and binary feeds, for 1 to maxThreads threads and as many partitions.
+*  "peak" is InventoryFeedLoader::Stats::peakBufferedBytes, the most the loader held at once.
+*  Usage: feed_benchmark [rows] [maxThreads] [directory]   (defaults 5000000, 8, current directory)
+*/
+#include "containers/multi_hashmap_impl.h"
+#include "warehouse_etc/inventory_feed_loader.h"
+#include "warehouse_etc/item_definition.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int NUM_KEYS = 100000;
+
+void report(const char* name, int threads, std::uint64_t rows, double seconds, std::size_t peakBytes) {
+	std::printf("%-16s %2d threads  %11.0f rows/s  %8.1f ms  peak %8.1f MiB\n",
+		name, threads, rows / seconds, seconds * 1000.0, peakBytes / (1024.0 * 1024.0));
+}
+
+//the baseline: one thread, one getline and one insertItem per row
+void benchPerRow(const std::string& csvPath) {
+	amazoom::MultiHashmapImpl storage;
+	Clock::time_point start = Clock::now();
+
+	std::ifstream in(csvPath);
+	std::string line;
+	std::uint64_t rows = 0;
+	while (std::getline(in, line)) {
+		const std::size_t first = line.find(',');
+		const std::size_t second = line.find(',', first + 1);
+		const int itemID = std::atoi(line.c_str());
+		amazoom::Item item(itemID, std::strtof(line.c_str() + first + 1, nullptr), line[second + 1] == '1');
+		storage.insertItem(itemID, item);
+		rows++;
+	}
+	report("per-row csv", 1, rows, std::chrono::duration<double>(Clock::now() - start).count(), 0);
+}
+
+void benchLoader(const char* name, const std::string& path, amazoom::InventoryFeedLoader::Format format, int threads) {
+	std::vector<std::unique_ptr<amazoom::MultiHashmapImpl>> shelves;
+	std::vector<amazoom::Storable*> partitions;
+	for (int p = 0; p < threads; p++) {
+		shelves.push_back(std::unique_ptr<amazoom::MultiHashmapImpl>(new amazoom::MultiHashmapImpl()));
+		partitions.push_back(shelves.back().get());
+	}
+
+	amazoom::InventoryFeedLoader loader(threads);
+	amazoom::InventoryFeedLoader::Stats stats = loader.load(path, format, partitions);
+	report(name, threads, stats.rows, stats.seconds, stats.peakBufferedBytes);
+}
+}
+
+int main(int argc, char** argv) {
+	const int numRows = argc > 1 ? std::atoi(argv[1]) : 5000000;
+	const int maxThreads = argc > 2 ? std::atoi(argv[2]) : 8;
+	const std::filesystem::path directory(argc > 3 ? argv[3] : ".");
+	const std::string csvPath((directory / "feed_benchmark.csv").string());
+	const std::string binaryPath((directory / "feed_benchmark.bin").string());
+
+	std::mt19937 eng(42);
+	std::uniform_int_distribution<int> keyDist(0, NUM_KEYS - 1);
+	std::vector<amazoom::Item> items;
+	items.reserve(numRows);
+	{
+		std::ofstream out(csvPath, std::ios::binary | std::ios::trunc);
+		for (int i = 0; i < numRows; i++) {
+			const int key = keyDist(eng);
+			const float weight = 0.5f + (i % 200) / 10.0f;
+			out << key << ',' << weight << ',' << (i % 5 == 0 ? 1 : 0) << '\n';
+			items.push_back(amazoom::Item(key, weight, i % 5 == 0));
+		}
+	}
+	amazoom::InventoryFeedLoader::writeBinary(binaryPath, items);
+	items.clear();
+	items.shrink_to_fit();
+
+	benchPerRow(csvPath);
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		benchLoader("loader csv", csvPath, amazoom::InventoryFeedLoader::CSV, threads);
+	}
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		benchLoader("loader binary", binaryPath, amazoom::InventoryFeedLoader::BINARY, threads);
+	}
+
+	std::filesystem::remove(csvPath);
+	std::filesystem::remove(binaryPath);
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include "heap_counter.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<long long> heapBytes{ 0 };
+
+//every allocation carries its size in front of it, so that delete can subtract it
+const std::size_t HEADER = alignof(std::max_align_t);
+}
+
+long long amazoom::heapBytesInUse() {
+	return heapBytes.load();
+}
+
+void* operator new(std::size_t size) {
+	char* block = static_cast<char*>(std::malloc(size + HEADER));
+	if (block == nullptr) {
+		throw std::bad_alloc();
+	}
+	*reinterpret_cast<std::size_t*>(block) = size;
+	heapBytes += static_cast<long long>(size);
+	return block + HEADER;
+}
+
+void* operator new[](std::size_t size) {
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+	if (ptr != nullptr) {
+		char* block = static_cast<char*>(ptr) - HEADER;
+		heapBytes -= static_cast<long long>(*reinterpret_cast<std::size_t*>(block));
+		std::free(block);
+	}
+}
+
+void operator delete[](void* ptr) noexcept {
+	operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+	operator delete(ptr);
+}
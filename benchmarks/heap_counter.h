@@ -0,0 +1,14 @@
+/* Counts the heap bytes in use, by replacing the global operator new and delete.
+*  Link heap_counter.cpp into a benchmark to use it. The replacements live in their own translation unit
+*  so that the compiler cannot inline them into the code being measured and see a block freed from
+*  before the pointer new returned.
+*/
+#ifndef AMAZOOM_BENCHMARKS_HEAP_COUNTER_H_
+#define AMAZOOM_BENCHMARKS_HEAP_COUNTER_H_
+
+namespace amazoom {
+	//bytes handed out by operator new and not yet deleted, not counting the allocator's own overhead
+	long long heapBytesInUse();
+}
+
+#endif
@@ -0,0 +1,105 @@
+/* Pickers on a ShardedMultiHashmap whose keys are picked with Zipf-distributed popularity, so a few
+*  bestsellers take most of the traffic. numThreads threads extract a random key's item and put it back.
+*  Runs with hot-key splitting off, then splitting with round-robin and per-thread sub-list picks.
+*  Reports operations per second and how many keys ended up split.
+*  Usage: hotkey_benchmark [keys] [zipfExponent] [numThreads] [seconds]   (defaults 10000, 1.2, 4, 2)
+*/
+#include "containers/sharded_multi_hashmap.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef amazoom::ShardedMultiHashmap<int, amazoom::Item> Hashmap;
+
+const int NUM_SHARDS = 16;
+const int ITEMS_PER_KEY = 20;
+
+enum Mode { NO_SPLITTING, ROUND_ROBIN, PER_THREAD };
+
+//cumulative popularity of keys 0..numKeys-1, key k weighing 1 / (k + 1)^exponent
+std::vector<double> zipfCdf(int numKeys, double exponent) {
+	std::vector<double> cdf(numKeys);
+	double total = 0.0;
+	for (int k = 0; k < numKeys; k++) {
+		total += 1.0 / std::pow(k + 1.0, exponent);
+		cdf[k] = total;
+	}
+	for (double& bound : cdf) {
+		bound /= total;
+	}
+	return cdf;
+}
+
+void bench(Mode mode, const std::vector<double>& cdf, int numThreads, double seconds) {
+	const int numKeys = static_cast<int>(cdf.size());
+	std::unique_ptr<Hashmap> hashmap(new Hashmap(NUM_SHARDS));
+	if (mode == ROUND_ROBIN) {
+		hashmap->enableHotKeySplitting(Hashmap::DEFAULT_SPLIT_WAYS, Hashmap::ROUND_ROBIN);
+	}
+	else if (mode == PER_THREAD) {
+		hashmap->enableHotKeySplitting(Hashmap::DEFAULT_SPLIT_WAYS, Hashmap::PER_THREAD);
+	}
+	for (int i = 0; i < numKeys * ITEMS_PER_KEY; i++) {
+		amazoom::Item item(i, 1.0f);
+		hashmap->insertItem(i % numKeys, item);
+	}
+
+	std::atomic<bool> stop{ false };
+	std::atomic<long long> ops{ 0 };
+
+	std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+	for (int t = 0; t < numThreads; t++) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&, t]() {
+			std::mt19937 eng(100u + t);
+			std::uniform_real_distribution<double> uniform(0.0, 1.0);
+			long long done = 0;
+			while (!stop) {
+				const int key = std::min(numKeys - 1,
+					static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), uniform(eng)) - cdf.begin()));
+				std::optional<amazoom::Item> item = hashmap->tryExtractItem(key);
+				if (item) {
+					hashmap->insertItem(key, *item);
+				}
+				done++;
+			}
+			ops += done;
+		})));
+	}
+
+	boost::this_thread::sleep_for(boost::chrono::milliseconds(static_cast<int>(seconds * 1000)));
+	stop = true;
+	for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+		threadPtr->join();
+	}
+
+	const char* names[] = { "no splitting", "split, round robin", "split, per thread" };
+	std::printf("%-20s %2d threads  %11.0f ops/s  %2d keys split\n", names[mode], numThreads,
+		ops.load() / seconds, hashmap->getNumSplitKeys());
+}
+}
+
+int main(int argc, char** argv) {
+	const int numKeys = argc > 1 ? std::atoi(argv[1]) : 10000;
+	const double exponent = argc > 2 ? std::atof(argv[2]) : 1.2;
+	const int numThreads = argc > 3 ? std::atoi(argv[3]) : 4;
+	const double seconds = argc > 4 ? std::atof(argv[4]) : 2.0;
+
+	const std::vector<double> cdf(zipfCdf(numKeys, exponent));
+	std::printf("hottest key takes %.1f%% of picks\n", cdf[0] * 100.0);
+
+	bench(NO_SPLITTING, cdf, numThreads, seconds);
+	bench(ROUND_ROBIN, cdf, numThreads, seconds);
+	bench(PER_THREAD, cdf, numThreads, seconds);
+	return 0;
+}
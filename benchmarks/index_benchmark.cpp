@@ -0,0 +1,99 @@
+/* Compares SwissMap against std::unordered_map as the key index, on its own and inside MultiHashmap.
+*  Usage: index_benchmark [maxKeys]   (default 10000000)
+*/
+#include "containers/multi_hashmap.h"
+#include "containers/swiss_map.h"
+#include "warehouse_etc/item_definition.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double nsPerOp(Clock::time_point start, Clock::time_point end, std::size_t ops) {
+	return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+}
+
+//Inserts every key, then looks each one up (hits) and looks up as many absent keys (misses)
+template <class T_MAP>
+void benchIndex(const char* name, const std::vector<int>& keys) {
+	T_MAP map;
+	const std::size_t n = keys.size();
+
+	Clock::time_point start = Clock::now();
+	for (int key : keys) {
+		map.insert(std::make_pair(key, key));
+	}
+	Clock::time_point inserted = Clock::now();
+
+	long long checksum = 0;
+	for (int key : keys) {
+		checksum += map.find(key)->second;
+	}
+	Clock::time_point hits = Clock::now();
+
+	for (int key : keys) {
+		checksum += map.find(-key - 1) == map.end() ? 0 : 1; //all keys are non-negative
+	}
+	Clock::time_point misses = Clock::now();
+
+	std::printf("%-22s %10zu keys  insert %7.1f ns  hit %7.1f ns  miss %7.1f ns  (checksum %lld)\n",
+		name, n, nsPerOp(start, inserted, n), nsPerOp(inserted, hits, n), nsPerOp(hits, misses, n), checksum);
+}
+
+//One item per key inserted then extracted through MultiHashmap, so the index is hit twice per item
+template <template <class...> class T_INDEX>
+void benchMultiHashmap(const char* name, const std::vector<int>& keys) {
+	std::unique_ptr<amazoom::MultiHashmap<int, amazoom::Item, T_INDEX>> hashmap(
+		new amazoom::MultiHashmap<int, amazoom::Item, T_INDEX>());
+	const std::size_t n = keys.size();
+
+	Clock::time_point start = Clock::now();
+	for (int key : keys) {
+		amazoom::Item item(key, 1.0f);
+		hashmap->insertItem(key, item);
+	}
+	Clock::time_point inserted = Clock::now();
+
+	for (int key : keys) {
+		hashmap->extractItem(key);
+	}
+	Clock::time_point extracted = Clock::now();
+
+	std::printf("%-22s %10zu keys  insert %7.1f ns  extract %7.1f ns\n",
+		name, n, nsPerOp(start, inserted, n), nsPerOp(inserted, extracted, n));
+}
+}
+
+int main(int argc, char** argv) {
+	const std::size_t maxKeys = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+	std::mt19937 eng(42);
+
+	for (std::size_t n = 10000; n <= maxKeys; n *= 10) {
+		//distinct item IDs, visited in random order
+		std::vector<int> keys(n);
+		std::iota(keys.begin(), keys.end(), 0);
+		std::shuffle(keys.begin(), keys.end(), eng);
+
+		benchIndex<std::unordered_map<int, int>>("unordered_map", keys);
+		benchIndex<amazoom::SwissMap<int, int>>("SwissMap", keys);
+
+		//the linked list nodes dominate memory; keep the end-to-end runs to 10^6 keys
+		if (n <= 1000000) {
+			benchMultiHashmap<std::unordered_map>("MultiHashmap<unordered>", keys);
+			benchMultiHashmap<amazoom::SwissMap>("MultiHashmap<Swiss>", keys);
+		}
+		std::printf("\n");
+	}
+	return 0;
+}
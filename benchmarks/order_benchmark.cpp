@@ -0,0 +1,149 @@
+/* Order fulfilment under contention: OrderTransaction against extracting line by line and putting
+*  the earlier lines back when a later one is out of stock ("compensating").
+*  Every worker repeatedly fulfils a random order of LINES_PER_ORDER lines spread over a few shelves,
+*  then restocks what it took so stock stays scarce but steady.
+*  Usage: order_benchmark [ordersPerThread] [maxThreads]   (defaults 20000, 8)
+*/
+#include "containers/box.h"
+#include "containers/order_transaction.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int NUM_SHELVES = 8;
+const int NUM_KEYS = 4;
+const int STOCK_PER_KEY = 1; //per shelf; low enough that orders regularly find a line missing
+const int LINES_PER_ORDER = 3;
+
+struct Line {
+	int shelf;
+	int key;
+};
+
+struct Counters {
+	std::atomic<long long> filled{ 0 };
+	std::atomic<long long> rejected{ 0 };
+	std::atomic<long long> putBack{ 0 }; //items re-inserted only to undo a partial order
+};
+
+typedef std::vector<std::unique_ptr<amazoom::Box>> Shelves;
+
+void stock(Shelves& shelves) {
+	for (int shelf = 0; shelf < NUM_SHELVES; shelf++) {
+		shelves.push_back(std::unique_ptr<amazoom::Box>(new amazoom::Box(1.0e6f)));
+		for (int key = 0; key < NUM_KEYS; key++) {
+			for (int i = 0; i < STOCK_PER_KEY; i++) {
+				amazoom::Item item(key, 1.0f);
+				shelves.back()->insertItem(item);
+			}
+		}
+	}
+}
+
+std::vector<Line> randomOrder(std::mt19937& eng) {
+	std::uniform_int_distribution<int> shelfDist(0, NUM_SHELVES - 1);
+	std::uniform_int_distribution<int> keyDist(0, NUM_KEYS - 1);
+	std::vector<Line> lines(LINES_PER_ORDER);
+	for (Line& line : lines) {
+		line = Line{ shelfDist(eng), keyDist(eng) };
+	}
+	return lines;
+}
+
+void restock(Shelves& shelves, const std::vector<Line>& lines, std::vector<amazoom::Item>& items) {
+	for (std::size_t i = 0; i < items.size(); i++) {
+		shelves[lines[i].shelf]->insertItem(items[i]);
+	}
+}
+
+void fulfilTransactional(Shelves& shelves, Counters& counters, int numOrders, unsigned seed) {
+	std::mt19937 eng(seed);
+	for (int i = 0; i < numOrders; i++) {
+		std::vector<Line> lines(randomOrder(eng));
+
+		amazoom::OrderTransaction order;
+		for (const Line& line : lines) {
+			order.addLine(*shelves[line.shelf], line.key);
+		}
+
+		std::optional<std::vector<amazoom::Item>> picked(order.tryExecute());
+		if (picked) {
+			counters.filled++;
+			restock(shelves, lines, *picked);
+		}
+		else {
+			counters.rejected++;
+		}
+	}
+}
+
+void fulfilCompensating(Shelves& shelves, Counters& counters, int numOrders, unsigned seed) {
+	std::mt19937 eng(seed);
+	for (int i = 0; i < numOrders; i++) {
+		std::vector<Line> lines(randomOrder(eng));
+
+		std::vector<amazoom::Item> picked;
+		for (const Line& line : lines) {
+			std::optional<amazoom::Item> item(shelves[line.shelf]->tryExtractItem(line.key));
+			if (!item) {
+				break;
+			}
+			picked.push_back(std::move(*item));
+		}
+
+		if (picked.size() == lines.size()) {
+			counters.filled++;
+		}
+		else {
+			counters.rejected++;
+			counters.putBack += static_cast<long long>(picked.size());
+		}
+		restock(shelves, lines, picked);
+	}
+}
+
+template <class T_FULFIL>
+void bench(const char* name, T_FULFIL fulfil, int numThreads, int ordersPerThread) {
+	Shelves shelves;
+	stock(shelves);
+	Counters counters;
+
+	Clock::time_point start = Clock::now();
+	std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+	for (int i = 0; i < numThreads; i++) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread(
+			[&, i]() { fulfil(shelves, counters, ordersPerThread, 1000u + i); })));
+	}
+	for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+		threadPtr->join();
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	const long long total = counters.filled + counters.rejected;
+	std::printf("%-14s %2d threads  %10.0f orders/s  filled %5.1f%%  put back %lld items\n",
+		name, numThreads, total / seconds, 100.0 * counters.filled / total, counters.putBack.load());
+}
+}
+
+int main(int argc, char** argv) {
+	const int ordersPerThread = argc > 1 ? std::atoi(argv[1]) : 20000;
+	const int maxThreads = argc > 2 ? std::atoi(argv[2]) : 8;
+
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		bench("transactional", fulfilTransactional, threads, ordersPerThread);
+		bench("compensating", fulfilCompensating, threads, ordersPerThread);
+	}
+	return 0;
+}
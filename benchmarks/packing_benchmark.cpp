@@ -0,0 +1,122 @@
+/* Packing throughput and box fill for BoxPacker against filling boxes by hand, one item at a time.
+*  "single order" packs every item as one order, "orders" splits them into orders of ITEMS_PER_ORDER
+*  and packs those in parallel. Fill is the total item weight over the total capacity of the boxes used;
+*  "bound" is the fewest boxes any packing could use.
+*  Usage: packing_benchmark [items] [maxThreads]   (defaults 100000, 8)
+*/
+#include "containers/box.h"
+#include "containers/box_packer.h"
+#include "warehouse_etc/item_definition.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const float BOX_CAPACITY = 100.0f;
+const std::size_t ITEMS_PER_ORDER = 50;
+
+double secondsSince(Clock::time_point start) {
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::vector<amazoom::Item> makeItems(std::size_t n, unsigned seed) {
+	std::mt19937 eng(seed);
+	std::uniform_real_distribution<float> weightDist(0.5f, 45.0f);
+
+	std::vector<amazoom::Item> items;
+	items.reserve(n);
+	for (std::size_t i = 0; i < n; i++) {
+		items.push_back(amazoom::Item(static_cast<int>(i % 1000), weightDist(eng)));
+	}
+	return items;
+}
+
+double totalWeight(const std::vector<amazoom::Item>& items) {
+	double total = 0.0;
+	for (const amazoom::Item& item : items) {
+		total += item.getWeight();
+	}
+	return total;
+}
+
+void report(const char* name, std::size_t n, double seconds, std::size_t numBoxes, double weight) {
+	const std::size_t bound = static_cast<std::size_t>(std::ceil(weight / BOX_CAPACITY));
+	std::printf("%-28s %8zu items  %10.0f items/s  %7zu boxes (bound %7zu)  fill %5.1f%%\n",
+		name, n, n / seconds, numBoxes, bound, 100.0 * weight / (numBoxes * BOX_CAPACITY));
+}
+
+//what callers did before BoxPacker: open a new box whenever the next item does not fit the current one
+void benchByHand(std::size_t n) {
+	std::vector<amazoom::Item> items(makeItems(n, 1));
+	const double weight = totalWeight(items);
+
+	Clock::time_point start = Clock::now();
+	std::vector<std::unique_ptr<amazoom::Box>> boxes;
+	boxes.push_back(std::unique_ptr<amazoom::Box>(new amazoom::Box(BOX_CAPACITY)));
+	for (amazoom::Item& item : items) {
+		if (!boxes.back()->canInsert(item)) {
+			boxes.push_back(std::unique_ptr<amazoom::Box>(new amazoom::Box(BOX_CAPACITY)));
+		}
+		boxes.back()->insertItem(item);
+	}
+	report("by hand (next fit)", n, secondsSince(start), boxes.size(), weight);
+}
+
+void benchSingleOrder(const char* name, amazoom::BoxPacker::Strategy strategy, std::size_t n) {
+	std::vector<amazoom::Item> items(makeItems(n, 1));
+	const double weight = totalWeight(items);
+
+	amazoom::BoxPacker packer(BOX_CAPACITY, strategy);
+	Clock::time_point start = Clock::now();
+	amazoom::BoxPacker::Boxes boxes(packer.pack(items));
+	report(name, n, secondsSince(start), boxes.size(), weight);
+}
+
+void benchOrders(int numThreads, std::size_t n) {
+	std::vector<amazoom::Item> items(makeItems(n, 2));
+	const double weight = totalWeight(items);
+
+	std::vector<std::vector<amazoom::Item>> orders((n + ITEMS_PER_ORDER - 1) / ITEMS_PER_ORDER);
+	for (std::size_t i = 0; i < n; i++) {
+		orders[i / ITEMS_PER_ORDER].push_back(std::move(items[i]));
+	}
+
+	amazoom::BoxPacker packer(BOX_CAPACITY, amazoom::BoxPacker::BEST_FIT_DECREASING);
+	Clock::time_point start = Clock::now();
+	std::vector<amazoom::BoxPacker::Boxes> packed(packer.packOrders(orders, numThreads));
+	const double seconds = secondsSince(start);
+
+	std::size_t numBoxes = 0;
+	for (const amazoom::BoxPacker::Boxes& boxes : packed) {
+		numBoxes += boxes.size();
+	}
+
+	char name[64];
+	std::snprintf(name, sizeof(name), "orders of %zu, %d threads", ITEMS_PER_ORDER, numThreads);
+	report(name, n, seconds, numBoxes, weight);
+}
+}
+
+int main(int argc, char** argv) {
+	const std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+	const int maxThreads = argc > 2 ? std::atoi(argv[2]) : 8;
+
+	std::printf("single order\n");
+	benchByHand(n);
+	benchSingleOrder("first fit decreasing", amazoom::BoxPacker::FIRST_FIT_DECREASING, n);
+	benchSingleOrder("best fit decreasing", amazoom::BoxPacker::BEST_FIT_DECREASING, n);
+
+	std::printf("\nindependent orders\n");
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		benchOrders(threads, n);
+	}
+	return 0;
+}
@@ -0,0 +1,58 @@
+/* Compares std::function predicates (doesContainObj/tryExtractItem) with the compile-time
+*  predicate overloads (containsIf/extractIf) on long same-key chains. The predicate matches
+*  nothing, so every call walks the whole chain and nothing is extracted.
+*  Usage: predicate_benchmark [maxChainLength]   (default 100000)
+*/
+#include "containers/multi_hashmap.h"
+#include "warehouse_etc/item_definition.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+template <class T_FXN>
+double nsPerItem(int repeats, int chainLength, T_FXN fxn) {
+	Clock::time_point start = Clock::now();
+	for (int i = 0; i < repeats; i++) {
+		fxn();
+	}
+	Clock::time_point end = Clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(repeats) * chainLength);
+}
+}
+
+int main(int argc, char** argv) {
+	const int maxChainLength = argc > 1 ? std::atoi(argv[1]) : 100000;
+	const int key = 1;
+	const float missingWeight = -1.0f;
+
+	for (int chainLength = 10; chainLength <= maxChainLength; chainLength *= 10) {
+		amazoom::MultiHashmap<int, amazoom::Item> hashmap;
+		for (int i = 0; i < chainLength; i++) {
+			amazoom::Item item(key, static_cast<float>(i));
+			hashmap.insertItem(key, item);
+		}
+
+		//enough repeats that every length walks roughly 10^7 nodes per measurement
+		const int repeats = 10000000 / chainLength;
+
+		auto lambda = [missingWeight](const amazoom::Item& item) { return item.getWeight() == missingWeight; };
+		const std::function<bool(const amazoom::Item&)> function(lambda);
+
+		int found = 0;
+		const double containsFunction = nsPerItem(repeats, chainLength, [&]() { found += hashmap.doesContainObj(key, function); });
+		const double containsTemplate = nsPerItem(repeats, chainLength, [&]() { found += hashmap.containsIf(key, lambda); });
+		const double extractFunction = nsPerItem(repeats, chainLength, [&]() { found += hashmap.tryExtractItem(key, function).has_value(); });
+		const double extractTemplate = nsPerItem(repeats, chainLength, [&]() { found += hashmap.extractIf(key, lambda).has_value(); });
+
+		std::printf("chain %7d  contains: std::function %6.2f ns/node  template %6.2f ns/node   "
+			"extract: std::function %6.2f ns/node  template %6.2f ns/node  (found %d)\n",
+			chainLength, containsFunction, containsTemplate, extractFunction, extractTemplate, found);
+	}
+	return 0;
+}
@@ -0,0 +1,116 @@
+/* Pickers against a reporting job on the same MultiHashmap. numThreads pickers insert and extract at
+*  random for a fixed time while one reporter repeatedly totals the weight of the whole inventory, either
+*  with visitItems (shared lock, so pickers wait for every pass) or through a snapshot (no lock held).
+*  Reports picker throughput and p99 latency, and how many passes the reporter completed.
+*  Usage: report_benchmark [items] [numThreads] [seconds]   (defaults 200000, 4, 2)
+*/
+#include "containers/multi_hashmap.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef amazoom::MultiHashmap<int, amazoom::Item> Hashmap;
+
+const int NUM_KEYS = 10000;
+
+enum class Reporter { NONE, LOCKED, SNAPSHOT };
+
+const char* reporterName(Reporter reporter) {
+	switch (reporter) {
+	case Reporter::NONE: return "no reporter";
+	case Reporter::LOCKED: return "visitItems";
+	default: return "snapshot";
+	}
+}
+
+void bench(Reporter reporter, int numItems, int numThreads, double seconds) {
+	std::unique_ptr<Hashmap> hashmap(new Hashmap());
+	for (int i = 0; i < numItems; i++) {
+		amazoom::Item item(i % NUM_KEYS, 1.0f + (i % 10));
+		hashmap->insertItem(i % NUM_KEYS, item);
+	}
+
+	std::atomic<bool> stop{ false };
+	std::vector<std::vector<std::int64_t>> latencies(numThreads);
+	std::atomic<int> passes{ 0 };
+
+	std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+	for (int t = 0; t < numThreads; t++) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&, t]() {
+			std::mt19937 eng(1000u + t);
+			std::uniform_int_distribution<int> keyDist(0, NUM_KEYS - 1);
+			std::vector<std::int64_t>& mine = latencies[t];
+
+			for (int i = 0; !stop; i++) {
+				const int key = keyDist(eng);
+				Clock::time_point start = Clock::now();
+				if (i % 2 == 0) {
+					amazoom::Item item(key, 1.0f);
+					hashmap->insertItem(key, item);
+				}
+				else {
+					hashmap->tryExtractItem(key);
+				}
+				mine.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+			}
+		})));
+	}
+
+	if (reporter != Reporter::NONE) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&]() {
+			while (!stop) {
+				double totalWeight = 0;
+				auto add = [&totalWeight](int, const amazoom::Item& item) { totalWeight += item.getWeight(); };
+				if (reporter == Reporter::LOCKED) {
+					hashmap->visitItems(add);
+				}
+				else {
+					hashmap->snapshot().visitItems(add);
+				}
+				if (totalWeight >= 0) {
+					passes++;
+				}
+			}
+		})));
+	}
+
+	boost::this_thread::sleep_for(boost::chrono::milliseconds(static_cast<int>(seconds * 1000)));
+	stop = true;
+	for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+		threadPtr->join();
+	}
+
+	std::vector<std::int64_t> all;
+	for (std::vector<std::int64_t>& l : latencies) {
+		all.insert(all.end(), l.begin(), l.end());
+	}
+	const std::size_t rank = std::min(all.size() - 1, static_cast<std::size_t>(0.99 * all.size()));
+	std::nth_element(all.begin(), all.begin() + rank, all.end());
+
+	std::printf("%-12s %2d pickers  %11.0f picks/s  p99 %10lld ns  %5d report passes\n",
+		reporterName(reporter), numThreads, all.size() / seconds, static_cast<long long>(all[rank]), passes.load());
+}
+}
+
+int main(int argc, char** argv) {
+	const int numItems = argc > 1 ? std::atoi(argv[1]) : 200000;
+	const int numThreads = argc > 2 ? std::atoi(argv[2]) : 4;
+	const double seconds = argc > 3 ? std::atof(argv[3]) : 2.0;
+
+	for (Reporter reporter : { Reporter::NONE, Reporter::LOCKED, Reporter::SNAPSHOT }) {
+		bench(reporter, numItems, numThreads, seconds);
+	}
+	return 0;
+}
@@ -0,0 +1,101 @@
+/* Checkout holds on a MultiHashmap shared with pickers. numThreads checkout threads hold 2 units of a
+*  random key and then give them back, while as many pickers extract and restock items at random.
+*  Holds are made either the old way, by extracting the units and reinserting them (two trips through the
+*  map lock), or with reserve/releaseReservation, which never take it.
+*  Reports holds per second and picker operations per second.
+*  Usage: reservation_benchmark [keys] [numThreads] [seconds]   (defaults 1000, 2, 2)
+*/
+#include "containers/multi_hashmap.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+typedef amazoom::MultiHashmap<int, amazoom::Item> Hashmap;
+
+const int ITEMS_PER_KEY = 20;
+const int HOLD_UNITS = 2;
+
+void bench(bool reservations, int numKeys, int numThreads, double seconds) {
+	std::unique_ptr<Hashmap> hashmap(new Hashmap());
+	for (int i = 0; i < numKeys * ITEMS_PER_KEY; i++) {
+		amazoom::Item item(i, 1.0f);
+		hashmap->insertItem(i % numKeys, item);
+	}
+
+	std::atomic<bool> stop{ false };
+	std::atomic<long long> holds{ 0 };
+	std::atomic<long long> picks{ 0 };
+
+	std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+	for (int t = 0; t < numThreads; t++) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&, t]() {
+			std::mt19937 eng(100u + t);
+			std::uniform_int_distribution<int> keyDist(0, numKeys - 1);
+			long long done = 0;
+			while (!stop) {
+				const int key = keyDist(eng);
+				if (reservations) {
+					std::optional<Hashmap::Reservation> hold = hashmap->reserve(key, HOLD_UNITS, std::chrono::minutes(1));
+					if (hold) {
+						hashmap->releaseReservation(*hold);
+					}
+				}
+				else {
+					std::vector<amazoom::Item> held = hashmap->extractItems(key, HOLD_UNITS);
+					std::vector<std::pair<int, amazoom::Item>> restored;
+					for (amazoom::Item& item : held) {
+						restored.emplace_back(key, std::move(item));
+					}
+					hashmap->insertItems(restored);
+				}
+				done++;
+			}
+			holds += done;
+		})));
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&, t]() {
+			std::mt19937 eng(200u + t);
+			std::uniform_int_distribution<int> keyDist(0, numKeys - 1);
+			long long done = 0;
+			while (!stop) {
+				const int key = keyDist(eng);
+				std::optional<amazoom::Item> item = hashmap->tryExtractItem(key);
+				if (item) {
+					hashmap->insertItem(key, *item);
+				}
+				done++;
+			}
+			picks += done;
+		})));
+	}
+
+	boost::this_thread::sleep_for(boost::chrono::milliseconds(static_cast<int>(seconds * 1000)));
+	stop = true;
+	for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+		threadPtr->join();
+	}
+
+	std::printf("%-20s %2d+%-2d threads  %11.0f holds/s  %11.0f picks/s\n", reservations ? "reserve/release" : "extract/reinsert",
+		numThreads, numThreads, holds.load() / seconds, picks.load() / seconds);
+}
+}
+
+int main(int argc, char** argv) {
+	const int numKeys = argc > 1 ? std::atoi(argv[1]) : 1000;
+	const int numThreads = argc > 2 ? std::atoi(argv[2]) : 2;
+	const double seconds = argc > 3 ? std::atof(argv[3]) : 2.0;
+
+	bench(false, numKeys, numThreads, seconds);
+	bench(true, numKeys, numThreads, seconds);
+	return 0;
+}
@@ -0,0 +1,74 @@
+/* Cold start: rebuilding storage by inserting items one call at a time against loading an InventorySnapshot.
+*  "write" is the time to snapshot the filled storage, "map" maps and verifies the file, and "load" inserts
+*  the mapped items as one batch.
+*  Usage: snapshot_benchmark [items] [keys] [path]   (defaults 2000000, 10000, inventory.snap)
+*/
+#include "containers/flat_multi_hashmap_impl.h"
+#include "containers/inventory_snapshot.h"
+#include "containers/multi_hashmap_impl.h"
+#include "warehouse_etc/item_definition.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double msSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <class T_STORAGE>
+void bench(const char* name, const std::vector<int>& keys, const std::string& path) {
+	std::unique_ptr<T_STORAGE> original(new T_STORAGE());
+
+	Clock::time_point start = Clock::now();
+	for (std::size_t i = 0; i < keys.size(); i++) {
+		amazoom::Item item(keys[i], 1.0f + (i % 100) / 10.0f);
+		original->insertItem(keys[i], item);
+	}
+	const double insertMs = msSince(start);
+
+	start = Clock::now();
+	amazoom::InventorySnapshot::write(*original, path);
+	const double writeMs = msSince(start);
+	original.reset();
+
+	start = Clock::now();
+	amazoom::InventorySnapshot snapshot(path);
+	const double mapMs = msSince(start);
+
+	std::unique_ptr<T_STORAGE> restored(new T_STORAGE());
+	start = Clock::now();
+	snapshot.loadInto(*restored);
+	const double loadMs = msSince(start);
+
+	std::printf("%-20s %9zu items  per-item insert %8.1f ms  write %7.1f ms  map %6.1f ms  load %8.1f ms  (%d restored)\n",
+		name, keys.size(), insertMs, writeMs, mapMs, loadMs, restored->getNumItems());
+}
+}
+
+int main(int argc, char** argv) {
+	const std::size_t numItems = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+	const int numKeys = argc > 2 ? std::atoi(argv[2]) : 10000;
+	const std::string path = argc > 3 ? argv[3] : "inventory.snap";
+
+	std::mt19937 eng(42);
+	std::uniform_int_distribution<int> keyDist(0, numKeys - 1);
+	std::vector<int> keys(numItems);
+	for (int& key : keys) {
+		key = keyDist(eng);
+	}
+
+	bench<amazoom::MultiHashmapImpl>("MultiHashmapImpl", keys, path);
+	bench<amazoom::FlatMultiHashmapImpl>("FlatMultiHashmapImpl", keys, path);
+
+	std::remove(path.c_str());
+	return 0;
+}
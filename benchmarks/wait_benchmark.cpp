@@ -0,0 +1,94 @@
+/* Pickers waiting for stock that a single stocker trickles in, one item every intervalUs.
+*  Compares pickers that poll tryExtractItem (yielding between tries) with pickers parked in extractItemWait.
+*  Reports the CPU time the whole process used, which polling burns while nothing is in stock,
+*  and the mean and p99 delay from an item's insertion to a picker holding it.
+*  Usage: wait_benchmark [numPickers] [items] [intervalUs]   (defaults 8, 2000, 200)
+*/
+#include "containers/multi_hashmap_impl.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int KEY = 1;
+
+std::int64_t nowNs() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+void bench(bool wait, int numPickers, int numItems, int intervalUs) {
+	amazoom::MultiHashmapImpl hashmap;
+
+	//items carry their insertion time, in microseconds since the start, as their ID
+	const std::int64_t start = nowNs();
+	std::vector<std::vector<std::int64_t>> delays(numPickers);
+	std::atomic<int> remaining{ numItems };
+
+	const std::clock_t cpuStart = std::clock();
+	std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+	for (int t = 0; t < numPickers; t++) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&, t]() {
+			while (remaining-- > 0) {
+				std::optional<amazoom::Item> item;
+				if (wait) {
+					item = hashmap.extractItemWait(KEY, std::chrono::seconds(60));
+				}
+				else {
+					while (!(item = hashmap.tryExtractItem(KEY))) {
+						boost::this_thread::yield();
+					}
+				}
+				delays[t].push_back((nowNs() - start) / 1000 - item->getID());
+			}
+		})));
+	}
+
+	for (int i = 0; i < numItems; i++) {
+		boost::this_thread::sleep_for(boost::chrono::microseconds(intervalUs));
+		amazoom::Item item(static_cast<int>((nowNs() - start) / 1000), 1.0f);
+		hashmap.insertItem(KEY, item);
+	}
+	for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+		threadPtr->join();
+	}
+	const double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+	const double wallSeconds = (nowNs() - start) / 1e9;
+
+	std::vector<std::int64_t> all;
+	for (std::vector<std::int64_t>& d : delays) {
+		all.insert(all.end(), d.begin(), d.end());
+	}
+	double mean = 0;
+	for (std::int64_t d : all) {
+		mean += d;
+	}
+	mean /= all.size();
+	const std::size_t rank = std::min(all.size() - 1, static_cast<std::size_t>(0.99 * all.size()));
+	std::nth_element(all.begin(), all.begin() + rank, all.end());
+
+	std::printf("%-16s %2d pickers  cpu %6.2f s over %5.2f s wall  delay mean %8.1f us  p99 %8lld us\n",
+		wait ? "extractItemWait" : "poll", numPickers, cpuSeconds, wallSeconds, mean, static_cast<long long>(all[rank]));
+}
+}
+
+int main(int argc, char** argv) {
+	const int numPickers = argc > 1 ? std::atoi(argv[1]) : 8;
+	const int numItems = argc > 2 ? std::atoi(argv[2]) : 2000;
+	const int intervalUs = argc > 3 ? std::atoi(argv[3]) : 200;
+
+	bench(false, numPickers, numItems, intervalUs);
+	bench(true, numPickers, numItems, intervalUs);
+	return 0;
+}
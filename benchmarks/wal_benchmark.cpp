@@ -0,0 +1,118 @@
+/* Cost of write-ahead logging on the insert path, and how well group commit batches syncs.
+*  Every thread inserts opsPerThread items through a LoggedContainerImpl over FlatMultiHashmapImpl, for
+*  1 to maxThreads threads and each durability, against the same storage without a log.
+*  "records/sync" is how many records each fdatasync covered on average.
+*  Usage: wal_benchmark [opsPerThread] [maxThreads] [path]   (defaults 20000, 32, inventory.wal)
+*/
+#include "containers/flat_multi_hashmap_impl.h"
+#include "containers/logged_container_impl.h"
+#include "containers/write_ahead_log.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int NUM_KEYS = 10000;
+
+std::int64_t percentile(std::vector<std::int64_t>& ns, double p) {
+	std::size_t rank = std::min(ns.size() - 1, static_cast<std::size_t>(p * ns.size()));
+	std::nth_element(ns.begin(), ns.begin() + rank, ns.end());
+	return ns[rank];
+}
+
+//log is null for the unlogged baseline
+void bench(const char* name, amazoom::WriteAheadLog* log, int numThreads, int opsPerThread) {
+	std::unique_ptr<amazoom::WorkerAccessibleContainer> storage(new amazoom::FlatMultiHashmapImpl());
+	if (log != nullptr) {
+		storage.reset(new amazoom::LoggedContainerImpl(storage, *log));
+	}
+
+	std::vector<std::vector<std::int64_t>> latencies(numThreads);
+	boost::barrier ready(numThreads + 1);
+
+	std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+	for (int t = 0; t < numThreads; t++) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&, t]() {
+			std::vector<std::int64_t>& mine = latencies[t];
+			mine.reserve(opsPerThread);
+
+			ready.wait();
+			for (int i = 0; i < opsPerThread; i++) {
+				const int key = (t * opsPerThread + i) % NUM_KEYS;
+				Clock::time_point start = Clock::now();
+				amazoom::Item item(key, 1.0f);
+				storage->insertItem(key, item);
+				mine.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+			}
+		})));
+	}
+
+	amazoom::WriteAheadLog::Stats before = log != nullptr ? log->getStats() : amazoom::WriteAheadLog::Stats{};
+	ready.wait();
+	Clock::time_point start = Clock::now();
+	for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+		threadPtr->join();
+	}
+	if (log != nullptr) {
+		log->sync();
+	}
+	const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::vector<std::int64_t> all;
+	for (std::vector<std::int64_t>& l : latencies) {
+		all.insert(all.end(), l.begin(), l.end());
+	}
+
+	double recordsPerSync = 0;
+	if (log != nullptr) {
+		amazoom::WriteAheadLog::Stats after = log->getStats();
+		const std::uint64_t syncs = after.syncs - before.syncs;
+		recordsPerSync = syncs > 0 ? static_cast<double>(after.recordsAppended - before.recordsAppended) / syncs : 0;
+	}
+
+	std::printf("%-8s %2d threads  %10.0f ops/s  p50 %8lld ns  p99 %9lld ns  records/sync %8.1f\n",
+		name, numThreads, all.size() / seconds,
+		static_cast<long long>(percentile(all, 0.50)), static_cast<long long>(percentile(all, 0.99)), recordsPerSync);
+}
+}
+
+int main(int argc, char** argv) {
+	const int opsPerThread = argc > 1 ? std::atoi(argv[1]) : 20000;
+	const int maxThreads = argc > 2 ? std::atoi(argv[2]) : 32;
+	const std::string path = argc > 3 ? argv[3] : "inventory.wal";
+
+	const struct {
+		const char* name;
+		amazoom::WriteAheadLog::Durability durability;
+	} levels[] = {
+		{ "async", amazoom::WriteAheadLog::ASYNC },
+		{ "write", amazoom::WriteAheadLog::WRITE },
+		{ "sync", amazoom::WriteAheadLog::SYNC },
+	};
+
+	for (int threads = 1; threads <= maxThreads; threads *= 2) {
+		bench("none", nullptr, threads, opsPerThread);
+	}
+	for (const auto& level : levels) {
+		std::printf("\n");
+		for (int threads = 1; threads <= maxThreads; threads *= 2) {
+			std::filesystem::remove(path);
+			amazoom::WriteAheadLog log(path, level.durability);
+			bench(level.name, &log, threads, opsPerThread);
+		}
+	}
+	std::filesystem::remove(path);
+	return 0;
+}
@@ -1,48 +1,180 @@
 #include "box.h"
 
+#include <cmath>
 
-amazoom::Box::Box(const float max_weight) : MAX_WEIGHT_(max_weight){}
+
+amazoom::Box::Box(const float max_weight) : ItemContainer("box"), MAX_WEIGHT_(max_weight), MAX_WEIGHT_UNITS_(toUnits(max_weight)) {}
 
 amazoom::Box::Box(StoragePtr& storage,
-	              const float max_weight) : ItemContainer(storage), MAX_WEIGHT_(max_weight) {}
+	              const float max_weight) : ItemContainer(storage, "box"), MAX_WEIGHT_(max_weight), MAX_WEIGHT_UNITS_(toUnits(max_weight)) {}
 
 amazoom::Box::~Box() { }
 
 bool amazoom::Box::canInsert(const amazoom::Item& item) {
-	boost::shared_lock<boost::shared_mutex> lock(mtx_);
-	return !wouldBeOverweight(item);
+	//only a hint once other workers are inserting; tryInsert checks and reserves together
+	return currWeightUnits_.load(std::memory_order_relaxed) + toUnits(item.getWeight()) <= MAX_WEIGHT_UNITS_;
 }
 
 amazoom::Item amazoom::Box::extractItem(int key) {
-	boost::unique_lock<boost::shared_mutex> lock(mtx_);
+	MeteredOp op(metrics_, MetricsOp::EXTRACT); //a throw counts as a miss
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(extractionMtx_, metrics_);
 
 	amazoom::Item extractedItem(storage_->extractItem(key));
-	currWeight_ -= extractedItem.getWeight();
+	releaseWeight(toUnits(extractedItem.getWeight()));
 
 	return std::move(extractedItem);
 }
 
+std::optional<amazoom::Item> amazoom::Box::tryExtractItem(int key) {
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(extractionMtx_, metrics_);
+
+	std::optional<Item> extractedItem(storage_->tryExtractItem(key));
+	if (extractedItem) {
+		releaseWeight(toUnits(extractedItem->getWeight()));
+	}
+	else {
+		op.miss();
+	}
+	return extractedItem;
+}
+
 void amazoom::Box::insertItem(Item& item) {
-	boost::unique_lock<boost::shared_mutex> lock(mtx_);
-	if (wouldBeOverweight(item)) {
+	if (!tryInsert(item)) {
 		throw BoxOverweightException("Item too heavy to be inserted.");  
 	}
-	storage_->insertItem(item.getID(),item);
-	currWeight_ += item.getWeight();
+}
+
+bool amazoom::Box::tryInsert(Item& item) {
+	MeteredOp op(metrics_, MetricsOp::INSERT); //insertItem comes through here too
+	const WeightUnits units = toUnits(item.getWeight());
+	if (!reserveWeight(units)) {
+		op.miss();
+		return false;
+	}
+
+	try {
+		storage_->insertItem(item.getID(), item);
+	}
+	catch (...) {
+		releaseWeight(units);
+		throw;
+	}
+	return true;
+}
+
+void amazoom::Box::insertItems(std::vector<Item>& items) {
+	MeteredOp op(metrics_, MetricsOp::INSERT_BATCH);
+	WeightUnits batchUnits = 0;
+	for (const Item& item : items) {
+		batchUnits += toUnits(item.getWeight());
+	}
+	if (!reserveWeight(batchUnits)) {
+		throw BoxOverweightException("Items too heavy to be inserted.");
+	}
+
+	std::vector<std::pair<int, Item>> keyedItems;
+	keyedItems.reserve(items.size());
+	for (Item& item : items) {
+		keyedItems.emplace_back(item.getID(), std::move(item));
+	}
+
+	try {
+		storage_->insertItems(keyedItems);
+	}
+	catch (...) {
+		//storage moves out every item it keeps, so the ones still here were refused: they go back to the
+		//caller with their weight, and what was stored keeps its reservation
+		WeightUnits refusedUnits = 0;
+		for (std::size_t i = 0; i < keyedItems.size(); i++) {
+			if (keyedItems[i].second.getID() != Item::INVALID_ITEM) {
+				refusedUnits += toUnits(keyedItems[i].second.getWeight());
+				items[i] = std::move(keyedItems[i].second);
+			}
+		}
+		releaseWeight(refusedUnits);
+		throw;
+	}
+}
+
+std::vector<amazoom::Item> amazoom::Box::extractItems(int key, int count) {
+	MeteredOp op(metrics_, MetricsOp::EXTRACT_BATCH);
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(extractionMtx_, metrics_);
+
+	std::vector<Item> extractedItems(extractItemsLocked(key, count));
+	if (extractedItems.empty()) {
+		op.miss();
+	}
+	return extractedItems;
+}
+
+std::vector<amazoom::Item> amazoom::Box::extractItemsLocked(int key, int count) {
+	std::vector<Item> extractedItems(storage_->extractItems(key, count));
+
+	WeightUnits batchUnits = 0;
+	for (const Item& item : extractedItems) {
+		batchUnits += toUnits(item.getWeight());
+	}
+	releaseWeight(batchUnits);
+
+	return extractedItems;
+}
+
+void amazoom::Box::restoreItemsLocked(int key, std::vector<Item>& items) {
+	WeightUnits batchUnits = 0;
+	for (const Item& item : items) {
+		batchUnits += toUnits(item.getWeight());
+	}
+	currWeightUnits_.fetch_add(batchUnits, std::memory_order_relaxed);
+	ItemContainer::restoreItemsLocked(key, items);
+}
+
+bool amazoom::Box::insertBestFit(Storable& source, int key) {
+	const WeightUnits freeUnits = MAX_WEIGHT_UNITS_ - currWeightUnits_.load(std::memory_order_relaxed);
+
+	std::optional<Item> bestFit(source.extractWithWeightAtMost(key, toWeight(freeUnits)));
+	if (!bestFit) {
+		return false;
+	}
+
+	//another worker may have filled the box since freeUnits was read; never overfill
+	if (!tryInsert(*bestFit)) {
+		source.insertItem(key, *bestFit);
+		return false;
+	}
+	return true;
 }
 
 float amazoom::Box::currentWeight() {
-	boost::unique_lock<boost::shared_mutex> lock(mtx_);
-	return currWeight_;
+	return toWeight(currWeightUnits_.load(std::memory_order_relaxed));
+}
+
+float amazoom::Box::remainingCapacity() {
+	return toWeight(MAX_WEIGHT_UNITS_ - currWeightUnits_.load(std::memory_order_relaxed));
 }
 
 float amazoom::Box::getMaxWeight() {
-	boost::shared_lock<boost::shared_mutex> lock(mtx_);
 	return MAX_WEIGHT_;
 }
 
-bool amazoom::Box::wouldBeOverweight(const Item& item)  {
-	//do not mutex, calling functions should be protected
-	return item.getWeight() + currWeight_ > MAX_WEIGHT_;
+amazoom::Box::WeightUnits amazoom::Box::toUnits(float weight) {
+	return static_cast<WeightUnits>(std::llround(static_cast<double>(weight) * WEIGHT_UNITS_PER_WEIGHT));
 }
 
+float amazoom::Box::toWeight(WeightUnits units) {
+	return static_cast<float>(static_cast<double>(units) / WEIGHT_UNITS_PER_WEIGHT);
+}
+
+bool amazoom::Box::reserveWeight(WeightUnits units) {
+	WeightUnits current = currWeightUnits_.load(std::memory_order_relaxed);
+	do {
+		if (current + units > MAX_WEIGHT_UNITS_) {
+			return false;
+		}
+	} while (!currWeightUnits_.compare_exchange_weak(current, current + units, std::memory_order_relaxed));
+	return true;
+}
+
+void amazoom::Box::releaseWeight(WeightUnits units) {
+	currWeightUnits_.fetch_sub(units, std::memory_order_relaxed);
+}
@@ -7,10 +7,17 @@
 
 #include "boost/thread.hpp"
 
+#include <atomic>
+#include <cstdint>
+
 namespace amazoom {
 
 /* Class representation of a box. Limits insertions due to a maximum weight
 *
+*  The weight is tracked as an atomic fixed-point counter rather than under a lock. Capacity is
+*  reserved with a compare-and-swap before an item reaches storage, so many workers can pack the
+*  same box at once and never overfill it. Each item's weight is rounded to fixed point
+*  once, and the same rounded amount is given back on extraction, so the total cannot drift.
 */
 class Box : public ItemContainer {
 private:
@@ -18,6 +25,7 @@ private:
 
 
 public:
+	typedef std::int64_t WeightUnits;
 
 	Box(const float max_weight = 100.0f); //uses the default scheme defined in ItemContainer
 	Box(StoragePtr& storage, const float max_weight = 100.0f); //accepts custom key-value mapping schemes
@@ -27,19 +35,53 @@ public:
 
 	virtual bool canInsert(const amazoom::Item& item) override;
 	virtual amazoom::Item extractItem(int key) override;
+	virtual std::optional<amazoom::Item> tryExtractItem(int key) override;
 	virtual void insertItem(Item& item) override;
+
+	//Inserts item only if it fits, checking and reserving its weight as one atomic step.
+	//Returns false instead of throwing when the box is too full. Use this instead of canInsert
+	//followed by insertItem when other workers may be packing the same box.
+	virtual bool tryInsert(Item& item);
+
+	//All or nothing: if the batch as a whole would make the box overweight, BoxOverweightException
+	//is thrown and no item is inserted. Capacity is reserved once for the whole batch.
+	//If storage throws, the items it refused are moved back into items and their weight is released.
+	virtual void insertItems(std::vector<Item>& items) override;
+	virtual std::vector<amazoom::Item> extractItems(int key, int count) override;
+
+	//Moves the heaviest unit of key that still fits in this box out of source and into the box.
+	//Returns false, leaving both untouched, if source has no unit of key light enough.
+	virtual bool insertBestFit(Storable& source, int key);
+
+	//Lock-free. Weight reserved by insertions still in progress is included
 	virtual float currentWeight();
+	virtual float remainingCapacity();
 	virtual float getMaxWeight();
 
+	//fixed-point resolution of the weight counter: an item of weight 1.0 counts as 1000 units
+	static const WeightUnits WEIGHT_UNITS_PER_WEIGHT = 1000;
+
+	//conversions used for all weight accounting; a box accepts a set of items exactly when
+	//the sum of their toUnits does not exceed toUnits(max_weight)
+	static WeightUnits toUnits(float weight);
+	static float toWeight(WeightUnits units);
+
+protected:
+	virtual std::vector<amazoom::Item> extractItemsLocked(int key, int count) override;
+
+	//takes back the weight extractItemsLocked released without checking it: insertions that used the
+	//capacity in between can leave the box over its maximum until something is extracted
+	virtual void restoreItemsLocked(int key, std::vector<amazoom::Item>& items) override;
+
 private:
-	//checks if adding the item would make the object overweight
-	bool wouldBeOverweight(const Item& item);
+	//atomically adds units to currWeightUnits_ if the result stays within the maximum
+	bool reserveWeight(WeightUnits units);
+	void releaseWeight(WeightUnits units);
 
 	const float MAX_WEIGHT_;
-	float currWeight_{ 0.0f };
-
-	boost::shared_mutex mtx_;
+	const WeightUnits MAX_WEIGHT_UNITS_;
+	std::atomic<WeightUnits> currWeightUnits_{ 0 };
 };
 }
 
-#endif
\ No newline at end of file
+#endif
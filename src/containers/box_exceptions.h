@@ -8,7 +8,7 @@ namespace amazoom {
 class BoxOverweightException: public std::exception {
 
 public:
-	BoxOverweightException(std::string error) {};
+	BoxOverweightException(std::string error) : error_(error) {};
 
 	const char* what() const noexcept { return error_.c_str(); }
 
@@ -0,0 +1,153 @@
+#include "box_packer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <numeric>
+
+#include "boost/thread.hpp"
+
+amazoom::BoxPacker::BoxPacker(const float boxCapacity, Strategy strategy)
+	: BOX_CAPACITY_(boxCapacity), BOX_CAPACITY_UNITS_(Box::toUnits(boxCapacity)), strategy_(strategy) {}
+
+amazoom::BoxPacker::~BoxPacker() {}
+
+amazoom::BoxPacker::Boxes amazoom::BoxPacker::pack(std::vector<Item>& items) const {
+	checkFits(items);
+	return packUnchecked(items);
+}
+
+std::vector<amazoom::BoxPacker::Boxes> amazoom::BoxPacker::packOrders(
+	std::vector<std::vector<Item>>& orders, int numThreads) const {
+
+	for (const std::vector<Item>& order : orders) {
+		checkFits(order);
+	}
+
+	std::vector<Boxes> packedOrders(orders.size());
+	const int numWorkers = std::max(1, std::min(numThreads, static_cast<int>(orders.size())));
+
+	//orders vary in size, so workers take the next unpacked order rather than a fixed slice
+	std::atomic<std::size_t> nextOrder{ 0 };
+	auto worker = [this, &orders, &packedOrders, &nextOrder]() {
+		for (std::size_t i = nextOrder++; i < orders.size(); i = nextOrder++) {
+			packedOrders[i] = packUnchecked(orders[i]);
+		}
+	};
+
+	std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+	for (int i = 1; i < numWorkers; i++) {
+		threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread(worker)));
+	}
+	worker(); //the calling thread packs too
+	for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+		threadPtr->join();
+	}
+
+	return packedOrders;
+}
+
+float amazoom::BoxPacker::getBoxCapacity() const {
+	return BOX_CAPACITY_;
+}
+
+amazoom::BoxPacker::Strategy amazoom::BoxPacker::getStrategy() const {
+	return strategy_;
+}
+
+void amazoom::BoxPacker::checkFits(const std::vector<Item>& items) const {
+	for (const Item& item : items) {
+		if (Box::toUnits(item.getWeight()) > BOX_CAPACITY_UNITS_) {
+			throw BoxOverweightException("Item too heavy to fit in any box.");
+		}
+	}
+}
+
+amazoom::BoxPacker::Boxes amazoom::BoxPacker::packUnchecked(std::vector<Item>& items) const {
+	std::vector<WeightUnits> weights(items.size());
+	for (std::size_t i = 0; i < items.size(); i++) {
+		weights[i] = Box::toUnits(items[i].getWeight());
+	}
+
+	//heaviest first; ties keep their original order so results are reproducible
+	std::vector<int> order(items.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&weights](int a, int b) { return weights[a] > weights[b]; });
+
+	std::vector<int> boxOf(strategy_ == FIRST_FIT_DECREASING ? assignFirstFit(weights, order) : assignBestFit(weights, order));
+
+	//group the items by box, then fill each box with a single reservation
+	const int numBoxes = items.empty() ? 0 : *std::max_element(boxOf.begin(), boxOf.end()) + 1;
+	std::vector<std::vector<Item>> contents(numBoxes);
+	for (int i : order) {
+		contents[boxOf[i]].push_back(std::move(items[i]));
+	}
+
+	Boxes boxes;
+	boxes.reserve(numBoxes);
+	for (std::vector<Item>& boxContents : contents) {
+		boxes.push_back(BoxPtr(new Box(BOX_CAPACITY_)));
+		boxes.back()->insertItems(boxContents);
+	}
+	return boxes;
+}
+
+std::vector<int> amazoom::BoxPacker::assignFirstFit(const std::vector<WeightUnits>& weights, const std::vector<int>& order) const {
+	std::vector<int> boxOf(weights.size());
+	if (weights.empty()) {
+		return boxOf;
+	}
+
+	//never more boxes than items. Leaves are boxes, inner nodes hold the largest remaining
+	//capacity below them. Unopened boxes are empty, so the leftmost box with room is always
+	//either an open box or the next one to open
+	std::size_t numLeaves = 1;
+	while (numLeaves < weights.size()) {
+		numLeaves *= 2;
+	}
+	std::vector<WeightUnits> tree(2 * numLeaves, BOX_CAPACITY_UNITS_);
+
+	for (int item : order) {
+		const WeightUnits weight = weights[item];
+
+		//descend to the leftmost leaf with enough room; the root always has room (checkFits)
+		std::size_t node = 1;
+		while (node < numLeaves) {
+			node = tree[2 * node] >= weight ? 2 * node : 2 * node + 1;
+		}
+		boxOf[item] = static_cast<int>(node - numLeaves);
+
+		tree[node] -= weight;
+		for (node /= 2; node >= 1; node /= 2) {
+			tree[node] = std::max(tree[2 * node], tree[2 * node + 1]);
+		}
+	}
+	return boxOf;
+}
+
+std::vector<int> amazoom::BoxPacker::assignBestFit(const std::vector<WeightUnits>& weights, const std::vector<int>& order) const {
+	std::vector<int> boxOf(weights.size());
+
+	//remaining capacity -> box, for every box opened so far
+	std::multimap<WeightUnits, int> openBoxes;
+	int numBoxes = 0;
+
+	for (int item : order) {
+		const WeightUnits weight = weights[item];
+
+		//the box with the least room that still fits the item
+		auto bestFit = openBoxes.lower_bound(weight);
+		if (bestFit == openBoxes.end()) {
+			boxOf[item] = numBoxes;
+			openBoxes.emplace(BOX_CAPACITY_UNITS_ - weight, numBoxes++);
+		}
+		else {
+			const int box = bestFit->second;
+			const WeightUnits remaining = bestFit->first - weight;
+			boxOf[item] = box;
+			openBoxes.erase(bestFit);
+			openBoxes.emplace(remaining, box);
+		}
+	}
+	return boxOf;
+}
@@ -0,0 +1,64 @@
+#ifndef AMAZOOM_CONTAINERS_BOX_PACKER_H_
+#define AMAZOOM_CONTAINERS_BOX_PACKER_H_
+
+#include "containers/box.h"
+#include "warehouse_etc/item_definition.h"
+
+#include <memory>
+#include <vector>
+
+namespace amazoom {
+
+/* Packs batches of items into as few boxes as it can.
+*  Items are sorted heaviest first and then placed one by one:
+*    FIRST_FIT_DECREASING puts each item in the earliest opened box with room. Open boxes are kept in
+*    a tournament tree of remaining capacities, so finding that box is O(log B) instead of O(B).
+*    BEST_FIT_DECREASING puts each item in the box it leaves with the least room, found in O(log B)
+*    in an ordered map of remaining capacities.
+*  Boxes are planned in fixed-point weight units first and only then filled, each with one
+*  Box::insertItems call, so no box is ever retried or overfilled.
+*  Independent orders can be packed concurrently with packOrders. Thread-safe.
+*/
+class BoxPacker {
+public:
+	typedef std::unique_ptr<Box> BoxPtr;
+	typedef std::vector<BoxPtr> Boxes;
+
+	enum Strategy { FIRST_FIT_DECREASING, BEST_FIT_DECREASING };
+
+	BoxPacker(const float boxCapacity = 100.0f, Strategy strategy = BEST_FIT_DECREASING);
+	~BoxPacker();
+
+	/*Packs one order. Items are moved out of items.
+	* Throws BoxOverweightException, before moving anything, if an item is heavier than an empty box.
+	*/
+	Boxes pack(std::vector<Item>& items) const;
+
+	/*Packs every order on its own, spreading the orders over numThreads threads.
+	* The result holds the boxes of orders[i] at index i. Items are moved out of orders.
+	* Throws BoxOverweightException, before moving anything, if any item is heavier than an empty box.
+	*/
+	std::vector<Boxes> packOrders(std::vector<std::vector<Item>>& orders, int numThreads) const;
+
+	float getBoxCapacity() const;
+	Strategy getStrategy() const;
+
+private:
+	typedef Box::WeightUnits WeightUnits;
+
+	//throws if any item cannot fit even in an empty box
+	void checkFits(const std::vector<Item>& items) const;
+
+	//returns, for every item, the index of the box it goes into
+	std::vector<int> assignFirstFit(const std::vector<WeightUnits>& weights, const std::vector<int>& order) const;
+	std::vector<int> assignBestFit(const std::vector<WeightUnits>& weights, const std::vector<int>& order) const;
+
+	Boxes packUnchecked(std::vector<Item>& items) const;
+
+	const float BOX_CAPACITY_;
+	const WeightUnits BOX_CAPACITY_UNITS_;
+	const Strategy strategy_;
+};
+}
+
+#endif
@@ -0,0 +1,586 @@
+#ifndef AMAZOOM_CONTAINERS_COLUMNAR_MULTI_HASHMAP_H_
+#define AMAZOOM_CONTAINERS_COLUMNAR_MULTI_HASHMAP_H_
+
+#include <unordered_map>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <stdexcept>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+
+#include "containers/container_metrics.h"
+#include "containers/multi_hashmap_exceptions.h"
+#include "containers/weight_aggregates.h"
+#include "warehouse_etc/item_definition.h"
+#include "warehouse_etc/packed_item.h"
+#include "boost/thread.hpp"
+
+namespace amazoom {
+/* A multihashmap of Items that stores each key's items as columns: one array of IDs, one of weights in
+*  PackedItem's fixed point, and one of flags. That is 9 bytes per item, so 10^8 units take under a gigabyte,
+*  and every column is trivially copyable, so growing a key, filling holes and moving items in bulk
+*  (extractPacked/insertPacked) are plain memory copies. Weight scans only read the weight column.
+*  Otherwise behaves like FlatMultiHashmap: same-key order is not preserved, O(1) average insertion and
+*  extraction by key, O(N) for filtered extraction over N same-key items.
+*  Weights are kept as PackedItem keeps them. Items are taken only if their weight comes back out exactly
+*  as it went in, so bookkeeping on top of the map, such as Box's weight counter, cannot drift: inserting
+*  an item outside PackedItem's range, or whose weight is not a whole number of 1/WEIGHT_SCALE kg (1.0005,
+*  say), throws std::out_of_range. PackedItems are stored as they are.
+*  Predicates and visitors are handed an Item rebuilt from the columns.
+*  Thread-safe. Allows multiple simutaneous reads, and single extraction/insertions
+*/
+template <typename T_KEY>
+class ColumnarMultiHashmap {
+
+	typedef amazoom::Item Item;
+	typedef std::function<bool(const Item& obj)> CompareFxn;
+
+	struct Columns {
+		std::vector<std::int32_t> ids;
+		std::vector<std::uint32_t> weights; //in 1/PackedItem::WEIGHT_SCALE kg
+		std::vector<std::uint8_t> flags;
+
+		std::size_t size() const { return ids.size(); }
+		//makes room for at least capacity items in every column
+		void reserve(std::size_t capacity);
+		//cannot throw once every column has been reserved for it; otherwise may leave the columns uneven
+		void push(const PackedItem& packed);
+		PackedItem at(std::size_t index) const;
+
+		//removes the item at index in O(1) by moving the last item into its slot
+		PackedItem swapAndPop(std::size_t index);
+	};
+
+	typedef std::unordered_map<T_KEY, Columns> Map;
+
+public:
+	ColumnarMultiHashmap();
+
+	ColumnarMultiHashmap(const ColumnarMultiHashmap<T_KEY>& hashmap) = delete;
+	ColumnarMultiHashmap<T_KEY>& operator=(const ColumnarMultiHashmap<T_KEY>& hashmap) = delete;
+
+	~ColumnarMultiHashmap();
+
+	int getNumItems() const; //returns how many items are currently stored
+
+	int countItems(const T_KEY& key) const; //returns how many items are currently stored by key
+
+	//Inserts an item into the container indexed by a key. Throws std::out_of_range, leaving obj valid,
+	//if its weight cannot be stored exactly
+	void insertItem(T_KEY key, Item& obj);
+
+	//Same semantics as FlatMultiHashmap
+	bool doesContainObj(const T_KEY& key, const CompareFxn compareFxn) const;
+	bool doesContainObj(const T_KEY& key) const;
+
+	Item extractItem(const T_KEY& key);
+	Item extractItem(const T_KEY& key, const CompareFxn compareFxn);
+
+	std::optional<Item> tryExtractItem(const T_KEY& key);
+	std::optional<Item> tryExtractItem(const T_KEY& key, const CompareFxn compareFxn);
+
+	template <class T_PRED>
+	bool containsIf(const T_KEY& key, const T_PRED& pred) const;
+
+	template <class T_PRED>
+	std::optional<Item> extractIf(const T_KEY& key, const T_PRED& pred);
+
+	//If the weight of any item of objs cannot be stored exactly, throws std::out_of_range before inserting anything
+	void insertItems(std::vector<std::pair<T_KEY, Item>>& objs);
+	std::vector<Item> extractItems(const T_KEY& key, int count);
+	std::vector<Item> extractItems(const T_KEY& key, int count, const CompareFxn compareFxn);
+
+	std::optional<Item> extractLightest(const T_KEY& key);
+	std::optional<Item> extractHeaviest(const T_KEY& key);
+	std::optional<Item> extractWithWeightAtMost(const T_KEY& key, float maxWeight);
+
+	/*Bulk moves that never build an Item: up to count of key's newest items are copied out of the columns,
+	* or packed items are appended to them, a column at a time.
+	*/
+	std::vector<PackedItem> extractPacked(const T_KEY& key, int count);
+	void insertPacked(const T_KEY& key, const std::vector<PackedItem>& packed);
+
+	template <class T_VISITOR>
+	void visitItems(const T_VISITOR& visit) const;
+
+	/*Aggregates over key's weight column, computed by the WeightAggregates kernels under the shared lock.
+	* Same semantics as Checkable::totalWeight, countWhere and weightHistogram
+	*/
+	double totalWeight(const T_KEY& key) const;
+	int countWhere(const T_KEY& key, float minWeight, float maxWeight) const;
+	std::vector<int> weightHistogram(const T_KEY& key, float binWidth, int numBins) const;
+
+	//operation and mtx_ statistics, recorded only when built with AMAZOOM_METRICS. See ContainerMetrics
+	ContainerMetrics& getMetrics() const;
+
+private:
+	//obj as stored; throws std::out_of_range unless the weight survives the round trip
+	static PackedItem pack(const Item& obj);
+
+	//extracts the item of key's columns that isBetter prefers over all others, among those weighing at most maxRawWeight
+	template <class T_BETTER>
+	std::optional<Item> extractByWeight(const T_KEY& key, std::uint64_t maxRawWeight, const T_BETTER& isBetter);
+
+	int currentNumItems{ 0 }; //how many items are stored
+
+	//Columns are kept when they become empty so a key that is restocked reuses their capacity
+	Map storInternal_;
+
+	//class level mutex. Separates reading and writing operations
+	mutable boost::shared_mutex mtx_;
+
+	mutable ContainerMetrics metrics_{ "columnar_multi_hashmap" };
+};
+}
+
+template <typename T_KEY>
+inline amazoom::ColumnarMultiHashmap<T_KEY>::ColumnarMultiHashmap() {}
+
+template <typename T_KEY>
+inline amazoom::ColumnarMultiHashmap<T_KEY>::~ColumnarMultiHashmap() {}
+
+template <typename T_KEY>
+inline int amazoom::ColumnarMultiHashmap<T_KEY>::getNumItems() const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	return currentNumItems;
+}
+
+template <typename T_KEY>
+inline int amazoom::ColumnarMultiHashmap<T_KEY>::countItems(const T_KEY& key) const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	auto found = storInternal_.find(key);
+	return found == storInternal_.end() ? 0 : static_cast<int>(found->second.size());
+}
+
+template <typename T_KEY>
+inline void amazoom::ColumnarMultiHashmap<T_KEY>::insertItem(T_KEY key, Item& obj) {
+	//packed before locking, so an item that does not fit is refused without touching the map
+	const PackedItem packed(pack(obj));
+
+	MeteredOp op(metrics_, MetricsOp::INSERT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	storInternal_[key].push(packed);
+	currentNumItems++;
+
+	//the container holds the item now
+	Item consumed(std::move(obj));
+}
+
+template <typename T_KEY>
+inline bool amazoom::ColumnarMultiHashmap<T_KEY>::doesContainObj(
+	const T_KEY& key, const CompareFxn compareFxn) const {
+	//mutex inside
+	return containsIf(key, compareFxn);
+}
+
+template <typename T_KEY>
+template <class T_PRED>
+inline bool amazoom::ColumnarMultiHashmap<T_KEY>::containsIf(const T_KEY& key, const T_PRED& pred) const {
+
+	MeteredOp op(metrics_, MetricsOp::CONTAINS);
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found != storInternal_.end()) {
+		const Columns& columns = found->second;
+		for (std::size_t i = 0; i < columns.size(); i++) {
+			if (pred(columns.at(i).toItem())) {
+				return true;
+			}
+		}
+	}
+	op.miss();
+	return false;
+}
+
+template <typename T_KEY>
+inline bool amazoom::ColumnarMultiHashmap<T_KEY>::doesContainObj(const T_KEY& key) const {
+	MeteredOp op(metrics_, MetricsOp::CONTAINS);
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	const bool isFound = found != storInternal_.end() && found->second.size() != 0;
+	if (!isFound) {
+		op.miss();
+	}
+	return isFound;
+}
+
+template <typename T_KEY>
+inline amazoom::Item amazoom::ColumnarMultiHashmap<T_KEY>::extractItem(const T_KEY& key) {
+	//mutex inside
+	std::optional<Item> extractedObj(tryExtractItem(key));
+	if (!extractedObj) {
+		std::ostringstream error;
+		error << "Container does not contain object matching key: " << key;
+		throw MultiHashMapNoSuchObj(error.str());
+	}
+	return std::move(*extractedObj);
+}
+
+template <typename T_KEY>
+inline amazoom::Item amazoom::ColumnarMultiHashmap<T_KEY>::extractItem(
+	const T_KEY& key, const CompareFxn compareFxn) {
+	//mutex inside
+	std::optional<Item> extractedObj(tryExtractItem(key, compareFxn));
+	if (!extractedObj) {
+		std::ostringstream error;
+		error << "Container does not contain object matching special params and key: " << key;
+		throw MultiHashMapNoSuchObj(error.str());
+	}
+	return std::move(*extractedObj);
+}
+
+template <typename T_KEY>
+inline std::optional<amazoom::Item> amazoom::ColumnarMultiHashmap<T_KEY>::tryExtractItem(const T_KEY& key) {
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found == storInternal_.end() || found->second.size() == 0) {
+		op.miss();
+		return std::nullopt;
+	}
+
+	currentNumItems--;
+	return found->second.swapAndPop(found->second.size() - 1).toItem();
+}
+
+template <typename T_KEY>
+inline std::optional<amazoom::Item> amazoom::ColumnarMultiHashmap<T_KEY>::tryExtractItem(
+	const T_KEY& key, const CompareFxn compareFxn) {
+	//mutex inside
+	return extractIf(key, compareFxn);
+}
+
+template <typename T_KEY>
+template <class T_PRED>
+inline std::optional<amazoom::Item> amazoom::ColumnarMultiHashmap<T_KEY>::extractIf(const T_KEY& key, const T_PRED& pred) {
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found != storInternal_.end()) {
+		Columns& columns = found->second;
+
+		//newest first, to match the order MultiHashmap hands objects out in
+		for (std::size_t i = columns.size(); i-- > 0;) {
+			if (pred(columns.at(i).toItem())) {
+				currentNumItems--;
+				return columns.swapAndPop(i).toItem();
+			}
+		}
+	}
+	op.miss();
+	return std::nullopt;
+}
+
+template <typename T_KEY>
+inline void amazoom::ColumnarMultiHashmap<T_KEY>::insertItems(std::vector<std::pair<T_KEY, Item>>& objs) {
+	std::vector<PackedItem> packed;
+	packed.reserve(objs.size());
+	for (const std::pair<T_KEY, Item>& keyObj : objs) {
+		packed.push_back(pack(keyObj.second));
+	}
+
+	MeteredOp op(metrics_, MetricsOp::INSERT_BATCH);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	//pallets are usually one item ID, so remember the last key's columns instead of hashing every item
+	std::vector<Columns*> destinations;
+	destinations.reserve(objs.size());
+	std::unordered_map<Columns*, std::size_t> incoming;
+	std::size_t* columnsIncoming = nullptr;
+	Columns* columns = nullptr;
+	const T_KEY* columnsKey = nullptr;
+	for (const std::pair<T_KEY, Item>& keyObj : objs) {
+		if (columns == nullptr || !(*columnsKey == keyObj.first)) {
+			auto found = storInternal_.find(keyObj.first);
+			if (found == storInternal_.end()) {
+				found = storInternal_.emplace(keyObj.first, Columns()).first;
+			}
+			columns = &found->second;
+			columnsKey = &found->first;
+			columnsIncoming = &incoming[columns];
+		}
+		destinations.push_back(columns);
+		(*columnsIncoming)++;
+	}
+
+	//grow every destination before moving anything, so that the pushes cannot throw and leave a key's
+	//columns at different lengths. An empty key left behind by a throw here is harmless
+	for (const std::pair<Columns* const, std::size_t>& grow : incoming) {
+		grow.first->reserve(grow.first->size() + grow.second);
+	}
+
+	for (std::size_t i = 0; i < objs.size(); i++) {
+		destinations[i]->push(packed[i]);
+
+		//the container holds the item now
+		Item consumed(std::move(objs[i].second));
+	}
+	currentNumItems += static_cast<int>(objs.size());
+}
+
+template <typename T_KEY>
+inline std::vector<amazoom::Item> amazoom::ColumnarMultiHashmap<T_KEY>::extractItems(const T_KEY& key, int count) {
+	std::vector<Item> extractedObjs;
+	for (const PackedItem& packed : extractPacked(key, count)) {
+		extractedObjs.push_back(packed.toItem());
+	}
+	return extractedObjs;
+}
+
+template <typename T_KEY>
+inline std::vector<amazoom::Item> amazoom::ColumnarMultiHashmap<T_KEY>::extractItems(
+	const T_KEY& key, int count, const CompareFxn compareFxn) {
+
+	std::vector<Item> extractedObjs;
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT_BATCH);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (count <= 0 || found == storInternal_.end()) {
+		op.miss();
+		return extractedObjs;
+	}
+	Columns& columns = found->second;
+
+	//walking backwards, a swapped-in item always comes from a slot already visited
+	for (std::size_t i = columns.size(); i-- > 0 && static_cast<int>(extractedObjs.size()) < count;) {
+		if (compareFxn(columns.at(i).toItem())) {
+			extractedObjs.push_back(columns.swapAndPop(i).toItem());
+		}
+	}
+	currentNumItems -= static_cast<int>(extractedObjs.size());
+
+	if (extractedObjs.empty()) {
+		op.miss();
+	}
+	return extractedObjs;
+}
+
+template <typename T_KEY>
+inline std::optional<amazoom::Item> amazoom::ColumnarMultiHashmap<T_KEY>::extractLightest(const T_KEY& key) {
+	return extractByWeight(key, std::numeric_limits<std::uint64_t>::max(), std::less<std::uint32_t>());
+}
+
+template <typename T_KEY>
+inline std::optional<amazoom::Item> amazoom::ColumnarMultiHashmap<T_KEY>::extractHeaviest(const T_KEY& key) {
+	return extractByWeight(key, std::numeric_limits<std::uint64_t>::max(), std::greater<std::uint32_t>());
+}
+
+template <typename T_KEY>
+inline std::optional<amazoom::Item> amazoom::ColumnarMultiHashmap<T_KEY>::extractWithWeightAtMost(const T_KEY& key, float maxWeight) {
+	if (!(maxWeight >= 0.0f)) {
+		return std::nullopt;
+	}
+
+	//a stored weight w / WEIGHT_SCALE is at most maxWeight exactly when w is at most this
+	const double maxRawWeight = std::floor(static_cast<double>(maxWeight) * PackedItem::WEIGHT_SCALE);
+	return extractByWeight(key, static_cast<std::uint64_t>(std::min(maxRawWeight, static_cast<double>(PackedItem::MAX_RAW_WEIGHT))),
+		std::greater<std::uint32_t>());
+}
+
+template <typename T_KEY>
+template <class T_BETTER>
+inline std::optional<amazoom::Item> amazoom::ColumnarMultiHashmap<T_KEY>::extractByWeight(
+	const T_KEY& key, std::uint64_t maxRawWeight, const T_BETTER& isBetter) {
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found == storInternal_.end()) {
+		op.miss();
+		return std::nullopt;
+	}
+	Columns& columns = found->second;
+
+	const std::vector<std::uint32_t>& weights = columns.weights;
+	std::size_t chosen = weights.size();
+	for (std::size_t i = 0; i < weights.size(); i++) {
+		if (weights[i] <= maxRawWeight && (chosen == weights.size() || isBetter(weights[i], weights[chosen]))) {
+			chosen = i;
+		}
+	}
+
+	if (chosen == weights.size()) {
+		op.miss();
+		return std::nullopt;
+	}
+	currentNumItems--;
+	return columns.swapAndPop(chosen).toItem();
+}
+
+template <typename T_KEY>
+inline std::vector<amazoom::PackedItem> amazoom::ColumnarMultiHashmap<T_KEY>::extractPacked(const T_KEY& key, int count) {
+	std::vector<PackedItem> extracted;
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT_BATCH);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (count <= 0 || found == storInternal_.end() || found->second.size() == 0) {
+		op.miss();
+		return extracted;
+	}
+	Columns& columns = found->second;
+
+	//take the newest items straight off the end, in the order extractItems would
+	const std::size_t toExtract = std::min(static_cast<std::size_t>(count), columns.size());
+	const std::size_t first = columns.size() - toExtract;
+	extracted.reserve(toExtract);
+	for (std::size_t i = columns.size(); i-- > first;) {
+		extracted.push_back(columns.at(i));
+	}
+	columns.ids.resize(first);
+	columns.weights.resize(first);
+	columns.flags.resize(first);
+	currentNumItems -= static_cast<int>(toExtract);
+
+	return extracted;
+}
+
+template <typename T_KEY>
+inline void amazoom::ColumnarMultiHashmap<T_KEY>::insertPacked(const T_KEY& key, const std::vector<PackedItem>& packed) {
+	MeteredOp op(metrics_, MetricsOp::INSERT_BATCH);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	Columns& columns = storInternal_[key];
+	columns.reserve(columns.size() + packed.size());
+	for (const PackedItem& item : packed) {
+		columns.push(item);
+	}
+	currentNumItems += static_cast<int>(packed.size());
+}
+
+template <typename T_KEY>
+template <class T_VISITOR>
+inline void amazoom::ColumnarMultiHashmap<T_KEY>::visitItems(const T_VISITOR& visit) const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	for (const auto& keyColumns : storInternal_) {
+		for (std::size_t i = 0; i < keyColumns.second.size(); i++) {
+			const Item obj(keyColumns.second.at(i).toItem());
+			visit(keyColumns.first, obj);
+		}
+	}
+}
+
+template <typename T_KEY>
+inline double amazoom::ColumnarMultiHashmap<T_KEY>::totalWeight(const T_KEY& key) const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found == storInternal_.end()) {
+		return 0.0;
+	}
+	const std::vector<std::uint32_t>& weights = found->second.weights;
+	return static_cast<double>(WeightAggregates::sumRaw(weights.data(), weights.size())) / PackedItem::WEIGHT_SCALE;
+}
+
+template <typename T_KEY>
+inline int amazoom::ColumnarMultiHashmap<T_KEY>::countWhere(const T_KEY& key, float minWeight, float maxWeight) const {
+	if (!(minWeight <= maxWeight)) {
+		return 0;
+	}
+
+	//stored weights are w / WEIGHT_SCALE, so the bounds become the smallest and largest w they admit
+	const double minRaw = std::max(0.0, std::ceil(static_cast<double>(minWeight) * PackedItem::WEIGHT_SCALE));
+	const double maxRaw = std::min(static_cast<double>(PackedItem::MAX_RAW_WEIGHT), std::floor(static_cast<double>(maxWeight) * PackedItem::WEIGHT_SCALE));
+	if (!(minRaw <= maxRaw)) {
+		return 0;
+	}
+
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found == storInternal_.end()) {
+		return 0;
+	}
+	const std::vector<std::uint32_t>& weights = found->second.weights;
+	return static_cast<int>(WeightAggregates::countRawBetween(weights.data(), weights.size(),
+		static_cast<std::uint32_t>(minRaw), static_cast<std::uint32_t>(maxRaw)));
+}
+
+template <typename T_KEY>
+inline std::vector<int> amazoom::ColumnarMultiHashmap<T_KEY>::weightHistogram(const T_KEY& key, float binWidth, int numBins) const {
+	WeightAggregates::checkHistogram(binWidth, numBins);
+	std::vector<int> bins(numBins, 0);
+
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found != storInternal_.end()) {
+		const std::vector<std::uint32_t>& weights = found->second.weights;
+		WeightAggregates::histogramRaw(weights.data(), weights.size(), static_cast<double>(binWidth) * PackedItem::WEIGHT_SCALE, bins);
+	}
+	return bins;
+}
+
+template <typename T_KEY>
+inline amazoom::ContainerMetrics& amazoom::ColumnarMultiHashmap<T_KEY>::getMetrics() const {
+	return metrics_;
+}
+
+template <typename T_KEY>
+inline amazoom::PackedItem amazoom::ColumnarMultiHashmap<T_KEY>::pack(const Item& obj) {
+	const PackedItem packed(obj);
+	if (packed.getWeight() != obj.getWeight()) {
+		throw std::out_of_range("ColumnarMultiHashmap cannot store weight " + std::to_string(obj.getWeight()) +
+			" exactly; weights must be whole multiples of 1/" + std::to_string(PackedItem::WEIGHT_SCALE) + " kg");
+	}
+	return packed;
+}
+
+template <typename T_KEY>
+inline void amazoom::ColumnarMultiHashmap<T_KEY>::Columns::reserve(std::size_t capacity) {
+	//at least doubles, as push_back would, so that many small insertions stay amortized O(1).
+	//Each column is checked on its own, so that one that failed to grow last time grows now
+	const auto grow = [capacity](auto& column) {
+		if (column.capacity() < capacity) {
+			column.reserve(std::max(capacity, 2 * column.capacity()));
+		}
+	};
+	grow(ids);
+	grow(weights);
+	grow(flags);
+}
+
+template <typename T_KEY>
+inline void amazoom::ColumnarMultiHashmap<T_KEY>::Columns::push(const PackedItem& packed) {
+	ids.push_back(packed.getID());
+	weights.push_back(packed.getRawWeight());
+	flags.push_back(static_cast<std::uint8_t>(packed.getFlags()));
+}
+
+template <typename T_KEY>
+inline amazoom::PackedItem amazoom::ColumnarMultiHashmap<T_KEY>::Columns::at(std::size_t index) const {
+	return PackedItem::fromFields(ids[index], weights[index], flags[index]);
+}
+
+template <typename T_KEY>
+inline amazoom::PackedItem amazoom::ColumnarMultiHashmap<T_KEY>::Columns::swapAndPop(std::size_t index) {
+	const PackedItem extracted(at(index));
+
+	ids[index] = ids.back();
+	weights[index] = weights.back();
+	flags[index] = flags.back();
+	ids.pop_back();
+	weights.pop_back();
+	flags.pop_back();
+
+	return extracted;
+}
+
+#endif
@@ -0,0 +1,96 @@
+#include "columnar_multi_hashmap_impl.h"
+
+amazoom::ColumnarMultiHashmapImpl::ColumnarMultiHashmapImpl() {}
+
+amazoom::ColumnarMultiHashmapImpl::~ColumnarMultiHashmapImpl() {}
+
+amazoom::Item amazoom::ColumnarMultiHashmapImpl::extractItem(const Key & key) {
+	return storage_.extractItem(key);
+}
+
+amazoom::Item amazoom::ColumnarMultiHashmapImpl::extractItem(const Key & key, CompareFxn compareFxn) {
+	return storage_.extractItem(key, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::ColumnarMultiHashmapImpl::tryExtractItem(const Key & key) {
+	return storage_.tryExtractItem(key);
+}
+
+std::optional<amazoom::Item> amazoom::ColumnarMultiHashmapImpl::tryExtractItem(const Key & key, CompareFxn compareFxn) {
+	return storage_.tryExtractItem(key, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::ColumnarMultiHashmapImpl::extractItemWait(const Key & key, std::chrono::milliseconds timeout) {
+	return waiters_.extractItemWait(key, timeout);
+}
+
+std::future<amazoom::Item> amazoom::ColumnarMultiHashmapImpl::extractItemAsync(const Key & key) {
+	return waiters_.extractItemAsync(key);
+}
+
+void amazoom::ColumnarMultiHashmapImpl::insertItem(Key key, Item & obj) {
+	storage_.insertItem(key, obj);
+	waiters_.notifyInserted(key);
+}
+
+void amazoom::ColumnarMultiHashmapImpl::insertItems(std::vector<std::pair<Key, Item>>& objs) {
+	storage_.insertItems(objs);
+	waiters_.notifyInserted(objs);
+}
+
+void amazoom::ColumnarMultiHashmapImpl::insertPacked(const Key & key, const std::vector<PackedItem>& packed) {
+	storage_.insertPacked(key, packed);
+	waiters_.notifyInserted(key);
+}
+
+std::vector<amazoom::Item> amazoom::ColumnarMultiHashmapImpl::extractItems(const Key & key, int count) {
+	return storage_.extractItems(key, count);
+}
+
+std::vector<amazoom::Item> amazoom::ColumnarMultiHashmapImpl::extractItems(const Key & key, int count, CompareFxn compareFxn) {
+	return storage_.extractItems(key, count, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::ColumnarMultiHashmapImpl::extractLightest(const Key & key) {
+	return storage_.extractLightest(key);
+}
+
+std::optional<amazoom::Item> amazoom::ColumnarMultiHashmapImpl::extractHeaviest(const Key & key) {
+	return storage_.extractHeaviest(key);
+}
+
+std::optional<amazoom::Item> amazoom::ColumnarMultiHashmapImpl::extractWithWeightAtMost(const Key & key, float maxWeight) {
+	return storage_.extractWithWeightAtMost(key, maxWeight);
+}
+
+bool amazoom::ColumnarMultiHashmapImpl::doesContainObj(const Key key) {
+	return storage_.doesContainObj(key);
+}
+
+bool amazoom::ColumnarMultiHashmapImpl::doesContainObj(const Key key, CompareFxn compareFxn) {
+	return storage_.doesContainObj(key, compareFxn);
+}
+
+int amazoom::ColumnarMultiHashmapImpl::getNumItems() {
+	return storage_.getNumItems();
+}
+
+int amazoom::ColumnarMultiHashmapImpl::countItems(const Key key) {
+	return storage_.countItems(key);
+}
+
+void amazoom::ColumnarMultiHashmapImpl::visitItems(const std::function<void(const Key key, const Item& obj)> visitor) {
+	storage_.visitItems(visitor);
+}
+
+double amazoom::ColumnarMultiHashmapImpl::totalWeight(const Key key) {
+	return storage_.totalWeight(key);
+}
+
+int amazoom::ColumnarMultiHashmapImpl::countWhere(const Key key, float minWeight, float maxWeight) {
+	return storage_.countWhere(key, minWeight, maxWeight);
+}
+
+std::vector<int> amazoom::ColumnarMultiHashmapImpl::weightHistogram(const Key key, float binWidth, int numBins) {
+	return storage_.weightHistogram(key, binWidth, numBins);
+}
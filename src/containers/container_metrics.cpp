@@ -0,0 +1,303 @@
+#include "container_metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+#ifdef AMAZOOM_METRICS
+#include <unordered_set>
+#endif
+
+namespace {
+
+const double PERCENTILES[] = { 0.50, 0.99, 0.999 };
+const char* const PERCENTILE_NAMES[] = { "p50", "p99", "p999" };
+
+//histogram buckets exported to Prometheus, as powers of two in ns (128 ns to 2.1 s)
+const int FIRST_PROMETHEUS_BUCKET = 7;
+const int LAST_PROMETHEUS_BUCKET = 31;
+
+void histogramToJson(std::ostringstream& out, const amazoom::HistogramSnapshot& histogram) {
+	out << "{\"count\":" << histogram.count << ",\"total_ns\":" << histogram.totalNs;
+	for (int i = 0; i < 3; i++) {
+		out << ",\"" << PERCENTILE_NAMES[i] << "_ns\":" << histogram.percentileNs(PERCENTILES[i]);
+	}
+
+	//only the buckets up to the last non-empty one, as [upper bound in ns, count] pairs
+	int lastBucket = amazoom::HistogramSnapshot::NUM_BUCKETS - 1;
+	while (lastBucket >= 0 && histogram.buckets[lastBucket] == 0) {
+		lastBucket--;
+	}
+	out << ",\"buckets\":[";
+	for (int bucket = 0; bucket <= lastBucket; bucket++) {
+		out << (bucket > 0 ? "," : "") << "[" << amazoom::HistogramSnapshot::bucketBoundNs(bucket) << "," << histogram.buckets[bucket] << "]";
+	}
+	out << "]}";
+}
+
+//names are generated or set by the user; escape the characters that would break the output
+std::string escaped(const std::string& name) {
+	std::string result;
+	for (char c : name) {
+		if (c == '"' || c == '\\') {
+			result += '\\';
+		}
+		result += c == '\n' ? ' ' : c;
+	}
+	return result;
+}
+
+std::string seconds(std::uint64_t ns) {
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.9g", ns / 1.0e9);
+	return buffer;
+}
+
+void histogramToPrometheus(std::ostringstream& out, const char* metric, const std::string& labels,
+	const amazoom::HistogramSnapshot& histogram) {
+
+	//Prometheus buckets are cumulative and inclusive. Every fourfold step from 128 ns to about 2 s is
+	//exported rather than every power of two, to keep the output of a large warehouse manageable
+	std::uint64_t cumulative = 0;
+	int bucket = 0;
+	for (int bound = FIRST_PROMETHEUS_BUCKET; bound <= LAST_PROMETHEUS_BUCKET; bound += 2) {
+		for (; bucket <= bound; bucket++) {
+			cumulative += histogram.buckets[bucket];
+		}
+		//durations in buckets up to bound are below 2^bound ns
+		out << metric << "_bucket{" << labels << ",le=\"" << seconds(amazoom::HistogramSnapshot::bucketBoundNs(bound))
+			<< "\"} " << cumulative << "\n";
+	}
+	out << metric << "_bucket{" << labels << ",le=\"+Inf\"} " << histogram.count << "\n";
+	out << metric << "_sum{" << labels << "} " << seconds(histogram.totalNs) << "\n";
+	out << metric << "_count{" << labels << "} " << histogram.count << "\n";
+}
+
+#ifdef AMAZOOM_METRICS
+struct Registry {
+	boost::mutex mtx;
+	std::unordered_set<amazoom::ContainerMetrics*> metrics;
+	std::uint64_t nextID{ 0 };
+};
+
+Registry& registry() {
+	//intentionally leaked: containers with static storage duration may unregister during exit
+	static Registry* instance = new Registry();
+	return *instance;
+}
+#endif
+}
+
+std::uint64_t amazoom::HistogramSnapshot::bucketBoundNs(int bucket) {
+	return std::uint64_t(1) << bucket;
+}
+
+std::uint64_t amazoom::HistogramSnapshot::percentileNs(double p) const {
+	if (count == 0) {
+		return 0;
+	}
+
+	//1-based rank of the p-th duration
+	const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(p * count + 0.5));
+	std::uint64_t seen = 0;
+	for (int bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+		seen += buckets[bucket];
+		if (seen >= rank) {
+			return bucketBoundNs(bucket);
+		}
+	}
+	return bucketBoundNs(NUM_BUCKETS - 1);
+}
+
+const char* amazoom::metricsOpName(MetricsOp op) {
+	switch (op) {
+	case MetricsOp::INSERT: return "insert";
+	case MetricsOp::INSERT_BATCH: return "insert_batch";
+	case MetricsOp::EXTRACT: return "extract";
+	case MetricsOp::EXTRACT_BATCH: return "extract_batch";
+	case MetricsOp::CONTAINS: return "contains";
+	default: return "unknown";
+	}
+}
+
+#ifdef AMAZOOM_METRICS
+
+void amazoom::LatencyHistogram::record(std::uint64_t ns) {
+	//bucket = bit width of ns, so bucket i holds [2^(i-1), 2^i)
+	int bucket = 0;
+	for (std::uint64_t remaining = ns; remaining != 0 && bucket < HistogramSnapshot::NUM_BUCKETS - 1; remaining >>= 1) {
+		bucket++;
+	}
+	buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+	totalNs_.fetch_add(ns, std::memory_order_relaxed);
+}
+
+amazoom::HistogramSnapshot amazoom::LatencyHistogram::snapshot() const {
+	//buckets are read one by one while others record, so count is taken as their sum to stay consistent
+	HistogramSnapshot result;
+	for (int bucket = 0; bucket < HistogramSnapshot::NUM_BUCKETS; bucket++) {
+		result.buckets[bucket] = buckets_[bucket].load(std::memory_order_relaxed);
+		result.count += result.buckets[bucket];
+	}
+	result.totalNs = totalNs_.load(std::memory_order_relaxed);
+	return result;
+}
+
+amazoom::ContainerMetrics::ContainerMetrics(const char* kind) {
+	std::uint64_t id = MetricsRegistry::add(this);
+	name_ = std::string(kind) + "_" + std::to_string(id);
+}
+
+amazoom::ContainerMetrics::~ContainerMetrics() {
+	MetricsRegistry::remove(this);
+}
+
+void amazoom::ContainerMetrics::recordOp(MetricsOp op, std::uint64_t ns, bool hit) {
+	OpStats& stats = ops_[static_cast<int>(op)];
+	stats.latency.record(ns);
+	if (!hit) {
+		stats.misses.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void amazoom::ContainerMetrics::recordLock(std::uint64_t waitNs, std::uint64_t holdNs) {
+	lockWait_.record(waitNs);
+	lockHold_.record(holdNs);
+}
+
+void amazoom::ContainerMetrics::setName(const std::string& name) {
+	boost::unique_lock<boost::mutex> lock(nameMtx_);
+	name_ = name;
+}
+
+std::string amazoom::ContainerMetrics::getName() const {
+	boost::unique_lock<boost::mutex> lock(nameMtx_);
+	return name_;
+}
+
+amazoom::MetricsSnapshot amazoom::ContainerMetrics::snapshot() const {
+	MetricsSnapshot result;
+	result.name = getName();
+	for (int op = 0; op < NUM_METRICS_OPS; op++) {
+		result.ops[op].misses = ops_[op].misses.load(std::memory_order_relaxed);
+		result.ops[op].latency = ops_[op].latency.snapshot();
+	}
+	result.lockWait = lockWait_.snapshot();
+	result.lockHold = lockHold_.snapshot();
+	return result;
+}
+
+std::uint64_t amazoom::MetricsRegistry::add(ContainerMetrics* metrics) {
+	Registry& reg = registry();
+	boost::unique_lock<boost::mutex> lock(reg.mtx);
+	reg.metrics.insert(metrics);
+	return reg.nextID++;
+}
+
+void amazoom::MetricsRegistry::remove(ContainerMetrics* metrics) {
+	Registry& reg = registry();
+	boost::unique_lock<boost::mutex> lock(reg.mtx);
+	reg.metrics.erase(metrics);
+}
+
+std::vector<amazoom::MetricsSnapshot> amazoom::MetricsRegistry::snapshot() {
+	Registry& reg = registry();
+	std::vector<MetricsSnapshot> snapshots;
+
+	//held throughout, so no container can unregister (and be destroyed) while it is being read
+	boost::unique_lock<boost::mutex> lock(reg.mtx);
+	snapshots.reserve(reg.metrics.size());
+	for (ContainerMetrics* metrics : reg.metrics) {
+		snapshots.push_back(metrics->snapshot());
+	}
+	lock.unlock();
+
+	std::sort(snapshots.begin(), snapshots.end(),
+		[](const MetricsSnapshot& a, const MetricsSnapshot& b) { return a.name < b.name; });
+	return snapshots;
+}
+
+#else
+
+std::vector<amazoom::MetricsSnapshot> amazoom::MetricsRegistry::snapshot() {
+	return std::vector<MetricsSnapshot>();
+}
+
+#endif
+
+std::string amazoom::MetricsRegistry::toJson() {
+	return toJson(snapshot());
+}
+
+std::string amazoom::MetricsRegistry::toJson(const std::vector<MetricsSnapshot>& snapshots) {
+	std::ostringstream out;
+	out << "{\"containers\":[";
+	for (std::size_t i = 0; i < snapshots.size(); i++) {
+		const MetricsSnapshot& snapshot = snapshots[i];
+		out << (i > 0 ? "," : "") << "{\"name\":\"" << escaped(snapshot.name) << "\",\"ops\":{";
+
+		for (int op = 0; op < NUM_METRICS_OPS; op++) {
+			out << (op > 0 ? "," : "") << "\"" << metricsOpName(static_cast<MetricsOp>(op)) << "\":{\"calls\":"
+				<< snapshot.ops[op].latency.count << ",\"misses\":" << snapshot.ops[op].misses << ",\"latency\":";
+			histogramToJson(out, snapshot.ops[op].latency);
+			out << "}";
+		}
+
+		out << "},\"lock\":{\"acquisitions\":" << snapshot.lockWait.count << ",\"wait\":";
+		histogramToJson(out, snapshot.lockWait);
+		out << ",\"hold\":";
+		histogramToJson(out, snapshot.lockHold);
+		out << "}}";
+	}
+	out << "]}";
+	return out.str();
+}
+
+std::string amazoom::MetricsRegistry::toPrometheus() {
+	return toPrometheus(snapshot());
+}
+
+std::string amazoom::MetricsRegistry::toPrometheus(const std::vector<MetricsSnapshot>& snapshots) {
+	std::ostringstream out;
+
+	out << "# HELP amazoom_container_ops_total Container operations, by container and operation.\n"
+		<< "# TYPE amazoom_container_ops_total counter\n";
+	for (const MetricsSnapshot& snapshot : snapshots) {
+		for (int op = 0; op < NUM_METRICS_OPS; op++) {
+			out << "amazoom_container_ops_total{container=\"" << escaped(snapshot.name) << "\",op=\""
+				<< metricsOpName(static_cast<MetricsOp>(op)) << "\"} " << snapshot.ops[op].latency.count << "\n";
+		}
+	}
+
+	out << "# HELP amazoom_container_misses_total Operations that found nothing, did not fit, or threw.\n"
+		<< "# TYPE amazoom_container_misses_total counter\n";
+	for (const MetricsSnapshot& snapshot : snapshots) {
+		for (int op = 0; op < NUM_METRICS_OPS; op++) {
+			out << "amazoom_container_misses_total{container=\"" << escaped(snapshot.name) << "\",op=\""
+				<< metricsOpName(static_cast<MetricsOp>(op)) << "\"} " << snapshot.ops[op].misses << "\n";
+		}
+	}
+
+	out << "# HELP amazoom_container_op_latency_seconds Latency of container operations.\n"
+		<< "# TYPE amazoom_container_op_latency_seconds histogram\n";
+	for (const MetricsSnapshot& snapshot : snapshots) {
+		for (int op = 0; op < NUM_METRICS_OPS; op++) {
+			std::string labels = "container=\"" + escaped(snapshot.name) + "\",op=\"" + metricsOpName(static_cast<MetricsOp>(op)) + "\"";
+			histogramToPrometheus(out, "amazoom_container_op_latency_seconds", labels, snapshot.ops[op].latency);
+		}
+	}
+
+	out << "# HELP amazoom_container_lock_wait_seconds Time spent waiting for a container mutex.\n"
+		<< "# TYPE amazoom_container_lock_wait_seconds histogram\n";
+	for (const MetricsSnapshot& snapshot : snapshots) {
+		histogramToPrometheus(out, "amazoom_container_lock_wait_seconds", "container=\"" + escaped(snapshot.name) + "\"", snapshot.lockWait);
+	}
+
+	out << "# HELP amazoom_container_lock_hold_seconds Time a container mutex was held per acquisition.\n"
+		<< "# TYPE amazoom_container_lock_hold_seconds histogram\n";
+	for (const MetricsSnapshot& snapshot : snapshots) {
+		histogramToPrometheus(out, "amazoom_container_lock_hold_seconds", "container=\"" + escaped(snapshot.name) + "\"", snapshot.lockHold);
+	}
+
+	return out.str();
+}
@@ -0,0 +1,223 @@
+#ifndef AMAZOOM_CONTAINERS_CONTAINER_METRICS_H_
+#define AMAZOOM_CONTAINERS_CONTAINER_METRICS_H_
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef AMAZOOM_METRICS
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <utility>
+
+#include "boost/thread.hpp"
+#endif
+
+namespace amazoom {
+/* Opt-in instrumentation for the containers. Build with AMAZOOM_METRICS defined to record, per container:
+*  calls, misses and a latency histogram for every operation, and how long each acquisition of the
+*  container's mutex waited for it and then held it. Without AMAZOOM_METRICS, ContainerMetrics,
+*  MeteredOp and MeteredLock are empty inline no-ops and MeteredLock is the plain boost lock, so
+*  nothing is recorded and nothing is paid.
+*
+*  Every instrumented container registers itself with MetricsRegistry for its lifetime;
+*  MetricsRegistry::toJson and toPrometheus dump all of them at once.
+*/
+
+enum class MetricsOp { INSERT, INSERT_BATCH, EXTRACT, EXTRACT_BATCH, CONTAINS, NUM_OPS };
+
+const int NUM_METRICS_OPS = static_cast<int>(MetricsOp::NUM_OPS);
+
+//Point-in-time copy of a latency histogram. Bucket i counts durations below 2^i ns that did not fit bucket i - 1
+struct HistogramSnapshot {
+	enum { NUM_BUCKETS = 40 }; //the last bucket also takes everything above 2^39 ns (about 9 minutes)
+
+	std::uint64_t count{ 0 };
+	std::uint64_t totalNs{ 0 };
+	std::array<std::uint64_t, NUM_BUCKETS> buckets{};
+
+	//exclusive upper bound, in ns, of the durations counted in bucket
+	static std::uint64_t bucketBoundNs(int bucket);
+
+	//upper bound of the bucket holding the p-th fraction of durations (p in [0, 1]); 0 if nothing was recorded
+	std::uint64_t percentileNs(double p) const;
+};
+
+struct OpSnapshot {
+	std::uint64_t misses{ 0 }; //nothing matched the key, the item did not fit, or the operation threw
+	HistogramSnapshot latency; //latency.count is the number of calls
+};
+
+struct MetricsSnapshot {
+	std::string name;
+	std::array<OpSnapshot, NUM_METRICS_OPS> ops;
+	HistogramSnapshot lockWait; //lockWait.count is the number of acquisitions
+	HistogramSnapshot lockHold;
+};
+
+const char* metricsOpName(MetricsOp op);
+
+#ifdef AMAZOOM_METRICS
+
+class LatencyHistogram {
+public:
+	void record(std::uint64_t ns);
+	HistogramSnapshot snapshot() const;
+
+private:
+	std::atomic<std::uint64_t> totalNs_{ 0 };
+	std::array<std::atomic<std::uint64_t>, HistogramSnapshot::NUM_BUCKETS> buckets_{};
+};
+
+//Per container statistics. All recording is lock-free (relaxed atomic increments)
+class ContainerMetrics {
+public:
+	//kind names the container type; the registry appends a unique number, e.g. "box_3"
+	explicit ContainerMetrics(const char* kind);
+	~ContainerMetrics();
+
+	ContainerMetrics(const ContainerMetrics&) = delete;
+	ContainerMetrics& operator=(const ContainerMetrics&) = delete;
+
+	void recordOp(MetricsOp op, std::uint64_t ns, bool hit);
+	void recordLock(std::uint64_t waitNs, std::uint64_t holdNs);
+
+	//replaces the generated name, e.g. with the container's location in the warehouse
+	void setName(const std::string& name);
+	std::string getName() const;
+
+	MetricsSnapshot snapshot() const;
+
+private:
+	struct OpStats {
+		std::atomic<std::uint64_t> misses{ 0 };
+		LatencyHistogram latency;
+	};
+
+	std::array<OpStats, NUM_METRICS_OPS> ops_;
+	LatencyHistogram lockWait_;
+	LatencyHistogram lockHold_;
+
+	mutable boost::mutex nameMtx_;
+	std::string name_;
+};
+
+//Times one container operation from construction to destruction. Leaving through an exception counts as a miss
+class MeteredOp {
+public:
+	MeteredOp(ContainerMetrics& metrics, MetricsOp op)
+		: metrics_(metrics), op_(op), uncaught_(std::uncaught_exceptions()), start_(std::chrono::steady_clock::now()) {}
+
+	~MeteredOp() {
+		const bool hit = !missed_ && std::uncaught_exceptions() == uncaught_;
+		metrics_.recordOp(op_, elapsedNs(start_), hit);
+	}
+
+	MeteredOp(const MeteredOp&) = delete;
+	MeteredOp& operator=(const MeteredOp&) = delete;
+
+	void miss() { missed_ = true; }
+
+	static std::uint64_t elapsedNs(std::chrono::steady_clock::time_point since) {
+		return static_cast<std::uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - since).count());
+	}
+
+private:
+	ContainerMetrics& metrics_;
+	const MetricsOp op_;
+	const int uncaught_;
+	const std::chrono::steady_clock::time_point start_;
+	bool missed_{ false };
+};
+
+/* A boost lock (unique_lock, shared_lock) that records how long it waited for the mutex and,
+*  when destroyed, how long it held it. Use it in place of T_LOCK(mtx).
+*/
+template <class T_LOCK>
+class MeteredLock : public T_LOCK {
+public:
+	MeteredLock(typename T_LOCK::mutex_type& mtx, ContainerMetrics& metrics)
+		: T_LOCK(mtx, boost::defer_lock), metrics_(&metrics) {
+		//an uncontended acquisition counts as no wait, which saves reading the clock before it
+		if (T_LOCK::try_lock()) {
+			acquired_ = std::chrono::steady_clock::now();
+			return;
+		}
+		std::chrono::steady_clock::time_point requested(std::chrono::steady_clock::now());
+		T_LOCK::lock();
+		acquired_ = std::chrono::steady_clock::now();
+		waitNs_ = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(acquired_ - requested).count());
+	}
+
+	MeteredLock(MeteredLock&& other)
+		: T_LOCK(std::move(static_cast<T_LOCK&>(other))), metrics_(other.metrics_), waitNs_(other.waitNs_), acquired_(other.acquired_) {}
+
+	~MeteredLock() {
+		if (this->owns_lock()) {
+			metrics_->recordLock(waitNs_, MeteredOp::elapsedNs(acquired_));
+		}
+	}
+
+private:
+	ContainerMetrics* metrics_;
+	std::uint64_t waitNs_{ 0 };
+	std::chrono::steady_clock::time_point acquired_;
+};
+
+#else
+
+class ContainerMetrics {
+public:
+	explicit ContainerMetrics(const char*) {}
+
+	void recordOp(MetricsOp, std::uint64_t, bool) {}
+	void recordLock(std::uint64_t, std::uint64_t) {}
+
+	void setName(const std::string&) {}
+	std::string getName() const { return std::string(); }
+
+	MetricsSnapshot snapshot() const { return MetricsSnapshot(); }
+};
+
+class MeteredOp {
+public:
+	MeteredOp(ContainerMetrics&, MetricsOp) {}
+	void miss() {}
+};
+
+template <class T_LOCK>
+class MeteredLock : public T_LOCK {
+public:
+	MeteredLock(typename T_LOCK::mutex_type& mtx, ContainerMetrics&) : T_LOCK(mtx) {}
+};
+
+#endif
+
+//Every live ContainerMetrics. Empty unless built with AMAZOOM_METRICS
+class MetricsRegistry {
+public:
+	static std::vector<MetricsSnapshot> snapshot();
+
+	//{"containers":[{"name":...,"ops":{"insert":{"calls":...,"misses":...,"latency":{"p50_ns":...}},...},"lock":{...}},...]}
+	static std::string toJson();
+	static std::string toJson(const std::vector<MetricsSnapshot>& snapshots);
+
+	//Prometheus text exposition format; latencies are histograms in seconds, labelled by container and op
+	static std::string toPrometheus();
+	static std::string toPrometheus(const std::vector<MetricsSnapshot>& snapshots);
+
+#ifdef AMAZOOM_METRICS
+private:
+	friend class ContainerMetrics;
+
+	//returns a number unique among registrations, used to name the container
+	static std::uint64_t add(ContainerMetrics* metrics);
+	static void remove(ContainerMetrics* metrics);
+#endif
+};
+}
+
+#endif
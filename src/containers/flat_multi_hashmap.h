@@ -0,0 +1,425 @@
+#ifndef AMAZOOM_CONTAINERS_FLAT_MULTI_HASHMAP_H_
+#define AMAZOOM_CONTAINERS_FLAT_MULTI_HASHMAP_H_
+
+#include <unordered_map>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <utility>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <limits>
+
+#include "containers/container_metrics.h"
+#include "containers/multi_hashmap_exceptions.h"
+#include "boost/thread.hpp"
+
+namespace amazoom {
+/* A multihashmap that stores all objects sharing a key contiguously in one vector instead of a
+*  linked list of individually allocated nodes. Scans over a key touch consecutive memory and the
+*  only per-object cost is the object itself. Extraction swaps the found object with the last one
+*  and pops it, so the order of objects under a key is not preserved.
+*  O(1) average case insertion and extraction by key, O(N) for filtered extraction over N same-key objects.
+*  Thread-safe. Allows multiple simutaneous reads, and single extraction/insertions
+*/
+template <typename T_KEY, class T_OBJ>
+class FlatMultiHashmap {
+
+	typedef std::vector<T_OBJ> Bucket;
+	typedef std::unordered_map<T_KEY, Bucket> Map;
+	typedef std::function<bool(const T_OBJ& obj)> CompareFxn;
+
+public:
+	FlatMultiHashmap();
+
+	FlatMultiHashmap(const FlatMultiHashmap<T_KEY, T_OBJ>& hashmap) = delete;
+	FlatMultiHashmap<T_KEY, T_OBJ>& operator=(const FlatMultiHashmap<T_KEY, T_OBJ>& hashmap) = delete;
+
+	~FlatMultiHashmap();
+
+	int getNumItems() const; //returns how many items are currently stored
+
+	int countItems(const T_KEY& key) const; //returns how many items are currently stored by key
+
+	//Inserts an object into the container indexed by a key.
+	void insertItem(T_KEY key, T_OBJ& obj);
+
+	//Same semantics as MultiHashmap::doesContainObj
+	bool doesContainObj(const T_KEY& key, const CompareFxn compareFxn) const;
+	bool doesContainObj(const T_KEY& key) const;
+
+	/*Extracts the most recently stored object matching key. 
+	* If no such object can be found MultiHashMapNoSuchObj is thrown*/
+	T_OBJ extractItem(const T_KEY& key);
+
+	/*Extracts an object matching key that also satisfies compareFxn, searching from the most
+	* recently stored object. If no such object can be found MultiHashMapNoSuchObj is thrown*/
+	T_OBJ extractItem(const T_KEY& key, const CompareFxn compareFxn);
+
+	//Same as extractItem, but returns an empty optional instead of throwing when nothing matches
+	std::optional<T_OBJ> tryExtractItem(const T_KEY& key);
+	std::optional<T_OBJ> tryExtractItem(const T_KEY& key, const CompareFxn compareFxn);
+
+	//Compile-time predicate versions of doesContainObj and tryExtractItem, see MultiHashmap
+	template <class T_PRED>
+	bool containsIf(const T_KEY& key, const T_PRED& pred) const;
+
+	template <class T_PRED>
+	std::optional<T_OBJ> extractIf(const T_KEY& key, const T_PRED& pred);
+
+	//Same semantics as the MultiHashmap batch functions; one lock acquisition per batch
+	void insertItems(std::vector<std::pair<T_KEY, T_OBJ>>& objs);
+	std::vector<T_OBJ> extractItems(const T_KEY& key, int count);
+	std::vector<T_OBJ> extractItems(const T_KEY& key, int count, const CompareFxn compareFxn);
+
+	/*Same semantics as the MultiHashmap weight functions. There is no weight index here; the key's
+	* bucket is scanned, which is a linear pass over contiguous memory. T_OBJ must provide getWeight() const.
+	*/
+	std::optional<T_OBJ> extractLightest(const T_KEY& key);
+	std::optional<T_OBJ> extractHeaviest(const T_KEY& key);
+	std::optional<T_OBJ> extractWithWeightAtMost(const T_KEY& key, float maxWeight);
+
+	//Same semantics as MultiHashmap::visitItems
+	template <class T_VISITOR>
+	void visitItems(const T_VISITOR& visit) const;
+
+	template <class T_VISITOR>
+	void visitItems(const T_KEY& key, const T_VISITOR& visit) const;
+
+	//operation and mtx_ statistics, recorded only when built with AMAZOOM_METRICS. See ContainerMetrics
+	ContainerMetrics& getMetrics() const;
+
+private:
+	//removes bucket[index] in O(1) by moving the last object into its slot
+	static T_OBJ swapAndPop(Bucket& bucket, std::size_t index);
+
+	//extracts the object of key's bucket that isBetter prefers over all others, among those weighing at most maxWeight
+	template <class T_BETTER>
+	std::optional<T_OBJ> extractByWeight(const T_KEY& key, float maxWeight, const T_BETTER& isBetter);
+
+	int currentNumItems{ 0 }; //how many items are stored
+
+	//Buckets are kept when they become empty so a key that is restocked reuses its capacity
+	Map storInternal_;
+
+	//class level mutex. Separates reading and writing operations
+	mutable boost::shared_mutex mtx_;
+
+	mutable ContainerMetrics metrics_{ "flat_multi_hashmap" };
+};
+}
+
+template <typename T_KEY, class T_OBJ>
+inline amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::FlatMultiHashmap() {}
+
+template <typename T_KEY, class T_OBJ>
+inline amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::~FlatMultiHashmap() {}
+
+template <typename T_KEY, class T_OBJ>
+inline int amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::getNumItems() const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	return currentNumItems;
+}
+
+template <typename T_KEY, class T_OBJ>
+inline int amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::countItems(const T_KEY& key) const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	auto found = storInternal_.find(key);
+	return found == storInternal_.end() ? 0 : static_cast<int>(found->second.size());
+}
+
+template <typename T_KEY, class T_OBJ>
+inline void amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::insertItem(T_KEY key, T_OBJ& obj) {
+	MeteredOp op(metrics_, MetricsOp::INSERT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	//operator[] creates the bucket on first use, a single lookup either way
+	storInternal_[key].push_back(std::move(obj));
+	currentNumItems++;
+}
+
+template <typename T_KEY, class T_OBJ>
+inline bool amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::doesContainObj(
+	const T_KEY& key, const CompareFxn compareFxn) const {
+	//mutex inside
+	return containsIf(key, compareFxn);
+}
+
+template <typename T_KEY, class T_OBJ>
+template <class T_PRED>
+inline bool amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::containsIf(const T_KEY& key, const T_PRED& pred) const {
+
+	MeteredOp op(metrics_, MetricsOp::CONTAINS);
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found != storInternal_.end()) {
+		for (const T_OBJ& obj : found->second) {
+			if (pred(obj)) {
+				return true;
+			}
+		}
+	}
+	op.miss();
+	return false;
+}
+
+template <typename T_KEY, class T_OBJ>
+inline bool amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::doesContainObj(const T_KEY& key) const {
+	MeteredOp op(metrics_, MetricsOp::CONTAINS);
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	const bool isFound = found != storInternal_.end() && !found->second.empty();
+	if (!isFound) {
+		op.miss();
+	}
+	return isFound;
+}
+
+template <typename T_KEY, class T_OBJ>
+inline T_OBJ amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::extractItem(const T_KEY& key) {
+	//mutex inside
+	std::optional<T_OBJ> extractedObj(tryExtractItem(key));
+	if (!extractedObj) {
+		std::ostringstream error;
+		error << "Container does not contain object matching key: " << key;
+		throw MultiHashMapNoSuchObj(error.str());
+	}
+	return std::move(*extractedObj);
+}
+
+template <typename T_KEY, class T_OBJ>
+inline T_OBJ amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::extractItem(
+	const T_KEY& key, const CompareFxn compareFxn) {
+	//mutex inside
+	std::optional<T_OBJ> extractedObj(tryExtractItem(key, compareFxn));
+	if (!extractedObj) {
+		std::ostringstream error;
+		error << "Container does not contain object matching special params and key: " << key;
+		throw MultiHashMapNoSuchObj(error.str());
+	}
+	return std::move(*extractedObj);
+}
+
+template <typename T_KEY, class T_OBJ>
+inline std::optional<T_OBJ> amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::tryExtractItem(const T_KEY& key) {
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found == storInternal_.end() || found->second.empty()) {
+		op.miss();
+		return std::nullopt;
+	}
+
+	currentNumItems--;
+	return swapAndPop(found->second, found->second.size() - 1);
+}
+
+template <typename T_KEY, class T_OBJ>
+inline std::optional<T_OBJ> amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::tryExtractItem(
+	const T_KEY& key, const CompareFxn compareFxn) {
+	//mutex inside
+	return extractIf(key, compareFxn);
+}
+
+template <typename T_KEY, class T_OBJ>
+template <class T_PRED>
+inline std::optional<T_OBJ> amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::extractIf(const T_KEY& key, const T_PRED& pred) {
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found != storInternal_.end()) {
+		Bucket& bucket = found->second;
+
+		//newest first, to match the order MultiHashmap hands objects out in
+		for (std::size_t i = bucket.size(); i-- > 0;) {
+			if (pred(bucket[i])) {
+				currentNumItems--;
+				return swapAndPop(bucket, i);
+			}
+		}
+	}
+	op.miss();
+	return std::nullopt;
+}
+
+template <typename T_KEY, class T_OBJ>
+inline void amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::insertItems(std::vector<std::pair<T_KEY, T_OBJ>>& objs) {
+	MeteredOp op(metrics_, MetricsOp::INSERT_BATCH);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	//pallets are usually one item ID, so remember the last bucket instead of hashing every object
+	Bucket* bucket = nullptr;
+	const T_KEY* bucketKey = nullptr;
+	for (std::pair<T_KEY, T_OBJ>& keyObj : objs) {
+		if (bucket == nullptr || !(*bucketKey == keyObj.first)) {
+			auto found = storInternal_.find(keyObj.first);
+			if (found == storInternal_.end()) {
+				found = storInternal_.emplace(keyObj.first, Bucket()).first;
+			}
+			bucket = &found->second;
+			bucketKey = &found->first;
+
+			//a pallet of a single item ID grows its bucket once instead of log(n) times
+			if (bucket->capacity() - bucket->size() < objs.size() && objs.front().first == objs.back().first) {
+				bucket->reserve(bucket->size() + objs.size());
+			}
+		}
+		bucket->push_back(std::move(keyObj.second));
+	}
+	currentNumItems += static_cast<int>(objs.size());
+}
+
+template <typename T_KEY, class T_OBJ>
+inline std::vector<T_OBJ> amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::extractItems(const T_KEY& key, int count) {
+	std::vector<T_OBJ> extractedObjs;
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT_BATCH);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (count <= 0 || found == storInternal_.end()) {
+		op.miss();
+		return extractedObjs;
+	}
+	Bucket& bucket = found->second;
+
+	//take the newest objects straight off the end
+	const std::size_t toExtract = std::min(static_cast<std::size_t>(count), bucket.size());
+	extractedObjs.reserve(toExtract);
+	for (std::size_t i = 0; i < toExtract; i++) {
+		extractedObjs.push_back(std::move(bucket.back()));
+		bucket.pop_back();
+	}
+	currentNumItems -= static_cast<int>(toExtract);
+
+	if (extractedObjs.empty()) {
+		op.miss();
+	}
+	return extractedObjs;
+}
+
+template <typename T_KEY, class T_OBJ>
+inline std::vector<T_OBJ> amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::extractItems(
+	const T_KEY& key, int count, const CompareFxn compareFxn) {
+
+	std::vector<T_OBJ> extractedObjs;
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT_BATCH);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (count <= 0 || found == storInternal_.end()) {
+		op.miss();
+		return extractedObjs;
+	}
+	Bucket& bucket = found->second;
+
+	//walking backwards, a swapped-in object always comes from a slot already visited
+	for (std::size_t i = bucket.size(); i-- > 0 && static_cast<int>(extractedObjs.size()) < count;) {
+		if (compareFxn(bucket[i])) {
+			extractedObjs.push_back(swapAndPop(bucket, i));
+		}
+	}
+	currentNumItems -= static_cast<int>(extractedObjs.size());
+
+	if (extractedObjs.empty()) {
+		op.miss();
+	}
+	return extractedObjs;
+}
+
+template <typename T_KEY, class T_OBJ>
+inline std::optional<T_OBJ> amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::extractLightest(const T_KEY& key) {
+	return extractByWeight(key, std::numeric_limits<float>::infinity(), std::less<float>());
+}
+
+template <typename T_KEY, class T_OBJ>
+inline std::optional<T_OBJ> amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::extractHeaviest(const T_KEY& key) {
+	return extractByWeight(key, std::numeric_limits<float>::infinity(), std::greater<float>());
+}
+
+template <typename T_KEY, class T_OBJ>
+inline std::optional<T_OBJ> amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::extractWithWeightAtMost(const T_KEY& key, float maxWeight) {
+	return extractByWeight(key, maxWeight, std::greater<float>());
+}
+
+template <typename T_KEY, class T_OBJ>
+template <class T_BETTER>
+inline std::optional<T_OBJ> amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::extractByWeight(
+	const T_KEY& key, float maxWeight, const T_BETTER& isBetter) {
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found == storInternal_.end()) {
+		op.miss();
+		return std::nullopt;
+	}
+	Bucket& bucket = found->second;
+
+	std::size_t chosen = bucket.size();
+	for (std::size_t i = 0; i < bucket.size(); i++) {
+		const float weight = bucket[i].getWeight();
+		if (weight <= maxWeight && (chosen == bucket.size() || isBetter(weight, bucket[chosen].getWeight()))) {
+			chosen = i;
+		}
+	}
+
+	if (chosen == bucket.size()) {
+		op.miss();
+		return std::nullopt;
+	}
+	currentNumItems--;
+	return swapAndPop(bucket, chosen);
+}
+
+template <typename T_KEY, class T_OBJ>
+template <class T_VISITOR>
+inline void amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::visitItems(const T_VISITOR& visit) const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	for (const auto& keyBucket : storInternal_) {
+		for (const T_OBJ& obj : keyBucket.second) {
+			visit(keyBucket.first, obj);
+		}
+	}
+}
+
+template <typename T_KEY, class T_OBJ>
+template <class T_VISITOR>
+inline void amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::visitItems(const T_KEY& key, const T_VISITOR& visit) const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found != storInternal_.end()) {
+		for (const T_OBJ& obj : found->second) {
+			visit(found->first, obj);
+		}
+	}
+}
+
+template <typename T_KEY, class T_OBJ>
+inline amazoom::ContainerMetrics& amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::getMetrics() const {
+	return metrics_;
+}
+
+template <typename T_KEY, class T_OBJ>
+inline T_OBJ amazoom::FlatMultiHashmap<T_KEY, T_OBJ>::swapAndPop(Bucket& bucket, std::size_t index) {
+	T_OBJ extractedObj(std::move(bucket[index]));
+
+	if (index + 1 != bucket.size()) {
+		bucket[index] = std::move(bucket.back());
+	}
+	bucket.pop_back();
+
+	return extractedObj;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include "flat_multi_hashmap_impl.h"
+
+#include "containers/weight_aggregates.h"
+
+amazoom::FlatMultiHashmapImpl::FlatMultiHashmapImpl() {}
+
+amazoom::FlatMultiHashmapImpl::~FlatMultiHashmapImpl() {}
+
+amazoom::Item amazoom::FlatMultiHashmapImpl::extractItem(const Key & key) {
+	return storage_.extractItem(key);
+}
+
+amazoom::Item amazoom::FlatMultiHashmapImpl::extractItem(const Key & key, CompareFxn compareFxn) {
+	return storage_.extractItem(key, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::FlatMultiHashmapImpl::tryExtractItem(const Key & key) {
+	return storage_.tryExtractItem(key);
+}
+
+std::optional<amazoom::Item> amazoom::FlatMultiHashmapImpl::tryExtractItem(const Key & key, CompareFxn compareFxn) {
+	return storage_.tryExtractItem(key, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::FlatMultiHashmapImpl::extractItemWait(const Key & key, std::chrono::milliseconds timeout) {
+	return waiters_.extractItemWait(key, timeout);
+}
+
+std::future<amazoom::Item> amazoom::FlatMultiHashmapImpl::extractItemAsync(const Key & key) {
+	return waiters_.extractItemAsync(key);
+}
+
+void amazoom::FlatMultiHashmapImpl::insertItem(Key key, Item & obj) {
+	storage_.insertItem(key, obj);
+	waiters_.notifyInserted(key);
+}
+
+void amazoom::FlatMultiHashmapImpl::insertItems(std::vector<std::pair<Key, Item>>& objs) {
+	storage_.insertItems(objs);
+	waiters_.notifyInserted(objs);
+}
+
+std::vector<amazoom::Item> amazoom::FlatMultiHashmapImpl::extractItems(const Key & key, int count) {
+	return storage_.extractItems(key, count);
+}
+
+std::vector<amazoom::Item> amazoom::FlatMultiHashmapImpl::extractItems(const Key & key, int count, CompareFxn compareFxn) {
+	return storage_.extractItems(key, count, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::FlatMultiHashmapImpl::extractLightest(const Key & key) {
+	return storage_.extractLightest(key);
+}
+
+std::optional<amazoom::Item> amazoom::FlatMultiHashmapImpl::extractHeaviest(const Key & key) {
+	return storage_.extractHeaviest(key);
+}
+
+std::optional<amazoom::Item> amazoom::FlatMultiHashmapImpl::extractWithWeightAtMost(const Key & key, float maxWeight) {
+	return storage_.extractWithWeightAtMost(key, maxWeight);
+}
+
+bool amazoom::FlatMultiHashmapImpl::doesContainObj(const Key key) {
+	return storage_.doesContainObj(key);
+}
+
+bool amazoom::FlatMultiHashmapImpl::doesContainObj(const Key key, CompareFxn compareFxn) {
+	return storage_.doesContainObj(key, compareFxn);
+}
+
+int amazoom::FlatMultiHashmapImpl::getNumItems() {
+	return storage_.getNumItems();
+}
+
+int amazoom::FlatMultiHashmapImpl::countItems(const Key key) {
+	return storage_.countItems(key);
+}
+
+void amazoom::FlatMultiHashmapImpl::visitItems(const std::function<void(const Key key, const Item& obj)> visitor) {
+	storage_.visitItems(visitor);
+}
+
+double amazoom::FlatMultiHashmapImpl::totalWeight(const Key key) {
+	return WeightAggregates::totalWeight(storage_, key);
+}
+
+int amazoom::FlatMultiHashmapImpl::countWhere(const Key key, float minWeight, float maxWeight) {
+	return WeightAggregates::countWhere(storage_, key, minWeight, maxWeight);
+}
+
+std::vector<int> amazoom::FlatMultiHashmapImpl::weightHistogram(const Key key, float binWidth, int numBins) {
+	return WeightAggregates::weightHistogram(storage_, key, binWidth, numBins);
+}
@@ -0,0 +1,270 @@
+#include "inventory_snapshot.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char MAGIC[8] = { 'A', 'M', 'Z', 'S', 'N', 'A', 'P', '\0' };
+const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+const std::uint64_t FNV_PRIME = 1099511628211ull;
+
+//thin wrappers over the unbuffered file API, so that the snapshot can be synced to disk before it replaces the old one
+#ifdef _WIN32
+int createFile(const std::string& path) {
+	return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+}
+
+bool writeFile(int fd, const char* data, std::size_t size) {
+	while (size > 0) {
+		int written = _write(fd, data, static_cast<unsigned int>(size));
+		if (written < 0) {
+			return false;
+		}
+		data += written;
+		size -= static_cast<std::size_t>(written);
+	}
+	return true;
+}
+
+bool syncFile(int fd) {
+	return _commit(fd) == 0;
+}
+
+bool closeFile(int fd) {
+	return _close(fd) == 0;
+}
+
+//NTFS journals renames itself; there is no directory handle to flush
+bool syncDirectory(const std::string& path) {
+	return true;
+}
+#else
+int createFile(const std::string& path) {
+	return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+}
+
+bool writeFile(int fd, const char* data, std::size_t size) {
+	while (size > 0) {
+		ssize_t written = ::write(fd, data, size);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += written;
+		size -= static_cast<std::size_t>(written);
+	}
+	return true;
+}
+
+bool syncFile(int fd) {
+	return ::fsync(fd) == 0;
+}
+
+bool closeFile(int fd) {
+	return ::close(fd) == 0;
+}
+
+//makes a rename within path durable
+bool syncDirectory(const std::string& path) {
+	const int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	const bool synced = ::fsync(fd) == 0;
+	::close(fd);
+	return synced;
+}
+#endif
+}
+
+void amazoom::InventorySnapshot::write(Checkable& storage, const std::string& path) {
+	writeItems([&storage](const std::function<void(int key, const Item& item)>& visitor) { storage.visitItems(visitor); }, path);
+}
+
+void amazoom::InventorySnapshot::write(ItemContainer& container, const std::string& path) {
+	writeItems([&container](const std::function<void(int key, const Item& item)>& visitor) { container.visitItems(visitor); }, path);
+}
+
+template <class T_VISIT>
+void amazoom::InventorySnapshot::writeItems(const T_VISIT& visitItems, const std::string& path) {
+	std::vector<KeyRun> runs;
+	std::vector<ItemRecord> items;
+
+	//the container is only locked while it is copied out, not while the file is written
+	visitItems([&runs, &items](int key, const Item& item) {
+		if (runs.empty() || runs.back().key != key) {
+			runs.push_back(KeyRun{ key, 0 });
+		}
+		runs.back().count++;
+		items.push_back(toRecord(item));
+	});
+
+	const char* runBytes = reinterpret_cast<const char*>(runs.data());
+	const char* itemBytes = reinterpret_cast<const char*>(items.data());
+	const std::size_t runSize = runs.size() * sizeof(KeyRun);
+	const std::size_t itemSize = items.size() * sizeof(ItemRecord);
+
+	Header header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.byteOrderMark = BYTE_ORDER_MARK;
+	header.numRuns = runs.size();
+	header.numItems = items.size();
+
+	//runs are 8 bytes each, so hashing the items on from the runs' hash equals hashing the file's body in one go
+	header.checksum = checksum(itemBytes, itemBytes + itemSize, checksum(runBytes, runBytes + runSize, FNV_OFFSET_BASIS));
+
+	/*Written next to the target, synced, and renamed over it, then the rename is synced too. A crash or power
+	* loss at any point leaves either the old snapshot or the complete new one, and once write returns the
+	* new one is on disk, so a write-ahead log covering it may be truncated.
+	*/
+	const std::string tmpPath = path + ".tmp";
+	std::error_code error;
+	const int fd = createFile(tmpPath);
+	if (fd < 0) {
+		throw InventorySnapshotException("Could not create inventory snapshot " + tmpPath + ": " + std::strerror(errno));
+	}
+	bool written = writeFile(fd, reinterpret_cast<const char*>(&header), sizeof(header)) &&
+		writeFile(fd, runBytes, runSize) && writeFile(fd, itemBytes, itemSize) && syncFile(fd);
+	int writeErrno = errno;
+	if (!closeFile(fd) && written) {
+		written = false;
+		writeErrno = errno;
+	}
+	if (!written) {
+		std::filesystem::remove(tmpPath, error);
+		throw InventorySnapshotException("Could not write inventory snapshot " + tmpPath + ": " + std::strerror(writeErrno));
+	}
+
+	std::filesystem::rename(tmpPath, path, error);
+	if (error) {
+		std::filesystem::remove(tmpPath, error);
+		throw InventorySnapshotException("Could not replace inventory snapshot: " + path);
+	}
+
+	std::filesystem::path directory(std::filesystem::path(path).parent_path());
+	if (!syncDirectory(directory.empty() ? "." : directory.string())) {
+		throw InventorySnapshotException("Could not sync the directory of inventory snapshot " + path + ": " + std::strerror(errno));
+	}
+}
+
+amazoom::InventorySnapshot::InventorySnapshot(const std::string& path) {
+	try {
+		file_ = boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+		region_ = boost::interprocess::mapped_region(file_, boost::interprocess::read_only);
+	}
+	catch (boost::interprocess::interprocess_exception& e) {
+		throw InventorySnapshotException("Could not map inventory snapshot " + path + ": " + e.what());
+	}
+
+	const char* begin = static_cast<const char*>(region_.get_address());
+	const std::size_t size = region_.get_size();
+
+	Header header;
+	if (size < sizeof(Header)) {
+		throw InventorySnapshotException("Inventory snapshot is truncated: " + path);
+	}
+	std::memcpy(&header, begin, sizeof(Header));
+
+	if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+		throw InventorySnapshotException("Not an inventory snapshot: " + path);
+	}
+	if (header.version != VERSION || header.byteOrderMark != BYTE_ORDER_MARK) {
+		throw InventorySnapshotException("Inventory snapshot was written by an incompatible version or machine: " + path);
+	}
+
+	//counts are checked against the file size before they are used to compute any offset
+	const std::size_t bodySize = size - sizeof(Header);
+	if (header.numRuns > bodySize / sizeof(KeyRun) || header.numItems > bodySize / sizeof(ItemRecord) ||
+		header.numRuns * sizeof(KeyRun) + header.numItems * sizeof(ItemRecord) != bodySize) {
+		throw InventorySnapshotException("Inventory snapshot is truncated: " + path);
+	}
+	if (checksum(begin + sizeof(Header), begin + size, FNV_OFFSET_BASIS) != header.checksum) {
+		throw InventorySnapshotException("Inventory snapshot checksum mismatch: " + path);
+	}
+
+	numRuns_ = static_cast<std::size_t>(header.numRuns);
+	numItems_ = static_cast<std::size_t>(header.numItems);
+	runs_ = reinterpret_cast<const KeyRun*>(begin + sizeof(Header));
+	items_ = reinterpret_cast<const ItemRecord*>(begin + sizeof(Header) + numRuns_ * sizeof(KeyRun));
+
+	std::uint64_t runTotal = 0;
+	for (std::size_t i = 0; i < numRuns_; i++) {
+		runTotal += runs_[i].count;
+	}
+	if (runTotal != numItems_) {
+		throw InventorySnapshotException("Inventory snapshot key runs do not match its items: " + path);
+	}
+}
+
+amazoom::InventorySnapshot::~InventorySnapshot() {}
+
+std::size_t amazoom::InventorySnapshot::getNumItems() const {
+	return numItems_;
+}
+
+std::size_t amazoom::InventorySnapshot::getNumKeys() const {
+	return numRuns_;
+}
+
+void amazoom::InventorySnapshot::loadInto(Storable& storage) const {
+	std::vector<std::pair<int, Item>> batch;
+	batch.reserve(numItems_);
+
+	const ItemRecord* record = items_;
+	for (std::size_t i = 0; i < numRuns_; i++) {
+		for (std::uint32_t j = 0; j < runs_[i].count; j++, record++) {
+			batch.emplace_back(runs_[i].key, toItem(*record));
+		}
+	}
+	storage.insertItems(batch);
+}
+
+void amazoom::InventorySnapshot::loadInto(ItemContainer& container) const {
+	//containers key items by their ID, which is also how they were written
+	std::vector<Item> batch;
+	batch.reserve(numItems_);
+
+	for (std::size_t i = 0; i < numItems_; i++) {
+		batch.push_back(toItem(items_[i]));
+	}
+	container.insertItems(batch);
+}
+
+amazoom::InventorySnapshot::ItemRecord amazoom::InventorySnapshot::toRecord(const Item& item) {
+	return ItemRecord{ item.getID(), item.getWeight(), item.isLarge() ? static_cast<std::uint32_t>(IS_LARGE) : 0u };
+}
+
+amazoom::Item amazoom::InventorySnapshot::toItem(const ItemRecord& record) {
+	return Item(record.itemID, record.weight, (record.flags & IS_LARGE) != 0);
+}
+
+std::uint64_t amazoom::InventorySnapshot::checksum(const char* begin, const char* end, std::uint64_t hash) {
+	//FNV-1a over 64-bit words rather than bytes: one multiply per 8 bytes, so checking a large snapshot stays cheap
+	const char* current = begin;
+	for (; end - current >= 8; current += 8) {
+		std::uint64_t word;
+		std::memcpy(&word, current, sizeof(word));
+		hash = (hash ^ word) * FNV_PRIME;
+	}
+	for (; current != end; current++) {
+		hash = (hash ^ static_cast<unsigned char>(*current)) * FNV_PRIME;
+	}
+	return hash;
+}
@@ -0,0 +1,103 @@
+#ifndef AMAZOOM_CONTAINERS_INVENTORY_SNAPSHOT_H_
+#define AMAZOOM_CONTAINERS_INVENTORY_SNAPSHOT_H_
+
+#include "containers/inventory_snapshot_exceptions.h"
+#include "containers/item_container.h"
+#include "containers/worker_accessible_container.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace amazoom {
+
+/* A binary copy of a container's items, written once and loaded back by memory mapping the file.
+*  Loading does not parse or read the file item by item: the item records are used in place and
+*  handed to the container as one batch, so restoring a warehouse costs one batched insertion per container.
+*
+*  File layout, in native byte order (a byte order mark in the header rejects files from other machines):
+*    Header      magic "AMZSNAP", version, record counts and a checksum of everything after the header
+*    KeyRun[]    (key, count) for every run of consecutive items sharing a key
+*    ItemRecord[] the packed ItemProperties of every item, grouped by key in the order of the runs
+*
+*  Example:
+*  InventorySnapshot::write(shelf, "shelf_12.snap");
+*  ...
+*  InventorySnapshot snapshot("shelf_12.snap");
+*  snapshot.loadInto(restoredShelf);
+*/
+class InventorySnapshot {
+public:
+	//Writes every item of storage or container to path, replacing the file only once it is complete,
+	//and returns once the new snapshot is synced to disk. Throws InventorySnapshotException if the file
+	//cannot be written, leaving any previous snapshot at path in place
+	static void write(Checkable& storage, const std::string& path);
+	static void write(ItemContainer& container, const std::string& path);
+
+	//Maps path read-only and verifies it. Throws InventorySnapshotException if it is not a valid snapshot
+	explicit InventorySnapshot(const std::string& path);
+	~InventorySnapshot();
+
+	InventorySnapshot(const InventorySnapshot& snapshot) = delete;
+	InventorySnapshot& operator=(const InventorySnapshot& snapshot) = delete;
+
+	std::size_t getNumItems() const;
+	std::size_t getNumKeys() const; //number of key runs; a key appears once unless it was written from several shards
+
+	//Inserts every item of the snapshot as a single batch. A Box checks its weight limit for the
+	//batch as a whole, so it either takes the whole snapshot or throws BoxOverweightException.
+	//A container that throws for another reason may keep part of the batch, see ItemContainer::insertItems
+	void loadInto(Storable& storage) const;
+	void loadInto(ItemContainer& container) const;
+
+	enum { VERSION = 1 };
+
+private:
+	struct Header {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byteOrderMark;
+		std::uint64_t numRuns;
+		std::uint64_t numItems;
+		std::uint64_t checksum;
+		std::uint64_t reserved;
+	};
+
+	struct KeyRun {
+		std::int32_t key;
+		std::uint32_t count;
+	};
+
+	//ItemProperties without its padding, so that no uninitialised bytes reach the file or the checksum
+	struct ItemRecord {
+		std::int32_t itemID;
+		float weight;
+		std::uint32_t flags;
+	};
+
+	enum { IS_LARGE = 1 };
+
+	template <class T_VISIT>
+	static void writeItems(const T_VISIT& visitItems, const std::string& path);
+
+	static ItemRecord toRecord(const Item& item);
+	static Item toItem(const ItemRecord& record);
+
+	//continues hash over the bytes from begin to end, eight at a time
+	static std::uint64_t checksum(const char* begin, const char* end, std::uint64_t hash);
+
+	boost::interprocess::file_mapping file_;
+	boost::interprocess::mapped_region region_;
+
+	const KeyRun* runs_{ nullptr };
+	const ItemRecord* items_{ nullptr };
+	std::size_t numRuns_{ 0 };
+	std::size_t numItems_{ 0 };
+};
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef AMAZOOM_CONTAINERS_INVENTORY_SNAPSHOT_EXCEPTIONS_H_
+#define AMAZOOM_CONTAINERS_INVENTORY_SNAPSHOT_EXCEPTIONS_H_
+
+#include <exception>
+#include <string>
+
+namespace amazoom {
+//thrown when a snapshot cannot be written, or a file is missing, truncated, corrupt or not a snapshot
+class InventorySnapshotException : public std::exception {
+
+public:
+	InventorySnapshotException(std::string error) : error_(error) {};
+
+	const char* what() const noexcept { return error_.c_str(); }
+
+private:
+	const std::string error_;
+};
+}
+
+#endif
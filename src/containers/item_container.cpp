@@ -1,9 +1,13 @@
 #include "item_container.h"
 
-amazoom::ItemContainer::ItemContainer() {
+amazoom::ItemContainer::ItemContainer() : metrics_("item_container") {
 }
 
-amazoom::ItemContainer::ItemContainer(StoragePtr& storage) : storage_(std::move(storage)){}
+amazoom::ItemContainer::ItemContainer(StoragePtr& storage) : storage_(std::move(storage)), metrics_("item_container") {}
+
+amazoom::ItemContainer::ItemContainer(const char* metricsKind) : metrics_(metricsKind) {}
+
+amazoom::ItemContainer::ItemContainer(StoragePtr& storage, const char* metricsKind) : storage_(std::move(storage)), metrics_(metricsKind) {}
 
 amazoom::ItemContainer::~ItemContainer() {}
 
@@ -15,7 +19,71 @@ bool amazoom::ItemContainer::canExtract(int key) {
 	return storage_->doesContainObj(key);
 }
 
-bool amazoom::ItemContainer::doesContainItem(int key) {
+bool amazoom::ItemContainer::doesContainItem(int key) const {
 	return storage_->doesContainObj(key);
 }
 
+int amazoom::ItemContainer::countItems(int key) const {
+	return storage_->countItems(key);
+}
+
+void amazoom::ItemContainer::visitItems(const std::function<void(int key, const amazoom::Item& item)> visitor) const {
+	storage_->visitItems(visitor);
+}
+
+double amazoom::ItemContainer::totalWeight(int key) const {
+	return storage_->totalWeight(key);
+}
+
+int amazoom::ItemContainer::countWhere(int key, float minWeight, float maxWeight) const {
+	return storage_->countWhere(key, minWeight, maxWeight);
+}
+
+std::vector<int> amazoom::ItemContainer::weightHistogram(int key, float binWidth, int numBins) const {
+	return storage_->weightHistogram(key, binWidth, numBins);
+}
+
+amazoom::ContainerMetrics& amazoom::ItemContainer::getMetrics() {
+	return metrics_;
+}
+
+std::optional<amazoom::Item> amazoom::ItemContainer::tryExtractItem(int key) {
+	if (!canExtract(key)) {
+		return std::nullopt;
+	}
+	try {
+		return extractItem(key);
+	}
+	catch (MultiHashMapNoSuchObj&) {
+		//another worker took the last one between the check and the extraction
+		return std::nullopt;
+	}
+}
+
+void amazoom::ItemContainer::insertItems(std::vector<Item>& items) {
+	//insertItem moves out only what it keeps, so a throw leaves items describing the partial batch
+	for (Item& item : items) {
+		insertItem(item);
+	}
+}
+
+std::vector<amazoom::Item> amazoom::ItemContainer::extractItems(int key, int count) {
+	std::vector<Item> extractedItems;
+	while (static_cast<int>(extractedItems.size()) < count && canExtract(key)) {
+		extractedItems.push_back(extractItem(key));
+	}
+	return extractedItems;
+}
+
+std::vector<amazoom::Item> amazoom::ItemContainer::extractItemsLocked(int key, int count) {
+	return storage_->extractItems(key, count);
+}
+
+void amazoom::ItemContainer::restoreItemsLocked(int key, std::vector<Item>& items) {
+	std::vector<std::pair<int, Item>> keyedItems;
+	keyedItems.reserve(items.size());
+	for (Item& item : items) {
+		keyedItems.emplace_back(key, std::move(item));
+	}
+	storage_->insertItems(keyedItems);
+}
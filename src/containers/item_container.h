@@ -2,13 +2,18 @@
 #define AMAZOOM_CONTAINERS_ITEM_CONTAINER_H_
 
 #include "warehouse_etc/item_definition.h"
+#include "containers/container_metrics.h"
 #include "containers/multi_hashmap_impl.h"
 #include "containers/worker_accessible_container.h"
 
 #include <boost/thread.hpp>
 #include <memory>
+#include <vector>
+#include <optional>
 
 namespace amazoom {
+class OrderTransaction;
+
 //ItemContainer is an interface from which other more specialized containers may be built
 class ItemContainer {
 private:
@@ -17,6 +22,28 @@ private:
 protected:
 	StoragePtr storage_{ std::unique_ptr<MultiHashmapImpl>(new MultiHashmapImpl()) };
 
+	//Every extraction must hold this shared. An OrderTransaction holds it exclusively while it checks and
+	//takes its order lines, so nothing it counted can disappear underneath it. Insertions never take it
+	boost::shared_mutex extractionMtx_;
+
+	//container level operation and extractionMtx_ statistics, see ContainerMetrics
+	ContainerMetrics metrics_;
+
+	//metricsKind names the derived container in MetricsRegistry snapshots, e.g. "box"
+	ItemContainer(const char* metricsKind);
+	ItemContainer(StoragePtr& storage, const char* metricsKind);
+
+	//Extracts up to count items matching key without taking extractionMtx_; the caller must hold it.
+	//By default this extracts straight from storage_. Override it to apply the container's own bookkeeping.
+	virtual std::vector<amazoom::Item> extractItemsLocked(int key, int count);
+
+	//Puts back items of key that extractItemsLocked took, for an order that could not be completed; the caller
+	//must hold extractionMtx_. The items were stored a moment ago, so the container's insertion policy is not
+	//applied again. Items are moved out of items. Override it alongside extractItemsLocked.
+	virtual void restoreItemsLocked(int key, std::vector<amazoom::Item>& items);
+
+	friend class OrderTransaction;
+
 public:
 	ItemContainer();
 
@@ -35,13 +62,43 @@ public:
 	//thread-safe by default.
 	virtual bool canExtract(int key);
 
-	bool doesContainItem(int key);
+	bool doesContainItem(int key) const;
+
+	//number of items matching key
+	int countItems(int key) const;
+
+	//Calls visitor(key, item) for every item stored, see Checkable::visitItems
+	void visitItems(const std::function<void(int key, const amazoom::Item& item)> visitor) const;
+
+	//weight aggregates of the items matching key, see Checkable::totalWeight
+	double totalWeight(int key) const;
+	int countWhere(int key, float minWeight, float maxWeight) const;
+	std::vector<int> weightHistogram(int key, float binWidth, int numBins) const;
+
+	ContainerMetrics& getMetrics();
 
 	//User implemented extraction function
 	virtual amazoom::Item extractItem(int key) = 0;
 
+	//Non-throwing extraction. Returns an empty optional if there is nothing to extract.
+	//By default this checks canExtract before calling extractItem; override it to avoid the double lookup.
+	virtual std::optional<amazoom::Item> tryExtractItem(int key);
+
 	//User implemented insertion function
 	virtual void insertItem(Item& item) = 0;
+
+	/*Inserts a batch of items, each keyed by its ID. By default this simply calls insertItem for each
+	* item; override it to apply the container's policy once for the whole batch.
+	* The default is not all or nothing: if an insertion throws, the items before it stay inserted. Either
+	* way items reports what happened: every item inserted has been moved out (its ID is Item::INVALID_ITEM)
+	* and every other item is still valid, so the caller can tell how many went in and take back the rest.
+	* Overrides must keep to this.
+	*/
+	virtual void insertItems(std::vector<Item>& items);
+
+	//Extracts up to count items matching key. Returns fewer, possibly none, if not enough are stored.
+	//By default this calls extractItem while canExtract holds; override it to batch.
+	virtual std::vector<amazoom::Item> extractItems(int key, int count);
 };
 }
 
@@ -9,7 +9,7 @@ namespace amazoom {
 class ItemContainerFullException : public std::exception {
 
 public:
-	ItemContainerFullException(std::string error) {};
+	ItemContainerFullException(std::string error) : error_(error) {};
 
 	const char* what() const noexcept { return error_.c_str(); }
 
@@ -0,0 +1,160 @@
+#include "logged_container_impl.h"
+
+amazoom::LoggedContainerImpl::LoggedContainerImpl(StoragePtr& storage, WriteAheadLog& log)
+	: storage_(std::move(storage)), log_(log) {}
+
+amazoom::LoggedContainerImpl::~LoggedContainerImpl() {}
+
+amazoom::Item amazoom::LoggedContainerImpl::extractItem(const Key & key) {
+	return logged(key, storage_->extractItem(key));
+}
+
+amazoom::Item amazoom::LoggedContainerImpl::extractItem(const Key & key, CompareFxn compareFxn) {
+	return logged(key, storage_->extractItem(key, compareFxn));
+}
+
+std::optional<amazoom::Item> amazoom::LoggedContainerImpl::tryExtractItem(const Key & key) {
+	return logged(key, storage_->tryExtractItem(key));
+}
+
+std::optional<amazoom::Item> amazoom::LoggedContainerImpl::tryExtractItem(const Key & key, CompareFxn compareFxn) {
+	return logged(key, storage_->tryExtractItem(key, compareFxn));
+}
+
+std::optional<amazoom::Item> amazoom::LoggedContainerImpl::extractItemWait(const Key & key, std::chrono::milliseconds timeout) {
+	return waiters_.extractItemWait(key, timeout);
+}
+
+std::future<amazoom::Item> amazoom::LoggedContainerImpl::extractItemAsync(const Key & key) {
+	return waiters_.extractItemAsync(key);
+}
+
+void amazoom::LoggedContainerImpl::insertItem(Key key, Item & obj) {
+	log_.logInsert(key, obj);
+	try {
+		storage_->insertItem(key, obj);
+	}
+	catch (...) {
+		if (obj.getID() != Item::INVALID_ITEM) {
+			logCompensation(key, obj);
+		}
+		throw;
+	}
+	waiters_.notifyInserted(key);
+}
+
+void amazoom::LoggedContainerImpl::insertItems(std::vector<std::pair<Key, Item>>& objs) {
+	log_.logInserts(objs);
+	try {
+		storage_->insertItems(objs);
+	}
+	catch (...) {
+		//storage moves out every item it keeps, so the ones still here are those it refused
+		for (const std::pair<Key, Item>& keyObj : objs) {
+			if (keyObj.second.getID() != Item::INVALID_ITEM) {
+				logCompensation(keyObj.first, keyObj.second);
+			}
+		}
+		throw;
+	}
+	waiters_.notifyInserted(objs);
+}
+
+std::vector<amazoom::Item> amazoom::LoggedContainerImpl::extractItems(const Key & key, int count) {
+	return logged(key, storage_->extractItems(key, count));
+}
+
+std::vector<amazoom::Item> amazoom::LoggedContainerImpl::extractItems(const Key & key, int count, CompareFxn compareFxn) {
+	return logged(key, storage_->extractItems(key, count, compareFxn));
+}
+
+std::optional<amazoom::Item> amazoom::LoggedContainerImpl::extractLightest(const Key & key) {
+	return logged(key, storage_->extractLightest(key));
+}
+
+std::optional<amazoom::Item> amazoom::LoggedContainerImpl::extractHeaviest(const Key & key) {
+	return logged(key, storage_->extractHeaviest(key));
+}
+
+std::optional<amazoom::Item> amazoom::LoggedContainerImpl::extractWithWeightAtMost(const Key & key, float maxWeight) {
+	return logged(key, storage_->extractWithWeightAtMost(key, maxWeight));
+}
+
+bool amazoom::LoggedContainerImpl::doesContainObj(const Key key) {
+	return storage_->doesContainObj(key);
+}
+
+bool amazoom::LoggedContainerImpl::doesContainObj(const Key key, CompareFxn compareFxn) {
+	return storage_->doesContainObj(key, compareFxn);
+}
+
+int amazoom::LoggedContainerImpl::getNumItems() {
+	return storage_->getNumItems();
+}
+
+int amazoom::LoggedContainerImpl::countItems(const Key key) {
+	return storage_->countItems(key);
+}
+
+void amazoom::LoggedContainerImpl::visitItems(const std::function<void(const Key key, const Item& obj)> visitor) {
+	storage_->visitItems(visitor);
+}
+
+double amazoom::LoggedContainerImpl::totalWeight(const Key key) {
+	return storage_->totalWeight(key);
+}
+
+int amazoom::LoggedContainerImpl::countWhere(const Key key, float minWeight, float maxWeight) {
+	return storage_->countWhere(key, minWeight, maxWeight);
+}
+
+std::vector<int> amazoom::LoggedContainerImpl::weightHistogram(const Key key, float binWidth, int numBins) {
+	return storage_->weightHistogram(key, binWidth, numBins);
+}
+
+amazoom::WriteAheadLog& amazoom::LoggedContainerImpl::getLog() {
+	return log_;
+}
+
+amazoom::Item amazoom::LoggedContainerImpl::logged(const Key & key, Item && item) {
+	try {
+		log_.logExtract(key, item);
+	}
+	catch (WriteAheadLogException&) {
+		storage_->insertItem(key, item);
+		throw;
+	}
+	return std::move(item);
+}
+
+void amazoom::LoggedContainerImpl::logCompensation(const Key& key, const Item& obj) {
+	try {
+		log_.logExtract(key, obj);
+	}
+	catch (WriteAheadLogException&) {
+		//the log has failed and throws from now on; the caller still gets storage's exception
+	}
+}
+
+std::optional<amazoom::Item> amazoom::LoggedContainerImpl::logged(const Key & key, std::optional<Item>&& item) {
+	if (!item) {
+		return std::nullopt;
+	}
+	return logged(key, std::move(*item));
+}
+
+std::vector<amazoom::Item> amazoom::LoggedContainerImpl::logged(const Key & key, std::vector<Item>&& items) {
+	try {
+		log_.logExtracts(key, items);
+	}
+	catch (WriteAheadLogException&) {
+		std::vector<std::pair<Key, Item>> restored;
+		restored.reserve(items.size());
+		for (Item& item : items) {
+			restored.emplace_back(key, std::move(item));
+		}
+		storage_->insertItems(restored);
+		throw;
+	}
+	return std::move(items);
+}
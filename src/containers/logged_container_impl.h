@@ -0,0 +1,87 @@
+#ifndef AMAZOOM_CONTAINERS_LOGGED_CONTAINER_IMPL_H_
+#define AMAZOOM_CONTAINERS_LOGGED_CONTAINER_IMPL_H_
+
+#include "containers/stock_waiters.h"
+#include "containers/worker_accessible_container.h"
+#include "containers/write_ahead_log.h"
+
+#include <memory>
+
+namespace amazoom {
+
+/* Bridge that records every insertion and extraction made on another WorkerAccessibleContainer in a
+*  WriteAheadLog. Insertions are logged before they are applied and extractions after, so in the log every
+*  item is inserted before it is extracted, whatever the interleaving of the threads.
+*  If storage then refuses an insertion by throwing, an extraction of each refused item is logged as well,
+*  so replay does not bring back items that were never stored.
+*  A call returns, and an extracted item is handed out, only once the log has made it durable.
+*  If logging an extraction fails, the items are put back and WriteAheadLogException is thrown.
+*  Lookups are passed straight through. Several containers may share one log; the log must outlive them.
+*
+*  Example:
+*  StoragePtr storage(new MultiHashmapImpl());
+*  StoragePtr logged(new LoggedContainerImpl(storage, log));
+*  Box box(logged);
+*/
+class LoggedContainerImpl : public WorkerAccessibleContainer {
+private:
+
+	typedef amazoom::Item Item;
+	typedef int Key;
+	typedef std::function<bool(const Item& obj)> CompareFxn;
+	typedef std::unique_ptr<WorkerAccessibleContainer> StoragePtr;
+
+public:
+	//Takes ownership of storage
+	LoggedContainerImpl(StoragePtr& storage, WriteAheadLog& log);
+	~LoggedContainerImpl();
+
+	virtual Item extractItem(const Key& key);
+	virtual Item extractItem(const Key& key, const CompareFxn compareFxn);
+
+	virtual std::optional<Item> tryExtractItem(const Key& key);
+	virtual std::optional<Item> tryExtractItem(const Key& key, const CompareFxn compareFxn);
+
+	virtual std::optional<Item> extractItemWait(const Key& key, std::chrono::milliseconds timeout);
+	virtual std::future<Item> extractItemAsync(const Key& key);
+
+	virtual void insertItem(Key key, Item& obj);
+
+	virtual void insertItems(std::vector<std::pair<Key, Item>>& objs);
+	virtual std::vector<Item> extractItems(const Key& key, int count);
+	virtual std::vector<Item> extractItems(const Key& key, int count, const CompareFxn compareFxn);
+
+	virtual std::optional<Item> extractLightest(const Key& key);
+	virtual std::optional<Item> extractHeaviest(const Key& key);
+	virtual std::optional<Item> extractWithWeightAtMost(const Key& key, float maxWeight);
+
+	virtual bool doesContainObj(const Key key);
+	virtual bool doesContainObj(const Key key, const CompareFxn compareFxn);
+
+	virtual int getNumItems();
+	virtual int countItems(const Key key);
+
+	virtual void visitItems(const std::function<void(const Key key, const Item& obj)> visitor);
+
+	virtual double totalWeight(const Key key);
+	virtual int countWhere(const Key key, float minWeight, float maxWeight);
+	virtual std::vector<int> weightHistogram(const Key key, float binWidth, int numBins);
+
+	WriteAheadLog& getLog();
+
+private:
+	//log the extraction of items already taken out of storage_, returning them
+	Item logged(const Key& key, Item&& item);
+	std::optional<Item> logged(const Key& key, std::optional<Item>&& item);
+	std::vector<Item> logged(const Key& key, std::vector<Item>&& items);
+
+	//logs the extraction of an item whose logged insertion storage refused, undoing it on replay
+	void logCompensation(const Key& key, const Item& obj);
+
+	StoragePtr storage_;
+	WriteAheadLog& log_;
+	StockWaiters waiters_{ *this }; //after storage_, which it extracts from
+};
+}
+
+#endif
@@ -0,0 +1,40 @@
+#include "monotonic_arena.h"
+
+#include <cstdint>
+
+amazoom::MonotonicArena::MonotonicArena(std::size_t chunkSize) : chunkSize_(chunkSize) {}
+
+amazoom::MonotonicArena::~MonotonicArena() {}
+
+void* amazoom::MonotonicArena::allocate(std::size_t size, std::size_t align) {
+	boost::unique_lock<boost::mutex> lock(mtx_);
+
+	std::size_t padding = (align - reinterpret_cast<std::uintptr_t>(current_) % align) % align;
+
+	if (current_ == nullptr || padding + size > remaining_) {
+		//oversized requests get a chunk of their own
+		const std::size_t newChunkSize = size + align > chunkSize_ ? size + align : chunkSize_;
+		chunks_.push_back(std::unique_ptr<char[]>(new char[newChunkSize]));
+		current_ = chunks_.back().get();
+		remaining_ = newChunkSize;
+		bytesReserved_ += newChunkSize;
+		padding = (align - reinterpret_cast<std::uintptr_t>(current_) % align) % align;
+	}
+
+	char* allocated = current_ + padding;
+	current_ += padding + size;
+	remaining_ -= padding + size;
+	bytesAllocated_ += padding + size;
+
+	return allocated;
+}
+
+std::size_t amazoom::MonotonicArena::bytesAllocated() const {
+	boost::unique_lock<boost::mutex> lock(mtx_);
+	return bytesAllocated_;
+}
+
+std::size_t amazoom::MonotonicArena::bytesReserved() const {
+	boost::unique_lock<boost::mutex> lock(mtx_);
+	return bytesReserved_;
+}
@@ -0,0 +1,72 @@
+#ifndef AMAZOOM_CONTAINERS_MONOTONIC_ARENA_H_
+#define AMAZOOM_CONTAINERS_MONOTONIC_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "boost/thread.hpp"
+
+namespace amazoom {
+/* Bump-pointer arena. Allocation is a pointer increment inside a large chunk and freeing
+*  individual allocations does nothing; all memory is released at once when the arena is destroyed.
+*  Suited to containers that are bulk-loaded and then mostly read, where per-node frees are rare.
+*  Thread-safe.
+*/
+class MonotonicArena {
+public:
+	enum { DEFAULT_CHUNK_SIZE = 1 << 20 };
+
+	explicit MonotonicArena(std::size_t chunkSize = DEFAULT_CHUNK_SIZE);
+	~MonotonicArena();
+
+	MonotonicArena(const MonotonicArena& arena) = delete;
+	MonotonicArena& operator=(const MonotonicArena& arena) = delete;
+
+	void* allocate(std::size_t size, std::size_t align);
+
+	std::size_t bytesAllocated() const; //bytes handed out, including alignment padding
+	std::size_t bytesReserved() const; //bytes held in chunks
+
+private:
+	const std::size_t chunkSize_;
+
+	std::vector<std::unique_ptr<char[]>> chunks_;
+	char* current_{ nullptr };
+	std::size_t remaining_{ 0 };
+	std::size_t bytesAllocated_{ 0 };
+	std::size_t bytesReserved_{ 0 };
+
+	mutable boost::mutex mtx_;
+};
+
+/* Allocator that draws from a MonotonicArena. The arena must outlive every container using it.
+*  Example:
+*  MonotonicArena arena;
+*  MultiHashmap<int, Item, std::unordered_map, ArenaAllocator<Item>> inventory{ ArenaAllocator<Item>(arena) };
+*/
+template <class T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+
+	explicit ArenaAllocator(MonotonicArena& arena) noexcept : arena_(&arena) {}
+	template <class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena_) {}
+
+	T* allocate(std::size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+	void deallocate(T*, std::size_t) noexcept {} //reclaimed when the arena is destroyed
+
+	template <class U>
+	bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena_; }
+	template <class U>
+	bool operator!=(const ArenaAllocator<U>& other) const noexcept { return arena_ != other.arena_; }
+
+private:
+	template <class U> friend class ArenaAllocator;
+
+	MonotonicArena* arena_;
+};
+}
+
+#endif
@@ -6,7 +6,21 @@
 #include <unordered_map>
 #include <memory>
 #include <functional>
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <utility>
+#include <optional>
+#include <sstream>
+#include <map>
+#include <set>
+#include <iterator>
+#include <limits>
+#include <chrono>
+#include <type_traits>
 
+#include "containers/container_metrics.h"
 #include "containers/multi_hashmap_exceptions.h"
 #include "boost/thread.hpp"
 
@@ -15,25 +29,106 @@ namespace amazoom {
 *  Internally, storage is an unordered_map pointing to linkedlists. O(1) average case insertion 
 *  and extraction, and O(N) worse case if all items have the same key, and chooses to select 
 *  by a unique filter. Performs closer to O(1) if there are are many keys
-*  Thread-safe. Allows multiple simutaneous reads, and single extraction/insertions
+*  Thread-safe. Allows multiple simutaneous reads, and single extraction/insertions.
+*  doesContainObj normally takes no lock: readers find the key's root node through a separately
+*  published (RCU style) root index, walk the linked list with atomic shared_ptr loads, and validate
+*  the walk against a per-key version counter that extractions bump (seqlock). With a compareFxn, a
+*  reader whose walk overlaps an extraction of the same key OPTIMISTIC_READ_ATTEMPTS times in a row
+*  takes the shared lock for one last walk, so it can then wait behind an insertion or extraction.
+*  doesContainObj(key) and countItems never fall back. ("No lock" means no lock of the map's own: the
+*  standard library may implement atomic shared_ptr loads with a small internal spinlock.)
+*
+*  T_INDEX is the map type used to index keys to their linked lists. Any map template with the
+*  std::unordered_map find/insert/iteration interface works, for example SwissMap.
+*  T_ALLOC allocates the linked list nodes (rebound through std::allocate_shared). NodePoolAllocator
+*  recycles nodes on extraction; ArenaAllocator suits bulk-loaded, read-mostly inventories.
+*
+*  After enableWeightIndex, every key also keeps its objects ordered by getWeight(), so the lightest,
+*  heaviest or best fitting object can be extracted in O(log N) instead of walking the whole list.
+*
+*  snapshot() returns a point-in-time, read-only view (MVCC) that can be iterated while insertions and
+*  extractions carry on. Taking one bumps an epoch counter, and every node records the epoch it was
+*  inserted in, so a snapshot simply skips newer nodes. An extraction of an object some live snapshot
+*  can still see hands out a copy (SnapshotCopy) and moves the untouched node to its key's retired list,
+*  where snapshots keep finding it until the last of them is released. Releasing a snapshot takes no lock
+*  of the map's, only the one snapshots register under: the next insertion or extraction, which holds mtx_
+*  anyway, frees the retired nodes nobody can see any more. With no snapshot alive, extractions move
+*  objects out exactly as before.
+*
+*  reserve() holds units of a key for an order without extracting them. Every key keeps an atomic count of
+*  its unreserved units: holds and every extraction claim units from it with compare-and-swap, so a hold
+*  never takes mtx_ and extractions cannot take held units. Holds expire after their ttl, lazily, the next
+*  time any hold is made, committed or released or availability is checked.
 */
-template <typename T_KEY, class T_OBJ>
+
+//detects T::getWeight() const, which the optional weight index orders objects by
+template <class T, class = void>
+struct HasGetWeight : std::false_type {};
+
+template <class T>
+struct HasGetWeight<T, std::void_t<decltype(std::declval<const T&>().getWeight())>> : std::true_type {};
+
+//Duplicates an object extracted while a snapshot still shows it: the caller gets the copy and the snapshot
+//keeps the original. Copyable objects are copied; specialise it for move-only objects such as Item
+template <class T>
+struct SnapshotCopy {
+	static T copy(const T& obj) { return T(obj); }
+};
+
+//Items cannot be copied, but a snapshot only needs an equal, read-only twin
+template <>
+struct SnapshotCopy<Item> {
+	static Item copy(const Item& item) { return Item(item.getID(), item.getWeight(), item.isLarge()); }
+};
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX = std::unordered_map, class T_ALLOC = std::allocator<T_OBJ>>
 class MultiHashmap {
 
 	class LinkedListNode; //forward declare
+	class RootLinkedListNode;
 	class DataLinkedListNode;
+	class RootIndexEntry;
+	class RootIndex;
+	class RetiredEntry;
 
 	//Linked list implementation
 	typedef std::shared_ptr<LinkedListNode> NodePtr;
+	typedef std::shared_ptr<RootLinkedListNode> RootNodePtr;
 	typedef std::shared_ptr<DataLinkedListNode> DataNodePtr;
-	typedef std::unordered_map<T_KEY, NodePtr> Map;
+	typedef std::shared_ptr<RootIndexEntry> RootIndexEntryPtr;
+	typedef std::shared_ptr<RootIndex> RootIndexPtr;
+	typedef std::shared_ptr<RetiredEntry> RetiredEntryPtr;
+	typedef T_INDEX<T_KEY, RootNodePtr> Map;
+
+	//per key weight index. Only touched under mtx_, lock-free readers never see it
+	typedef std::pair<const float, DataLinkedListNode*> WeightEntry;
+	typedef std::multimap<float, DataLinkedListNode*, std::less<float>,
+		typename std::allocator_traits<T_ALLOC>::template rebind_alloc<WeightEntry>> WeightIndex;
 	typedef std::function<bool(const Item& obj)> CompareFxn;
 
-	//LinkedList default. Only used for the first node of all linked lists
+	//LinkedList default. nxtptr_ may be read by lock-free readers, so once a node is reachable 
+	//it must only be written through std::atomic_store. prvptr_ is a non-owning back link that
+	//lets a node found through the weight index be unlinked without walking the list; only
+	//writers holding mtx_ read or write it
 	class LinkedListNode {
 	public:
 		LinkedListNode(NodePtr nxtptr = nullptr) : nxtptr_(nxtptr) {}
 		NodePtr nxtptr_{};
+		LinkedListNode* prvptr_{ nullptr };
+	};
+
+	//Only used for the first node of all linked lists. version_ is odd while an extraction
+	//is modifying this key's list, and lets lock-free readers detect that their walk raced with it
+	class RootLinkedListNode : public LinkedListNode {
+	public:
+		RootLinkedListNode(NodePtr nxtptr = nullptr) : LinkedListNode(nxtptr) {}
+		std::atomic<unsigned int> version_{ 0 };
+		std::unique_ptr<WeightIndex> weightIndex_; //null unless enableWeightIndex was called
+		std::atomic<int> numObjs_{ 0 }; //written under mtx_, read lock-free by countItems
+		std::atomic<int> numAvailable_{ 0 }; //objects not held by a reservation, claimed by compare-and-swap
+		std::atomic<int> numReserved_{ 0 };
+		RetiredEntryPtr retired_; //newest first, written with std::atomic_store under mtx_
+		bool listedRetired_{ false }; //in retiredRoots_. Guarded by mtx_
 	};
 
 	//LinkedList plus Data. Used for all nodes after the root node.
@@ -42,25 +137,98 @@ class MultiHashmap {
 	//be extracted.
 	class DataLinkedListNode : public LinkedListNode {
 	public:
-		DataLinkedListNode(NodePtr nxtptr, T_KEY key, T_OBJ& obj) 
-			: LinkedListNode(nxtptr), key_(key), obj_(std::move(obj)) {}
-
-		DataLinkedListNode(T_KEY key, T_OBJ& obj) : key_(key), obj_(std::move(obj)) {}
+		DataLinkedListNode(NodePtr nxtptr, T_KEY key, T_OBJ& obj, std::uint64_t createdEpoch)
+			: LinkedListNode(nxtptr), key_(key), obj_(std::move(obj)), createdEpoch_(createdEpoch) {}
 
 		T_KEY key_;
 		T_OBJ obj_;
+		const std::uint64_t createdEpoch_; //visible to snapshots with a later epoch
+		typename WeightIndex::iterator weightPos_{}; //valid while the root has a weight index
+	};
+
+	//Read-only copy of storInternal_ for lock-free readers. Entries are prepended to a bucket and never
+	//modified, and when the index grows a brand new one is built and published, so a reader holding an
+	//older index still sees a valid (if slightly stale) set of roots. Roots are never removed.
+	class RootIndexEntry {
+	public:
+		RootIndexEntry(const T_KEY& key, RootNodePtr root, RootIndexEntryPtr nxtptr)
+			: key_(key), root_(root), nxtptr_(nxtptr) {}
+
+		const T_KEY key_;
+		const RootNodePtr root_;
+		const RootIndexEntryPtr nxtptr_;
+	};
+
+	class RootIndex {
+	public:
+		RootIndex(std::size_t numBuckets) : buckets_(numBuckets) {}
+		std::vector<RootIndexEntryPtr> buckets_; //bucket heads, written with std::atomic_store
+	};
+
+	//A node extracted while a snapshot could see it, kept intact for the snapshots with an epoch up to
+	//extractedEpoch_. Entries are only ever cut off the end of the list, once no live snapshot needs them
+	class RetiredEntry {
+	public:
+		RetiredEntry(const DataNodePtr& node, std::uint64_t extractedEpoch, const RetiredEntryPtr& nxtptr)
+			: node_(node), extractedEpoch_(extractedEpoch), nxtptr_(nxtptr) {}
+
+		const DataNodePtr node_;
+		const std::uint64_t extractedEpoch_;
+		RetiredEntryPtr nxtptr_; //written with std::atomic_store
 	};
-		
+
 public:
-	MultiHashmap();
+	/* Read-only view of the map as it was when snapshot() returned. Iterating it takes no lock (a key whose
+	*  list keeps changing under the walk falls back to the shared lock, as doesContainObj does), and never
+	*  blocks insertions or extractions. Objects extracted after the snapshot was taken stay alive, and
+	*  visible through it, until it is destroyed, so release snapshots promptly.
+	*  Must not outlive the map. Not thread-safe itself; use one per thread.
+	*/
+	class Snapshot {
+	public:
+		Snapshot(Snapshot&& snapshot);
+		~Snapshot();
+
+		Snapshot(const Snapshot&) = delete;
+		Snapshot& operator=(const Snapshot&) = delete;
+		Snapshot& operator=(Snapshot&&) = delete;
+
+		int getNumItems() const; //number of objects stored when the snapshot was taken
+		int countItems(const T_KEY& key) const;
+		std::uint64_t getEpoch() const;
+
+		//Calls visit(key, obj) for every object in the snapshot, all objects of a key one after another
+		template <class T_VISITOR>
+		void visitItems(const T_VISITOR& visit) const;
+
+		//Calls visit(key, obj) for every object stored under key in the snapshot
+		template <class T_VISITOR>
+		void visitItems(const T_KEY& key, const T_VISITOR& visit) const;
+
+	private:
+		friend class MultiHashmap;
+
+		Snapshot(MultiHashmap* map, std::uint64_t epoch, int numItems, const RootIndexPtr& roots);
+
+		MultiHashmap* map_;
+		std::uint64_t epoch_;
+		int numItems_;
+		RootIndexPtr roots_; //the root index when the snapshot was taken; roots added later only hold newer objects
+	};
+
 
-	MultiHashmap(const MultiHashmap<T_KEY, T_OBJ>& hashmap) = delete; //copy constructor to-do
-	MultiHashmap<T_KEY, T_OBJ>& operator=(const MultiHashmap<T_KEY, T_OBJ>& hashmap) = delete; //assignment to-do
+	explicit MultiHashmap(const T_ALLOC& alloc = T_ALLOC());
+
+	//objects are not duplicated; use snapshot() for a consistent copy to read from
+	MultiHashmap(const MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>& hashmap) = delete;
+	MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>& operator=(const MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>& hashmap) = delete;
 
 	~MultiHashmap();
 
 	int getNumItems() const; //returns how many items are currently stored
 
+	int countItems(const T_KEY& key) const; //returns how many items are currently stored by key. Lock-free
+
 	//Inserts an object into the container indexed by a key.
 	void insertItem(T_KEY key, T_OBJ& obj);
 
@@ -74,10 +242,11 @@ public:
 	* int key = 0;
 	* thisHashmap.doesContainObj(key, [desiredMemberGet, desiredAttribute](const T_OBJ& obj)->bool {
 	*  return (obj.getSomeMember() == desiredMemberGet && obj.attribute >= desiredAttribute; }}; 
+	* Lock-free unless extractions of key keep overlapping the walk, see the class comment.
 	*/
 	bool doesContainObj(const T_KEY& key, const CompareFxn compareFxn) const;
 
-	/*If no comparison function is provided, will search purely by key */
+	/*If no comparison function is provided, will search purely by key. Never takes mtx_ */
 	bool doesContainObj(const T_KEY& key) const;
 
 	/*Extracts any object matching key. If no such object can be found MultiHashMapNoSuchObj is thrown*/
@@ -94,41 +263,254 @@ public:
 	*/
 	T_OBJ extractItem(const T_KEY& key, const CompareFxn compareFxn);
 
+	/*Same as extractItem, but returns an empty optional instead of throwing when nothing matches.
+	* Use this where a miss is an ordinary outcome, e.g. probing many containers for stock.
+	*/
+	std::optional<T_OBJ> tryExtractItem(const T_KEY& key);
+	std::optional<T_OBJ> tryExtractItem(const T_KEY& key, const CompareFxn compareFxn);
+
+	/*Compile-time predicate versions of doesContainObj and tryExtractItem. pred is any callable taking
+	* const T_OBJ&, and is inlined into the list walk instead of being called through std::function,
+	* which matters when many objects share a key.
+	*
+	* Example of calling this function:
+	* thisHashmap.extractIf(key, [maxWeight](const T_OBJ& obj) { return obj.getWeight() <= maxWeight; });
+	*/
+	template <class T_PRED>
+	bool containsIf(const T_KEY& key, const T_PRED& pred) const;
+
+	template <class T_PRED>
+	std::optional<T_OBJ> extractIf(const T_KEY& key, const T_PRED& pred);
+
+	/*Inserts every (key, object) pair under a single lock acquisition. Objects are moved out of objs*/
+	void insertItems(std::vector<std::pair<T_KEY, T_OBJ>>& objs);
+
+	/*Extracts up to count objects matching key (and compareFxn) under a single lock acquisition.
+	* Returns fewer than count objects, possibly none, if not enough are stored. Never throws MultiHashMapNoSuchObj.
+	*/
+	std::vector<T_OBJ> extractItems(const T_KEY& key, int count);
+	std::vector<T_OBJ> extractItems(const T_KEY& key, int count, const CompareFxn compareFxn);
+
+	/*Starts ordering every key's objects by weight. Objects already stored are indexed now, later
+	* insertions and extractions keep the index up to date at O(log N) each. Calling it again does nothing.
+	* T_OBJ must provide getWeight() const.
+	*/
+	void enableWeightIndex();
+
+	/*Extracts the lightest/heaviest object stored under key, or the heaviest one weighing at most
+	* maxWeight (the best fit for that much free capacity). Returns an empty optional if there is none.
+	* O(log N) once enableWeightIndex has been called, otherwise the key's whole list is walked.
+	*/
+	std::optional<T_OBJ> extractLightest(const T_KEY& key);
+	std::optional<T_OBJ> extractHeaviest(const T_KEY& key);
+	std::optional<T_OBJ> extractWithWeightAtMost(const T_KEY& key, float maxWeight);
+
+	/*Calls visit(key, obj) for every stored object, with all objects of a key visited one after another.
+	* mtx_ is held shared throughout, so the objects visited are a consistent snapshot and insertions and
+	* extractions wait until it returns. visit must not call back into this container.
+	*/
+	template <class T_VISITOR>
+	void visitItems(const T_VISITOR& visit) const;
+
+	//Same, for the objects stored under key only
+	template <class T_VISITOR>
+	void visitItems(const T_KEY& key, const T_VISITOR& visit) const;
+
+	/*Returns a point-in-time view of every stored object, see Snapshot. Takes the shared lock only for
+	* as long as it takes to register the snapshot.
+	*/
+	Snapshot snapshot();
+
+	int getNumSnapshots() const; //snapshots currently alive
+
+	//Ticket for units of key held by reserve(). Only the first commit or release of it counts
+	struct Reservation {
+		std::uint64_t id;
+		T_KEY key;
+		int count;
+	};
+
+	/*Holds count units of key for an order until they are picked (commitReservation), given back
+	* (releaseReservation), or ttl passes and they return to stock by themselves. Held units stay stored, and
+	* are still counted by countItems and visited, but no extraction other than the commit can take them.
+	* (MultiHashmapImpl, the Checkable bridge, counts only the units extraction can take.)
+	* Returns an empty optional if fewer than count unreserved units are stored. Never takes mtx_.
+	*
+	* Example of calling this function:
+	* std::optional<Reservation> hold = thisHashmap.reserve(key, 2, std::chrono::minutes(15));
+	* ...
+	* std::vector<T_OBJ> picked = thisHashmap.commitReservation(*hold);
+	*/
+	std::optional<Reservation> reserve(const T_KEY& key, int count, std::chrono::milliseconds ttl);
+
+	/*Extracts the units held by reservation. Throws MultiHashMapNoSuchReservation if it was already
+	* committed or released, or has expired.
+	*/
+	std::vector<T_OBJ> commitReservation(const Reservation& reservation);
+
+	//Returns the held units to stock. Returns false if reservation was already committed or released, or has expired
+	bool releaseReservation(const Reservation& reservation);
+
+	int countAvailable(const T_KEY& key); //units of key stored and not held by a reservation. Lock-free
+	int countReserved(const T_KEY& key); //units of key held by reservations. Lock-free
+	int getNumReservations(); //holds not yet committed, released or expired
+
+	//operation and mtx_ statistics, recorded only when built with AMAZOOM_METRICS. See ContainerMetrics
+	ContainerMetrics& getMetrics() const;
+
 private:
-	int currentNumItems{ 0 }; //how many items are stored
+	enum { INITIAL_INDEX_BUCKETS = 16, OPTIMISTIC_READ_ATTEMPTS = 8 };
+	enum WeightPick { LIGHTEST, HEAVIEST, HEAVIEST_AT_MOST };
+
+	typedef std::chrono::steady_clock Clock;
+
+	struct Hold {
+		RootNodePtr root;
+		int count;
+		Clock::time_point expires;
+	};
+
+	//lock-free lookup of the root node of key. Returns nullptr if key was never inserted
+	RootNodePtr findRootLockFree(const T_KEY& key) const;
+
+	//makes a newly created root visible to lock-free readers. Caller must hold mtx_ exclusively
+	void publishRoot(const T_KEY& key, const RootNodePtr& root);
+
+	static std::size_t bucketFor(const T_KEY& key, std::size_t numBuckets);
+
+	//walks the list after root looking for a match. Safe without mtx_, but may observe
+	//an object while it is being extracted, so lock-free callers must validate root->version_
+	template <class T_PRED>
+	static bool scanList(const RootNodePtr& root, const T_KEY& key, const T_PRED& pred);
+
+	//insertion body of insertItem. Caller must hold mtx_ exclusively
+	void insertLocked(T_KEY key, T_OBJ& obj);
+
+	//extraction body shared by extractItem and tryExtractItem. Caller must hold mtx_ exclusively
+	template <class T_PRED>
+	std::optional<T_OBJ> tryExtractLocked(const T_KEY& key, const T_PRED& pred);
+
+	//unlinks up to count objects of key matching pred, without claiming them. Caller must hold mtx_ exclusively
+	template <class T_PRED>
+	std::vector<T_OBJ> extractLocked(const RootNodePtr& root, const T_KEY& key, int count, const T_PRED& pred);
+
+	//extraction body shared by extractLightest, extractHeaviest and extractWithWeightAtMost. Caller must hold mtx_ exclusively
+	std::optional<T_OBJ> extractByWeightLocked(const T_KEY& key, WeightPick pick, float maxWeight);
+
+	//takes between minCount and maxCount of root's unreserved units, as many as there are, and returns how
+	//many it took, or 0 if there are fewer than minCount. Units an extraction claims but does not use go back
+	static int claimAvailable(RootLinkedListNode& root, int minCount, int maxCount);
+
+	//returns the units of expired holds to stock. Caller must hold reservationMtx_
+	void expireReservationsLocked(Clock::time_point now);
+	void expireReservationsIfDue();
+
+	//adds node to root's weight index, if it has one
+	static void indexWeight(RootLinkedListNode& root, DataLinkedListNode& node);
+
+	//detaches node from root's list and weight index and moves its object out, or copies it and retires
+	//the node if a live snapshot may still show it. Caller must hold mtx_ exclusively and bracket the call
+	//with beginListWrite/endListWrite
+	T_OBJ unlinkLocked(const RootNodePtr& root, const NodePtr& node);
+
+	//collects the nodes of root visible to the snapshot taken at epoch, live ones first, then retired ones
+	void collectVisible(const RootNodePtr& root, std::uint64_t epoch, std::vector<const DataLinkedListNode*>& visible) const;
+	static void appendVisible(const RootNodePtr& root, std::uint64_t epoch, std::vector<const DataLinkedListNode*>& visible);
+
+	//unregisters a snapshot without taking mtx_, leaving its retired nodes to the next writer
+	void releaseSnapshot(std::uint64_t epoch);
+
+	//drops the retired nodes no remaining snapshot can see, if a snapshot was released since the last time.
+	//Caller must hold mtx_ exclusively
+	void reclaimRetiredLocked();
+
+	//marks op as a miss if nothing was extracted, and passes extracted through
+	static std::optional<T_OBJ> meteredExtraction(MeteredOp& op, std::optional<T_OBJ>&& extracted);
+
+	//bracket any change to the list after root that readers could observe (unlinking, moving objects out)
+	static void beginListWrite(const RootNodePtr& root);
+	static void endListWrite(const RootNodePtr& root);
+
+	std::atomic<int> currentNumItems{ 0 }; //how many items are stored
 	const CompareFxn defaultCompareFxn_{ 
 		[](const T_OBJ&)->bool { return true; } 
 	}; //returns true
 
+	T_ALLOC alloc_;
+
 	Map storInternal_;
 
+	RootIndexPtr rootIndex_{ std::make_shared<RootIndex>(INITIAL_INDEX_BUCKETS) }; //published with std::atomic_store
+	std::size_t numRoots_{ 0 }; //guarded by mtx_
+	bool weightIndexed_{ false }; //guarded by mtx_
+
+	//bumped by every snapshot, under the shared lock, so no writer is ever in the middle of an operation when it moves
+	std::atomic<std::uint64_t> epoch_{ 0 };
+	//raised under the shared lock, so no writer sees it rise mid-operation. It falls whenever a snapshot is
+	//released, which at worst makes an extraction retire a node nobody will read, and reclaim it later
+	std::atomic<int> numSnapshots_{ 0 };
+	boost::mutex snapshotMtx_; //guards snapshotEpochs_. Taken after mtx_, never before
+	std::multiset<std::uint64_t> snapshotEpochs_;
+	std::vector<RootNodePtr> retiredRoots_; //roots with a non-empty retired list. Guarded by mtx_
+	std::atomic<bool> reclaimDue_{ false }; //a snapshot was released and retiredRoots_ has not been trimmed since
+
+	//holds by reservation id, and in order of expiry. Never taken together with mtx_
+	boost::mutex reservationMtx_;
+	std::unordered_map<std::uint64_t, Hold> holds_;
+	std::set<std::pair<Clock::time_point, std::uint64_t>> expiries_;
+	std::uint64_t nextReservationId_{ 1 }; //guarded by reservationMtx_
+	std::atomic<Clock::rep> nextExpiry_{ std::numeric_limits<Clock::rep>::max() }; //lets the common case skip reservationMtx_
+
 	//class level mutex. Separates reading and writing operations
 	mutable boost::shared_mutex mtx_;
 
+	mutable ContainerMetrics metrics_{ "multi_hashmap" };
 };
 }
 
-template <typename T_KEY, class T_OBJ>
-inline amazoom::MultiHashmap<T_KEY, T_OBJ>::MultiHashmap(){}
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::MultiHashmap(const T_ALLOC& alloc) : alloc_(alloc) {}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::~MultiHashmap() {
+}
 
-template <typename T_KEY, class T_OBJ>
-inline amazoom::MultiHashmap<T_KEY, T_OBJ>::~MultiHashmap() {
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::getNumItems() const{
+	return currentNumItems.load();
 }
 
-template<typename T_KEY, class T_OBJ>
-inline int amazoom::MultiHashmap<T_KEY, T_OBJ>::getNumItems() const{
-	boost::unique_lock<boost::shared_mutex> lock(mtx_);
-	return currentNumItems;
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::countItems(const T_KEY& key) const {
+	RootNodePtr rootPtr(findRootLockFree(key));
+	return rootPtr == nullptr ? 0 : rootPtr->numObjs_.load();
 }
 
-template <typename T_KEY, class T_OBJ>
-inline void amazoom::MultiHashmap<T_KEY, T_OBJ>::insertItem(T_KEY key, T_OBJ& obj) {
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::insertItem(T_KEY key, T_OBJ& obj) {
+	MeteredOp op(metrics_, MetricsOp::INSERT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	reclaimRetiredLocked();
+	insertLocked(std::move(key), obj);
+}
 
-	boost::unique_lock<boost::shared_mutex> lock(mtx_);
-	
-	if (storInternal_.count(key)) { //if the root node already exists
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::insertItems(std::vector<std::pair<T_KEY, T_OBJ>>& objs) {
+	MeteredOp op(metrics_, MetricsOp::INSERT_BATCH);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	reclaimRetiredLocked();
+	for (std::pair<T_KEY, T_OBJ>& keyObj : objs) {
+		insertLocked(keyObj.first, keyObj.second);
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::insertLocked(T_KEY key, T_OBJ& obj) {
+
+	auto foundRoot = storInternal_.find(key);
+	if (foundRoot != storInternal_.end()) { //if the root node already exists
 		//grab the root node
-		NodePtr rootNodePtr(storInternal_.at(key));
+		NodePtr rootNodePtr(foundRoot->second);
 		/*All new nodes are inserted directly after the root node.
 		//The topology of the system is below
 		//  
@@ -143,105 +525,847 @@ inline void amazoom::MultiHashmap<T_KEY, T_OBJ>::insertItem(T_KEY key, T_OBJ& ob
 		NodePtr nextNodePtr(rootNodePtr->nxtptr_);
 
 		//create newnode to be inserted into linked list, and connect to the node that was originally in its place
-		NodePtr newNode = std::make_shared<DataLinkedListNode>(nextNodePtr, key, obj);
+		DataNodePtr newNode = std::allocate_shared<DataLinkedListNode>(alloc_, nextNodePtr, key, obj, epoch_.load(std::memory_order_relaxed));
+		newNode->prvptr_ = rootNodePtr.get();
+		if (nextNodePtr != nullptr) {
+			nextNodePtr->prvptr_ = newNode.get();
+		}
+		indexWeight(*foundRoot->second, *newNode);
 
-		//re-link the first node
-		rootNodePtr->nxtptr_ = newNode;
+		//re-link the first node. The new node is fully built, so readers see all of it or none of it
+		std::atomic_store(&rootNodePtr->nxtptr_, NodePtr(newNode));
+		foundRoot->second->numObjs_++;
+		foundRoot->second->numAvailable_++;
 	}
 	else { //There are no items stored at this hash. Create an empty root node, a data node and connect them.
 
 		//create node the connects to the root. This contains key, and obj
-		NodePtr dataNodePtr(std::make_shared<DataLinkedListNode>(nullptr, key, obj));
+		DataNodePtr dataNodePtr(std::allocate_shared<DataLinkedListNode>(alloc_, nullptr, key, obj, epoch_.load(std::memory_order_relaxed)));
 
 		//create empty root node and link it to our new data node
-		auto newRootNode(std::make_shared<LinkedListNode>(dataNodePtr));
+		auto newRootNode(std::allocate_shared<RootLinkedListNode>(alloc_, dataNodePtr));
+		dataNodePtr->prvptr_ = newRootNode.get();
+		newRootNode->numObjs_ = 1;
+		newRootNode->numAvailable_ = 1;
+		if (weightIndexed_) {
+			newRootNode->weightIndex_.reset(new WeightIndex(alloc_));
+			indexWeight(*newRootNode, *dataNodePtr);
+		}
+
+		publishRoot(key, newRootNode);
 
 		//insert empty root node
-		storInternal_.insert(std::make_pair<T_KEY, NodePtr>(std::move(key), std::move(newRootNode)));
+		storInternal_.insert(std::make_pair<T_KEY, RootNodePtr>(std::move(key), std::move(newRootNode)));
 	}
 
-	//lock counter
 	currentNumItems++;
 	
 }
 
-template<typename T_KEY, class T_OBJ>
-inline bool amazoom::MultiHashmap<T_KEY, T_OBJ>::doesContainObj(const T_KEY& key, const CompareFxn compareFxn) const {
-	boost::unique_lock<boost::shared_mutex> lock(mtx_);
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::doesContainObj(const T_KEY& key, const CompareFxn compareFxn) const {
+	//lock-free inside
+	return containsIf(key, compareFxn);
+}
 
-	if (storInternal_.count(key) == 0) {
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_PRED>
+inline bool amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::containsIf(const T_KEY& key, const T_PRED& pred) const {
+	MeteredOp op(metrics_, MetricsOp::CONTAINS);
+	RootNodePtr rootPtr(findRootLockFree(key));
+	if (rootPtr == nullptr) {
+		op.miss();
 		return false;
 	}
-	else {
-		//the root exists, now traverse the linked list and search for an object with a matching key that satisfies the compare function
-		DataNodePtr currentNodePtr = std::static_pointer_cast<DataLinkedListNode>(storInternal_.at(key)->nxtptr_);
 
-		while (currentNodePtr != nullptr) {
-			if (currentNodePtr->key_ == key && compareFxn(currentNodePtr->obj_)) {
-				return true;
+	//optimistic read: retry while an extraction on this key overlaps our walk
+	for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; attempt++) {
+		const unsigned int versionBefore = rootPtr->version_.load(std::memory_order_acquire);
+		if (versionBefore & 1u) {
+			boost::this_thread::yield(); //an extraction is in progress
+			continue;
+		}
+
+		const bool found = scanList(rootPtr, key, pred);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (rootPtr->version_.load(std::memory_order_relaxed) == versionBefore) {
+			if (!found) {
+				op.miss();
 			}
-			currentNodePtr = std::static_pointer_cast<DataLinkedListNode>(currentNodePtr->nxtptr_);
+			return found;
 		}
 	}
-	return false;
+
+	//heavily contended key; block extractions (but not other readers) for one consistent walk
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	const bool found = scanList(rootPtr, key, pred);
+	if (!found) {
+		op.miss();
+	}
+	return found;
 }
 
 
-template<typename T_KEY, class T_OBJ>
-inline bool amazoom::MultiHashmap<T_KEY, T_OBJ>::doesContainObj(const T_KEY& key) const {
-	//mutex inside
-	return doesContainObj(key, defaultCompareFxn_);
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::doesContainObj(const T_KEY& key) const {
+	//no object is inspected, so a single atomic load of the first link is already consistent
+	MeteredOp op(metrics_, MetricsOp::CONTAINS);
+	RootNodePtr rootPtr(findRootLockFree(key));
+	const bool found = rootPtr != nullptr && std::atomic_load(&rootPtr->nxtptr_) != nullptr;
+	if (!found) {
+		op.miss();
+	}
+	return found;
 }
 
-template <typename T_KEY, class T_OBJ>
-inline T_OBJ amazoom::MultiHashmap<T_KEY, T_OBJ>::extractItem(const T_KEY& key){
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline T_OBJ amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractItem(const T_KEY& key){
 	//mutex inside
 	return extractItem(key, defaultCompareFxn_);
 }
 
-template<typename T_KEY, class T_OBJ>
-inline T_OBJ amazoom::MultiHashmap<T_KEY, T_OBJ>::extractItem(
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline T_OBJ amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractItem(
 	const T_KEY& key, const CompareFxn compareFxn) {
 
-	boost::unique_lock<boost::shared_mutex> lock(mtx_);
+	MeteredOp op(metrics_, MetricsOp::EXTRACT); //a throw counts as a miss
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
 
-	if (!storInternal_.count(key)) {
-		throw MultiHashMapNoSuchObj("Container does not contain object matching key: " + key);
+	std::optional<T_OBJ> extractedObj(tryExtractLocked(key, compareFxn));
+	if (!extractedObj) {
+		std::ostringstream error;
+		error << "Container does not contain object matching key: " << key;
+		throw MultiHashMapNoSuchObj(error.str());
+	}
+	return std::move(*extractedObj);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::tryExtractItem(const T_KEY& key) {
+	//mutex inside
+	return tryExtractItem(key, defaultCompareFxn_);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::tryExtractItem(
+	const T_KEY& key, const CompareFxn compareFxn) {
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	return meteredExtraction(op, tryExtractLocked(key, compareFxn));
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_PRED>
+inline std::optional<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractIf(const T_KEY& key, const T_PRED& pred) {
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	return meteredExtraction(op, tryExtractLocked(key, pred));
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_PRED>
+inline std::optional<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::tryExtractLocked(
+	const T_KEY& key, const T_PRED& pred) {
+
+	auto foundRoot = storInternal_.find(key);
+	if (foundRoot == storInternal_.end()) {
+		return std::nullopt;
 	}
 	
 	//first item is always the root node. Nodes that contain actual data begin after
-	NodePtr rootPtr = storInternal_.at(key); 
+	RootNodePtr rootPtr = foundRoot->second; 
 	NodePtr currentNodePtr = rootPtr->nxtptr_;
-	NodePtr prevNode(rootPtr);
 
-	//only root exists, no data node. this occurs when all items matching this key have been taken out
-	if (rootPtr->nxtptr_ == nullptr) {
-		throw MultiHashMapNoSuchObj("Container does not contain object matching key: " + key);
+	//an empty list (only root exists) occurs when all items matching this key have been taken out
+	while (currentNodePtr != nullptr) {
+		auto castedNodePtr = std::static_pointer_cast<DataLinkedListNode>(currentNodePtr);
+
+		//key must match, and user defined comparison function must return true
+		if (castedNodePtr->key_ == key && pred(castedNodePtr->obj_)) { break; };
+
+		currentNodePtr = currentNodePtr->nxtptr_;
+	}
+
+	if (currentNodePtr == nullptr) {
+		//reached the end of the linked list, no matches
+		return std::nullopt;
 	}
+	if (claimAvailable(*rootPtr, 1, 1) == 0) {
+		//everything left is held for orders
+		return std::nullopt;
+	}
+
+	//lock-free readers may be standing on this node; tell them their walk is invalid
+	beginListWrite(rootPtr);
 
-	while (currentNodePtr->nxtptr_ != nullptr) {
-		if (currentNodePtr == nullptr) {
-			//reached the end of the linked list, no matches
-			throw MultiHashMapNoSuchObj("Container does not contain object matching special params and key: " + key);
+	//detach this node from the linked list and extract its data content
+	std::optional<T_OBJ> extractedObj(unlinkLocked(rootPtr, currentNodePtr));
+
+	endListWrite(rootPtr);
+
+	currentNumItems--;
+
+	return extractedObj;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::vector<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractItems(const T_KEY& key, int count) {
+	//mutex inside
+	return extractItems(key, count, defaultCompareFxn_);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::vector<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractItems(
+	const T_KEY& key, int count, const CompareFxn compareFxn) {
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT_BATCH);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto foundRoot = storInternal_.find(key);
+	if (count <= 0 || foundRoot == storInternal_.end()) {
+		op.miss();
+		return std::vector<T_OBJ>();
+	}
+
+	RootNodePtr rootPtr = foundRoot->second;
+	const int claimed = claimAvailable(*rootPtr, 1, count);
+	std::vector<T_OBJ> extractedObjs(extractLocked(rootPtr, key, claimed, compareFxn));
+
+	//compareFxn may have matched fewer objects than were claimed
+	rootPtr->numAvailable_ += claimed - static_cast<int>(extractedObjs.size());
+
+	if (extractedObjs.empty()) {
+		op.miss();
+	}
+	return extractedObjs;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_PRED>
+inline std::vector<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractLocked(
+	const RootNodePtr& root, const T_KEY& key, int count, const T_PRED& pred) {
+
+	std::vector<T_OBJ> extractedObjs;
+	if (count <= 0) {
+		return extractedObjs;
+	}
+	extractedObjs.reserve(count);
+
+	NodePtr currentNodePtr(root->nxtptr_);
+
+	//one version bump for the whole batch, readers retry at most once for it
+	beginListWrite(root);
+
+	while (currentNodePtr != nullptr && static_cast<int>(extractedObjs.size()) < count) {
+		NodePtr nextNodePtr(currentNodePtr->nxtptr_);
+		DataLinkedListNode& dataNode = static_cast<DataLinkedListNode&>(*currentNodePtr);
+
+		if (dataNode.key_ == key && pred(dataNode.obj_)) {
+			extractedObjs.push_back(unlinkLocked(root, currentNodePtr));
 		}
+		currentNodePtr = nextNodePtr;
+	}
 
-		auto castedNodePtr = std::static_pointer_cast<DataLinkedListNode>(currentNodePtr);
+	endListWrite(root);
 
-		//key must match, and user defined comparison function must return true
-		if (castedNodePtr->key_ == key && compareFxn(castedNodePtr->obj_)) { break; };
+	currentNumItems -= static_cast<int>(extractedObjs.size());
 
-		prevNode = currentNodePtr;
-		currentNodePtr = currentNodePtr->nxtptr_;
+	return extractedObjs;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::enableWeightIndex() {
+	static_assert(HasGetWeight<T_OBJ>::value, "the weight index orders objects by T_OBJ::getWeight()");
+
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	if (weightIndexed_) {
+		return;
+	}
+	weightIndexed_ = true;
+
+	for (const auto& keyRoot : storInternal_) {
+		RootLinkedListNode& root = *keyRoot.second;
+		root.weightIndex_.reset(new WeightIndex(alloc_));
+
+		for (LinkedListNode* node = root.nxtptr_.get(); node != nullptr; node = node->nxtptr_.get()) {
+			indexWeight(root, static_cast<DataLinkedListNode&>(*node));
+		}
 	}
-	// extract the data content of the node
-	T_OBJ extractedObj(std::move(std::static_pointer_cast<DataLinkedListNode>(currentNodePtr)->obj_));
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractLightest(const T_KEY& key) {
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	return meteredExtraction(op, extractByWeightLocked(key, LIGHTEST, 0.0f));
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractHeaviest(const T_KEY& key) {
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	return meteredExtraction(op, extractByWeightLocked(key, HEAVIEST, 0.0f));
+}
 
-	//detach this node from the linked list
-	prevNode->nxtptr_ = currentNodePtr->nxtptr_;
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractWithWeightAtMost(
+	const T_KEY& key, float maxWeight) {
+
+	MeteredOp op(metrics_, MetricsOp::EXTRACT);
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	return meteredExtraction(op, extractByWeightLocked(key, HEAVIEST_AT_MOST, maxWeight));
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractByWeightLocked(
+	const T_KEY& key, WeightPick pick, float maxWeight) {
+
+	auto foundRoot = storInternal_.find(key);
+	if (foundRoot == storInternal_.end()) {
+		return std::nullopt;
+	}
+
+	RootNodePtr rootPtr = foundRoot->second;
+	NodePtr chosenNodePtr;
+
+	if (rootPtr->weightIndex_ != nullptr) {
+		WeightIndex& index = *rootPtr->weightIndex_;
+		if (index.empty()) {
+			return std::nullopt;
+		}
+
+		typename WeightIndex::iterator chosen;
+		if (pick == LIGHTEST) {
+			chosen = index.begin();
+		}
+		else if (pick == HEAVIEST) {
+			chosen = std::prev(index.end());
+		}
+		else {
+			//first entry heavier than maxWeight; the one before it is the best fit
+			chosen = index.upper_bound(maxWeight);
+			if (chosen == index.begin()) {
+				return std::nullopt;
+			}
+			--chosen;
+		}
+
+		//take an owning reference through the predecessor, the index only holds a raw pointer
+		chosenNodePtr = chosen->second->prvptr_->nxtptr_;
+	}
+	else {
+		//no index, remember the best candidate seen during a full walk
+		float chosenWeight = 0.0f;
+		for (NodePtr currentNodePtr(rootPtr->nxtptr_); currentNodePtr != nullptr; currentNodePtr = currentNodePtr->nxtptr_) {
+			const float weight = static_cast<const DataLinkedListNode&>(*currentNodePtr).obj_.getWeight();
+
+			const bool better = (pick == LIGHTEST) ? weight < chosenWeight : weight > chosenWeight;
+			if ((pick != HEAVIEST_AT_MOST || weight <= maxWeight) && (chosenNodePtr == nullptr || better)) {
+				chosenNodePtr = currentNodePtr;
+				chosenWeight = weight;
+			}
+		}
+
+		if (chosenNodePtr == nullptr) {
+			return std::nullopt;
+		}
+	}
+
+	if (claimAvailable(*rootPtr, 1, 1) == 0) {
+		return std::nullopt;
+	}
+
+	beginListWrite(rootPtr);
+	std::optional<T_OBJ> extractedObj(unlinkLocked(rootPtr, chosenNodePtr));
+	endListWrite(rootPtr);
 
 	currentNumItems--;
 
-	return std::move(extractedObj);
+	return extractedObj;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::indexWeight(RootLinkedListNode& root, DataLinkedListNode& node) {
+	if constexpr (HasGetWeight<T_OBJ>::value) {
+		if (root.weightIndex_ != nullptr) {
+			node.weightPos_ = root.weightIndex_->emplace(node.obj_.getWeight(), &node);
+		}
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline T_OBJ amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::unlinkLocked(const RootNodePtr& root, const NodePtr& nodePtr) {
+	reclaimRetiredLocked();
+
+	DataLinkedListNode& node = static_cast<DataLinkedListNode&>(*nodePtr);
+	LinkedListNode* prevNode = node.prvptr_;
+	NodePtr nextNodePtr(node.nxtptr_);
+
+	if (nextNodePtr != nullptr) {
+		nextNodePtr->prvptr_ = prevNode;
+	}
+	if (root->weightIndex_ != nullptr) {
+		root->weightIndex_->erase(node.weightPos_);
+	}
+	root->numObjs_--;
+
+	//every live snapshot was taken at or before the current epoch, so only a node inserted before it can be in one.
+	//Such a node keeps its object, which snapshots may be reading right now, and the caller gets a copy
+	if (numSnapshots_.load(std::memory_order_relaxed) > 0 && node.createdEpoch_ < epoch_.load(std::memory_order_relaxed)) {
+		T_OBJ extractedObj(SnapshotCopy<T_OBJ>::copy(node.obj_));
+
+		std::atomic_store(&root->retired_, std::allocate_shared<RetiredEntry>(alloc_,
+			std::static_pointer_cast<DataLinkedListNode>(nodePtr), epoch_.load(std::memory_order_relaxed), root->retired_));
+		if (!root->listedRetired_) {
+			root->listedRetired_ = true;
+			retiredRoots_.push_back(root);
+		}
+
+		std::atomic_store(&prevNode->nxtptr_, nextNodePtr);
+		return extractedObj;
+	}
+
+	T_OBJ extractedObj(std::move(node.obj_));
+
+	//readers already standing on node hold their own reference and can still follow its nxtptr_
+	std::atomic_store(&prevNode->nxtptr_, nextNodePtr);
+
+	return extractedObj;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::meteredExtraction(
+	MeteredOp& op, std::optional<T_OBJ>&& extracted) {
+
+	if (!extracted) {
+		op.miss();
+	}
+	return std::move(extracted);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_VISITOR>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::visitItems(const T_VISITOR& visit) const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	for (const auto& keyRoot : storInternal_) {
+		for (const LinkedListNode* node = keyRoot.second->nxtptr_.get(); node != nullptr; node = node->nxtptr_.get()) {
+			const DataLinkedListNode& dataNode = static_cast<const DataLinkedListNode&>(*node);
+			visit(dataNode.key_, dataNode.obj_);
+		}
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_VISITOR>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::visitItems(const T_KEY& key, const T_VISITOR& visit) const {
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	auto found = storInternal_.find(key);
+	if (found == storInternal_.end()) {
+		return;
+	}
+	for (const LinkedListNode* node = found->second->nxtptr_.get(); node != nullptr; node = node->nxtptr_.get()) {
+		const DataLinkedListNode& dataNode = static_cast<const DataLinkedListNode&>(*node);
+		visit(dataNode.key_, dataNode.obj_);
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline amazoom::ContainerMetrics& amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::getMetrics() const {
+	return metrics_;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline typename amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Snapshot
+amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::snapshot() {
+	//writers are shut out while the epoch moves and the snapshot registers: every node is then either
+	//older than the snapshot or inserted after it, and every later extraction knows the snapshot exists
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+
+	const std::uint64_t epoch = ++epoch_;
+	{
+		boost::lock_guard<boost::mutex> guard(snapshotMtx_);
+		snapshotEpochs_.insert(epoch);
+	}
+	numSnapshots_++;
+
+	return Snapshot(this, epoch, currentNumItems.load(), std::atomic_load(&rootIndex_));
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::getNumSnapshots() const {
+	return numSnapshots_.load();
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<typename amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Reservation>
+amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::reserve(const T_KEY& key, int count, std::chrono::milliseconds ttl) {
+	expireReservationsIfDue();
+
+	RootNodePtr rootPtr(findRootLockFree(key));
+	if (count <= 0 || rootPtr == nullptr || claimAvailable(*rootPtr, count, count) == 0) {
+		return std::nullopt;
+	}
+	rootPtr->numReserved_ += count;
+
+	const Clock::time_point expires = Clock::now() + ttl;
+	boost::lock_guard<boost::mutex> guard(reservationMtx_);
+	const std::uint64_t id = nextReservationId_++;
+	holds_.emplace(id, Hold{ rootPtr, count, expires });
+	expiries_.emplace(expires, id);
+	nextExpiry_.store(expiries_.begin()->first.time_since_epoch().count());
+
+	return Reservation{ id, key, count };
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::vector<T_OBJ> amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::commitReservation(const Reservation& reservation) {
+	MeteredOp op(metrics_, MetricsOp::EXTRACT_BATCH); //a throw counts as a miss
+
+	Hold hold;
+	{
+		boost::lock_guard<boost::mutex> guard(reservationMtx_);
+		expireReservationsLocked(Clock::now());
+
+		auto found = holds_.find(reservation.id);
+		if (found == holds_.end()) {
+			std::ostringstream error;
+			error << "Reservation " << reservation.id << " of key " << reservation.key << " was committed, released or has expired";
+			throw MultiHashMapNoSuchReservation(error.str());
+		}
+		hold = std::move(found->second);
+		expiries_.erase(std::make_pair(hold.expires, reservation.id));
+		holds_.erase(found);
+	}
+
+	//the held units are still counted in numReserved_, so nothing else can take them before this does
+	MeteredLock<boost::unique_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	std::vector<T_OBJ> extractedObjs(extractLocked(hold.root, reservation.key, hold.count, defaultCompareFxn_));
+	hold.root->numReserved_ -= hold.count;
+
+	return extractedObjs;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::releaseReservation(const Reservation& reservation) {
+	boost::lock_guard<boost::mutex> guard(reservationMtx_);
+	expireReservationsLocked(Clock::now());
+
+	auto found = holds_.find(reservation.id);
+	if (found == holds_.end()) {
+		return false;
+	}
+	Hold& hold = found->second;
+	hold.root->numReserved_ -= hold.count;
+	hold.root->numAvailable_ += hold.count;
+
+	expiries_.erase(std::make_pair(hold.expires, reservation.id));
+	holds_.erase(found);
+	return true;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::countAvailable(const T_KEY& key) {
+	expireReservationsIfDue();
+	RootNodePtr rootPtr(findRootLockFree(key));
+	return rootPtr == nullptr ? 0 : rootPtr->numAvailable_.load();
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::countReserved(const T_KEY& key) {
+	expireReservationsIfDue();
+	RootNodePtr rootPtr(findRootLockFree(key));
+	return rootPtr == nullptr ? 0 : rootPtr->numReserved_.load();
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::getNumReservations() {
+	boost::lock_guard<boost::mutex> guard(reservationMtx_);
+	expireReservationsLocked(Clock::now());
+	return static_cast<int>(holds_.size());
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::claimAvailable(RootLinkedListNode& root, int minCount, int maxCount) {
+	int available = root.numAvailable_.load();
+	int claimed;
+	do {
+		claimed = std::min(available, maxCount);
+		if (claimed < minCount || claimed <= 0) {
+			return 0;
+		}
+	} while (!root.numAvailable_.compare_exchange_weak(available, available - claimed));
+	return claimed;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::expireReservationsLocked(Clock::time_point now) {
+	while (!expiries_.empty() && expiries_.begin()->first <= now) {
+		auto found = holds_.find(expiries_.begin()->second);
+		found->second.root->numReserved_ -= found->second.count;
+		found->second.root->numAvailable_ += found->second.count;
+		holds_.erase(found);
+		expiries_.erase(expiries_.begin());
+	}
+	nextExpiry_.store(expiries_.empty() ? std::numeric_limits<Clock::rep>::max() : expiries_.begin()->first.time_since_epoch().count());
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::expireReservationsIfDue() {
+	//no hold at all keeps nextExpiry_ at its maximum, so the clock is not even read
+	if (nextExpiry_.load(std::memory_order_relaxed) == std::numeric_limits<Clock::rep>::max()) {
+		return;
+	}
+	const Clock::time_point now = Clock::now();
+	if (nextExpiry_.load(std::memory_order_relaxed) <= now.time_since_epoch().count()) {
+		boost::lock_guard<boost::mutex> guard(reservationMtx_);
+		expireReservationsLocked(now);
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::releaseSnapshot(std::uint64_t epoch) {
+	//no mtx_, so dropping a snapshot never waits for or holds up a writer; the next one reclaims
+	boost::lock_guard<boost::mutex> guard(snapshotMtx_);
+	snapshotEpochs_.erase(snapshotEpochs_.find(epoch));
+	numSnapshots_--;
+	reclaimDue_.store(true, std::memory_order_release);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::reclaimRetiredLocked() {
+	if (!reclaimDue_.load(std::memory_order_acquire) || !reclaimDue_.exchange(false, std::memory_order_acq_rel)) {
+		return;
+	}
+
+	//no snapshot can be taken meanwhile, since that needs the shared lock
+	std::uint64_t oldestEpoch = std::numeric_limits<std::uint64_t>::max();
+	{
+		boost::lock_guard<boost::mutex> guard(snapshotMtx_);
+		if (!snapshotEpochs_.empty()) {
+			oldestEpoch = *snapshotEpochs_.begin();
+		}
+	}
+
+	//a retired node is needed while a snapshot taken at or before its extraction lives. Lists are newest
+	//first, so everything from the first entry extracted before the oldest snapshot on can go
+	for (std::size_t i = 0; i < retiredRoots_.size();) {
+		RootLinkedListNode& root = *retiredRoots_[i];
+
+		RetiredEntryPtr* link = &root.retired_;
+		while (*link != nullptr && (*link)->extractedEpoch_ >= oldestEpoch) {
+			link = &(*link)->nxtptr_;
+		}
+		std::atomic_store(link, RetiredEntryPtr());
+
+		if (root.retired_ == nullptr) {
+			root.listedRetired_ = false;
+			retiredRoots_[i] = std::move(retiredRoots_.back());
+			retiredRoots_.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::collectVisible(
+	const RootNodePtr& root, std::uint64_t epoch, std::vector<const DataLinkedListNode*>& visible) const {
+
+	//same optimistic read as containsIf: an extraction during the walk may have moved a node from the
+	//live list to the retired one, so that the walk saw it twice or not at all
+	for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; attempt++) {
+		const unsigned int versionBefore = root->version_.load(std::memory_order_acquire);
+		if (versionBefore & 1u) {
+			boost::this_thread::yield();
+			continue;
+		}
+
+		visible.clear();
+		appendVisible(root, epoch, visible);
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (root->version_.load(std::memory_order_relaxed) == versionBefore) {
+			return;
+		}
+	}
+
+	MeteredLock<boost::shared_lock<boost::shared_mutex>> lock(mtx_, metrics_);
+	visible.clear();
+	appendVisible(root, epoch, visible);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::appendVisible(
+	const RootNodePtr& root, std::uint64_t epoch, std::vector<const DataLinkedListNode*>& visible) {
+
+	//the raw pointers stay valid while the snapshot lives: a visible node that is extracted is retired, not freed
+	for (NodePtr currentNodePtr(std::atomic_load(&root->nxtptr_)); currentNodePtr != nullptr;
+		currentNodePtr = std::atomic_load(&currentNodePtr->nxtptr_)) {
+
+		const DataLinkedListNode& dataNode = static_cast<const DataLinkedListNode&>(*currentNodePtr);
+		if (dataNode.createdEpoch_ < epoch) {
+			visible.push_back(&dataNode);
+		}
+	}
+
+	//retired entries are newest first; the first one extracted before the snapshot ends the ones it can see
+	for (RetiredEntryPtr entry(std::atomic_load(&root->retired_)); entry != nullptr && entry->extractedEpoch_ >= epoch;
+		entry = std::atomic_load(&entry->nxtptr_)) {
+
+		if (entry->node_->createdEpoch_ < epoch) {
+			visible.push_back(entry->node_.get());
+		}
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Snapshot::Snapshot(
+	MultiHashmap* map, std::uint64_t epoch, int numItems, const RootIndexPtr& roots)
+	: map_(map), epoch_(epoch), numItems_(numItems), roots_(roots) {}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Snapshot::Snapshot(Snapshot&& snapshot)
+	: map_(snapshot.map_), epoch_(snapshot.epoch_), numItems_(snapshot.numItems_), roots_(std::move(snapshot.roots_)) {
+	snapshot.map_ = nullptr;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Snapshot::~Snapshot() {
+	if (map_ != nullptr) {
+		map_->releaseSnapshot(epoch_);
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Snapshot::getNumItems() const {
+	return numItems_;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Snapshot::countItems(const T_KEY& key) const {
+	int count = 0;
+	visitItems(key, [&count](const T_KEY&, const T_OBJ&) { count++; });
+	return count;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::uint64_t amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Snapshot::getEpoch() const {
+	return epoch_;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_VISITOR>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Snapshot::visitItems(const T_VISITOR& visit) const {
+	std::vector<const DataLinkedListNode*> visible;
+
+	for (const RootIndexEntryPtr& bucket : roots_->buckets_) {
+		for (RootIndexEntryPtr entry(std::atomic_load(&bucket)); entry != nullptr; entry = entry->nxtptr_) {
+			map_->collectVisible(entry->root_, epoch_, visible);
+			for (const DataLinkedListNode* node : visible) {
+				visit(node->key_, node->obj_);
+			}
+		}
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_VISITOR>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Snapshot::visitItems(const T_KEY& key, const T_VISITOR& visit) const {
+	RootNodePtr root(map_->findRootLockFree(key));
+	if (root == nullptr) {
+		return;
+	}
+
+	std::vector<const DataLinkedListNode*> visible;
+	map_->collectVisible(root, epoch_, visible);
+	for (const DataLinkedListNode* node : visible) {
+		visit(node->key_, node->obj_);
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::beginListWrite(const RootNodePtr& root) {
+	//version_ is only written under mtx_, so a plain increment is enough. Odd means "in progress"
+	std::atomic<unsigned int>& version = root->version_;
+	version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::endListWrite(const RootNodePtr& root) {
+	std::atomic<unsigned int>& version = root->version_;
+	version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline typename amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::RootNodePtr
+amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::findRootLockFree(const T_KEY& key) const {
+	RootIndexPtr index(std::atomic_load(&rootIndex_));
+
+	RootIndexEntryPtr entry(std::atomic_load(&index->buckets_[bucketFor(key, index->buckets_.size())]));
+	while (entry != nullptr) {
+		if (entry->key_ == key) {
+			return entry->root_;
+		}
+		entry = entry->nxtptr_; //entries are immutable once published
+	}
+	return nullptr;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::publishRoot(const T_KEY& key, const RootNodePtr& root) {
+	numRoots_++;
+
+	if (numRoots_ > rootIndex_->buckets_.size()) {
+		//grow by building a fresh index off to the side, then swap it in. 
+		//Readers still holding the old index are unaffected
+		RootIndexPtr grown(std::make_shared<RootIndex>(rootIndex_->buckets_.size() * 2));
+		std::vector<RootIndexEntryPtr>& buckets = grown->buckets_;
+
+		for (const auto& keyRoot : storInternal_) {
+			RootIndexEntryPtr& head = buckets[bucketFor(keyRoot.first, buckets.size())];
+			head = std::allocate_shared<RootIndexEntry>(alloc_, keyRoot.first, keyRoot.second, head);
+		}
+		RootIndexEntryPtr& head = buckets[bucketFor(key, buckets.size())];
+		head = std::allocate_shared<RootIndexEntry>(alloc_, key, root, head);
+
+		std::atomic_store(&rootIndex_, grown);
+	}
+	else {
+		RootIndexEntryPtr& head = rootIndex_->buckets_[bucketFor(key, rootIndex_->buckets_.size())];
+		std::atomic_store(&head, std::allocate_shared<RootIndexEntry>(alloc_, key, root, head));
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::size_t amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::bucketFor(const T_KEY& key, std::size_t numBuckets) {
+	//mix the bits first, std::hash is the identity for integers
+	const std::uint64_t hashed = static_cast<std::uint64_t>(std::hash<T_KEY>()(key)) * 0x9E3779B97F4A7C15ull;
+	return static_cast<std::size_t>((hashed >> 32) % numBuckets);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_PRED>
+inline bool amazoom::MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::scanList(
+	const RootNodePtr& root, const T_KEY& key, const T_PRED& pred) {
+
+	//holding a shared_ptr keeps a node alive even if it is unlinked while we stand on it
+	NodePtr currentNodePtr(std::atomic_load(&root->nxtptr_));
+
+	while (currentNodePtr != nullptr) {
+		const DataLinkedListNode& dataNode = static_cast<const DataLinkedListNode&>(*currentNodePtr);
+		if (dataNode.key_ == key && pred(dataNode.obj_)) {
+			return true;
+		}
+		currentNodePtr = std::atomic_load(&currentNodePtr->nxtptr_);
+	}
+	return false;
 }
 
 #endif
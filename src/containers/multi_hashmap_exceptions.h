@@ -8,7 +8,19 @@ namespace amazoom {
 class MultiHashMapNoSuchObj : public std::exception {
 
 public:
-	MultiHashMapNoSuchObj(std::string error) {};
+	MultiHashMapNoSuchObj(std::string error) : error_(error) {};
+
+	const char* what() const noexcept { return error_.c_str(); }
+
+private:
+	const std::string error_;
+};
+
+//thrown when committing a reservation that was already committed or released, or has expired
+class MultiHashMapNoSuchReservation : public std::exception {
+
+public:
+	MultiHashMapNoSuchReservation(std::string error) : error_(error) {};
 
 	const char* what() const noexcept { return error_.c_str(); }
 
@@ -1,5 +1,7 @@
 #include "multi_hashmap_impl.h"
 
+#include "containers/weight_aggregates.h"
+
 amazoom::MultiHashmapImpl::MultiHashmapImpl() {}
 
 amazoom::MultiHashmapImpl::~MultiHashmapImpl() {}
@@ -12,12 +14,55 @@ amazoom::Item amazoom::MultiHashmapImpl::extractItem(const Key & key, CompareFxn
 	return std::move(storage_.extractItem(key, compareFxn));
 }
 
+std::optional<amazoom::Item> amazoom::MultiHashmapImpl::tryExtractItem(const Key & key) {
+	return storage_.tryExtractItem(key);
+}
+
+std::optional<amazoom::Item> amazoom::MultiHashmapImpl::tryExtractItem(const Key & key, CompareFxn compareFxn) {
+	return storage_.tryExtractItem(key, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::MultiHashmapImpl::extractItemWait(const Key & key, std::chrono::milliseconds timeout) {
+	return waiters_.extractItemWait(key, timeout);
+}
+
+std::future<amazoom::Item> amazoom::MultiHashmapImpl::extractItemAsync(const Key & key) {
+	return waiters_.extractItemAsync(key);
+}
+
 void amazoom::MultiHashmapImpl::insertItem(Key key, Item & obj) {
 	storage_.insertItem(key, obj);
+	waiters_.notifyInserted(key);
+}
+
+void amazoom::MultiHashmapImpl::insertItems(std::vector<std::pair<Key, Item>>& objs) {
+	storage_.insertItems(objs);
+	waiters_.notifyInserted(objs);
+}
+
+std::vector<amazoom::Item> amazoom::MultiHashmapImpl::extractItems(const Key & key, int count) {
+	return storage_.extractItems(key, count);
+}
+
+std::vector<amazoom::Item> amazoom::MultiHashmapImpl::extractItems(const Key & key, int count, CompareFxn compareFxn) {
+	return storage_.extractItems(key, count, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::MultiHashmapImpl::extractLightest(const Key & key) {
+	return storage_.extractLightest(key);
 }
 
+std::optional<amazoom::Item> amazoom::MultiHashmapImpl::extractHeaviest(const Key & key) {
+	return storage_.extractHeaviest(key);
+}
+
+std::optional<amazoom::Item> amazoom::MultiHashmapImpl::extractWithWeightAtMost(const Key & key, float maxWeight) {
+	return storage_.extractWithWeightAtMost(key, maxWeight);
+}
+
+//units held by reservations are stored but cannot be extracted, so stock checks do not see them
 bool amazoom::MultiHashmapImpl::doesContainObj(const Key key) {
-	return storage_.doesContainObj(key);
+	return storage_.countAvailable(key) > 0;
 }
 
 bool amazoom::MultiHashmapImpl::doesContainObj(const Key key, CompareFxn compareFxn) {
@@ -27,3 +72,31 @@ bool amazoom::MultiHashmapImpl::doesContainObj(const Key key, CompareFxn compare
 int amazoom::MultiHashmapImpl::getNumItems() {
 	return storage_.getNumItems();
 }
+
+int amazoom::MultiHashmapImpl::countItems(const Key key) {
+	return storage_.countAvailable(key);
+}
+
+void amazoom::MultiHashmapImpl::visitItems(const std::function<void(const Key key, const Item& obj)> visitor) {
+	storage_.visitItems(visitor);
+}
+
+double amazoom::MultiHashmapImpl::totalWeight(const Key key) {
+	return WeightAggregates::totalWeight(storage_, key);
+}
+
+int amazoom::MultiHashmapImpl::countWhere(const Key key, float minWeight, float maxWeight) {
+	return WeightAggregates::countWhere(storage_, key, minWeight, maxWeight);
+}
+
+std::vector<int> amazoom::MultiHashmapImpl::weightHistogram(const Key key, float binWidth, int numBins) {
+	return WeightAggregates::weightHistogram(storage_, key, binWidth, numBins);
+}
+
+bool amazoom::MultiHashmapImpl::releaseReservation(const Reservation & reservation) {
+	if (!storage_.releaseReservation(reservation)) {
+		return false;
+	}
+	waiters_.notifyInserted(reservation.key);
+	return true;
+}
@@ -1,6 +1,7 @@
 #ifndef AMAZOOM_CONTAINERS_MULTI_HASHMAP_IMPL_H_
 #define AMAZOOM_CONTAINERS_MULTI_HASHMAP_IMPL_H_
 
+#include "containers/stock_waiters.h"
 #include "containers/worker_accessible_container.h"
 #include "containers/multi_hashmap.h"
 
@@ -21,16 +22,64 @@ public:
 	virtual Item extractItem(const Key& key);
 	virtual Item extractItem(const Key& key, const CompareFxn compareFxn);
 
+	virtual std::optional<Item> tryExtractItem(const Key& key);
+	virtual std::optional<Item> tryExtractItem(const Key& key, const CompareFxn compareFxn);
+
+	virtual std::optional<Item> extractItemWait(const Key& key, std::chrono::milliseconds timeout);
+	virtual std::future<Item> extractItemAsync(const Key& key);
+
 	virtual void insertItem(Key key, Item& obj);
 
+	virtual void insertItems(std::vector<std::pair<Key, Item>>& objs);
+	virtual std::vector<Item> extractItems(const Key& key, int count);
+	virtual std::vector<Item> extractItems(const Key& key, int count, const CompareFxn compareFxn);
+
+	virtual std::optional<Item> extractLightest(const Key& key);
+	virtual std::optional<Item> extractHeaviest(const Key& key);
+	virtual std::optional<Item> extractWithWeightAtMost(const Key& key, float maxWeight);
+
 	virtual bool doesContainObj(const Key key);
 	virtual bool doesContainObj(const Key key, const CompareFxn compareFxn);
 
 	virtual int getNumItems();
+	virtual int countItems(const Key key);
+
+	virtual void visitItems(const std::function<void(const Key key, const Item& obj)> visitor);
+
+	virtual double totalWeight(const Key key);
+	virtual int countWhere(const Key key, float minWeight, float maxWeight);
+	virtual std::vector<int> weightHistogram(const Key key, float binWidth, int numBins);
+
+	//Non-virtual fast path for callers that hold the concrete type: the predicate is inlined
+	//into the scan instead of going through a virtual call and std::function
+	template <class T_PRED>
+	bool containsIf(const Key key, const T_PRED& pred) const { return storage_.containsIf(key, pred); }
+
+	template <class T_PRED>
+	std::optional<Item> extractIf(const Key& key, const T_PRED& pred) { return storage_.extractIf(key, pred); }
+
+	//Makes the weight functions above O(log N) per key, at the cost of O(log N) insertions
+	void enableWeightIndex() { storage_.enableWeightIndex(); }
+
+	//Point-in-time view for audits and reports that does not hold up pickers, see MultiHashmap::Snapshot
+	MultiHashmap<Key, Item>::Snapshot snapshot() { return storage_.snapshot(); }
+
+	typedef MultiHashmap<Key, Item>::Reservation Reservation;
+
+	//Holds stock for an order without extracting it, see MultiHashmap::reserve. A released hold's units go to
+	//pickers waiting in extractItemWait/extractItemAsync; an expired hold's with the key's next insertion.
+	//countItems and doesContainObj(key) leave held units out, so stock checks before an extraction hold
+	std::optional<Reservation> reserve(const Key& key, int count, std::chrono::milliseconds ttl) { return storage_.reserve(key, count, ttl); }
+	std::vector<Item> commitReservation(const Reservation& reservation) { return storage_.commitReservation(reservation); }
+	bool releaseReservation(const Reservation& reservation);
+
+	int countAvailable(const Key key) { return storage_.countAvailable(key); }
+	int countReserved(const Key key) { return storage_.countReserved(key); }
 
 private:
 
 	MultiHashmap<Key, Item> storage_;
+	StockWaiters waiters_{ *this }; //after storage_, which it extracts from
 
 };
 }
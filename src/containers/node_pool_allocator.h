@@ -0,0 +1,202 @@
+#ifndef AMAZOOM_CONTAINERS_NODE_POOL_ALLOCATOR_H_
+#define AMAZOOM_CONTAINERS_NODE_POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+#include "boost/thread.hpp"
+
+namespace amazoom {
+/* Process-wide pool of fixed-size memory blocks, one pool per (size, alignment) pair.
+*  Each thread keeps a small cache of free blocks, so allocating and freeing is a pointer push/pop
+*  with no locking in the common case. Caches refill from and spill to a shared free list in batches.
+*  Blocks are carved out of large slabs that are kept for the life of the process, so memory freed
+*  here is reused by later allocations of the same size but never returned to the operating system.
+*/
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_ALIGN>
+class FixedSizePool {
+public:
+	static void* allocate();
+	static void deallocate(void* block);
+
+private:
+	enum { BLOCKS_PER_SLAB = 256, TRANSFER_BATCH = 64, MAX_CACHED_BLOCKS = 2 * TRANSFER_BATCH };
+
+	static_assert(BLOCK_ALIGN <= alignof(std::max_align_t), "slabs come from operator new, which only guarantees max_align_t");
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	//rounded so that every block in a slab stays aligned and can hold a free list link
+	static constexpr std::size_t STRIDE =
+		((BLOCK_SIZE < sizeof(FreeBlock) ? sizeof(FreeBlock) : BLOCK_SIZE) + BLOCK_ALIGN - 1) / BLOCK_ALIGN * BLOCK_ALIGN;
+
+	struct SharedPool {
+		boost::mutex mtx;
+		FreeBlock* head{ nullptr };
+		std::vector<void*> slabs;
+	};
+
+	//Trivially destructible, so it can still be read after the thread's flusher has run
+	struct ThreadCache {
+		FreeBlock* head;
+		std::size_t count;
+		bool flushed; //set once the thread is exiting; later frees bypass the cache
+	};
+
+	//returns every cached block to the shared pool when its thread exits
+	struct ThreadCacheFlusher {
+		~ThreadCacheFlusher();
+	};
+
+	static SharedPool& sharedPool();
+	static ThreadCache& threadCache();
+
+	//moves up to TRANSFER_BATCH blocks from the shared pool into cache, carving a new slab if needed
+	static void refill(ThreadCache& cache);
+
+	//moves count blocks from cache back to the shared pool
+	static void spill(ThreadCache& cache, std::size_t count);
+};
+
+/* Stateless allocator handing out single objects from FixedSizePool. Intended for node based
+*  structures, such as the MultiHashmap linked list nodes allocated through std::allocate_shared.
+*  Array allocations (n > 1) fall through to operator new.
+*/
+template <class T>
+class NodePoolAllocator {
+public:
+	typedef T value_type;
+
+	NodePoolAllocator() noexcept {}
+	template <class U>
+	NodePoolAllocator(const NodePoolAllocator<U>&) noexcept {}
+
+	T* allocate(std::size_t n) {
+		if (n == 1) {
+			return static_cast<T*>(FixedSizePool<sizeof(T), alignof(T)>::allocate());
+		}
+		return static_cast<T*>(::operator new(n * sizeof(T)));
+	}
+
+	void deallocate(T* ptr, std::size_t n) noexcept {
+		if (n == 1) {
+			FixedSizePool<sizeof(T), alignof(T)>::deallocate(ptr);
+		}
+		else {
+			::operator delete(ptr);
+		}
+	}
+
+	template <class U>
+	bool operator==(const NodePoolAllocator<U>&) const noexcept { return true; }
+	template <class U>
+	bool operator!=(const NodePoolAllocator<U>&) const noexcept { return false; }
+};
+}
+
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_ALIGN>
+inline void* amazoom::FixedSizePool<BLOCK_SIZE, BLOCK_ALIGN>::allocate() {
+	ThreadCache& cache = threadCache();
+	if (cache.head == nullptr) {
+		refill(cache);
+	}
+
+	FreeBlock* block = cache.head;
+	cache.head = block->next;
+	cache.count--;
+	return block;
+}
+
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_ALIGN>
+inline void amazoom::FixedSizePool<BLOCK_SIZE, BLOCK_ALIGN>::deallocate(void* block) {
+	ThreadCache& cache = threadCache();
+
+	FreeBlock* freed = static_cast<FreeBlock*>(block);
+	freed->next = cache.head;
+	cache.head = freed;
+	cache.count++;
+
+	//keep per-thread caches bounded; a thread that only frees (e.g. a picker) hands blocks back
+	if (cache.flushed) {
+		spill(cache, cache.count);
+	}
+	else if (cache.count > MAX_CACHED_BLOCKS) {
+		spill(cache, TRANSFER_BATCH);
+	}
+}
+
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_ALIGN>
+inline typename amazoom::FixedSizePool<BLOCK_SIZE, BLOCK_ALIGN>::SharedPool&
+amazoom::FixedSizePool<BLOCK_SIZE, BLOCK_ALIGN>::sharedPool() {
+	//intentionally leaked: containers with static storage duration may free nodes during exit
+	static SharedPool* pool = new SharedPool();
+	return *pool;
+}
+
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_ALIGN>
+inline typename amazoom::FixedSizePool<BLOCK_SIZE, BLOCK_ALIGN>::ThreadCache&
+amazoom::FixedSizePool<BLOCK_SIZE, BLOCK_ALIGN>::threadCache() {
+	thread_local ThreadCache cache{ nullptr, 0, false };
+	thread_local ThreadCacheFlusher flusher;
+	(void)flusher; //odr-use, so that it is constructed and later destroyed on this thread
+	return cache;
+}
+
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_ALIGN>
+inline amazoom::FixedSizePool<BLOCK_SIZE, BLOCK_ALIGN>::ThreadCacheFlusher::~ThreadCacheFlusher() {
+	ThreadCache& cache = threadCache();
+	spill(cache, cache.count);
+	cache.flushed = true;
+}
+
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_ALIGN>
+inline void amazoom::FixedSizePool<BLOCK_SIZE, BLOCK_ALIGN>::refill(ThreadCache& cache) {
+	SharedPool& pool = sharedPool();
+	boost::unique_lock<boost::mutex> lock(pool.mtx);
+
+	if (pool.head == nullptr) {
+		char* slab = static_cast<char*>(::operator new(STRIDE * BLOCKS_PER_SLAB));
+		pool.slabs.push_back(slab);
+
+		//thread the new blocks onto the shared free list
+		for (std::size_t i = BLOCKS_PER_SLAB; i-- > 0;) {
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + i * STRIDE);
+			block->next = pool.head;
+			pool.head = block;
+		}
+	}
+
+	for (int i = 0; i < TRANSFER_BATCH && pool.head != nullptr; i++) {
+		FreeBlock* block = pool.head;
+		pool.head = block->next;
+		block->next = cache.head;
+		cache.head = block;
+		cache.count++;
+	}
+}
+
+template <std::size_t BLOCK_SIZE, std::size_t BLOCK_ALIGN>
+inline void amazoom::FixedSizePool<BLOCK_SIZE, BLOCK_ALIGN>::spill(ThreadCache& cache, std::size_t count) {
+	if (count == 0) {
+		return;
+	}
+
+	//detach the first count blocks from the cache before taking the lock
+	FreeBlock* first = cache.head;
+	FreeBlock* last = first;
+	for (std::size_t i = 1; i < count; i++) {
+		last = last->next;
+	}
+	cache.head = last->next;
+	cache.count -= count;
+
+	SharedPool& pool = sharedPool();
+	boost::unique_lock<boost::mutex> lock(pool.mtx);
+	last->next = pool.head;
+	pool.head = first;
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include "order_transaction.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "boost/thread.hpp"
+
+amazoom::OrderTransaction::OrderTransaction() {}
+
+amazoom::OrderTransaction::~OrderTransaction() {}
+
+void amazoom::OrderTransaction::addLine(ItemContainer& container, int key, int count) {
+	if (count < 1) {
+		throw std::invalid_argument("An order line needs a count of at least one.");
+	}
+	lines_.push_back(OrderLine{ &container, key, count });
+}
+
+int amazoom::OrderTransaction::getNumLines() const {
+	return static_cast<int>(lines_.size());
+}
+
+std::vector<amazoom::Item> amazoom::OrderTransaction::execute() {
+	int unavailableLine = -1;
+	std::vector<Item> items(executeLocked(unavailableLine));
+	if (unavailableLine >= 0) {
+		throw OrderUnavailableException("Not enough items in stock for order line " + std::to_string(unavailableLine) +
+			" (key " + std::to_string(lines_[unavailableLine].key) + ").");
+	}
+	return items;
+}
+
+std::optional<std::vector<amazoom::Item>> amazoom::OrderTransaction::tryExecute() {
+	int unavailableLine = -1;
+	std::vector<Item> items(executeLocked(unavailableLine));
+	if (unavailableLine >= 0) {
+		return std::nullopt;
+	}
+	return items;
+}
+
+std::vector<amazoom::Item> amazoom::OrderTransaction::executeLocked(int& unavailableLine) {
+	//every container once, in address order. Any two transactions lock shared containers in the same order
+	std::vector<ItemContainer*> containers;
+	containers.reserve(lines_.size());
+	for (const OrderLine& line : lines_) {
+		containers.push_back(line.container);
+	}
+	std::sort(containers.begin(), containers.end(), std::less<ItemContainer*>());
+	containers.erase(std::unique(containers.begin(), containers.end()), containers.end());
+
+	std::vector<MeteredLock<boost::unique_lock<boost::shared_mutex>>> locks;
+	locks.reserve(containers.size());
+	for (ItemContainer* container : containers) {
+		locks.emplace_back(container->extractionMtx_, container->metrics_);
+	}
+
+	std::vector<Item> items;
+	unavailableLine = findUnavailableLine();
+	if (unavailableLine >= 0) {
+		return items;
+	}
+
+	//Stock counted under the locks normally stays, but a count need not be exact: a split key of a
+	//ShardedMultiHashmap is not counted at one point in time. A line that still comes up short puts back
+	//everything taken so far, so a failed order leaves every container as it was
+	std::vector<std::size_t> lineEnds;
+	lineEnds.reserve(lines_.size());
+	for (std::size_t i = 0; i < lines_.size(); i++) {
+		const OrderLine& line = lines_[i];
+		std::vector<Item> lineItems(line.container->extractItemsLocked(line.key, line.count));
+		const bool isShort = static_cast<int>(lineItems.size()) < line.count;
+		for (Item& item : lineItems) {
+			items.push_back(std::move(item));
+		}
+		lineEnds.push_back(items.size());
+
+		if (isShort) {
+			restoreLocked(items, lineEnds);
+			unavailableLine = static_cast<int>(i);
+			return std::vector<Item>();
+		}
+	}
+	return items;
+}
+
+void amazoom::OrderTransaction::restoreLocked(std::vector<Item>& items, const std::vector<std::size_t>& lineEnds) {
+	std::size_t lineStart = 0;
+	for (std::size_t i = 0; i < lineEnds.size(); i++) {
+		std::vector<Item> lineItems;
+		for (std::size_t j = lineStart; j < lineEnds[i]; j++) {
+			lineItems.push_back(std::move(items[j]));
+		}
+		lines_[i].container->restoreItemsLocked(lines_[i].key, lineItems);
+		lineStart = lineEnds[i];
+	}
+}
+
+int amazoom::OrderTransaction::findUnavailableLine() const {
+	for (std::size_t i = 0; i < lines_.size(); i++) {
+		const OrderLine& line = lines_[i];
+
+		//several lines may draw on the same key of the same container. Orders are short, so a
+		//quadratic scan beats building a map
+		int needed = line.count;
+		for (std::size_t j = 0; j < i; j++) {
+			if (lines_[j].container == line.container && lines_[j].key == line.key) {
+				needed += lines_[j].count;
+			}
+		}
+		if (line.container->countItems(line.key) < needed) {
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
@@ -0,0 +1,67 @@
+#ifndef AMAZOOM_CONTAINERS_ORDER_TRANSACTION_H_
+#define AMAZOOM_CONTAINERS_ORDER_TRANSACTION_H_
+
+#include "containers/item_container.h"
+#include "containers/order_transaction_exceptions.h"
+#include "warehouse_etc/item_definition.h"
+
+#include <optional>
+#include <vector>
+
+namespace amazoom {
+
+/* An order made of lines "count items of key from container", fulfilled all or nothing.
+*  Executing locks the extraction side of every container involved, always in the same global
+*  (address) order so that concurrent transactions cannot deadlock, checks that every line is in
+*  stock, and only then extracts. Other workers can keep inserting meanwhile, but nobody else can
+*  extract from those containers until the transaction is done, so stock that was counted stays.
+*  Should a line still come up short (a count that is not point-in-time, see ShardedMultiHashmap),
+*  what the order already took is put back and the order fails like any other.
+*
+*  Example:
+*  OrderTransaction order;
+*  order.addLine(shelfA, 12, 2);
+*  order.addLine(shelfB, 40);
+*  std::optional<std::vector<Item>> picked = order.tryExecute();
+*/
+class OrderTransaction {
+public:
+	OrderTransaction();
+	~OrderTransaction();
+
+	//Adds a line for count items of key from container. count must be at least 1.
+	//container must outlive the transaction.
+	void addLine(ItemContainer& container, int key, int count = 1);
+
+	int getNumLines() const;
+
+	/*Extracts every line. The items are returned line by line, in the order the lines were added.
+	* If any line cannot be filled nothing is extracted and OrderUnavailableException is thrown.
+	*/
+	std::vector<Item> execute();
+
+	//Same as execute, but returns an empty optional instead of throwing when a line cannot be filled
+	std::optional<std::vector<Item>> tryExecute();
+
+private:
+	struct OrderLine {
+		ItemContainer* container;
+		int key;
+		int count;
+	};
+
+	//returns the first line that cannot be filled, or -1. Caller must hold every extraction lock
+	int findUnavailableLine() const;
+
+	//execution body shared by execute and tryExecute. unavailableLine is set to -1 on success
+	std::vector<Item> executeLocked(int& unavailableLine);
+
+	//puts items back into the lines they were taken for; lineEnds[i] is the end of line i in items.
+	//Caller must hold every extraction lock
+	void restoreLocked(std::vector<Item>& items, const std::vector<std::size_t>& lineEnds);
+
+	std::vector<OrderLine> lines_;
+};
+}
+
+#endif
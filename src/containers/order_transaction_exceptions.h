@@ -0,0 +1,20 @@
+#ifndef AMAZOOM_CONTAINERS_ORDER_TRANSACTION_EXCEPTIONS_H_
+#define AMAZOOM_CONTAINERS_ORDER_TRANSACTION_EXCEPTIONS_H_
+
+#include <exception>
+#include <string>
+
+namespace amazoom {
+class OrderUnavailableException : public std::exception {
+
+public:
+	OrderUnavailableException(std::string error) : error_(error) {};
+
+	const char* what() const noexcept { return error_.c_str(); }
+
+private:
+	const std::string error_;
+};
+}
+
+#endif
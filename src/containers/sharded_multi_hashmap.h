@@ -0,0 +1,949 @@
+#ifndef AMAZOOM_CONTAINERS_SHARDED_MULTI_HASHMAP_H_
+#define AMAZOOM_CONTAINERS_SHARDED_MULTI_HASHMAP_H_
+
+#include "containers/multi_hashmap.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace amazoom {
+/* A lock-striped MultiHashmap. Keys are spread over N independent MultiHashmaps (shards) by hash,
+*  and each shard has its own mutex, so insertions and extractions on keys that live in different
+*  shards never wait on each other. All objects sharing a key live in the same shard, so the
+*  semantics of every operation are identical to a single MultiHashmap.
+*  Thread-safe. getNumItems is a sum over the shards and is not a point-in-time snapshot.
+*  T_INDEX and T_ALLOC are forwarded to every shard, see MultiHashmap.
+*
+*  Hot keys: a bestseller can hold most of the traffic and tens of thousands of objects under one key, which
+*  one shard's lock serializes and its predicate scans walk in full. After enableHotKeySplitting, every
+*  SAMPLE_PERIOD-th insertion or extraction of a thread counts towards its key's heat, and a key taking a
+*  large share of the samples is split: its objects are spread over sub-lists in several consecutive shards,
+*  each behind its own lock. Each operation on it starts at one sub-list (round robin, or one per thread)
+*  and moves on to the others only if that one cannot serve it. Once the key's share of samples falls, it is
+*  merged back into its own shard. While a key is split its objects are not visited one after another,
+*  and the weight functions extract the best of each sub-list's candidates and put the others back.
+*
+*  Splits, merges and those put-backs move objects between shards, so a lookup can pass an object in
+*  flight. A lookup or extraction that comes up short while any move ran looks again with moves held off,
+*  so it never misses an object that was stored throughout. What stays weaker than a single MultiHashmap:
+*  countItems and visitItems of a key are not point-in-time, and a weight function may pass over an object
+*  another weight function holds out at that moment.
+*/
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX = std::unordered_map, class T_ALLOC = std::allocator<T_OBJ>>
+class ShardedMultiHashmap {
+
+	typedef MultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC> Shard;
+	typedef std::unique_ptr<Shard> ShardPtr;
+	typedef std::function<bool(const T_OBJ& obj)> CompareFxn;
+
+public:
+	enum { DEFAULT_NUM_SHARDS = 16, DEFAULT_SPLIT_WAYS = 4 };
+
+	//which sub-list of a split key an operation starts at
+	enum SplitPick { ROUND_ROBIN, PER_THREAD };
+
+	//numShards must be at least 1. More shards means less contention at the cost of memory
+	explicit ShardedMultiHashmap(int numShards = DEFAULT_NUM_SHARDS, const T_ALLOC& alloc = T_ALLOC());
+
+	ShardedMultiHashmap(const ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>& hashmap) = delete;
+	ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>& operator=(const ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>& hashmap) = delete;
+
+	~ShardedMultiHashmap();
+
+	int getNumItems() const; //returns how many items are currently stored, summed over all shards
+	int getNumShards() const;
+
+	int countItems(const T_KEY& key) const; //only the shard owning key is read
+
+	//See MultiHashmap for the semantics of the functions below. Only the shard owning key is locked.
+	void insertItem(T_KEY key, T_OBJ& obj);
+
+	bool doesContainObj(const T_KEY& key, const CompareFxn compareFxn) const;
+	bool doesContainObj(const T_KEY& key) const;
+
+	T_OBJ extractItem(const T_KEY& key);
+	T_OBJ extractItem(const T_KEY& key, const CompareFxn compareFxn);
+
+	std::optional<T_OBJ> tryExtractItem(const T_KEY& key);
+	std::optional<T_OBJ> tryExtractItem(const T_KEY& key, const CompareFxn compareFxn);
+
+	template <class T_PRED>
+	bool containsIf(const T_KEY& key, const T_PRED& pred) const;
+
+	template <class T_PRED>
+	std::optional<T_OBJ> extractIf(const T_KEY& key, const T_PRED& pred);
+
+	//Batches are split by shard, and each shard is locked once for its part of the batch
+	void insertItems(std::vector<std::pair<T_KEY, T_OBJ>>& objs);
+
+	std::vector<T_OBJ> extractItems(const T_KEY& key, int count);
+	std::vector<T_OBJ> extractItems(const T_KEY& key, int count, const CompareFxn compareFxn);
+
+	//Enables the weight index on every shard
+	void enableWeightIndex();
+
+	std::optional<T_OBJ> extractLightest(const T_KEY& key);
+	std::optional<T_OBJ> extractHeaviest(const T_KEY& key);
+	std::optional<T_OBJ> extractWithWeightAtMost(const T_KEY& key, float maxWeight);
+
+	//Visits the shards one after another, each one locked only while it is visited, so unlike
+	//MultiHashmap::visitItems the objects visited are not a snapshot of the whole map
+	template <class T_VISITOR>
+	void visitItems(const T_VISITOR& visit) const;
+
+	//Visits the objects of key, one sub-list after another if it is split
+	template <class T_VISITOR>
+	void visitItems(const T_KEY& key, const T_VISITOR& visit) const;
+
+	//each shard records its own operation and mutex statistics, see MultiHashmap::getMetrics
+	ContainerMetrics& getShardMetrics(int shard) const;
+
+	/*Starts splitting hot keys over ways sub-lists (at most one per shard). Calling it again changes how
+	* later splits are made. Does nothing with a single shard.
+	*/
+	void enableHotKeySplitting(int ways = DEFAULT_SPLIT_WAYS, SplitPick pick = ROUND_ROBIN);
+
+	//Split or merge key now rather than waiting for its heat to do so. Return false if nothing changed:
+	//splitting is not enabled, key is already split (or not, for mergeKey), or MAX_SPLIT_KEYS are split
+	bool splitKey(const T_KEY& key);
+	bool mergeKey(const T_KEY& key);
+
+	bool isSplit(const T_KEY& key) const;
+	int getNumSplitKeys() const;
+
+	enum { MAX_SPLIT_KEYS = 16 };
+
+private:
+	//A split key. Sub-list i lives in shard (home + i) % numShards, sub-list 0 being the key's own shard.
+	//merged_ is set before the sub-lists are drained back into sub-list 0, see insertInto
+	class SplitInfo {
+	public:
+		SplitInfo(const T_KEY& key, std::size_t home, int ways) : key_(key), home_(home), ways_(ways) {}
+
+		const T_KEY key_;
+		const std::size_t home_;
+		const int ways_;
+		std::atomic<unsigned int> next_{ 0 }; //round robin cursor
+		std::atomic<int> heat_{ 0 }; //samples since the last cool down
+		std::atomic<bool> merged_{ false };
+	};
+
+	typedef std::shared_ptr<SplitInfo> SplitInfoPtr;
+	typedef std::vector<SplitInfoPtr> SplitTable;
+
+	//where an operation on a key goes: its own shard, plus its sub-lists if it is split
+	struct Route {
+		std::size_t home;
+		SplitInfoPtr split;
+	};
+
+	//sampled key heat, shared by keys whose hashes collide. A different key wears a slot down before taking it over
+	struct HeatSlot {
+		std::atomic<std::uint64_t> hash{ 0 };
+		std::atomic<int> hits{ 0 };
+	};
+
+	enum {
+		SAMPLE_PERIOD = 16, //one operation in this many, per thread, is sampled
+		NUM_HEAT_SLOTS = 64,
+		COOL_DOWN_SAMPLES = 2048, //heat halves, and split keys are reconsidered, after this many samples
+		SPLIT_HEAT = 256, //about a sixteenth of the samples, sustained
+		MERGE_HEAT = 32 //fewer samples than this since the last cool down merges a split key
+	};
+
+	//selects the shard that owns this key
+	std::size_t shardIndexFor(const T_KEY& key) const;
+	static std::uint64_t mixedHash(const T_KEY& key);
+
+	//routeFor also samples the key's heat, for insertions and extractions. findRoute only looks
+	Route routeFor(const T_KEY& key);
+	Route findRoute(const T_KEY& key) const;
+
+	Shard& subList(const SplitInfo& split, int way) const;
+
+	//the sub-list an operation on split starts at
+	int pickSubList(SplitInfo& split) const;
+	static unsigned int threadSlot();
+
+	//inserts into one sub-list of a key. An insertion that lands in a sub-list a merge may already have
+	//drained moves that sub-list to the key's own shard itself
+	void insertInto(const Route& route, int way, const T_KEY& key, T_OBJ& obj);
+	void drainSubList(const SplitInfo& split, int way);
+
+	//calls extract(shard) on key's sub-lists, starting at the picked one, until one returns an object
+	template <class T_EXTRACT>
+	std::optional<T_OBJ> probe(const Route& route, const T_EXTRACT& extract);
+
+	//calls extract(shard, countLeft) on key's sub-lists, starting at the picked one, until count objects are extracted
+	template <class T_EXTRACT>
+	std::vector<T_OBJ> gather(const Route& route, int count, const T_EXTRACT& extract);
+
+	//extracts extract(shard)'s candidate from every sub-list and keeps the one better(a, b) prefers over the others
+	template <class T_EXTRACT, class T_BETTER>
+	std::optional<T_OBJ> extractBest(const Route& route, const T_KEY& key, const T_EXTRACT& extract, const T_BETTER& better);
+
+	void sample(const T_KEY& key, const Route& route);
+	void coolDown();
+
+	//probe, gather and extractBest, looked at again with no move running if they came up short while one ran
+	template <class T_EXTRACT>
+	std::optional<T_OBJ> probeSettled(const T_KEY& key, const T_EXTRACT& extract);
+
+	template <class T_EXTRACT>
+	std::vector<T_OBJ> gatherSettled(const T_KEY& key, int count, const T_EXTRACT& extract);
+
+	template <class T_EXTRACT, class T_BETTER>
+	std::optional<T_OBJ> extractBestSettled(const T_KEY& key, const T_EXTRACT& extract, const T_BETTER& better);
+
+	//whether key has an object matching pred, on one route
+	template <class T_PRED>
+	bool containsOn(const Route& route, const T_KEY& key, const T_PRED& pred) const;
+
+	//taken before a lookup; movedSince tells whether any move ran while it looked
+	struct MoveStamp {
+		std::uint64_t started;
+		bool settled; //no move was running when the stamp was taken
+	};
+
+	MoveStamp stampMoves() const;
+	bool movedSince(const MoveStamp& stamp) const;
+
+	//the map whose moveMtx_ the calling thread holds, if any, so that nested moves do not lock it again
+	static const void*& moveLockHolder();
+
+	//Held by everything that moves objects between shards: splits, merges, drains and weight function put-backs
+	class MoveGuard {
+	public:
+		explicit MoveGuard(ShardedMultiHashmap& map) : map_(map), owns_(moveLockHolder() != &map) {
+			if (owns_) {
+				map_.moveMtx_.lock_shared();
+				previous_ = moveLockHolder();
+				moveLockHolder() = &map_;
+				map_.movesStarted_++;
+			}
+		}
+
+		~MoveGuard() {
+			if (owns_) {
+				map_.movesFinished_++;
+				moveLockHolder() = previous_;
+				map_.moveMtx_.unlock_shared();
+			}
+		}
+
+		MoveGuard(const MoveGuard& guard) = delete;
+		MoveGuard& operator=(const MoveGuard& guard) = delete;
+
+	private:
+		ShardedMultiHashmap& map_;
+		const bool owns_;
+		const void* previous_{ nullptr };
+	};
+
+	//Held by a lookup looking again: waits for the moves in flight to finish and holds off new ones
+	class MovesSettled {
+	public:
+		explicit MovesSettled(const ShardedMultiHashmap& map) : map_(map), owns_(moveLockHolder() != &map) {
+			if (owns_) {
+				map_.moveMtx_.lock();
+				previous_ = moveLockHolder();
+				moveLockHolder() = &map_;
+			}
+		}
+
+		~MovesSettled() {
+			if (owns_) {
+				moveLockHolder() = previous_;
+				map_.moveMtx_.unlock();
+			}
+		}
+
+		MovesSettled(const MovesSettled& settled) = delete;
+		MovesSettled& operator=(const MovesSettled& settled) = delete;
+
+	private:
+		const ShardedMultiHashmap& map_;
+		const bool owns_;
+		const void* previous_{ nullptr };
+	};
+
+	//Caller must hold splitMtx_
+	bool splitLocked(const T_KEY& key);
+	void mergeLocked(const SplitInfoPtr& split);
+	void publishSplits(const SplitTable& table);
+
+	std::vector<ShardPtr> shards_;
+
+	std::atomic<int> splitWays_{ 0 }; //0 until enableHotKeySplitting
+	std::atomic<SplitPick> splitPick_{ ROUND_ROBIN };
+
+	//published with std::atomic_store, like MultiHashmap's root index. Only consulted for a key whose shard
+	//is the home of some split key, so other shards never pay for it
+	std::shared_ptr<const SplitTable> splits_{ std::make_shared<const SplitTable>() };
+	std::vector<std::atomic<int>> splitsPerShard_;
+	boost::mutex splitMtx_; //serializes splits, merges and cool downs
+
+	std::array<HeatSlot, NUM_HEAT_SLOTS> heat_;
+	std::atomic<std::uint64_t> numSamples_{ 0 };
+
+	mutable boost::shared_mutex moveMtx_; //shared by moves, exclusive for a lookup looking again
+	std::atomic<std::uint64_t> movesStarted_{ 0 };
+	std::atomic<std::uint64_t> movesFinished_{ 0 };
+};
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::ShardedMultiHashmap(int numShards, const T_ALLOC& alloc)
+	: splitsPerShard_(numShards < 1 ? 0 : numShards) {
+	if (numShards < 1) {
+		throw std::invalid_argument("ShardedMultiHashmap requires at least one shard.");
+	}
+	shards_.reserve(numShards);
+	for (int i = 0; i < numShards; i++) {
+		shards_.push_back(ShardPtr(new Shard(alloc)));
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::~ShardedMultiHashmap() {
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::getNumItems() const {
+	int total = 0;
+	for (const ShardPtr& shard : shards_) {
+		total += shard->getNumItems();
+	}
+	return total;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::getNumShards() const {
+	return static_cast<int>(shards_.size());
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::countItems(const T_KEY& key) const {
+	Route route(findRoute(key));
+	if (route.split == nullptr) {
+		return shards_[route.home]->countItems(key);
+	}
+
+	int total = 0;
+	for (int way = 0; way < route.split->ways_; way++) {
+		total += subList(*route.split, way).countItems(key);
+	}
+	return total;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::insertItem(T_KEY key, T_OBJ& obj) {
+	Route route(routeFor(key));
+	if (route.split == nullptr) {
+		//mutex inside
+		shards_[route.home]->insertItem(key, obj);
+		return;
+	}
+	insertInto(route, pickSubList(*route.split), key, obj);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::doesContainObj(
+	const T_KEY& key, const CompareFxn compareFxn) const {
+	//lock-free inside
+	return containsIf(key, compareFxn);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::doesContainObj(const T_KEY& key) const {
+	auto isStored = [&key](const Shard& shard) {
+		//lock-free inside
+		return shard.doesContainObj(key);
+	};
+	auto anySubList = [this, &isStored](const Route& route) {
+		if (route.split == nullptr) {
+			return isStored(*shards_[route.home]);
+		}
+		for (int way = 0; way < route.split->ways_; way++) {
+			if (isStored(subList(*route.split, way))) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	const MoveStamp stamp(stampMoves());
+	const bool found = anySubList(findRoute(key));
+	if (found || !movedSince(stamp)) {
+		return found;
+	}
+	MovesSettled settled(*this);
+	return anySubList(findRoute(key));
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline T_OBJ amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractItem(const T_KEY& key) {
+	std::optional<T_OBJ> extractedObj(tryExtractItem(key));
+	if (extractedObj) {
+		return std::move(*extractedObj);
+	}
+	//mutex inside. Throws MultiHashMapNoSuchObj, as a single MultiHashmap would, unless it was just restocked
+	return shards_[shardIndexFor(key)]->extractItem(key);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline T_OBJ amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractItem(
+	const T_KEY& key, const CompareFxn compareFxn) {
+	std::optional<T_OBJ> extractedObj(tryExtractItem(key, compareFxn));
+	if (extractedObj) {
+		return std::move(*extractedObj);
+	}
+	//mutex inside
+	return shards_[shardIndexFor(key)]->extractItem(key, compareFxn);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::tryExtractItem(const T_KEY& key) {
+	//mutex inside
+	return probeSettled(key, [&key](Shard& shard) { return shard.tryExtractItem(key); });
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::tryExtractItem(
+	const T_KEY& key, const CompareFxn compareFxn) {
+	//mutex inside
+	return probeSettled(key, [&key, &compareFxn](Shard& shard) { return shard.tryExtractItem(key, compareFxn); });
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_PRED>
+inline bool amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::containsIf(const T_KEY& key, const T_PRED& pred) const {
+	const MoveStamp stamp(stampMoves());
+	const bool found = containsOn(findRoute(key), key, pred);
+	if (found || !movedSince(stamp)) {
+		return found;
+	}
+	MovesSettled settled(*this);
+	return containsOn(findRoute(key), key, pred);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_PRED>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractIf(const T_KEY& key, const T_PRED& pred) {
+	//mutex inside
+	return probeSettled(key, [&key, &pred](Shard& shard) { return shard.extractIf(key, pred); });
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::insertItems(std::vector<std::pair<T_KEY, T_OBJ>>& objs) {
+	if (shards_.size() == 1) {
+		shards_[0]->insertItems(objs);
+		return;
+	}
+
+	std::vector<std::vector<std::pair<T_KEY, T_OBJ>>> perShard(shards_.size());
+	std::vector<SplitInfoPtr> splitsUsed; //split keys that got objects outside their own shard
+	for (std::pair<T_KEY, T_OBJ>& keyObj : objs) {
+		Route route(routeFor(keyObj.first));
+		std::size_t shard = route.home;
+		if (route.split != nullptr) {
+			const int way = pickSubList(*route.split);
+			shard = (route.home + way) % shards_.size();
+			if (way != 0 && std::find(splitsUsed.begin(), splitsUsed.end(), route.split) == splitsUsed.end()) {
+				splitsUsed.push_back(route.split);
+			}
+		}
+		perShard[shard].push_back(std::move(keyObj));
+	}
+
+	for (std::size_t i = 0; i < shards_.size(); i++) {
+		if (!perShard[i].empty()) {
+			//mutex inside
+			shards_[i]->insertItems(perShard[i]);
+		}
+	}
+
+	//same check as insertInto, for every sub-list this batch may have reached
+	for (const SplitInfoPtr& split : splitsUsed) {
+		if (split->merged_.load()) {
+			for (int way = 1; way < split->ways_; way++) {
+				drainSubList(*split, way);
+			}
+		}
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::vector<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractItems(
+	const T_KEY& key, int count) {
+	//mutex inside
+	return gatherSettled(key, count, [&key](Shard& shard, int countLeft) { return shard.extractItems(key, countLeft); });
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::vector<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractItems(
+	const T_KEY& key, int count, const CompareFxn compareFxn) {
+	//mutex inside
+	return gatherSettled(key, count, [&key, &compareFxn](Shard& shard, int countLeft) { return shard.extractItems(key, countLeft, compareFxn); });
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_VISITOR>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::visitItems(const T_VISITOR& visit) const {
+	for (const ShardPtr& shard : shards_) {
+		shard->visitItems(visit);
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_VISITOR>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::visitItems(const T_KEY& key, const T_VISITOR& visit) const {
+	Route route(findRoute(key));
+	if (route.split == nullptr) {
+		shards_[route.home]->visitItems(key, visit);
+		return;
+	}
+
+	for (int way = 0; way < route.split->ways_; way++) {
+		subList(*route.split, way).visitItems(key, visit);
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline amazoom::ContainerMetrics& amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::getShardMetrics(int shard) const {
+	return shards_.at(shard)->getMetrics();
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::size_t amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::shardIndexFor(const T_KEY& key) const {
+	return static_cast<std::size_t>((mixedHash(key) >> 32) % shards_.size());
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::uint64_t amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::mixedHash(const T_KEY& key) {
+	//std::hash is the identity for integers, so mix the bits (fibonacci hashing) before picking
+	//a shard. Otherwise item IDs that step by the shard count would all land in one shard.
+	return static_cast<std::uint64_t>(std::hash<T_KEY>()(key)) * 0x9E3779B97F4A7C15ull;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::enableWeightIndex() {
+	for (ShardPtr& shard : shards_) {
+		shard->enableWeightIndex();
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractLightest(const T_KEY& key) {
+	//mutex inside
+	return extractBestSettled(key, [&key](Shard& shard) { return shard.extractLightest(key); },
+		[](const T_OBJ& a, const T_OBJ& b) { return a.getWeight() < b.getWeight(); });
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractHeaviest(const T_KEY& key) {
+	//mutex inside
+	return extractBestSettled(key, [&key](Shard& shard) { return shard.extractHeaviest(key); },
+		[](const T_OBJ& a, const T_OBJ& b) { return a.getWeight() > b.getWeight(); });
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractWithWeightAtMost(
+	const T_KEY& key, float maxWeight) {
+	//mutex inside
+	return extractBestSettled(key, [&key, maxWeight](Shard& shard) { return shard.extractWithWeightAtMost(key, maxWeight); },
+		[](const T_OBJ& a, const T_OBJ& b) { return a.getWeight() > b.getWeight(); });
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::enableHotKeySplitting(int ways, SplitPick pick) {
+	splitPick_.store(pick);
+	splitWays_.store(std::min(ways, getNumShards()) < 2 ? 0 : std::min(ways, getNumShards()));
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::splitKey(const T_KEY& key) {
+	boost::lock_guard<boost::mutex> guard(splitMtx_);
+	return splitLocked(key);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::mergeKey(const T_KEY& key) {
+	boost::lock_guard<boost::mutex> guard(splitMtx_);
+	Route route(findRoute(key));
+	if (route.split == nullptr) {
+		return false;
+	}
+	mergeLocked(route.split);
+	return true;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::isSplit(const T_KEY& key) const {
+	return findRoute(key).split != nullptr;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::getNumSplitKeys() const {
+	return static_cast<int>(std::atomic_load(&splits_)->size());
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline typename amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Route
+amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::routeFor(const T_KEY& key) {
+	Route route(findRoute(key));
+	if (splitWays_.load(std::memory_order_relaxed) == 0) {
+		return route;
+	}
+
+	//a countdown per thread rather than a shared counter, which every operation would contend on
+	thread_local unsigned int countdown = SAMPLE_PERIOD;
+	if (--countdown == 0) {
+		countdown = SAMPLE_PERIOD;
+		sample(key, route);
+	}
+	return route;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline typename amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Route
+amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::findRoute(const T_KEY& key) const {
+	Route route{ shardIndexFor(key), nullptr };
+	if (splitsPerShard_[route.home].load() == 0) {
+		return route;
+	}
+
+	std::shared_ptr<const SplitTable> splits(std::atomic_load(&splits_));
+	for (const SplitInfoPtr& split : *splits) {
+		if (split->key_ == key) {
+			route.split = split;
+			break;
+		}
+	}
+	return route;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline typename amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::Shard&
+amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::subList(const SplitInfo& split, int way) const {
+	return *shards_[(split.home_ + way) % shards_.size()];
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline int amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::pickSubList(SplitInfo& split) const {
+	if (split.merged_.load(std::memory_order_relaxed)) {
+		return 0;
+	}
+	if (splitPick_.load(std::memory_order_relaxed) == PER_THREAD) {
+		return static_cast<int>(threadSlot() % split.ways_);
+	}
+	return static_cast<int>(split.next_.fetch_add(1, std::memory_order_relaxed) % split.ways_);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline unsigned int amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::threadSlot() {
+	static std::atomic<unsigned int> numThreads{ 0 };
+	thread_local const unsigned int slot = numThreads++;
+	return slot;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::insertInto(
+	const Route& route, int way, const T_KEY& key, T_OBJ& obj) {
+
+	subList(*route.split, way).insertItem(key, obj);
+
+	/*A merge sets merged_ and then drains every sub-list under that sub-list's lock. If the drain locked this
+	* sub-list after the insertion, it took the object with it. Otherwise the insertion came after the drain,
+	* and so after merged_ was set: it is seen here, and the object is moved to the key's own shard now.
+	*/
+	if (way != 0 && route.split->merged_.load()) {
+		drainSubList(*route.split, way);
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::drainSubList(const SplitInfo& split, int way) {
+	MoveGuard moving(*this);
+	std::vector<T_OBJ> drained(subList(split, way).extractItems(split.key_, std::numeric_limits<int>::max()));
+	if (drained.empty()) {
+		return;
+	}
+
+	std::vector<std::pair<T_KEY, T_OBJ>> moved;
+	moved.reserve(drained.size());
+	for (T_OBJ& obj : drained) {
+		moved.emplace_back(split.key_, std::move(obj));
+	}
+	subList(split, 0).insertItems(moved);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_EXTRACT>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::probe(const Route& route, const T_EXTRACT& extract) {
+	if (route.split == nullptr) {
+		return extract(*shards_[route.home]);
+	}
+
+	const int ways = route.split->ways_;
+	const int start = pickSubList(*route.split);
+	for (int i = 0; i < ways; i++) {
+		std::optional<T_OBJ> extractedObj(extract(subList(*route.split, (start + i) % ways)));
+		if (extractedObj) {
+			return extractedObj;
+		}
+	}
+	return std::nullopt;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_EXTRACT>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::probeSettled(const T_KEY& key, const T_EXTRACT& extract) {
+	const MoveStamp stamp(stampMoves());
+	std::optional<T_OBJ> extractedObj(probe(routeFor(key), extract));
+	if (extractedObj || !movedSince(stamp)) {
+		return extractedObj;
+	}
+
+	//a move may have carried the object past the probe, or the route changed under it; with none running, look again
+	MovesSettled settled(*this);
+	return probe(findRoute(key), extract);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_EXTRACT>
+inline std::vector<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::gatherSettled(
+	const T_KEY& key, int count, const T_EXTRACT& extract) {
+
+	const MoveStamp stamp(stampMoves());
+	std::vector<T_OBJ> extractedObjs(gather(routeFor(key), count, extract));
+	if (static_cast<int>(extractedObjs.size()) >= count || !movedSince(stamp)) {
+		return extractedObjs;
+	}
+
+	MovesSettled settled(*this);
+	std::vector<T_OBJ> rest(gather(findRoute(key), count - static_cast<int>(extractedObjs.size()), extract));
+	std::move(rest.begin(), rest.end(), std::back_inserter(extractedObjs));
+	return extractedObjs;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_EXTRACT, class T_BETTER>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractBestSettled(
+	const T_KEY& key, const T_EXTRACT& extract, const T_BETTER& better) {
+
+	const MoveStamp stamp(stampMoves());
+	std::optional<T_OBJ> best(extractBest(routeFor(key), key, extract, better));
+	if (best || !movedSince(stamp)) {
+		return best;
+	}
+
+	MovesSettled settled(*this);
+	return extractBest(findRoute(key), key, extract, better);
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_PRED>
+inline bool amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::containsOn(const Route& route, const T_KEY& key, const T_PRED& pred) const {
+	if (route.split == nullptr) {
+		//lock-free inside
+		return shards_[route.home]->containsIf(key, pred);
+	}
+
+	for (int way = 0; way < route.split->ways_; way++) {
+		if (subList(*route.split, way).containsIf(key, pred)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline typename amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::MoveStamp
+amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::stampMoves() const {
+	//finished first: moves start before they finish, so if the later load of started matches, none was running then
+	const std::uint64_t finished = movesFinished_.load();
+	const std::uint64_t started = movesStarted_.load();
+	return MoveStamp{ started, started == finished };
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::movedSince(const MoveStamp& stamp) const {
+	return !stamp.settled || movesStarted_.load() != stamp.started;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline const void*& amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::moveLockHolder() {
+	thread_local const void* holder = nullptr;
+	return holder;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_EXTRACT>
+inline std::vector<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::gather(
+	const Route& route, int count, const T_EXTRACT& extract) {
+
+	if (route.split == nullptr) {
+		return extract(*shards_[route.home], count);
+	}
+
+	std::vector<T_OBJ> extractedObjs;
+	const int ways = route.split->ways_;
+	const int start = pickSubList(*route.split);
+	for (int i = 0; i < ways && static_cast<int>(extractedObjs.size()) < count; i++) {
+		std::vector<T_OBJ> part(extract(subList(*route.split, (start + i) % ways), count - static_cast<int>(extractedObjs.size())));
+		std::move(part.begin(), part.end(), std::back_inserter(extractedObjs));
+	}
+	return extractedObjs;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+template <class T_EXTRACT, class T_BETTER>
+inline std::optional<T_OBJ> amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::extractBest(
+	const Route& route, const T_KEY& key, const T_EXTRACT& extract, const T_BETTER& better) {
+
+	if (route.split == nullptr) {
+		return extract(*shards_[route.home]);
+	}
+
+	//candidates are out of their sub-lists until they are put back
+	MoveGuard moving(*this);
+	std::optional<T_OBJ> best;
+	int bestWay = 0;
+	for (int way = 0; way < route.split->ways_; way++) {
+		std::optional<T_OBJ> candidate(extract(subList(*route.split, way)));
+		if (!candidate) {
+			continue;
+		}
+		if (!best || better(*candidate, *best)) {
+			if (best) {
+				insertInto(route, bestWay, key, *best);
+			}
+			best = std::move(candidate);
+			bestWay = way;
+		}
+		else {
+			insertInto(route, way, key, *candidate);
+		}
+	}
+	return best;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::sample(const T_KEY& key, const Route& route) {
+	if (route.split != nullptr) {
+		route.split->heat_++;
+	}
+	else {
+		const std::uint64_t hash = mixedHash(key);
+		HeatSlot& slot = heat_[(hash >> 16) % NUM_HEAT_SLOTS];
+
+		if (slot.hash.load(std::memory_order_relaxed) == hash) {
+			if (slot.hits.fetch_add(1, std::memory_order_relaxed) + 1 >= SPLIT_HEAT) {
+				//never wait here; whoever holds splitMtx_ is already rearranging keys
+				boost::unique_lock<boost::mutex> lock(splitMtx_, boost::try_to_lock);
+				if (lock.owns_lock()) {
+					splitLocked(key);
+				}
+			}
+		}
+		else if (slot.hits.fetch_sub(1, std::memory_order_relaxed) <= 1) {
+			slot.hash.store(hash, std::memory_order_relaxed);
+			slot.hits.store(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (++numSamples_ % COOL_DOWN_SAMPLES == 0) {
+		coolDown();
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::coolDown() {
+	boost::unique_lock<boost::mutex> lock(splitMtx_, boost::try_to_lock);
+	if (!lock.owns_lock()) {
+		return;
+	}
+
+	for (HeatSlot& slot : heat_) {
+		slot.hits.store(slot.hits.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+	}
+
+	std::shared_ptr<const SplitTable> splits(std::atomic_load(&splits_));
+	for (const SplitInfoPtr& split : *splits) {
+		if (split->heat_.exchange(0) < MERGE_HEAT) {
+			mergeLocked(split);
+		}
+	}
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline bool amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::splitLocked(const T_KEY& key) {
+	const int ways = splitWays_.load();
+	std::shared_ptr<const SplitTable> splits(std::atomic_load(&splits_));
+	if (ways == 0 || splits->size() >= MAX_SPLIT_KEYS || findRoute(key).split != nullptr) {
+		return false;
+	}
+
+	MoveGuard moving(*this);
+	SplitInfoPtr split(std::make_shared<SplitInfo>(key, shardIndexFor(key), ways));
+	split->heat_ = SPLIT_HEAT; //a fresh split survives its first cool down
+	SplitTable grown(*splits);
+	grown.push_back(split);
+	publishSplits(grown);
+	splitsPerShard_[split->home_]++;
+
+	//spread the objects already stored, so the sub-lists start out even and each scan walks a share of them
+	Shard& home = subList(*split, 0);
+	const int share = home.countItems(key) / ways;
+	for (int way = 1; way < ways && share > 0; way++) {
+		std::vector<T_OBJ> objs(home.extractItems(key, share));
+		std::vector<std::pair<T_KEY, T_OBJ>> moved;
+		moved.reserve(objs.size());
+		for (T_OBJ& obj : objs) {
+			moved.emplace_back(key, std::move(obj));
+		}
+		subList(*split, way).insertItems(moved);
+	}
+
+	//heat is counted on the split itself from now on
+	HeatSlot& slot = heat_[(mixedHash(key) >> 16) % NUM_HEAT_SLOTS];
+	slot.hits.store(0, std::memory_order_relaxed);
+	return true;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::mergeLocked(const SplitInfoPtr& split) {
+	MoveGuard moving(*this);
+
+	//new insertions go to the key's own shard from here on, and stragglers drain after themselves (insertInto)
+	split->merged_.store(true);
+	for (int way = 1; way < split->ways_; way++) {
+		drainSubList(*split, way);
+	}
+
+	//extractions kept probing the sub-lists during the drain; only now do they stop
+	std::shared_ptr<const SplitTable> splits(std::atomic_load(&splits_));
+	SplitTable shrunk;
+	for (const SplitInfoPtr& other : *splits) {
+		if (other != split) {
+			shrunk.push_back(other);
+		}
+	}
+	publishSplits(shrunk);
+	splitsPerShard_[split->home_]--;
+}
+
+template <typename T_KEY, class T_OBJ, template <class...> class T_INDEX, class T_ALLOC>
+inline void amazoom::ShardedMultiHashmap<T_KEY, T_OBJ, T_INDEX, T_ALLOC>::publishSplits(const SplitTable& table) {
+	std::atomic_store(&splits_, std::shared_ptr<const SplitTable>(std::make_shared<const SplitTable>(table)));
+}
+
+#endif
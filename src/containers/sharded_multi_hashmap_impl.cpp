@@ -0,0 +1,93 @@
+#include "sharded_multi_hashmap_impl.h"
+
+#include "containers/weight_aggregates.h"
+
+amazoom::ShardedMultiHashmapImpl::ShardedMultiHashmapImpl(int numShards) : storage_(numShards) {}
+
+amazoom::ShardedMultiHashmapImpl::~ShardedMultiHashmapImpl() {}
+
+amazoom::Item amazoom::ShardedMultiHashmapImpl::extractItem(const Key & key) {
+	return storage_.extractItem(key);
+}
+
+amazoom::Item amazoom::ShardedMultiHashmapImpl::extractItem(const Key & key, CompareFxn compareFxn) {
+	return storage_.extractItem(key, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::ShardedMultiHashmapImpl::tryExtractItem(const Key & key) {
+	return storage_.tryExtractItem(key);
+}
+
+std::optional<amazoom::Item> amazoom::ShardedMultiHashmapImpl::tryExtractItem(const Key & key, CompareFxn compareFxn) {
+	return storage_.tryExtractItem(key, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::ShardedMultiHashmapImpl::extractItemWait(const Key & key, std::chrono::milliseconds timeout) {
+	return waiters_.extractItemWait(key, timeout);
+}
+
+std::future<amazoom::Item> amazoom::ShardedMultiHashmapImpl::extractItemAsync(const Key & key) {
+	return waiters_.extractItemAsync(key);
+}
+
+void amazoom::ShardedMultiHashmapImpl::insertItem(Key key, Item & obj) {
+	storage_.insertItem(key, obj);
+	waiters_.notifyInserted(key);
+}
+
+void amazoom::ShardedMultiHashmapImpl::insertItems(std::vector<std::pair<Key, Item>>& objs) {
+	storage_.insertItems(objs);
+	waiters_.notifyInserted(objs);
+}
+
+std::vector<amazoom::Item> amazoom::ShardedMultiHashmapImpl::extractItems(const Key & key, int count) {
+	return storage_.extractItems(key, count);
+}
+
+std::vector<amazoom::Item> amazoom::ShardedMultiHashmapImpl::extractItems(const Key & key, int count, CompareFxn compareFxn) {
+	return storage_.extractItems(key, count, compareFxn);
+}
+
+std::optional<amazoom::Item> amazoom::ShardedMultiHashmapImpl::extractLightest(const Key & key) {
+	return storage_.extractLightest(key);
+}
+
+std::optional<amazoom::Item> amazoom::ShardedMultiHashmapImpl::extractHeaviest(const Key & key) {
+	return storage_.extractHeaviest(key);
+}
+
+std::optional<amazoom::Item> amazoom::ShardedMultiHashmapImpl::extractWithWeightAtMost(const Key & key, float maxWeight) {
+	return storage_.extractWithWeightAtMost(key, maxWeight);
+}
+
+bool amazoom::ShardedMultiHashmapImpl::doesContainObj(const Key key) {
+	return storage_.doesContainObj(key);
+}
+
+bool amazoom::ShardedMultiHashmapImpl::doesContainObj(const Key key, CompareFxn compareFxn) {
+	return storage_.doesContainObj(key, compareFxn);
+}
+
+int amazoom::ShardedMultiHashmapImpl::getNumItems() {
+	return storage_.getNumItems();
+}
+
+int amazoom::ShardedMultiHashmapImpl::countItems(const Key key) {
+	return storage_.countItems(key);
+}
+
+void amazoom::ShardedMultiHashmapImpl::visitItems(const std::function<void(const Key key, const Item& obj)> visitor) {
+	storage_.visitItems(visitor);
+}
+
+double amazoom::ShardedMultiHashmapImpl::totalWeight(const Key key) {
+	return WeightAggregates::totalWeight(storage_, key);
+}
+
+int amazoom::ShardedMultiHashmapImpl::countWhere(const Key key, float minWeight, float maxWeight) {
+	return WeightAggregates::countWhere(storage_, key, minWeight, maxWeight);
+}
+
+std::vector<int> amazoom::ShardedMultiHashmapImpl::weightHistogram(const Key key, float binWidth, int numBins) {
+	return WeightAggregates::weightHistogram(storage_, key, binWidth, numBins);
+}
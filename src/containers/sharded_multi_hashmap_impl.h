@@ -0,0 +1,79 @@
+#ifndef AMAZOOM_CONTAINERS_SHARDED_MULTI_HASHMAP_IMPL_H_
+#define AMAZOOM_CONTAINERS_SHARDED_MULTI_HASHMAP_IMPL_H_
+
+#include "containers/stock_waiters.h"
+#include "containers/worker_accessible_container.h"
+#include "containers/sharded_multi_hashmap.h"
+
+namespace amazoom {
+
+//Bridge to connect ShardedMultiHashmap to WorkerAccessibleContainer interface.
+//Drop-in replacement for MultiHashmapImpl when many workers access the same container.
+class ShardedMultiHashmapImpl : public WorkerAccessibleContainer {
+private:
+
+	typedef amazoom::Item Item;
+	typedef int Key;
+	typedef std::function<bool(const Item& obj)> CompareFxn;
+
+public:
+	explicit ShardedMultiHashmapImpl(int numShards = ShardedMultiHashmap<Key, Item>::DEFAULT_NUM_SHARDS);
+	~ShardedMultiHashmapImpl();
+
+	virtual Item extractItem(const Key& key);
+	virtual Item extractItem(const Key& key, const CompareFxn compareFxn);
+
+	virtual std::optional<Item> tryExtractItem(const Key& key);
+	virtual std::optional<Item> tryExtractItem(const Key& key, const CompareFxn compareFxn);
+
+	virtual std::optional<Item> extractItemWait(const Key& key, std::chrono::milliseconds timeout);
+	virtual std::future<Item> extractItemAsync(const Key& key);
+
+	virtual void insertItem(Key key, Item& obj);
+
+	virtual void insertItems(std::vector<std::pair<Key, Item>>& objs);
+	virtual std::vector<Item> extractItems(const Key& key, int count);
+	virtual std::vector<Item> extractItems(const Key& key, int count, const CompareFxn compareFxn);
+
+	virtual std::optional<Item> extractLightest(const Key& key);
+	virtual std::optional<Item> extractHeaviest(const Key& key);
+	virtual std::optional<Item> extractWithWeightAtMost(const Key& key, float maxWeight);
+
+	virtual bool doesContainObj(const Key key);
+	virtual bool doesContainObj(const Key key, const CompareFxn compareFxn);
+
+	virtual int getNumItems();
+	virtual int countItems(const Key key);
+
+	virtual void visitItems(const std::function<void(const Key key, const Item& obj)> visitor);
+
+	virtual double totalWeight(const Key key);
+	virtual int countWhere(const Key key, float minWeight, float maxWeight);
+	virtual std::vector<int> weightHistogram(const Key key, float binWidth, int numBins);
+
+	//Non-virtual fast path for callers that hold the concrete type: the predicate is inlined
+	//into the scan instead of going through a virtual call and std::function
+	template <class T_PRED>
+	bool containsIf(const Key key, const T_PRED& pred) const { return storage_.containsIf(key, pred); }
+
+	template <class T_PRED>
+	std::optional<Item> extractIf(const Key& key, const T_PRED& pred) { return storage_.extractIf(key, pred); }
+
+	//Makes the weight functions above O(log N) per key, at the cost of O(log N) insertions
+	void enableWeightIndex() { storage_.enableWeightIndex(); }
+
+	//Spreads keys that take a large share of the traffic over several shards, see ShardedMultiHashmap
+	void enableHotKeySplitting(int ways = ShardedMultiHashmap<Key, Item>::DEFAULT_SPLIT_WAYS,
+		ShardedMultiHashmap<Key, Item>::SplitPick pick = ShardedMultiHashmap<Key, Item>::ROUND_ROBIN) {
+		storage_.enableHotKeySplitting(ways, pick);
+	}
+
+private:
+
+	ShardedMultiHashmap<Key, Item> storage_;
+	StockWaiters waiters_{ *this }; //after storage_, which it extracts from
+
+};
+}
+
+#endif
@@ -0,0 +1,122 @@
+#include "stock_waiters.h"
+
+#include <algorithm>
+#include <exception>
+
+amazoom::StockWaiters::StockWaiters(Storable& storage) : storage_(storage) {}
+
+amazoom::StockWaiters::~StockWaiters() {}
+
+std::optional<amazoom::Item> amazoom::StockWaiters::extractItemWait(const Key& key, std::chrono::milliseconds timeout) {
+	std::optional<Item> item = storage_.tryExtractItem(key);
+	if (item || timeout.count() <= 0) {
+		return item;
+	}
+
+	WaiterPtr waiter = std::make_shared<std::promise<Item>>();
+	std::future<Item> future = waiter->get_future();
+	enqueue(key, waiter);
+
+	if (future.wait_for(timeout) != std::future_status::ready) {
+		boost::unique_lock<boost::mutex> lock(mtx_);
+		//waiters are only completed under mtx_, so if it is still queued it will not be
+		auto found = waiters_.find(key);
+		if (found != waiters_.end()) {
+			std::deque<WaiterPtr>& queue = found->second;
+			auto queued = std::find(queue.begin(), queue.end(), waiter);
+			if (queued != queue.end()) {
+				queue.erase(queued);
+				numWaiters_--;
+				if (queue.empty()) {
+					waiters_.erase(found);
+				}
+				return std::nullopt;
+			}
+		}
+	}
+	return future.get();
+}
+
+std::future<amazoom::Item> amazoom::StockWaiters::extractItemAsync(const Key& key) {
+	WaiterPtr waiter = std::make_shared<std::promise<Item>>();
+	std::future<Item> future = waiter->get_future();
+
+	std::optional<Item> item = storage_.tryExtractItem(key);
+	if (item) {
+		waiter->set_value(std::move(*item));
+	}
+	else {
+		enqueue(key, waiter);
+	}
+	return future;
+}
+
+void amazoom::StockWaiters::notifyInserted(const Key& key) {
+	if (!hasWaiters()) {
+		return;
+	}
+	boost::unique_lock<boost::mutex> lock(mtx_);
+	serve(key);
+}
+
+void amazoom::StockWaiters::notifyInserted(const std::vector<std::pair<Key, Item>>& objs) {
+	if (!hasWaiters()) {
+		return;
+	}
+	boost::unique_lock<boost::mutex> lock(mtx_);
+	for (const std::pair<Key, Item>& keyObj : objs) {
+		serve(keyObj.first);
+	}
+}
+
+int amazoom::StockWaiters::getNumWaiters() const {
+	return numWaiters_.load();
+}
+
+void amazoom::StockWaiters::enqueue(const Key& key, const WaiterPtr& waiter) {
+	boost::unique_lock<boost::mutex> lock(mtx_);
+	waiters_[key].push_back(waiter);
+	numWaiters_++;
+	serve(key);
+}
+
+void amazoom::StockWaiters::serve(const Key& key) {
+	auto found = waiters_.find(key);
+	if (found == waiters_.end()) {
+		return;
+	}
+
+	std::deque<WaiterPtr>& queue = found->second;
+	while (!queue.empty()) {
+		std::optional<Item> item;
+		try {
+			item = storage_.tryExtractItem(key);
+		}
+		catch (...) {
+			//the extraction was made for this waiter, so it gets the failure rather than the inserting thread
+			queue.front()->set_exception(std::current_exception());
+			queue.pop_front();
+			numWaiters_--;
+			break;
+		}
+		if (!item) {
+			break;
+		}
+		queue.front()->set_value(std::move(*item));
+		queue.pop_front();
+		numWaiters_--;
+	}
+
+	if (queue.empty()) {
+		waiters_.erase(found);
+	}
+}
+
+bool amazoom::StockWaiters::hasWaiters() const {
+	/*Pairs with enqueue: an inserter stores its item, then looks for waiters; a waiter registers, then
+	* looks for items. The fence keeps the inserter's look from moving ahead of its store, so at least one
+	* of the two sees the other and the item cannot be left stored while its waiter sleeps.
+	*/
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	return numWaiters_.load(std::memory_order_relaxed) > 0;
+}
@@ -0,0 +1,77 @@
+#ifndef AMAZOOM_CONTAINERS_STOCK_WAITERS_H_
+#define AMAZOOM_CONTAINERS_STOCK_WAITERS_H_
+
+#include "containers/worker_accessible_container.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace amazoom {
+
+/* Pickers parked until a key is restocked, for the extractItemWait/extractItemAsync of a container.
+*  A picker that finds nothing queues a promise on its key's waiter list instead of retrying. The thread
+*  that then inserts the key extracts the items on the waiters' behalf, oldest waiter first, and completes
+*  their promises, so nobody polls the container.
+*
+*  Owned by the container bridge, which calls notifyInserted after every insertion. Extractions go through
+*  storage's own tryExtractItem, so a bridge that logs or counts extractions does so for handed-off items too.
+*  While nobody waits, notifyInserted costs one fence and one atomic load.
+*/
+class StockWaiters {
+private:
+	typedef amazoom::Item Item;
+	typedef int Key;
+
+public:
+	//storage is the container the items are extracted from, usually the owner itself
+	explicit StockWaiters(Storable& storage);
+
+	//Pending futures fail with std::future_error (broken_promise)
+	~StockWaiters();
+
+	StockWaiters(const StockWaiters& waiters) = delete;
+	StockWaiters& operator=(const StockWaiters& waiters) = delete;
+
+	//Extracts an item by key, waiting up to timeout for one to be inserted.
+	//Returns an empty optional if none arrived in time. Rethrows the exception of a failed extraction
+	std::optional<Item> extractItemWait(const Key& key, std::chrono::milliseconds timeout);
+
+	//Returns a future that becomes ready with an item of key, at once if one is stored
+	std::future<Item> extractItemAsync(const Key& key);
+
+	//Hands newly inserted items to the waiters of their keys
+	void notifyInserted(const Key& key);
+	void notifyInserted(const std::vector<std::pair<Key, Item>>& objs);
+
+	int getNumWaiters() const;
+
+private:
+	typedef std::shared_ptr<std::promise<Item>> WaiterPtr;
+
+	//queues waiter on key, then serves key in case an insertion happened before waiter could be seen
+	void enqueue(const Key& key, const WaiterPtr& waiter);
+
+	//Completes key's waiters, oldest first, while storage has items for them. Called with mtx_ held
+	void serve(const Key& key);
+
+	bool hasWaiters() const;
+
+	Storable& storage_;
+
+	boost::mutex mtx_;
+	std::unordered_map<Key, std::deque<WaiterPtr>> waiters_;
+	std::atomic<int> numWaiters_{ 0 };
+};
+}
+
+#endif
@@ -0,0 +1,393 @@
+#ifndef AMAZOOM_CONTAINERS_SWISS_MAP_H_
+#define AMAZOOM_CONTAINERS_SWISS_MAP_H_
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AMAZOOM_SWISS_MAP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace amazoom {
+/* Open-addressing hash map in the style of a "Swiss table". Every slot has a one byte control
+*  entry holding either EMPTY, DELETED, or the low 7 bits of the key's hash. Lookups load a group of
+*  16 control bytes at once and compare them all against the hash in a single SSE2 instruction
+*  (a portable scalar loop is used where SSE2 is unavailable), so most probes touch one cache line of
+*  control bytes and at most one slot. Slots are stored in one flat array, with no per-element allocation.
+*
+*  Implements the subset of the std::unordered_map interface used by the containers, so it can be
+*  given as the index template parameter of MultiHashmap. Not thread-safe; callers lock around it.
+*  Like std::unordered_map, insertion may invalidate iterators, but unlike it, also references.
+*/
+template <typename T_KEY, class T_VALUE, class T_HASH = std::hash<T_KEY>, class T_EQUAL = std::equal_to<T_KEY>>
+class SwissMap {
+public:
+	typedef T_KEY key_type;
+	typedef T_VALUE mapped_type;
+	typedef std::pair<const T_KEY, T_VALUE> value_type;
+	typedef std::size_t size_type;
+
+private:
+	typedef std::int8_t Ctrl;
+
+	enum : Ctrl { CTRL_EMPTY = -128, CTRL_DELETED = -2 }; //full slots hold 0..127
+	enum { GROUP_WIDTH = 16, MIN_CAPACITY = GROUP_WIDTH };
+
+	//A group of GROUP_WIDTH control bytes. Each match returns a bitmask, bit i set if byte i matched
+	class Group {
+	public:
+		explicit Group(const Ctrl* pos) {
+#ifdef AMAZOOM_SWISS_MAP_SSE2
+			ctrl_ = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+#else
+			std::memcpy(ctrl_, pos, GROUP_WIDTH);
+#endif
+		}
+
+		std::uint32_t match(Ctrl h2) const {
+#ifdef AMAZOOM_SWISS_MAP_SSE2
+			return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl_)));
+#else
+			std::uint32_t mask = 0;
+			for (int i = 0; i < GROUP_WIDTH; i++) {
+				mask |= static_cast<std::uint32_t>(ctrl_[i] == h2) << i;
+			}
+			return mask;
+#endif
+		}
+
+		std::uint32_t matchEmpty() const { return match(static_cast<Ctrl>(CTRL_EMPTY)); }
+
+		//EMPTY and DELETED are the only negative control bytes, so this is a sign bit test
+		std::uint32_t matchEmptyOrDeleted() const {
+#ifdef AMAZOOM_SWISS_MAP_SSE2
+			return static_cast<std::uint32_t>(_mm_movemask_epi8(ctrl_));
+#else
+			std::uint32_t mask = 0;
+			for (int i = 0; i < GROUP_WIDTH; i++) {
+				mask |= static_cast<std::uint32_t>(ctrl_[i] < 0) << i;
+			}
+			return mask;
+#endif
+		}
+
+	private:
+#ifdef AMAZOOM_SWISS_MAP_SSE2
+		__m128i ctrl_;
+#else
+		Ctrl ctrl_[GROUP_WIDTH];
+#endif
+	};
+
+	template <class T_MAP, class T_REF>
+	class IteratorBase {
+	public:
+		IteratorBase(T_MAP* map = nullptr, std::size_t index = 0) : map_(map), index_(index) { skipEmpty(); }
+
+		T_REF& operator*() const { return map_->slots_[index_]; }
+		T_REF* operator->() const { return &map_->slots_[index_]; }
+
+		IteratorBase& operator++() {
+			index_++;
+			skipEmpty();
+			return *this;
+		}
+
+		bool operator==(const IteratorBase& other) const { return index_ == other.index_; }
+		bool operator!=(const IteratorBase& other) const { return index_ != other.index_; }
+
+	private:
+		friend class SwissMap;
+
+		void skipEmpty() {
+			while (map_ != nullptr && index_ < map_->capacity_ && map_->ctrl_[index_] < 0) {
+				index_++;
+			}
+		}
+
+		T_MAP* map_;
+		std::size_t index_;
+	};
+
+public:
+	typedef IteratorBase<SwissMap, value_type> iterator;
+	typedef IteratorBase<const SwissMap, const value_type> const_iterator;
+
+	SwissMap();
+	SwissMap(const SwissMap& map) = delete;
+	SwissMap& operator=(const SwissMap& map) = delete;
+	~SwissMap();
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, capacity_); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, capacity_); }
+
+	size_type size() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	iterator find(const T_KEY& key);
+	const_iterator find(const T_KEY& key) const;
+	size_type count(const T_KEY& key) const { return find(key) != end() ? 1 : 0; }
+
+	//throws std::out_of_range if key is not present
+	T_VALUE& at(const T_KEY& key);
+	const T_VALUE& at(const T_KEY& key) const;
+
+	T_VALUE& operator[](const T_KEY& key) { return emplace(key, T_VALUE()).first->second; }
+
+	//does nothing and returns the existing element if key is already present
+	std::pair<iterator, bool> insert(value_type&& value) { return emplace(value.first, std::move(value.second)); }
+	std::pair<iterator, bool> emplace(const T_KEY& key, T_VALUE&& value);
+
+	size_type erase(const T_KEY& key);
+
+	//grows the table so that at least numElements fit without a rehash
+	void reserve(size_type numElements);
+
+private:
+	//splits a hash into the probe start (h1) and the control byte (h2)
+	static std::size_t hashOf(const T_KEY& key);
+	static std::size_t h1(std::size_t hash) { return hash >> 7; }
+	static Ctrl h2(std::size_t hash) { return static_cast<Ctrl>(hash & 0x7F); }
+
+	static int lowestBit(std::uint32_t mask);
+
+	//returns the slot holding key, or capacity_ if there is none
+	std::size_t findIndex(const T_KEY& key, std::size_t hash) const;
+
+	//returns the first EMPTY or DELETED slot on key's probe sequence
+	std::size_t findInsertIndex(std::size_t hash) const;
+
+	//writes a control byte, mirroring the first group past the end so groups can be loaded unaligned
+	void setCtrl(std::size_t index, Ctrl ctrl);
+
+	void rehash(std::size_t newCapacity);
+
+	static std::size_t maxLoad(std::size_t capacity) { return capacity - capacity / 8; } //7/8 load factor
+
+	std::vector<Ctrl> ctrl_;
+	value_type* slots_{ nullptr };
+	std::size_t capacity_{ 0 }; //always a power of two, or zero before the first insertion
+	std::size_t size_{ 0 };
+	std::size_t growthLeft_{ 0 }; //insertions into EMPTY slots left before a rehash is required
+
+	std::allocator<value_type> alloc_;
+};
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::SwissMap() {}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::~SwissMap() {
+	for (std::size_t i = 0; i < capacity_; i++) {
+		if (ctrl_[i] >= 0) {
+			slots_[i].~value_type();
+		}
+	}
+	if (slots_ != nullptr) {
+		alloc_.deallocate(slots_, capacity_);
+	}
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline typename amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::iterator
+amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::find(const T_KEY& key) {
+	iterator found(this, capacity_);
+	found.index_ = findIndex(key, hashOf(key)); //set directly, the found slot is full
+	return found;
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline typename amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::const_iterator
+amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::find(const T_KEY& key) const {
+	const_iterator found(this, capacity_);
+	found.index_ = findIndex(key, hashOf(key));
+	return found;
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline T_VALUE& amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::at(const T_KEY& key) {
+	const std::size_t index = findIndex(key, hashOf(key));
+	if (index == capacity_) {
+		throw std::out_of_range("SwissMap::at key not found");
+	}
+	return slots_[index].second;
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline const T_VALUE& amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::at(const T_KEY& key) const {
+	const std::size_t index = findIndex(key, hashOf(key));
+	if (index == capacity_) {
+		throw std::out_of_range("SwissMap::at key not found");
+	}
+	return slots_[index].second;
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline std::pair<typename amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::iterator, bool>
+amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::emplace(const T_KEY& key, T_VALUE&& value) {
+	const std::size_t hash = hashOf(key);
+
+	std::size_t index = findIndex(key, hash);
+	if (index != capacity_) {
+		iterator existing(this, capacity_);
+		existing.index_ = index;
+		return std::make_pair(existing, false);
+	}
+
+	index = capacity_ == 0 ? 0 : findInsertIndex(hash);
+	if (capacity_ == 0 || (growthLeft_ == 0 && ctrl_[index] == static_cast<Ctrl>(CTRL_EMPTY))) {
+		//reusing a DELETED slot never needs a rehash, filling an EMPTY one might
+		rehash(capacity_ == 0 ? static_cast<std::size_t>(MIN_CAPACITY) : (size_ + 1 > maxLoad(capacity_) / 2 ? capacity_ * 2 : capacity_));
+		index = findInsertIndex(hash);
+	}
+
+	if (ctrl_[index] == static_cast<Ctrl>(CTRL_EMPTY)) {
+		growthLeft_--;
+	}
+	new (&slots_[index]) value_type(key, std::move(value));
+	setCtrl(index, h2(hash));
+	size_++;
+
+	iterator inserted(this, capacity_);
+	inserted.index_ = index;
+	return std::make_pair(inserted, true);
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline typename amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::size_type
+amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::erase(const T_KEY& key) {
+	const std::size_t index = findIndex(key, hashOf(key));
+	if (index == capacity_) {
+		return 0;
+	}
+	slots_[index].~value_type();
+
+	//a DELETED marker keeps probe sequences that pass through this slot intact.
+	//They are cleared by the next rehash
+	setCtrl(index, static_cast<Ctrl>(CTRL_DELETED));
+	size_--;
+	return 1;
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline void amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::reserve(size_type numElements) {
+	std::size_t newCapacity = capacity_ == 0 ? static_cast<std::size_t>(MIN_CAPACITY) : capacity_;
+	while (maxLoad(newCapacity) < numElements) {
+		newCapacity *= 2;
+	}
+	if (newCapacity != capacity_) {
+		rehash(newCapacity);
+	}
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline std::size_t amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::hashOf(const T_KEY& key) {
+	//std::hash is the identity for integers; spread the bits so both h1 and h2 are useful
+	std::uint64_t hashed = static_cast<std::uint64_t>(T_HASH()(key)) * 0x9E3779B97F4A7C15ull;
+	hashed ^= hashed >> 32;
+	return static_cast<std::size_t>(hashed);
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline int amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::lowestBit(std::uint32_t mask) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctz(mask);
+#endif
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline std::size_t amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::findIndex(
+	const T_KEY& key, std::size_t hash) const {
+
+	if (capacity_ == 0) {
+		return capacity_;
+	}
+
+	const std::size_t mask = capacity_ - 1;
+	const Ctrl tag = h2(hash);
+	std::size_t pos = h1(hash) & mask;
+
+	//triangular probing over groups visits every group once when the capacity is a power of two
+	for (std::size_t probe = 1; probe <= capacity_ / GROUP_WIDTH; probe++) {
+		Group group(&ctrl_[pos]);
+
+		for (std::uint32_t matches = group.match(tag); matches != 0; matches &= matches - 1) {
+			const std::size_t index = (pos + lowestBit(matches)) & mask;
+			if (T_EQUAL()(slots_[index].first, key)) {
+				return index;
+			}
+		}
+		if (group.matchEmpty() != 0) {
+			return capacity_; //key would have been placed in this group
+		}
+		pos = (pos + probe * GROUP_WIDTH) & mask;
+	}
+	return capacity_;
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline std::size_t amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::findInsertIndex(std::size_t hash) const {
+	const std::size_t mask = capacity_ - 1;
+	std::size_t pos = h1(hash) & mask;
+
+	for (std::size_t probe = 1;; probe++) {
+		const std::uint32_t available = Group(&ctrl_[pos]).matchEmptyOrDeleted();
+		if (available != 0) {
+			return (pos + lowestBit(available)) & mask;
+		}
+		pos = (pos + probe * GROUP_WIDTH) & mask;
+	}
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline void amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::setCtrl(std::size_t index, Ctrl ctrl) {
+	ctrl_[index] = ctrl;
+	if (index < GROUP_WIDTH) {
+		ctrl_[capacity_ + index] = ctrl;
+	}
+}
+
+template <typename T_KEY, class T_VALUE, class T_HASH, class T_EQUAL>
+inline void amazoom::SwissMap<T_KEY, T_VALUE, T_HASH, T_EQUAL>::rehash(std::size_t newCapacity) {
+	std::vector<Ctrl> oldCtrl(std::move(ctrl_));
+	value_type* oldSlots = slots_;
+	const std::size_t oldCapacity = capacity_;
+
+	ctrl_.assign(newCapacity + GROUP_WIDTH, static_cast<Ctrl>(CTRL_EMPTY));
+	slots_ = alloc_.allocate(newCapacity);
+	capacity_ = newCapacity;
+	growthLeft_ = maxLoad(newCapacity) - size_;
+
+	//every element is re-placed, which also drops all DELETED markers
+	for (std::size_t i = 0; i < oldCapacity; i++) {
+		if (oldCtrl[i] >= 0) {
+			const std::size_t hash = hashOf(oldSlots[i].first);
+			const std::size_t index = findInsertIndex(hash);
+			new (&slots_[index]) value_type(std::move(const_cast<T_KEY&>(oldSlots[i].first)), std::move(oldSlots[i].second));
+			setCtrl(index, h2(hash));
+			oldSlots[i].~value_type();
+		}
+	}
+	if (oldSlots != nullptr) {
+		alloc_.deallocate(oldSlots, oldCapacity);
+	}
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include "weight_aggregates.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+amazoom::WeightAggregates::Isa amazoom::WeightAggregates::getIsa() {
+#if defined(__AVX2__)
+	return AVX2;
+#elif defined(__SSE4_1__)
+	return SSE4_1;
+#else
+	return SCALAR;
+#endif
+}
+
+const char* amazoom::WeightAggregates::getIsaName() {
+	const char* names[] = { "scalar", "sse4.1", "avx2" };
+	return names[getIsa()];
+}
+
+std::uint64_t amazoom::WeightAggregates::sumRaw(const std::uint32_t* weights, std::size_t count) {
+	//the compiler vectorizes the plain loop on every target; widening by hand measured slower.
+	//Weights only have to be below 2^31, so narrower lanes could not add more than two before widening
+	return sumRawScalar(weights, count);
+}
+
+std::size_t amazoom::WeightAggregates::countRawBetween(
+	const std::uint32_t* weights, std::size_t count, std::uint32_t minRaw, std::uint32_t maxRaw) {
+
+	std::size_t i = 0;
+	std::size_t matches = 0;
+	if (minRaw > maxRaw) {
+		return 0;
+	}
+
+	//a weight is in range exactly when clamping it to the range leaves it unchanged; matching lanes are
+	//all ones, that is -1, so subtracting them counts
+#if defined(__AVX2__)
+	const __m256i low = _mm256_set1_epi32(static_cast<int>(minRaw));
+	const __m256i high = _mm256_set1_epi32(static_cast<int>(maxRaw));
+	__m256i counts = _mm256_setzero_si256();
+	for (; i + 8 <= count; i += 8) {
+		const __m256i weight = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+		const __m256i clamped = _mm256_min_epu32(_mm256_max_epu32(weight, low), high);
+		counts = _mm256_sub_epi32(counts, _mm256_cmpeq_epi32(clamped, weight));
+	}
+	alignas(32) std::uint32_t lanes[8];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), counts);
+	for (std::uint32_t lane : lanes) {
+		matches += lane;
+	}
+#elif defined(__SSE4_1__)
+	const __m128i low = _mm_set1_epi32(static_cast<int>(minRaw));
+	const __m128i high = _mm_set1_epi32(static_cast<int>(maxRaw));
+	__m128i counts = _mm_setzero_si128();
+	for (; i + 4 <= count; i += 4) {
+		const __m128i weight = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+		const __m128i clamped = _mm_min_epu32(_mm_max_epu32(weight, low), high);
+		counts = _mm_sub_epi32(counts, _mm_cmpeq_epi32(clamped, weight));
+	}
+	alignas(16) std::uint32_t lanes[4];
+	_mm_store_si128(reinterpret_cast<__m128i*>(lanes), counts);
+	for (std::uint32_t lane : lanes) {
+		matches += lane;
+	}
+#endif
+
+	return matches + countRawBetweenScalar(weights + i, count - i, minRaw, maxRaw);
+}
+
+void amazoom::WeightAggregates::histogramRaw(
+	const std::uint32_t* weights, std::size_t count, double rawBinWidth, std::vector<int>& bins) {
+
+	std::size_t i = 0;
+
+	//bins are found by the same correctly rounded division as in histogramRawScalar, so they always agree
+#if defined(__AVX2__) || defined(__SSE4_1__)
+	const int numBins = static_cast<int>(bins.size());
+#if defined(__AVX2__)
+	const int LANES = 4;
+	const __m256d width = _mm256_set1_pd(rawBinWidth);
+	const __m256d lastBin = _mm256_set1_pd(numBins - 1);
+#else
+	const int LANES = 2;
+	const __m128d width = _mm_set1_pd(rawBinWidth);
+	const __m128d lastBin = _mm_set1_pd(numBins - 1);
+#endif
+	std::vector<int> laneBins(static_cast<std::size_t>(numBins) * LANES, 0);
+	alignas(16) int binIndex[4];
+
+	for (; i + LANES <= count; i += LANES) {
+#if defined(__AVX2__)
+		const __m128i weight = _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i));
+		const __m256d quotient = _mm256_min_pd(_mm256_div_pd(_mm256_cvtepi32_pd(weight), width), lastBin);
+		_mm_store_si128(reinterpret_cast<__m128i*>(binIndex), _mm256_cvttpd_epi32(quotient));
+#else
+		const __m128i weight = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(weights + i));
+		const __m128d quotient = _mm_min_pd(_mm_div_pd(_mm_cvtepi32_pd(weight), width), lastBin);
+		_mm_store_si128(reinterpret_cast<__m128i*>(binIndex), _mm_cvttpd_epi32(quotient));
+#endif
+		for (int lane = 0; lane < LANES; lane++) {
+			laneBins[static_cast<std::size_t>(lane) * numBins + binIndex[lane]]++;
+		}
+	}
+
+	for (int lane = 0; lane < LANES; lane++) {
+		for (int bin = 0; bin < numBins; bin++) {
+			bins[bin] += laneBins[static_cast<std::size_t>(lane) * numBins + bin];
+		}
+	}
+#endif
+
+	histogramRawScalar(weights + i, count - i, rawBinWidth, bins);
+}
+
+std::uint64_t amazoom::WeightAggregates::sumRawScalar(const std::uint32_t* weights, std::size_t count) {
+	std::uint64_t total = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		total += weights[i];
+	}
+	return total;
+}
+
+std::size_t amazoom::WeightAggregates::countRawBetweenScalar(
+	const std::uint32_t* weights, std::size_t count, std::uint32_t minRaw, std::uint32_t maxRaw) {
+
+	std::size_t matches = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		if (minRaw <= weights[i] && weights[i] <= maxRaw) {
+			matches++;
+		}
+	}
+	return matches;
+}
+
+void amazoom::WeightAggregates::histogramRawScalar(
+	const std::uint32_t* weights, std::size_t count, double rawBinWidth, std::vector<int>& bins) {
+
+	const double lastBin = static_cast<double>(bins.size() - 1);
+	for (std::size_t i = 0; i < count; i++) {
+		const double quotient = std::min(static_cast<double>(weights[i]) / rawBinWidth, lastBin);
+		bins[static_cast<std::size_t>(quotient)]++;
+	}
+}
+
+void amazoom::WeightAggregates::checkHistogram(float binWidth, int numBins) {
+	if (!(binWidth > 0.0f) || numBins < 1) {
+		throw std::invalid_argument("A weight histogram needs a positive bin width and at least one bin.");
+	}
+}
+
+int amazoom::WeightAggregates::binOf(float weight, float binWidth, int numBins) {
+	//the same quotient histogramRaw takes for a packed weight, so both kinds of container bin alike
+	const double quotient = static_cast<double>(weight) / binWidth;
+	if (!(quotient >= 1.0)) {
+		return 0;
+	}
+	return static_cast<int>(std::min(quotient, static_cast<double>(numBins - 1)));
+}
@@ -3,7 +3,12 @@
 
 #include "warehouse_etc/item_definition.h"
 
+#include <chrono>
 #include <functional>
+#include <future>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace amazoom {
 	//Read-only container
@@ -13,7 +18,7 @@ namespace amazoom {
 		typedef int Key;
 		
 	public:
-		//searches through the underlying storage scheme for an object purely by key
+		//searches through the underlying storage scheme for an object purely by key that extraction can take
 		virtual bool doesContainObj(const Key key) = 0;
 
 		/*Searches through the underlying storage scheme for an object purely by key plus provides an optional
@@ -23,6 +28,25 @@ namespace amazoom {
 
 		//Return number of items currently stored
 		virtual int getNumItems() = 0;
+
+		//Return number of items currently stored by key that extraction can take. Items held for an order
+		//(see MultiHashmapImpl::reserve) are stored but not counted
+		virtual int countItems(const Key key) = 0;
+
+		/*Calls visitor(key, item) for every item stored, with the items of a key visited one after another.
+		* Writers wait while the items are visited, so visitor must not modify this container.
+		*/
+		virtual void visitItems(const std::function<void(const Key key, const Item& obj)> visitor) = 0;
+
+		/*Aggregates over the items stored by key, without extracting them:
+		* totalWeight sums their weights, countWhere counts those with minWeight <= weight <= maxWeight, and
+		* weightHistogram counts them per bin of binWidth kg starting at 0, bin i holding weights in
+		* [i * binWidth, (i + 1) * binWidth) and the last of the numBins bins everything heavier too.
+		* weightHistogram throws std::invalid_argument unless binWidth > 0 and numBins >= 1.
+		*/
+		virtual double totalWeight(const Key key) = 0;
+		virtual int countWhere(const Key key, float minWeight, float maxWeight) = 0;
+		virtual std::vector<int> weightHistogram(const Key key, float binWidth, int numBins) = 0;
 	};
 
 	//Write-only container
@@ -40,15 +64,56 @@ namespace amazoom {
 		*/
 		virtual Item extractItem(const Key& key, const std::function<bool(const Item& obj)> compareFxn) = 0;
 
+		/*Same as extractItem, but returns an empty optional instead of throwing if no item matches.
+		*/
+		virtual std::optional<Item> tryExtractItem(const Key& key) = 0;
+		virtual std::optional<Item> tryExtractItem(const Key& key, const std::function<bool(const Item& obj)> compareFxn) = 0;
+
+		/*Extracts an item by key, waiting up to timeout for one to be inserted if none is stored, rather than
+		* the caller retrying. The insertion that supplies the key hands the item over directly.
+		* Returns an empty optional if none arrived in time.
+		*/
+		virtual std::optional<Item> extractItemWait(const Key& key, std::chrono::milliseconds timeout) = 0;
+
+		/*Returns a future for an item of key: ready at once if one is stored, otherwise completed by the
+		* insertion that supplies it. The future fails with std::future_error if the container is destroyed first.
+		*/
+		virtual std::future<Item> extractItemAsync(const Key& key) = 0;
+
 		/*Inserts an item obj, and indexes it by key
 		* custom compare function to narrow the search, and extracts it.
 		*/
 		virtual void insertItem(Key key, Item& obj) = 0;
+
+		/*Inserts every (key, item) pair as one batch, paying for synchronization once rather than per item.
+		* Items are moved out of objs.
+		*/
+		virtual void insertItems(std::vector<std::pair<Key, Item>>& objs) = 0;
+
+		/*Extracts up to count items matching key as one batch. Returns fewer items, possibly none,
+		* if not enough are stored.
+		*/
+		virtual std::vector<Item> extractItems(const Key& key, int count) = 0;
+
+		/*Same as above, but only items that also satisfy compareFxn are extracted.
+		*/
+		virtual std::vector<Item> extractItems(const Key& key, int count, const std::function<bool(const Item& obj)> compareFxn) = 0;
+
+		/*Extracts the lightest or heaviest item stored by key, or the heaviest one weighing at most maxWeight.
+		* Returns an empty optional if there is no such item.
+		*/
+		virtual std::optional<Item> extractLightest(const Key& key) = 0;
+		virtual std::optional<Item> extractHeaviest(const Key& key) = 0;
+		virtual std::optional<Item> extractWithWeightAtMost(const Key& key, float maxWeight) = 0;
 	};
 	/*Interface for swapping out an underlying storage class
 	* Containers must be checkable, and storable
 	*/
-	class WorkerAccessibleContainer : public Storable, public Checkable { };
+	class WorkerAccessibleContainer : public Storable, public Checkable {
+	public:
+		//containers own their storage through this interface, so the implementation must be destroyed too
+		virtual ~WorkerAccessibleContainer() {}
+	};
 }
 
 #endif
\ No newline at end of file
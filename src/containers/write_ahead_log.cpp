@@ -0,0 +1,390 @@
+#include "write_ahead_log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const std::uint32_t BATCH_MAGIC = 0x4c415741; //"AWAL"
+
+const std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+const std::uint64_t FNV_PRIME = 1099511628211ull;
+
+//thin wrappers over the unbuffered file API: the log must control exactly when bytes reach the OS and the disk
+#ifdef _WIN32
+int openLog(const std::string& path, bool truncate) {
+	return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | (truncate ? _O_TRUNC : 0), _S_IREAD | _S_IWRITE);
+}
+
+bool writeLog(int fd, const char* data, std::size_t size) {
+	while (size > 0) {
+		int written = _write(fd, data, static_cast<unsigned int>(size));
+		if (written < 0) {
+			return false;
+		}
+		data += written;
+		size -= static_cast<std::size_t>(written);
+	}
+	return true;
+}
+
+bool syncLog(int fd) {
+	return _commit(fd) == 0;
+}
+
+void closeLog(int fd) {
+	_close(fd);
+}
+#else
+int openLog(const std::string& path, bool truncate) {
+	return ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+}
+
+bool writeLog(int fd, const char* data, std::size_t size) {
+	while (size > 0) {
+		ssize_t written = ::write(fd, data, size);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		data += written;
+		size -= static_cast<std::size_t>(written);
+	}
+	return true;
+}
+
+bool syncLog(int fd) {
+#ifdef __APPLE__
+	return ::fsync(fd) == 0;
+#else
+	//the file only grows by appends, so syncing its data (and size) without the rest of its metadata is enough
+	return ::fdatasync(fd) == 0;
+#endif
+}
+
+void closeLog(int fd) {
+	::close(fd);
+}
+#endif
+}
+
+amazoom::WriteAheadLog::WriteAheadLog(const std::string& path, Durability durability, int asyncIntervalMs)
+	: path_(path), durability_(durability), asyncIntervalMs_(asyncIntervalMs) {
+	//appending after a torn batch would hide every later batch from replay, so the tail is cut off first
+	std::error_code error;
+	if (std::filesystem::exists(path_, error)) {
+		bool tornTail = false;
+		const std::uint64_t validLength = scan(path_, [](const Record*, std::size_t) {}, tornTail);
+		if (tornTail) {
+			std::filesystem::resize_file(path_, validLength, error);
+			if (error) {
+				throw WriteAheadLogException("Could not cut off the torn end of write-ahead log " + path_ + ": " + error.message());
+			}
+		}
+	}
+
+	fd_ = openLog(path_, false);
+	if (fd_ < 0) {
+		throw WriteAheadLogException("Could not open write-ahead log " + path_ + ": " + std::strerror(errno));
+	}
+
+	if (durability_ == ASYNC) {
+		committer_.reset(new boost::thread([this]() { runCommitter(); }));
+	}
+}
+
+amazoom::WriteAheadLog::~WriteAheadLog() {
+	if (committer_) {
+		{
+			boost::lock_guard<boost::mutex> lock(mtx_);
+			stopping_ = true;
+		}
+		committerCv_.notify_one();
+		committer_->join();
+	}
+
+	try {
+		sync();
+	}
+	catch (WriteAheadLogException&) {
+		//already reported to the appenders; there is nobody left to tell
+	}
+	closeLog(fd_);
+}
+
+void amazoom::WriteAheadLog::logInsert(int key, const Item& item) {
+	const Record record = toRecord(INSERT, key, item);
+	append(&record, 1);
+}
+
+void amazoom::WriteAheadLog::logInserts(const std::vector<std::pair<int, Item>>& objs) {
+	std::vector<Record> records;
+	records.reserve(objs.size());
+	for (const std::pair<int, Item>& obj : objs) {
+		records.push_back(toRecord(INSERT, obj.first, obj.second));
+	}
+	append(records.data(), records.size());
+}
+
+void amazoom::WriteAheadLog::logExtract(int key, const Item& item) {
+	const Record record = toRecord(EXTRACT, key, item);
+	append(&record, 1);
+}
+
+void amazoom::WriteAheadLog::logExtracts(int key, const std::vector<Item>& items) {
+	std::vector<Record> records;
+	records.reserve(items.size());
+	for (const Item& item : items) {
+		records.push_back(toRecord(EXTRACT, key, item));
+	}
+	append(records.data(), records.size());
+}
+
+void amazoom::WriteAheadLog::sync() {
+	boost::unique_lock<boost::mutex> lock(mtx_);
+	awaitCommit(lock, appended_, true);
+}
+
+void amazoom::WriteAheadLog::truncate() {
+	boost::unique_lock<boost::mutex> lock(mtx_);
+	while (committing_) {
+		committedCv_.wait(lock);
+	}
+
+	closeLog(fd_);
+	fd_ = openLog(path_, true);
+	if (fd_ < 0 || !syncLog(fd_)) {
+		error_ = "Could not truncate write-ahead log " + path_ + ": " + std::strerror(errno);
+		throw WriteAheadLogException(error_);
+	}
+
+	//whatever was still buffered happened before the snapshot too
+	pending_.clear();
+	written_ = appended_;
+	synced_ = appended_;
+	committedCv_.notify_all();
+}
+
+amazoom::WriteAheadLog::Durability amazoom::WriteAheadLog::getDurability() const {
+	return durability_;
+}
+
+const std::string& amazoom::WriteAheadLog::getPath() const {
+	return path_;
+}
+
+amazoom::WriteAheadLog::Stats amazoom::WriteAheadLog::getStats() const {
+	boost::lock_guard<boost::mutex> lock(mtx_);
+	return stats_;
+}
+
+void amazoom::WriteAheadLog::append(const Record* records, std::size_t count) {
+	if (count == 0) {
+		return;
+	}
+
+	boost::unique_lock<boost::mutex> lock(mtx_);
+	if (!error_.empty()) {
+		throw WriteAheadLogException(error_);
+	}
+	pending_.insert(pending_.end(), records, records + count);
+	appended_ += count;
+	stats_.recordsAppended += count;
+
+	if (durability_ == ASYNC) {
+		if (pending_.size() >= ASYNC_COMMIT_RECORDS) {
+			committerCv_.notify_one();
+		}
+		return;
+	}
+	awaitCommit(lock, appended_, durability_ == SYNC);
+}
+
+void amazoom::WriteAheadLog::awaitCommit(boost::unique_lock<boost::mutex>& lock, std::uint64_t seq, bool sync) {
+	while (error_.empty() && (sync ? synced_ : written_) < seq) {
+		if (committing_) {
+			committedCv_.wait(lock);
+		}
+		else {
+			commit(lock, sync);
+		}
+	}
+	if (!error_.empty()) {
+		throw WriteAheadLogException(error_);
+	}
+}
+
+void amazoom::WriteAheadLog::commit(boost::unique_lock<boost::mutex>& lock, bool sync) {
+	committing_ = true;
+
+	std::vector<Record> batch;
+	batch.swap(pending_);
+	pending_.swap(spare_);
+	const std::uint64_t end = appended_;
+	const bool needsSync = sync && synced_ < end;
+
+	//appenders keep filling pending_ while this batch is written; they make up the next commit
+	lock.unlock();
+
+	std::string error;
+	if (!batch.empty()) {
+		BatchHeader header{ BATCH_MAGIC, static_cast<std::uint32_t>(batch.size()), 0 };
+		header.checksum = checksum(header, batch.data());
+
+		//header and records go out in one write, so the batch is either wholly in the file or torn at its end
+		const std::size_t recordBytes = batch.size() * sizeof(Record);
+		writeBuffer_.resize(sizeof(BatchHeader) + recordBytes);
+		std::memcpy(writeBuffer_.data(), &header, sizeof(BatchHeader));
+		std::memcpy(writeBuffer_.data() + sizeof(BatchHeader), batch.data(), recordBytes);
+
+		if (!writeLog(fd_, writeBuffer_.data(), writeBuffer_.size())) {
+			error = "Could not write to write-ahead log " + path_ + ": " + std::strerror(errno);
+		}
+	}
+	if (error.empty() && needsSync && !syncLog(fd_)) {
+		error = "Could not sync write-ahead log " + path_ + ": " + std::strerror(errno);
+	}
+
+	lock.lock();
+	if (!error.empty()) {
+		error_ = error;
+	}
+	else {
+		written_ = end;
+		if (needsSync) {
+			synced_ = end;
+			stats_.syncs++;
+		}
+		if (!batch.empty()) {
+			stats_.commits++;
+		}
+	}
+
+	batch.clear();
+	spare_.swap(batch);
+	committing_ = false;
+	committedCv_.notify_all();
+}
+
+void amazoom::WriteAheadLog::runCommitter() {
+	boost::unique_lock<boost::mutex> lock(mtx_);
+	while (!stopping_) {
+		committerCv_.wait_for(lock, boost::chrono::milliseconds(asyncIntervalMs_));
+		if (!committing_ && error_.empty() && synced_ < appended_) {
+			commit(lock, true);
+		}
+	}
+}
+
+amazoom::WriteAheadLog::ReplayResult amazoom::WriteAheadLog::replay(const std::string& path, Storable& storage) {
+	ReplayResult result{};
+
+	//consecutive insertions are applied as one batch; an extraction has to see every insertion before it
+	std::vector<std::pair<int, Item>> inserts;
+	auto flushInserts = [&storage, &inserts]() {
+		if (!inserts.empty()) {
+			storage.insertItems(inserts);
+			inserts.clear();
+		}
+	};
+
+	scan(path, [&](const Record* records, std::size_t count) {
+		for (std::size_t i = 0; i < count; i++) {
+			const Record& record = records[i];
+			if (record.op == INSERT) {
+				inserts.emplace_back(record.key, toItem(record));
+				result.inserts++;
+				continue;
+			}
+
+			flushInserts();
+			const bool isLarge = (record.flags & IS_LARGE) != 0;
+			std::optional<Item> extracted = storage.tryExtractItem(record.key, [&record, isLarge](const Item& item) {
+				return item.getID() == record.itemID && item.getWeight() == record.weight && item.isLarge() == isLarge;
+			});
+			if (extracted) {
+				result.extracts++;
+			}
+			else {
+				result.missingExtracts++;
+			}
+		}
+	}, result.tornTail);
+
+	flushInserts();
+	return result;
+}
+
+template <class T_ON_BATCH>
+std::uint64_t amazoom::WriteAheadLog::scan(const std::string& path, const T_ON_BATCH& onBatch, bool& tornTail) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		throw WriteAheadLogException("Could not read write-ahead log " + path);
+	}
+	in.seekg(0, std::ios::end);
+	const std::uint64_t fileSize = static_cast<std::uint64_t>(in.tellg());
+	in.seekg(0, std::ios::beg);
+
+	std::vector<Record> records;
+	std::uint64_t validLength = 0;
+	tornTail = false;
+
+	while (validLength < fileSize) {
+		BatchHeader header;
+		if (fileSize - validLength < sizeof(BatchHeader) || !in.read(reinterpret_cast<char*>(&header), sizeof(BatchHeader))) {
+			tornTail = true;
+			break;
+		}
+
+		//the count is checked against the rest of the file before it sizes anything
+		const std::uint64_t batchSize = sizeof(BatchHeader) + static_cast<std::uint64_t>(header.numRecords) * sizeof(Record);
+		if (header.magic != BATCH_MAGIC || batchSize > fileSize - validLength) {
+			tornTail = true;
+			break;
+		}
+
+		records.resize(header.numRecords);
+		if (!in.read(reinterpret_cast<char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(Record))) ||
+			checksum(header, records.data()) != header.checksum) {
+			tornTail = true;
+			break;
+		}
+
+		onBatch(records.data(), records.size());
+		validLength += batchSize;
+	}
+	return validLength;
+}
+
+amazoom::WriteAheadLog::Record amazoom::WriteAheadLog::toRecord(Op op, int key, const Item& item) {
+	return Record{ op, key, item.getID(), item.getWeight(), item.isLarge() ? static_cast<std::uint32_t>(IS_LARGE) : 0u };
+}
+
+amazoom::Item amazoom::WriteAheadLog::toItem(const Record& record) {
+	return Item(record.itemID, record.weight, (record.flags & IS_LARGE) != 0);
+}
+
+std::uint64_t amazoom::WriteAheadLog::checksum(const BatchHeader& header, const Record* records) {
+	//FNV-1a over 32-bit words (records are 20 bytes), seeded with the count so a torn header is caught too
+	std::uint64_t hash = (FNV_OFFSET_BASIS ^ header.numRecords) * FNV_PRIME;
+	const char* current = reinterpret_cast<const char*>(records);
+	const char* end = current + static_cast<std::size_t>(header.numRecords) * sizeof(Record);
+	for (; current != end; current += 4) {
+		std::uint32_t word;
+		std::memcpy(&word, current, sizeof(word));
+		hash = (hash ^ word) * FNV_PRIME;
+	}
+	return hash;
+}
@@ -0,0 +1,179 @@
+#ifndef AMAZOOM_CONTAINERS_WRITE_AHEAD_LOG_H_
+#define AMAZOOM_CONTAINERS_WRITE_AHEAD_LOG_H_
+
+#include "containers/worker_accessible_container.h"
+#include "containers/write_ahead_log_exceptions.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace amazoom {
+
+/* Append-only log of the insertions and extractions made on containers, so that after a crash a
+*  container can be rebuilt from its last InventorySnapshot plus the log written since.
+*  Usually filled by LoggedContainerImpl rather than called directly.
+*
+*  Group commit: appending only copies the records into a shared buffer. A thread that has to wait for its
+*  records to be committed writes, if no other thread is already doing so, everything buffered so far with
+*  a single write (and, for SYNC, a single fdatasync) on behalf of every thread that appended meanwhile.
+*  While one commit syncs, the next one accumulates, so the more threads log at once, the more records
+*  each sync covers.
+*
+*  Durability, chosen per log:
+*    ASYNC  appending returns once the records are buffered; a background thread commits and syncs every
+*           asyncIntervalMs. A crash loses at most the last interval
+*    WRITE  appending returns once the records are written to the file. They survive the process, not the machine
+*    SYNC   appending returns once the records are synced to disk
+*
+*  File layout, in native byte order: one batch per commit, each a BatchHeader (magic, record count and a
+*  checksum) followed by its Records. A crash mid-commit can leave a torn last batch: replay stops before
+*  it, and opening the log cuts it off so that new batches follow the last valid one.
+*
+*  Example:
+*  WriteAheadLog log("shelf_12.wal", WriteAheadLog::SYNC);
+*  StoragePtr storage(new MultiHashmapImpl());
+*  StoragePtr logged(new LoggedContainerImpl(storage, log));
+*  Box shelf(logged);
+*  ...
+*  //checkpoint, while the shelf is not being modified. write returns only once the snapshot is synced to
+*  //disk and throws otherwise, so the log is never truncated while the only other copy could still be lost
+*  InventorySnapshot::write(shelf, "shelf_12.snap");
+*  log.truncate();
+*  ...
+*  //recovery
+*  InventorySnapshot("shelf_12.snap").loadInto(restored);
+*  WriteAheadLog::replay("shelf_12.wal", restored);
+*/
+class WriteAheadLog {
+public:
+	enum Durability { ASYNC, WRITE, SYNC };
+
+	//cumulative counters since the log was opened
+	struct Stats {
+		std::uint64_t recordsAppended;
+		std::uint64_t commits; //batches written, one write call each
+		std::uint64_t syncs;
+	};
+
+	struct ReplayResult {
+		std::size_t inserts;
+		std::size_t extracts;
+		std::size_t missingExtracts; //logged extractions of items storage did not hold, which were skipped
+		bool tornTail; //the log ended in an incomplete or corrupt batch, which was ignored
+	};
+
+	enum { DEFAULT_ASYNC_INTERVAL_MS = 10 };
+
+	//Opens path for appending, creating it if needed. Throws WriteAheadLogException if it cannot be opened
+	explicit WriteAheadLog(const std::string& path, Durability durability = SYNC, int asyncIntervalMs = DEFAULT_ASYNC_INTERVAL_MS);
+
+	//Commits and syncs whatever is still buffered
+	~WriteAheadLog();
+
+	WriteAheadLog(const WriteAheadLog& log) = delete;
+	WriteAheadLog& operator=(const WriteAheadLog& log) = delete;
+
+	//Return once the records are as durable as the log's Durability promises.
+	//Throw WriteAheadLogException if a commit failed; the log stays failed from then on
+	void logInsert(int key, const Item& item);
+	void logInserts(const std::vector<std::pair<int, Item>>& objs);
+	void logExtract(int key, const Item& item);
+	void logExtracts(int key, const std::vector<Item>& items);
+
+	//Returns once everything appended so far is synced to disk, whatever the log's Durability
+	void sync();
+
+	//Discards everything logged so far. Call it only once InventorySnapshot::write has returned for every
+	//logged container, which is when their snapshots are durable, and while nothing modifies them,
+	//so that the log only holds what happened after the snapshots
+	void truncate();
+
+	Durability getDurability() const;
+	const std::string& getPath() const;
+	Stats getStats() const;
+
+	//Applies the log at path to storage in order: insertions are inserted, and each extraction removes
+	//an item with the same key, ID, weight and size. Stops at a torn last batch.
+	//Throws WriteAheadLogException if path cannot be read
+	static ReplayResult replay(const std::string& path, Storable& storage);
+
+private:
+	enum Op : std::uint32_t { INSERT = 1, EXTRACT = 2 };
+
+	//ItemProperties without its padding, tagged with the operation and the key it was stored under
+	struct Record {
+		std::uint32_t op;
+		std::int32_t key;
+		std::int32_t itemID;
+		float weight;
+		std::uint32_t flags;
+	};
+
+	struct BatchHeader {
+		std::uint32_t magic;
+		std::uint32_t numRecords;
+		std::uint64_t checksum; //of numRecords and the records
+	};
+
+	enum { IS_LARGE = 1 };
+
+	//ASYNC commits early once this many records are buffered
+	enum { ASYNC_COMMIT_RECORDS = 16384 };
+
+	static Record toRecord(Op op, int key, const Item& item);
+	static Item toItem(const Record& record);
+
+	static std::uint64_t checksum(const BatchHeader& header, const Record* records);
+
+	//Calls onBatch(records, count) for every valid batch of the log at path, in order.
+	//Returns the length of the valid prefix of the file; tornTail is set if anything follows it
+	template <class T_ON_BATCH>
+	static std::uint64_t scan(const std::string& path, const T_ON_BATCH& onBatch, bool& tornTail);
+
+	void append(const Record* records, std::size_t count);
+
+	//Waits until the first seq records are written, or synced if sync is set, committing them itself when
+	//no other thread is. Throws if the log has failed
+	void awaitCommit(boost::unique_lock<boost::mutex>& lock, std::uint64_t seq, bool sync);
+
+	//Writes, and syncs if sync is set, everything buffered. Called with lock held and no commit in progress;
+	//releases lock while it writes
+	void commit(boost::unique_lock<boost::mutex>& lock, bool sync);
+
+	void runCommitter();
+
+	const std::string path_;
+	const Durability durability_;
+	const int asyncIntervalMs_;
+	int fd_{ -1 };
+
+	mutable boost::mutex mtx_;
+	boost::condition_variable committedCv_;
+	boost::condition_variable committerCv_;
+
+	std::vector<Record> pending_; //appended, not yet handed to a commit
+	std::vector<Record> spare_; //the previous commit's emptied buffer, swapped in to keep pending_'s capacity
+	std::vector<char> writeBuffer_; //header and records of the commit in progress; only the committing thread uses it
+
+	//counts of records, in append order
+	std::uint64_t appended_{ 0 };
+	std::uint64_t written_{ 0 };
+	std::uint64_t synced_{ 0 };
+
+	bool committing_{ false };
+	bool stopping_{ false };
+	std::string error_; //set once a commit fails
+	Stats stats_{};
+
+	std::unique_ptr<boost::thread> committer_; //ASYNC only
+};
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef AMAZOOM_CONTAINERS_WRITE_AHEAD_LOG_EXCEPTIONS_H_
+#define AMAZOOM_CONTAINERS_WRITE_AHEAD_LOG_EXCEPTIONS_H_
+
+#include <exception>
+#include <string>
+
+namespace amazoom {
+//thrown when the log cannot be opened, written or synced. Once a write fails, every later append throws too
+class WriteAheadLogException : public std::exception {
+
+public:
+	WriteAheadLogException(std::string error) : error_(error) {};
+
+	const char* what() const noexcept { return error_.c_str(); }
+
+private:
+	const std::string error_;
+};
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef AMAZOOM_WAREHOUSE_ETC_INVENTORY_FEED_EXCEPTIONS_H_
+#define AMAZOOM_WAREHOUSE_ETC_INVENTORY_FEED_EXCEPTIONS_H_
+
+#include <exception>
+#include <string>
+
+namespace amazoom {
+//thrown when a feed cannot be read or written, or a binary feed has a bad header or a partial record
+class InventoryFeedException : public std::exception {
+
+public:
+	InventoryFeedException(std::string error) : error_(error) {};
+
+	const char* what() const noexcept { return error_.c_str(); }
+
+private:
+	const std::string error_;
+};
+}
+
+#endif
@@ -0,0 +1,275 @@
+#include "warehouse_etc/inventory_feed_loader.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+const char MAGIC[8] = { 'A', 'M', 'Z', 'F', 'E', 'E', 'D', '\0' };
+const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+//a CSV row is about this long; used to size the per partition row buffers up front
+const std::size_t TYPICAL_CSV_ROW_BYTES = 16;
+}
+
+amazoom::InventoryFeedLoader::InventoryFeedLoader(int numThreads, std::size_t chunkBytes)
+	: chunkBytes_(std::max(chunkBytes, sizeof(FeedRecord))), scheduler_(numThreads) {}
+
+amazoom::InventoryFeedLoader::~InventoryFeedLoader() {}
+
+amazoom::InventoryFeedLoader::Stats amazoom::InventoryFeedLoader::load(const std::string& path, Format format, Storable& storage) {
+	std::vector<Storable*> partitions{ &storage };
+	return load(path, format, partitions);
+}
+
+amazoom::InventoryFeedLoader::Stats amazoom::InventoryFeedLoader::load(const std::string& path, Format format,
+	const std::vector<Storable*>& partitions) {
+
+	if (partitions.empty()) {
+		throw std::invalid_argument("InventoryFeedLoader requires at least one partition.");
+	}
+	const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+
+	std::ifstream in(path, std::ios::binary);
+	if (!in) {
+		throw InventoryFeedException("Could not open inventory feed: " + path);
+	}
+
+	Stats stats{};
+	if (format == BINARY) {
+		FeedHeader header;
+		if (!in.read(reinterpret_cast<char*>(&header), sizeof(FeedHeader)) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+			throw InventoryFeedException("Not a binary inventory feed: " + path);
+		}
+		if (header.version != VERSION || header.byteOrderMark != BYTE_ORDER_MARK) {
+			throw InventoryFeedException("Inventory feed was written by an incompatible version or machine: " + path);
+		}
+		stats.bytes += sizeof(FeedHeader);
+	}
+
+	const std::size_t numChunks = static_cast<std::size_t>(scheduler_.getNumWorkers());
+	const std::size_t windowBytes = numChunks * chunkBytes_;
+
+	//window holds the bytes of an incomplete last line or record (carry) followed by the bytes just read
+	std::vector<char> window;
+	std::size_t carry = 0;
+	bool eof = false;
+
+	while (!eof) {
+		window.resize(carry + windowBytes);
+		in.read(window.data() + carry, static_cast<std::streamsize>(windowBytes));
+		const std::size_t got = static_cast<std::size_t>(in.gcount());
+		eof = got < windowBytes;
+		stats.bytes += got;
+
+		//the window is handed out up to its last complete line or record; the rest waits for the next read
+		const std::size_t filled = carry + got;
+		std::size_t complete = filled;
+		if (format == BINARY) {
+			complete = filled - filled % sizeof(FeedRecord);
+			if (eof && complete != filled) {
+				throw InventoryFeedException("Inventory feed ends in a partial record: " + path);
+			}
+		}
+		else if (!eof) {
+			const char* lastBreak = nullptr;
+			for (const char* c = window.data() + filled; c != window.data(); c--) {
+				if (c[-1] == '\n') {
+					lastBreak = c;
+					break;
+				}
+			}
+			if (lastBreak == nullptr) {
+				//one line longer than the whole window: keep reading until it ends
+				carry = filled;
+				continue;
+			}
+			complete = static_cast<std::size_t>(lastBreak - window.data());
+		}
+
+		//split into numChunks chunks of about equal size, each ending at a line or record boundary
+		std::vector<Chunk> chunks;
+		const char* pos = window.data();
+		const char* end = window.data() + complete;
+		std::size_t chunkSize = std::max<std::size_t>(complete / numChunks, 1);
+		if (format == BINARY) {
+			chunkSize = std::max(chunkSize - chunkSize % sizeof(FeedRecord), sizeof(FeedRecord));
+		}
+		while (pos < end) {
+			const char* chunkEnd = pos + std::min(chunkSize, static_cast<std::size_t>(end - pos));
+			if (format == CSV && chunkEnd < end) {
+				const void* lineBreak = std::memchr(chunkEnd, '\n', static_cast<std::size_t>(end - chunkEnd));
+				chunkEnd = lineBreak != nullptr ? static_cast<const char*>(lineBreak) + 1 : end;
+			}
+			chunks.push_back(Chunk{ pos, chunkEnd, std::vector<Rows>(partitions.size()), 0 });
+			pos = chunkEnd;
+		}
+
+		std::vector<TaskScheduler::Task> tasks;
+		for (Chunk& chunk : chunks) {
+			tasks.push_back([&chunk, format]() {
+				if (format == CSV) {
+					parseCsv(chunk);
+				}
+				else {
+					parseBinary(chunk);
+				}
+			});
+		}
+		runAll(tasks);
+
+		std::size_t rowBytes = 0;
+		for (const Chunk& chunk : chunks) {
+			stats.rejectedRows += chunk.rejectedRows;
+			for (const Rows& rows : chunk.partitions) {
+				stats.rows += rows.size();
+				rowBytes += rows.capacity() * sizeof(Rows::value_type);
+			}
+		}
+		stats.peakBufferedBytes = std::max(stats.peakBufferedBytes, window.capacity() + rowBytes);
+
+		//one task per partition, so no two loader threads ever insert into the same storage
+		tasks.clear();
+		for (std::size_t p = 0; p < partitions.size(); p++) {
+			tasks.push_back([&chunks, &partitions, p]() {
+				for (Chunk& chunk : chunks) {
+					if (!chunk.partitions[p].empty()) {
+						partitions[p]->insertItems(chunk.partitions[p]);
+					}
+				}
+			});
+		}
+		runAll(tasks);
+
+		carry = filled - complete;
+		std::memmove(window.data(), window.data() + complete, carry);
+	}
+
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	stats.rowsPerSecond = stats.seconds > 0 ? stats.rows / stats.seconds : 0;
+	return stats;
+}
+
+void amazoom::InventoryFeedLoader::writeBinary(const std::string& path, const std::vector<Item>& items) {
+	FeedHeader header{};
+	std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+	header.version = VERSION;
+	header.byteOrderMark = BYTE_ORDER_MARK;
+
+	std::vector<FeedRecord> records;
+	records.reserve(items.size());
+	for (const Item& item : items) {
+		records.push_back(FeedRecord{ item.getID(), item.getWeight(), item.isLarge() ? static_cast<std::uint32_t>(IS_LARGE) : 0u });
+	}
+
+	std::ofstream out(path, std::ios::binary | std::ios::trunc);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(FeedRecord)));
+	out.flush();
+	if (!out) {
+		throw InventoryFeedException("Could not write inventory feed: " + path);
+	}
+}
+
+void amazoom::InventoryFeedLoader::parseCsv(Chunk& chunk) {
+	const std::size_t numPartitions = chunk.partitions.size();
+	const std::size_t expectedRows = static_cast<std::size_t>(chunk.end - chunk.begin) / TYPICAL_CSV_ROW_BYTES / numPartitions;
+	for (Rows& rows : chunk.partitions) {
+		rows.reserve(expectedRows);
+	}
+
+	const char* line = chunk.begin;
+	while (line < chunk.end) {
+		const void* lineBreak = std::memchr(line, '\n', static_cast<std::size_t>(chunk.end - line));
+		const char* lineEnd = lineBreak != nullptr ? static_cast<const char*>(lineBreak) : chunk.end;
+		const char* rowEnd = (lineEnd > line && lineEnd[-1] == '\r') ? lineEnd - 1 : lineEnd;
+
+		//blank lines are neither rows nor rejected
+		if (rowEnd > line) {
+			int itemID;
+			float weight;
+			bool isLarge;
+			if (parseCsvRow(line, rowEnd, itemID, weight, isLarge)) {
+				chunk.partitions[partitionFor(itemID, numPartitions)].emplace_back(itemID, Item(itemID, weight, isLarge));
+			}
+			else {
+				chunk.rejectedRows++;
+			}
+		}
+		line = lineEnd == chunk.end ? chunk.end : lineEnd + 1;
+	}
+}
+
+bool amazoom::InventoryFeedLoader::parseCsvRow(const char* begin, const char* end, int& itemID, float& weight, bool& isLarge) {
+	//from_chars neither allocates nor depends on the locale, so chunks parse independently at full speed
+	std::from_chars_result parsed = std::from_chars(begin, end, itemID);
+	if (parsed.ec != std::errc() || parsed.ptr == end || *parsed.ptr != ',') {
+		return false;
+	}
+	parsed = std::from_chars(parsed.ptr + 1, end, weight);
+	if (parsed.ec != std::errc() || parsed.ptr == end || *parsed.ptr != ',') {
+		return false;
+	}
+
+	const std::string_view flag(parsed.ptr + 1, static_cast<std::size_t>(end - parsed.ptr - 1));
+	if (flag == "1" || flag == "true") {
+		isLarge = true;
+	}
+	else if (flag == "0" || flag == "false") {
+		isLarge = false;
+	}
+	else {
+		return false;
+	}
+	return true;
+}
+
+void amazoom::InventoryFeedLoader::parseBinary(Chunk& chunk) {
+	const std::size_t numPartitions = chunk.partitions.size();
+	const std::size_t numRecords = static_cast<std::size_t>(chunk.end - chunk.begin) / sizeof(FeedRecord);
+	for (Rows& rows : chunk.partitions) {
+		rows.reserve(numRecords / numPartitions + 1);
+	}
+
+	for (std::size_t i = 0; i < numRecords; i++) {
+		FeedRecord record;
+		std::memcpy(&record, chunk.begin + i * sizeof(FeedRecord), sizeof(FeedRecord));
+		chunk.partitions[partitionFor(record.itemID, numPartitions)].emplace_back(
+			record.itemID, Item(record.itemID, record.weight, (record.flags & IS_LARGE) != 0));
+	}
+}
+
+std::size_t amazoom::InventoryFeedLoader::partitionFor(int key, std::size_t numPartitions) {
+	//negative IDs are valid keys, so the remainder is taken in unsigned arithmetic
+	return static_cast<std::size_t>(static_cast<unsigned int>(key)) % numPartitions;
+}
+
+void amazoom::InventoryFeedLoader::runAll(std::vector<TaskScheduler::Task>& tasks) {
+	//the scheduler swallows exceptions, so each task hands its own back
+	boost::mutex errorMtx;
+	std::exception_ptr error;
+
+	for (TaskScheduler::Task& task : tasks) {
+		scheduler_.submit([&task, &errorMtx, &error]() {
+			try {
+				task();
+			}
+			catch (...) {
+				boost::lock_guard<boost::mutex> lock(errorMtx);
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+		});
+	}
+	scheduler_.waitIdle();
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
@@ -0,0 +1,112 @@
+#ifndef AMAZOOM_WAREHOUSE_ETC_INVENTORY_FEED_LOADER_H_
+#define AMAZOOM_WAREHOUSE_ETC_INVENTORY_FEED_LOADER_H_
+
+#include "containers/worker_accessible_container.h"
+#include "warehouse_etc/inventory_feed_exceptions.h"
+#include "warehouse_etc/item_definition.h"
+#include "warehouse_etc/task_scheduler.h"
+
+#include "boost/thread.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace amazoom {
+
+/* Loads a stock feed of (itemID, weight, isLarge) rows into storage, keyed by item ID.
+*  The feed is streamed through a window of numThreads chunks at a time, so memory stays bounded
+*  whatever the size of the feed. Each window is handled in two parallel phases on a TaskScheduler:
+*    parse   every chunk is parsed by one task, which sorts its rows by the partition that owns their key
+*    insert  every partition receives the window's rows from one task, one insertItems batch per chunk
+*  A partition is only ever written by one loader thread at a time and takes its lock once per batch,
+*  so the loader's threads never contend with each other.
+*
+*  Formats:
+*    CSV     one "itemID,weight,isLarge" row per line; isLarge is 0, 1, true or false. Lines that do not
+*            parse, such as a header line, are skipped and counted in Stats::rejectedRows
+*    BINARY  a FeedHeader (magic "AMZFEED", version, byte order mark) followed by 12-byte records of the
+*            item ID, weight and flags, in native byte order, as written by writeBinary
+*
+*  Example:
+*  InventoryFeedLoader loader;
+*  std::vector<Storable*> shelves{ &shelf0, &shelf1, &shelf2, &shelf3 };
+*  InventoryFeedLoader::Stats stats = loader.load("nightly.csv", InventoryFeedLoader::CSV, shelves);
+*/
+class InventoryFeedLoader {
+public:
+	enum Format { CSV, BINARY };
+
+	struct Stats {
+		std::uint64_t rows; //inserted
+		std::uint64_t rejectedRows;
+		std::uint64_t bytes; //of the feed
+		double seconds;
+		double rowsPerSecond;
+		std::size_t peakBufferedBytes; //most the loader held at once: the read window plus the rows parsed from it
+	};
+
+	enum { DEFAULT_CHUNK_BYTES = 4 << 20 };
+
+	explicit InventoryFeedLoader(int numThreads = boost::thread::hardware_concurrency(), std::size_t chunkBytes = DEFAULT_CHUNK_BYTES);
+	~InventoryFeedLoader();
+
+	InventoryFeedLoader(const InventoryFeedLoader& loader) = delete;
+	InventoryFeedLoader& operator=(const InventoryFeedLoader& loader) = delete;
+
+	//Inserts every row of the feed at path into partitions[itemID mod partitions.size()].
+	//Throws InventoryFeedException if the feed cannot be read or is not a valid binary feed; rows of
+	//earlier windows have been inserted by then. Exceptions thrown by the storage are rethrown
+	Stats load(const std::string& path, Format format, const std::vector<Storable*>& partitions);
+	Stats load(const std::string& path, Format format, Storable& storage);
+
+	//Writes items as a binary feed. Throws InventoryFeedException if path cannot be written
+	static void writeBinary(const std::string& path, const std::vector<Item>& items);
+
+	enum { VERSION = 1 };
+
+private:
+	typedef std::vector<std::pair<int, Item>> Rows;
+
+	struct FeedHeader {
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t byteOrderMark;
+	};
+
+	//ItemProperties without its padding, as in InventorySnapshot
+	struct FeedRecord {
+		std::int32_t itemID;
+		float weight;
+		std::uint32_t flags;
+	};
+
+	enum { IS_LARGE = 1 };
+
+	//a slice of the window, parsed by one task into rows per partition
+	struct Chunk {
+		const char* begin;
+		const char* end;
+		std::vector<Rows> partitions;
+		std::uint64_t rejectedRows;
+	};
+
+	static void parseCsv(Chunk& chunk);
+	static void parseBinary(Chunk& chunk);
+
+	//parses one CSV line, without its line break. Returns false if it is not a valid row
+	static bool parseCsvRow(const char* begin, const char* end, int& itemID, float& weight, bool& isLarge);
+
+	static std::size_t partitionFor(int key, std::size_t numPartitions);
+
+	//Runs every task on scheduler_ and waits for them. Rethrows the first exception any of them threw
+	void runAll(std::vector<TaskScheduler::Task>& tasks);
+
+	const std::size_t chunkBytes_;
+	TaskScheduler scheduler_;
+};
+}
+
+#endif
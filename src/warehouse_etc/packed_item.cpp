@@ -0,0 +1,55 @@
+#include "warehouse_etc/packed_item.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+amazoom::PackedItem::PackedItem(int itemID, float weight, bool isLarge)
+	: itemID_(static_cast<std::uint32_t>(itemID)),
+	weightAndFlags_((toRawWeight(weight) << FLAG_BITS) | (isLarge ? static_cast<std::uint32_t>(IS_LARGE) : 0u)) {}
+
+amazoom::PackedItem::PackedItem(const Item& item)
+	: PackedItem(item.getID(), item.getWeight(), item.isLarge()) {}
+
+int amazoom::PackedItem::getID() const {
+	return static_cast<int>(itemID_);
+}
+
+float amazoom::PackedItem::getWeight() const {
+	return fromRawWeight(getRawWeight());
+}
+
+bool amazoom::PackedItem::isLarge() const {
+	return (weightAndFlags_ & IS_LARGE) != 0;
+}
+
+std::uint32_t amazoom::PackedItem::getRawWeight() const {
+	return weightAndFlags_ >> FLAG_BITS;
+}
+
+std::uint32_t amazoom::PackedItem::getFlags() const {
+	return weightAndFlags_ & ((1u << FLAG_BITS) - 1);
+}
+
+amazoom::Item amazoom::PackedItem::toItem() const {
+	return Item(getID(), getWeight(), isLarge());
+}
+
+amazoom::PackedItem amazoom::PackedItem::fromFields(int itemID, std::uint32_t rawWeight, std::uint32_t flags) {
+	PackedItem packed;
+	packed.itemID_ = static_cast<std::uint32_t>(itemID);
+	packed.weightAndFlags_ = (rawWeight << FLAG_BITS) | flags;
+	return packed;
+}
+
+std::uint32_t amazoom::PackedItem::toRawWeight(float weight) {
+	//written so that NaN fails too
+	if (!(weight >= 0.0f && weight <= MAX_WEIGHT)) {
+		throw std::out_of_range("PackedItem cannot hold weight: " + std::to_string(weight));
+	}
+	return static_cast<std::uint32_t>(std::lround(static_cast<double>(weight) * WEIGHT_SCALE));
+}
+
+float amazoom::PackedItem::fromRawWeight(std::uint32_t rawWeight) {
+	return static_cast<float>(rawWeight) / WEIGHT_SCALE;
+}
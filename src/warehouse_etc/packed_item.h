@@ -0,0 +1,60 @@
+#ifndef AMAZOOM_WAREHOUSE_ETC_PACKED_ITEM_H_
+#define AMAZOOM_WAREHOUSE_ETC_PACKED_ITEM_H_
+
+#include "warehouse_etc/item_definition.h"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace amazoom {
+	/* An item's properties in 8 bytes, for storing and moving items in bulk.
+	*  The ID takes the first 32 bits. The second word holds the weight as an unsigned fixed-point number
+	*  of 1/WEIGHT_SCALE kg in its upper 28 bits, and flags in the lower 4, so weights are kept to about
+	*  a gram and up to MAX_WEIGHT.
+	*  Unlike Item, a PackedItem is trivially copyable: an array of them is moved with memcpy, and copying
+	*  one leaves the source as it was.
+	*/
+	class PackedItem {
+
+	public:
+		enum { WEIGHT_SCALE = 1024, FLAG_BITS = 4 };
+		enum Flags { IS_LARGE = 1 };
+
+		static constexpr std::uint32_t MAX_RAW_WEIGHT = (1u << (32 - FLAG_BITS)) - 1;
+		static constexpr float MAX_WEIGHT = static_cast<float>(MAX_RAW_WEIGHT / WEIGHT_SCALE); //whole kg, exact as a float
+
+		PackedItem() = default;
+
+		//Weights are rounded to the nearest 1/WEIGHT_SCALE kg.
+		//Throws std::out_of_range if weight is negative, above MAX_WEIGHT or not a number
+		PackedItem(int itemID, float weight, bool isLarge);
+		explicit PackedItem(const Item& item);
+
+		int getID() const;
+		float getWeight() const;
+		bool isLarge() const;
+
+		//the weight in 1/WEIGHT_SCALE kg
+		std::uint32_t getRawWeight() const;
+		std::uint32_t getFlags() const;
+
+		//a new Item with these properties; the PackedItem stays valid
+		Item toItem() const;
+
+		//for storage that keeps the fields apart, see ColumnarMultiHashmap. Nothing is checked
+		static PackedItem fromFields(int itemID, std::uint32_t rawWeight, std::uint32_t flags);
+
+		//Converts between kg and 1/WEIGHT_SCALE kg. toRawWeight throws as the constructor does
+		static std::uint32_t toRawWeight(float weight);
+		static float fromRawWeight(std::uint32_t rawWeight);
+
+	private:
+		std::uint32_t itemID_;
+		std::uint32_t weightAndFlags_;
+	};
+
+	static_assert(sizeof(PackedItem) == 8, "PackedItem must stay 8 bytes");
+	static_assert(std::is_trivially_copyable<PackedItem>::value, "PackedItem must be movable with memcpy");
+}
+
+#endif
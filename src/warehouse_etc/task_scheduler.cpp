@@ -0,0 +1,254 @@
+#include "warehouse_etc/task_scheduler.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace {
+//which scheduler and worker the calling thread belongs to, if any
+thread_local const amazoom::TaskScheduler* currentScheduler = nullptr;
+thread_local int currentWorker = -1;
+}
+
+amazoom::TaskScheduler::TaskScheduler(int numWorkers) {
+	if (numWorkers < 1) {
+		numWorkers = 1; //hardware_concurrency() may report 0
+	}
+
+	workers_.reserve(numWorkers);
+	for (int i = 0; i < numWorkers; i++) {
+		workers_.push_back(std::unique_ptr<Worker>(new Worker()));
+	}
+	threads_.reserve(numWorkers);
+	for (int i = 0; i < numWorkers; i++) {
+		threads_.push_back(std::unique_ptr<boost::thread>(new boost::thread(&TaskScheduler::workerLoop, this, i)));
+	}
+}
+
+amazoom::TaskScheduler::~TaskScheduler() {
+	{
+		boost::unique_lock<boost::mutex> lock(idleMtx_);
+		stopping_ = true;
+	}
+	idleCv_.notify_all();
+
+	for (std::unique_ptr<boost::thread>& thread : threads_) {
+		thread->join();
+	}
+}
+
+int amazoom::TaskScheduler::getNumWorkers() const {
+	return static_cast<int>(workers_.size());
+}
+
+void amazoom::TaskScheduler::submit(Task task) {
+	const int numWorkers = static_cast<int>(workers_.size());
+	const int workerIndex = (currentScheduler == this) ? currentWorker : static_cast<int>(nextWorker_++ % numWorkers);
+	enqueue(workerIndex, std::move(task));
+}
+
+void amazoom::TaskScheduler::submit(Task task, const void* affinity) {
+	//pointers are aligned, so mix the bits before picking a worker
+	const std::uint64_t hashed = static_cast<std::uint64_t>(std::hash<const void*>()(affinity)) * 0x9E3779B97F4A7C15ull;
+	enqueue(static_cast<int>((hashed >> 32) % workers_.size()), std::move(task));
+}
+
+void amazoom::TaskScheduler::submitInsert(WorkerAccessibleContainer& container, Item& item) {
+	//std::function must be copyable and Item is move-only, so the task shares ownership of it
+	std::shared_ptr<Item> itemPtr(std::make_shared<Item>(std::move(item)));
+	submit([&container, itemPtr]() {
+		container.insertItem(itemPtr->getID(), *itemPtr);
+	}, &container);
+}
+
+void amazoom::TaskScheduler::submitExtract(WorkerAccessibleContainer& container, int key,
+	std::function<void(std::optional<Item>)> onDone) {
+
+	submit([&container, key, onDone]() {
+		std::optional<Item> extractedItem(container.tryExtractItem(key));
+		if (onDone) {
+			onDone(std::move(extractedItem));
+		}
+	}, &container);
+}
+
+void amazoom::TaskScheduler::submitPack(const BoxPacker& packer, std::vector<Item>& items,
+	std::function<void(BoxPacker::Boxes)> onDone) {
+
+	std::shared_ptr<std::vector<Item>> itemsPtr(std::make_shared<std::vector<Item>>(std::move(items)));
+	items.clear();
+	submit([&packer, itemsPtr, onDone]() {
+		BoxPacker::Boxes boxes(packer.pack(*itemsPtr));
+		if (onDone) {
+			onDone(std::move(boxes));
+		}
+	}, &packer);
+}
+
+void amazoom::TaskScheduler::waitIdle() {
+	boost::unique_lock<boost::mutex> lock(doneMtx_);
+	while (pending_.load() != 0) {
+		doneCv_.wait(lock);
+	}
+}
+
+amazoom::TaskScheduler::Stats amazoom::TaskScheduler::getStats() const {
+	Stats stats{};
+	stats.tasksSubmitted = submitted_.load();
+
+	std::uint64_t queueLatencyNs = 0;
+	std::uint64_t maxQueueLatencyNs = 0;
+	std::uint64_t runTimeNs = 0;
+	for (const std::unique_ptr<Worker>& worker : workers_) {
+		const std::uint64_t executed = worker->executed.load(std::memory_order_relaxed);
+		stats.tasksPerWorker.push_back(executed);
+		stats.tasksExecuted += executed;
+		stats.tasksFailed += worker->failed.load(std::memory_order_relaxed);
+		stats.tasksStolen += worker->stolen.load(std::memory_order_relaxed);
+		stats.stealAttempts += worker->stealAttempts.load(std::memory_order_relaxed);
+		stats.failedSteals += worker->failedSteals.load(std::memory_order_relaxed);
+		queueLatencyNs += worker->queueLatencyNs.load(std::memory_order_relaxed);
+		maxQueueLatencyNs = std::max(maxQueueLatencyNs, worker->maxQueueLatencyNs.load(std::memory_order_relaxed));
+		runTimeNs += worker->runTimeNs.load(std::memory_order_relaxed);
+	}
+
+	if (stats.tasksExecuted > 0) {
+		stats.meanQueueLatencyUs = queueLatencyNs / 1000.0 / stats.tasksExecuted;
+		stats.meanRunTimeUs = runTimeNs / 1000.0 / stats.tasksExecuted;
+	}
+	stats.maxQueueLatencyUs = maxQueueLatencyNs / 1000.0;
+	return stats;
+}
+
+void amazoom::TaskScheduler::enqueue(int workerIndex, Task task) {
+	//running tasks may still queue follow-up work while the scheduler drains
+	if (stopping_.load() && currentScheduler != this) {
+		throw std::logic_error("TaskScheduler is shutting down.");
+	}
+
+	submitted_++;
+	pending_++;
+	{
+		Worker& worker = *workers_[workerIndex];
+		boost::unique_lock<boost::mutex> lock(worker.mtx);
+		worker.tasks.push_back(QueuedTask{ std::move(task), Clock::now(), workerIndex });
+	}
+
+	//a sleeper counts itself before it checks queued_, and we count the task before we check
+	//sleepers_, so either it sees the task or we see it and wake it
+	queued_++;
+	if (sleepers_.load() > 0) {
+		boost::unique_lock<boost::mutex> lock(idleMtx_);
+		idleCv_.notify_one();
+	}
+}
+
+void amazoom::TaskScheduler::workerLoop(int workerIndex) {
+	currentScheduler = this;
+	currentWorker = workerIndex;
+
+	while (true) {
+		std::optional<QueuedTask> queuedTask(popLocal(workerIndex));
+		if (!queuedTask && workers_.size() > 1) {
+			queuedTask = steal(workerIndex);
+		}
+		if (queuedTask) {
+			run(workerIndex, *queuedTask);
+			continue;
+		}
+
+		boost::unique_lock<boost::mutex> lock(idleMtx_);
+		sleepers_++;
+		while (queued_.load() == 0 && !stopping_.load()) {
+			idleCv_.wait(lock);
+		}
+		sleepers_--;
+
+		if (queued_.load() == 0 && stopping_.load()) {
+			return;
+		}
+	}
+}
+
+std::optional<amazoom::TaskScheduler::QueuedTask> amazoom::TaskScheduler::popLocal(int workerIndex) {
+	Worker& worker = *workers_[workerIndex];
+	boost::unique_lock<boost::mutex> lock(worker.mtx);
+	if (worker.tasks.empty()) {
+		return std::nullopt;
+	}
+
+	std::optional<QueuedTask> queuedTask(std::move(worker.tasks.back()));
+	worker.tasks.pop_back();
+	queued_--;
+	return queuedTask;
+}
+
+std::optional<amazoom::TaskScheduler::QueuedTask> amazoom::TaskScheduler::steal(int workerIndex) {
+	Worker& thief = *workers_[workerIndex];
+	thief.stealAttempts.fetch_add(1, std::memory_order_relaxed);
+
+	const int numWorkers = static_cast<int>(workers_.size());
+	std::vector<QueuedTask> loot;
+
+	//start from the next worker so that thieves spread out over victims
+	for (int offset = 1; offset < numWorkers && loot.empty(); offset++) {
+		Worker& victim = *workers_[(workerIndex + offset) % numWorkers];
+		boost::unique_lock<boost::mutex> lock(victim.mtx);
+
+		const std::size_t toSteal = (victim.tasks.size() + 1) / 2;
+		for (std::size_t i = 0; i < toSteal; i++) {
+			loot.push_back(std::move(victim.tasks.front()));
+			victim.tasks.pop_front();
+		}
+	}
+
+	if (loot.empty()) {
+		thief.failedSteals.fetch_add(1, std::memory_order_relaxed);
+		return std::nullopt;
+	}
+
+	//run the oldest now, keep the rest in the same order on our own deque
+	std::optional<QueuedTask> queuedTask(std::move(loot.front()));
+	queued_--;
+	if (loot.size() > 1) {
+		boost::unique_lock<boost::mutex> lock(thief.mtx);
+		for (std::size_t i = loot.size() - 1; i > 0; i--) {
+			thief.tasks.push_front(std::move(loot[i]));
+		}
+	}
+	return queuedTask;
+}
+
+void amazoom::TaskScheduler::run(int workerIndex, QueuedTask& queuedTask) {
+	Worker& worker = *workers_[workerIndex];
+
+	const Clock::time_point started = Clock::now();
+	const std::uint64_t queueLatencyNs = static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(started - queuedTask.submitted).count());
+
+	try {
+		queuedTask.task();
+	}
+	catch (...) {
+		worker.failed.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	const std::uint64_t runTimeNs = static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count());
+
+	worker.executed.fetch_add(1, std::memory_order_relaxed);
+	if (queuedTask.queuedOn != workerIndex) {
+		worker.stolen.fetch_add(1, std::memory_order_relaxed);
+	}
+	worker.queueLatencyNs.fetch_add(queueLatencyNs, std::memory_order_relaxed);
+	worker.runTimeNs.fetch_add(runTimeNs, std::memory_order_relaxed);
+	//only this worker writes its counters, so a plain load/store pair is enough for the maximum
+	if (queueLatencyNs > worker.maxQueueLatencyNs.load(std::memory_order_relaxed)) {
+		worker.maxQueueLatencyNs.store(queueLatencyNs, std::memory_order_relaxed);
+	}
+
+	if (--pending_ == 0) {
+		boost::unique_lock<boost::mutex> lock(doneMtx_);
+		doneCv_.notify_all();
+	}
+}
@@ -0,0 +1,133 @@
+#ifndef AMAZOOM_WAREHOUSE_ETC_TASK_SCHEDULER_H_
+#define AMAZOOM_WAREHOUSE_ETC_TASK_SCHEDULER_H_
+
+#include "containers/box_packer.h"
+#include "containers/worker_accessible_container.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace amazoom {
+
+/* Runs pick/put/pack tasks on a fixed set of worker threads.
+*  Each worker has its own deque: it pushes and pops its own tasks at the back (most recent first,
+*  while their data is still in cache) and, when it runs dry, steals the older half of another worker's
+*  deque from the front. Stealing half at once means a busy worker is robbed rarely, and an idle one
+*  gets enough work to stay busy for a while.
+*  Tasks can carry an affinity, usually the container they work on. Tasks with the same affinity are
+*  queued on the same worker, so one container's data tends to stay in one core's cache, and only
+*  move elsewhere when that worker falls behind and others steal from it.
+*  Thread-safe. Tasks still queued when the scheduler is destroyed are run before the workers exit.
+*/
+class TaskScheduler {
+public:
+	typedef std::function<void()> Task;
+
+	//cumulative counters since construction. Latencies are measured from submission
+	struct Stats {
+		std::uint64_t tasksSubmitted;
+		std::uint64_t tasksExecuted;
+		std::uint64_t tasksFailed; //threw an exception, which was swallowed
+		std::uint64_t tasksStolen; //ran on a different worker than they were queued on
+		std::uint64_t stealAttempts;
+		std::uint64_t failedSteals; //found every other deque empty
+		double meanQueueLatencyUs; //submission until a worker starts it
+		double maxQueueLatencyUs;
+		double meanRunTimeUs;
+		std::vector<std::uint64_t> tasksPerWorker;
+	};
+
+	explicit TaskScheduler(int numWorkers = boost::thread::hardware_concurrency());
+	~TaskScheduler();
+
+	TaskScheduler(const TaskScheduler& scheduler) = delete;
+	TaskScheduler& operator=(const TaskScheduler& scheduler) = delete;
+
+	int getNumWorkers() const;
+
+	//Queues task. Called from a worker, it goes on that worker's deque, otherwise workers take turns
+	void submit(Task task);
+
+	//Queues task on the worker that owns affinity, e.g. the address of the container it works on
+	void submit(Task task, const void* affinity);
+
+	//Convenience tasks, queued with container as their affinity.
+	//item is moved into the task; onDone (optional) is called on the worker with the extracted item
+	void submitInsert(WorkerAccessibleContainer& container, Item& item);
+	void submitExtract(WorkerAccessibleContainer& container, int key,
+		std::function<void(std::optional<Item>)> onDone = nullptr);
+
+	//Packs one order with packer, queued with packer as its affinity, so each packing station's
+	//orders stay on one worker. items are moved into the task; onDone (optional) is called on the worker
+	//with the packed boxes. An order packer rejects (BoxOverweightException) counts as a failed task
+	void submitPack(const BoxPacker& packer, std::vector<Item>& items,
+		std::function<void(BoxPacker::Boxes)> onDone = nullptr);
+
+	//Blocks until every task submitted so far, and every task those submitted, has finished
+	void waitIdle();
+
+	Stats getStats() const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct QueuedTask {
+		Task task;
+		Clock::time_point submitted;
+		int queuedOn;
+	};
+
+	//one per worker, aligned so that neighbouring workers' counters do not share a cache line
+	struct alignas(64) Worker {
+		boost::mutex mtx;
+		std::deque<QueuedTask> tasks; //owner uses the back, thieves the front
+
+		std::atomic<std::uint64_t> executed{ 0 };
+		std::atomic<std::uint64_t> failed{ 0 };
+		std::atomic<std::uint64_t> stolen{ 0 };
+		std::atomic<std::uint64_t> stealAttempts{ 0 };
+		std::atomic<std::uint64_t> failedSteals{ 0 };
+		std::atomic<std::uint64_t> queueLatencyNs{ 0 };
+		std::atomic<std::uint64_t> maxQueueLatencyNs{ 0 };
+		std::atomic<std::uint64_t> runTimeNs{ 0 };
+	};
+
+	void enqueue(int workerIndex, Task task);
+	void workerLoop(int workerIndex);
+
+	std::optional<QueuedTask> popLocal(int workerIndex);
+
+	//moves the older half of another worker's deque onto workerIndex's deque and returns one of those tasks
+	std::optional<QueuedTask> steal(int workerIndex);
+
+	void run(int workerIndex, QueuedTask& queuedTask);
+
+	std::vector<std::unique_ptr<Worker>> workers_;
+	std::vector<std::unique_ptr<boost::thread>> threads_;
+
+	std::atomic<std::uint64_t> submitted_{ 0 };
+	std::atomic<unsigned int> nextWorker_{ 0 }; //round robin for tasks submitted from outside
+	std::atomic<long long> queued_{ 0 }; //tasks sitting in a deque
+	std::atomic<long long> pending_{ 0 }; //tasks submitted and not yet finished
+	std::atomic<bool> stopping_{ false };
+
+	//idle workers sleep here until something is queued
+	boost::mutex idleMtx_;
+	boost::condition_variable idleCv_;
+	std::atomic<int> sleepers_{ 0 };
+
+	boost::mutex doneMtx_;
+	boost::condition_variable doneCv_;
+};
+}
+
+#endif
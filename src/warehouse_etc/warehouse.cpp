@@ -0,0 +1,193 @@
+#include "warehouse_etc/warehouse.h"
+
+#include <algorithm>
+#include <cstdint>
+
+amazoom::Warehouse::Warehouse() {
+	stripes_.reserve(NUM_INDEX_STRIPES);
+	for (int i = 0; i < NUM_INDEX_STRIPES; i++) {
+		stripes_.push_back(std::unique_ptr<IndexStripe>(new IndexStripe()));
+	}
+}
+
+amazoom::Warehouse::~Warehouse() {}
+
+int amazoom::Warehouse::addContainer(ContainerPtr& container) {
+	boost::unique_lock<boost::shared_mutex> lock(containersMtx_);
+	containers_.push_back(std::move(container));
+	return static_cast<int>(containers_.size()) - 1;
+}
+
+int amazoom::Warehouse::getNumContainers() {
+	boost::shared_lock<boost::shared_mutex> lock(containersMtx_);
+	return static_cast<int>(containers_.size());
+}
+
+const amazoom::ItemContainer& amazoom::Warehouse::getContainer(int containerID) {
+	return containerAt(containerID);
+}
+
+amazoom::ItemContainer& amazoom::Warehouse::containerAt(int containerID) {
+	boost::shared_lock<boost::shared_mutex> lock(containersMtx_);
+	//containers are never removed, so the reference stays valid after the lock is released
+	return *containers_.at(containerID);
+}
+
+void amazoom::Warehouse::insertItem(int containerID, Item& item) {
+	ItemContainer& container = containerAt(containerID);
+	const int key = item.getID();
+
+	//count first, so the index never reports less than is really there
+	adjustCount(key, containerID, 1);
+	try {
+		container.insertItem(item);
+	}
+	catch (...) {
+		adjustCount(key, containerID, -1);
+		throw;
+	}
+}
+
+void amazoom::Warehouse::insertItems(int containerID, std::vector<Item>& items) {
+	ItemContainer& container = containerAt(containerID);
+
+	for (const std::pair<int, int>& keyCount : countKeys(items)) {
+		adjustCount(keyCount.first, containerID, keyCount.second);
+	}
+	try {
+		container.insertItems(items);
+	}
+	catch (...) {
+		//a container moves out every item it inserts, so only the items still here come off the index
+		for (const std::pair<int, int>& keyCount : countKeys(items)) {
+			adjustCount(keyCount.first, containerID, -keyCount.second);
+		}
+		throw;
+	}
+}
+
+std::vector<std::pair<int, int>> amazoom::Warehouse::countKeys(const std::vector<Item>& items) {
+	std::vector<std::pair<int, int>> keyCounts; //pallets usually hold one or a few item IDs
+	for (const Item& item : items) {
+		if (item.getID() == Item::INVALID_ITEM) {
+			continue;
+		}
+		auto found = std::find_if(keyCounts.begin(), keyCounts.end(),
+			[&item](const std::pair<int, int>& keyCount) { return keyCount.first == item.getID(); });
+		if (found == keyCounts.end()) {
+			keyCounts.emplace_back(item.getID(), 1);
+		}
+		else {
+			found->second++;
+		}
+	}
+	return keyCounts;
+}
+
+amazoom::Item amazoom::Warehouse::extractItem(int containerID, int key) {
+	Item extractedItem(containerAt(containerID).extractItem(key));
+	adjustCount(key, containerID, -1);
+	return extractedItem;
+}
+
+std::optional<amazoom::Item> amazoom::Warehouse::tryExtractItem(int key) {
+	//a container can come up empty if another worker got there first; move on to the next
+	for (const ItemLocation& location : locateItem(key)) {
+		std::optional<Item> extractedItem(containerAt(location.containerID).tryExtractItem(key));
+		if (extractedItem) {
+			adjustCount(key, location.containerID, -1);
+			return extractedItem;
+		}
+	}
+	return std::nullopt;
+}
+
+std::vector<amazoom::Item> amazoom::Warehouse::extractItems(int key, int count) {
+	std::vector<Item> extractedItems;
+
+	for (const ItemLocation& location : locateItem(key)) {
+		const int remaining = count - static_cast<int>(extractedItems.size());
+		if (remaining <= 0) {
+			break;
+		}
+
+		std::vector<Item> containerItems(containerAt(location.containerID).extractItems(key, std::min(remaining, location.count)));
+		if (!containerItems.empty()) {
+			adjustCount(key, location.containerID, -static_cast<int>(containerItems.size()));
+		}
+		for (Item& item : containerItems) {
+			extractedItems.push_back(std::move(item));
+		}
+	}
+	return extractedItems;
+}
+
+std::vector<amazoom::Warehouse::ItemLocation> amazoom::Warehouse::locateItem(int key) {
+	IndexStripe& stripe = stripeFor(key);
+	boost::shared_lock<boost::shared_mutex> lock(stripe.mtx);
+
+	auto found = stripe.locations.find(key);
+	if (found == stripe.locations.end()) {
+		return std::vector<ItemLocation>();
+	}
+	return found->second;
+}
+
+int amazoom::Warehouse::countItems(int key) {
+	IndexStripe& stripe = stripeFor(key);
+	boost::shared_lock<boost::shared_mutex> lock(stripe.mtx);
+
+	auto found = stripe.locations.find(key);
+	if (found == stripe.locations.end()) {
+		return 0;
+	}
+
+	int total = 0;
+	for (const ItemLocation& location : found->second) {
+		total += location.count;
+	}
+	return total;
+}
+
+bool amazoom::Warehouse::doesContainItem(int key) {
+	IndexStripe& stripe = stripeFor(key);
+	boost::shared_lock<boost::shared_mutex> lock(stripe.mtx);
+
+	//entries are dropped as soon as their count reaches zero
+	return stripe.locations.find(key) != stripe.locations.end();
+}
+
+amazoom::Warehouse::IndexStripe& amazoom::Warehouse::stripeFor(int key) {
+	//item IDs are often sequential; mix them so neighbours land on different stripes
+	const std::uint32_t hashed = static_cast<std::uint32_t>(key) * 0x9E3779B1u;
+	return *stripes_[(hashed >> 16) % NUM_INDEX_STRIPES];
+}
+
+void amazoom::Warehouse::adjustCount(int key, int containerID, int delta) {
+	IndexStripe& stripe = stripeFor(key);
+	boost::unique_lock<boost::shared_mutex> lock(stripe.mtx);
+
+	KeyLocations& locations = stripe.locations[key];
+	auto found = std::find_if(locations.begin(), locations.end(),
+		[containerID](const ItemLocation& location) { return location.containerID == containerID; });
+
+	if (found == locations.end()) {
+		if (delta > 0) {
+			locations.push_back(ItemLocation{ containerID, delta });
+		}
+		else if (locations.empty()) {
+			stripe.locations.erase(key);
+		}
+		return;
+	}
+
+	found->count += delta;
+	if (found->count <= 0) {
+		//order of the remaining locations does not matter
+		*found = locations.back();
+		locations.pop_back();
+		if (locations.empty()) {
+			stripe.locations.erase(key);
+		}
+	}
+}
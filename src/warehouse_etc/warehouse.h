@@ -0,0 +1,104 @@
+#ifndef AMAZOOM_WAREHOUSE_ETC_WAREHOUSE_H_
+#define AMAZOOM_WAREHOUSE_ETC_WAREHOUSE_H_
+
+#include "containers/item_container.h"
+#include "warehouse_etc/item_definition.h"
+
+#include "boost/thread.hpp"
+
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace amazoom {
+
+/* Owns every ItemContainer in the warehouse and keeps an index from item ID to the containers
+*  holding that item, with a count per container. Every insertion and extraction made through the
+*  Warehouse updates the index, so finding stock is a hash lookup instead of asking every container.
+*  Containers owned by a Warehouse must only be modified through it, or the index goes stale.
+*
+*  The index is split into stripes by item ID, each behind its own shared_mutex, so updates for
+*  different items rarely contend. Counts are raised before an item is inserted and lowered after it
+*  is extracted: while operations are in flight a count can overstate a container's stock, never
+*  understate it. Thread-safe.
+*/
+class Warehouse {
+private:
+	typedef std::unique_ptr<ItemContainer> ContainerPtr;
+
+public:
+	//where a given item is stocked, and how many of it
+	struct ItemLocation {
+		int containerID;
+		int count;
+	};
+
+	Warehouse();
+	~Warehouse();
+
+	Warehouse(const Warehouse& warehouse) = delete;
+	Warehouse& operator=(const Warehouse& warehouse) = delete;
+
+	//Takes ownership of container and returns the ID used to address it. Items already stored in
+	//container are not indexed, so add containers while they are still empty.
+	int addContainer(ContainerPtr& container);
+
+	int getNumContainers();
+
+	//Read-only access, since modifying the container directly would bypass the index; see the class comment.
+	//Throws std::out_of_range for an unknown containerID
+	const ItemContainer& getContainer(int containerID);
+
+	//Inserts item into the given container, which may reject it by throwing (e.g. BoxOverweightException)
+	void insertItem(int containerID, Item& item);
+
+	//Inserts a batch into one container with a single index update per item ID. If the container throws
+	//having kept part of the batch (see ItemContainer::insertItems), the index keeps counting that part
+	void insertItems(int containerID, std::vector<Item>& items);
+
+	//Extracts from a specific container, with the same semantics as its extractItem
+	Item extractItem(int containerID, int key);
+
+	//Extracts one item matching key from whichever container holds it. Returns an empty optional if none does
+	std::optional<Item> tryExtractItem(int key);
+
+	//Extracts up to count items matching key, gathered from as many containers as needed
+	std::vector<Item> extractItems(int key, int count);
+
+	//Every container holding key. O(1) lookup plus the number of containers listed
+	std::vector<ItemLocation> locateItem(int key);
+
+	int countItems(int key); //total across all containers
+	bool doesContainItem(int key);
+
+private:
+	enum { NUM_INDEX_STRIPES = 64 };
+
+	typedef std::vector<ItemLocation> KeyLocations;
+
+	//the container to modify on the index's behalf. Throws std::out_of_range for an unknown containerID
+	ItemContainer& containerAt(int containerID);
+
+	struct IndexStripe {
+		boost::shared_mutex mtx;
+		std::unordered_map<int, KeyLocations> locations;
+	};
+
+	IndexStripe& stripeFor(int key);
+
+	//adds delta to the count of key in containerID, dropping the entry when it reaches zero
+	void adjustCount(int key, int containerID, int delta);
+
+	//how many of items each item ID has, leaving out items that were moved out
+	static std::vector<std::pair<int, int>> countKeys(const std::vector<Item>& items);
+
+	std::vector<ContainerPtr> containers_;
+	boost::shared_mutex containersMtx_; //guards containers_ itself, not the containers
+
+	std::vector<std::unique_ptr<IndexStripe>> stripes_;
+};
+}
+
+#endif
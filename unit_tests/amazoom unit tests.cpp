@@ -7,10 +7,32 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 #include <random>
 #include <functional>
 #include <cmath>
+#include <atomic>
+#include <unordered_map>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 
 #include "warehouse_etc/item_definition.h"
+#include "warehouse_etc/packed_item.h"
 #include "containers/multi_hashmap.h"
+#include "containers/sharded_multi_hashmap_impl.h"
+#include "containers/flat_multi_hashmap_impl.h"
+#include "containers/columnar_multi_hashmap_impl.h"
+#include "containers/weight_aggregates.h"
+#include "containers/swiss_map.h"
+#include "containers/node_pool_allocator.h"
+#include "containers/monotonic_arena.h"
 #include "containers/box.h"
+#include "containers/box_packer.h"
+#include "containers/order_transaction.h"
+#include "containers/container_metrics.h"
+#include "containers/inventory_snapshot.h"
+#include "containers/logged_container_impl.h"
+#include "containers/write_ahead_log.h"
+#include "warehouse_etc/warehouse.h"
+#include "warehouse_etc/task_scheduler.h"
+#include "warehouse_etc/inventory_feed_loader.h"
 
 #include "unit_tests.h"
 
@@ -72,6 +94,58 @@ namespace AmazoomUnitTests
 			Assert::IsFalse(isEqual);
 
 		};
+
+		TEST_METHOD(PackedItemRoundTrip) {
+			const int itemID = 77;
+			const float weight = 12.5f;
+
+			amazoom::Item item(itemID, weight, true);
+			amazoom::PackedItem packed(item);
+			Assert::AreEqual(static_cast<std::size_t>(8), sizeof(packed));
+			Assert::AreEqual(itemID, packed.getID());
+			Assert::AreEqual(weight, packed.getWeight());
+			Assert::IsTrue(packed.isLarge());
+
+			//packing copies; the item is still valid
+			checkItemEquals(item, itemID, weight, true);
+			amazoom::Item unpacked(packed.toItem());
+			checkItemEquals(unpacked, itemID, weight, true);
+
+			//weights are kept to 1/WEIGHT_SCALE kg
+			amazoom::PackedItem rounded(itemID, 0.3f, false);
+			Assert::IsTrue(std::fabs(rounded.getWeight() - 0.3f) <= 0.5f / amazoom::PackedItem::WEIGHT_SCALE);
+			Assert::IsFalse(rounded.isLarge());
+
+			bool didExcept = false;
+			try {
+				amazoom::PackedItem negative(itemID, -1.0f, false);
+			}
+			catch (std::out_of_range& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			didExcept = false;
+			try {
+				amazoom::PackedItem tooHeavy(itemID, amazoom::PackedItem::MAX_WEIGHT * 2.0f, false);
+			}
+			catch (std::out_of_range& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			//MAX_WEIGHT itself fits, anything above it does not
+			amazoom::PackedItem heaviest(itemID, amazoom::PackedItem::MAX_WEIGHT, false);
+			Assert::AreEqual(amazoom::PackedItem::MAX_WEIGHT, heaviest.getWeight());
+			didExcept = false;
+			try {
+				amazoom::PackedItem justOver(itemID, amazoom::PackedItem::MAX_WEIGHT + 0.5f, false);
+			}
+			catch (std::out_of_range& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+		};
 	};
 
 	TEST_CLASS(Mult_Hashmap_Testing) {
@@ -307,6 +381,68 @@ namespace AmazoomUnitTests
 			Assert::IsFalse(container.doesContainObj(ID, comparisonFuncWeightID));
 		};
 
+		TEST_METHOD(DoesContainObjectManyKeys) {
+			//enough keys to force the lock-free root index to grow several times
+			const int NUM_KEYS = 5000;
+			const float WEIGHT = 2.0f;
+
+			amazoom::MultiHashmap<int, amazoom::Item> container;
+
+			for (int i = 0; i < NUM_KEYS; i++) {
+				amazoom::Item newItem(i * 7, WEIGHT);
+				container.insertItem(newItem.getID(), newItem);
+			}
+
+			for (int i = 0; i < NUM_KEYS; i++) {
+				Assert::IsTrue(container.doesContainObj(i * 7));
+				Assert::IsFalse(container.doesContainObj(i * 7 + 1));
+			}
+		};
+
+		TEST_METHOD(DoesContainObjectWhileExtracting) {
+			const int ID = 3;
+			const int NUM_ITEMS = 20000;
+			const float KEPT_WEIGHT = 99.0f;
+
+			amazoom::MultiHashmap<int, amazoom::Item> container;
+
+			//one item that is never extracted, buried under many that are
+			amazoom::Item keptItem(ID, KEPT_WEIGHT);
+			container.insertItem(keptItem.getID(), keptItem);
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				amazoom::Item newItem(ID, 1.0f);
+				container.insertItem(newItem.getID(), newItem);
+			}
+
+			auto isKept = [KEPT_WEIGHT](const amazoom::Item& item)->bool {
+				return item.getWeight() == KEPT_WEIGHT;
+			};
+
+			//readers must always find the kept item, no matter how the extractions interleave
+			std::atomic<bool> readerFailed{ false };
+			std::atomic<bool> done{ false };
+			boost::thread reader([&container, &readerFailed, &done, isKept, ID]() {
+				while (!done) {
+					if (!container.doesContainObj(ID, isKept) || !container.doesContainObj(ID)) {
+						readerFailed = true;
+					}
+				}
+			});
+
+			auto isNotKept = [KEPT_WEIGHT](const amazoom::Item& item)->bool {
+				return item.getWeight() != KEPT_WEIGHT;
+			};
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				container.extractItem(ID, isNotKept);
+			}
+			done = true;
+			reader.join();
+
+			Assert::IsFalse(readerFailed);
+			Assert::AreEqual(1, container.getNumItems());
+			Assert::IsTrue(container.doesContainObj(ID, isKept));
+		};
+
 		TEST_METHOD(ExtractionSpecial) {
 			const int id1 = 5;
 			const int id2 = 2015;
@@ -413,72 +549,2691 @@ namespace AmazoomUnitTests
 
 			}
 		};
-	};
 
+		TEST_METHOD(BatchInsertExtract) {
+			const int id1 = 7;
+			const int id2 = 8;
+			const int NUM_PER_ID = 100;
 
-	TEST_CLASS(Box_Testing) {
-	public:
-		TEST_METHOD(OverweightCheck) {
+			std::vector<std::pair<int, amazoom::Item>> pallet;
+			for (int i = 0; i < NUM_PER_ID; i++) {
+				pallet.emplace_back(id1, amazoom::Item(id1, static_cast<float>(i)));
+				pallet.emplace_back(id2, amazoom::Item(id2, static_cast<float>(i)));
+			}
 
-			
-			
-			const int MIN_ID = 0;
-			const int MAX_ID = 100;
-			const float MIN_MAX_WEIGHT = 2.65f;
+			amazoom::MultiHashmap<int, amazoom::Item> container;
+			container.insertItems(pallet);
 
-			const float BOX_MAX_WEIGHT = 200.0f;
+			Assert::AreEqual(NUM_PER_ID * 2, container.getNumItems());
+			for (std::pair<int, amazoom::Item>& keyItem : pallet) {
+				checkItemIsInvalid(keyItem.second);
+			}
 
-			//number of items to generate to completely fill the box plus an extra to
-			//check overweight
-			int NUM_ITEMS = (int)(std::floor(BOX_MAX_WEIGHT / MIN_MAX_WEIGHT)) + 1;
+			//only the heavy half of id1
+			auto isHeavy = [NUM_PER_ID](const amazoom::Item& item)->bool {
+				return item.getWeight() >= NUM_PER_ID / 2;
+			};
+			std::vector<amazoom::Item> heavy(container.extractItems(id1, NUM_PER_ID, isHeavy));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_PER_ID / 2), heavy.size());
+			for (amazoom::Item& item : heavy) {
+				Assert::IsTrue(isHeavy(item));
+				Assert::AreEqual(id1, item.getID());
+			}
 
-			typedef std::vector<amazoom::ItemProperties> Properties;
-			typedef std::vector<amazoom::Item> Items;
+			//asking for more than is stored returns what there is
+			std::vector<amazoom::Item> rest(container.extractItems(id1, NUM_PER_ID));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_PER_ID / 2), rest.size());
+			Assert::IsFalse(container.doesContainObj(id1));
 
-			//randomly generated items, and properties for future reference
-			std::pair<Properties, Items> gens(getRandomItems(NUM_ITEMS, MIN_ID, MAX_ID, MIN_MAX_WEIGHT, MIN_MAX_WEIGHT));
+			Assert::AreEqual(static_cast<std::size_t>(10), container.extractItems(id2, 10).size());
+			Assert::AreEqual(NUM_PER_ID - 10, container.getNumItems());
+			Assert::AreEqual(static_cast<std::size_t>(0), container.extractItems(id2 + 1, 10).size());
+		};
 
-			//pull out of pairs into single vectors
-			Properties properties(std::get<Properties>(gens));
-			Items items(std::move(std::get<Items>(gens)));
-			
-			//testing object 
-			amazoom::Box box(BOX_MAX_WEIGHT);
-			
-			//information about what props were inserted
-			Properties insertedProps;
-			
-			//number of insertions to do to reach, but not go over the box's weight limit
-			const float limit(std::floor(box.getMaxWeight() / MIN_MAX_WEIGHT));
+		TEST_METHOD(TryExtraction) {
+			const int id = 42;
+			const float weight1 = 1.0f;
+			const float weight2 = 2.0f;
 
-			for (int i = 0; i < limit; i++) {
+			amazoom::MultiHashmap<int, amazoom::Item> container;
 
-				Assert::IsTrue(box.canInsert(items.at(0)));
+			Assert::IsFalse(container.tryExtractItem(id).has_value());
 
-				//insert item
-				box.insertItem(items.at(0));
-				items.pop_back();
+			amazoom::Item item1(id, weight1);
+			amazoom::Item item2(id, weight2);
+			container.insertItem(item1.getID(), item1);
+			container.insertItem(item2.getID(), item2);
 
-				//record which items were stored
-				insertedProps.push_back(properties.at(0));
-				properties.pop_back();
+			//no stored object satisfies the filter, including the last node in the list
+			auto isHeavy = [](const amazoom::Item& item)->bool { return item.getWeight() > 5.0f; };
+			Assert::IsFalse(container.tryExtractItem(id, isHeavy).has_value());
+			Assert::AreEqual(2, container.getNumItems());
+
+			auto isWeight1 = [weight1](const amazoom::Item& item)->bool { return item.getWeight() == weight1; };
+			std::optional<amazoom::Item> extracted(container.tryExtractItem(id, isWeight1));
+			Assert::IsTrue(extracted.has_value());
+			checkItemEquals(*extracted, id, weight1);
+
+			//the throwing variant reports the key that missed
+			bool didExcept = false;
+			try {
+				container.extractItem(id, isWeight1);
 			}
-			Assert::IsFalse(box.canInsert(items.at(0)));
-			
-			//should fail
+			catch (amazoom::MultiHashMapNoSuchObj& e) {
+				didExcept = std::string(e.what()).find("42") != std::string::npos;
+			}
+			Assert::IsTrue(didExcept);
+			Assert::AreEqual(1, container.getNumItems());
+		};
+
+		TEST_METHOD(TemplatePredicates) {
+			const int id = 17;
+			const int NUM_ITEMS = 50;
+
+			amazoom::MultiHashmapImpl hashmap;
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				amazoom::Item item(id, static_cast<float>(i));
+				hashmap.insertItem(item.getID(), item);
+			}
+
+			const float target = 3.0f;
+			auto isTarget = [target](const amazoom::Item& item) { return item.getWeight() == target; };
+
+			Assert::IsTrue(hashmap.containsIf(id, isTarget));
+			Assert::IsFalse(hashmap.containsIf(id + 1, isTarget));
+
+			std::optional<amazoom::Item> extracted(hashmap.extractIf(id, isTarget));
+			Assert::IsTrue(extracted.has_value());
+			checkItemEquals(*extracted, id, target);
+
+			Assert::IsFalse(hashmap.containsIf(id, isTarget));
+			Assert::IsFalse(hashmap.extractIf(id, isTarget).has_value());
+			Assert::AreEqual(NUM_ITEMS - 1, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(PooledNodesMultithreading) {
+			typedef amazoom::MultiHashmap<int, amazoom::Item, std::unordered_map,
+				amazoom::NodePoolAllocator<amazoom::Item>> PooledHashmap;
+
+			const int NUM_PER_THREAD = 5000;
+			const int THREADS = 4;
+			const int ROUNDS = 3;
+
+			PooledHashmap hashmap;
+
+			//each thread repeatedly fills and drains its own keys, so nodes freed by one
+			//round are recycled by the next
+			auto churn = [&hashmap, NUM_PER_THREAD, ROUNDS](int thread) {
+				for (int round = 0; round < ROUNDS; round++) {
+					for (int i = 0; i < NUM_PER_THREAD; i++) {
+						amazoom::Item item(thread, static_cast<float>(i));
+						hashmap.insertItem(item.getID(), item);
+					}
+					for (int i = 0; i < NUM_PER_THREAD; i++) {
+						hashmap.extractItem(thread);
+					}
+				}
+				for (int i = 0; i < NUM_PER_THREAD; i++) {
+					amazoom::Item item(thread, static_cast<float>(i));
+					hashmap.insertItem(item.getID(), item);
+				}
+			};
+
+			std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread(churn, i)));
+			}
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.at(i)->join();
+			}
+
+			Assert::AreEqual(NUM_PER_THREAD * THREADS, hashmap.getNumItems());
+			for (int i = 0; i < THREADS; i++) {
+				auto isLast = [NUM_PER_THREAD](const amazoom::Item& item) { return item.getWeight() == NUM_PER_THREAD - 1; };
+				Assert::IsTrue(hashmap.containsIf(i, isLast));
+				Assert::AreEqual(static_cast<std::size_t>(NUM_PER_THREAD), hashmap.extractItems(i, NUM_PER_THREAD * 2).size());
+			}
+			Assert::AreEqual(0, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(ArenaBackedHashmap) {
+			typedef amazoom::MultiHashmap<int, amazoom::Item, std::unordered_map,
+				amazoom::ArenaAllocator<amazoom::Item>> ArenaHashmap;
+
+			const int NUM_KEYS = 2000;
+			amazoom::MonotonicArena arena(4096);
+
+			{
+				ArenaHashmap hashmap{ amazoom::ArenaAllocator<amazoom::Item>(arena) };
+				for (int i = 0; i < NUM_KEYS; i++) {
+					amazoom::Item item(i, 1.0f);
+					hashmap.insertItem(item.getID(), item);
+				}
+				Assert::IsTrue(arena.bytesAllocated() > 0);
+				Assert::IsTrue(arena.bytesReserved() >= arena.bytesAllocated());
+
+				for (int i = 0; i < NUM_KEYS; i++) {
+					Assert::IsTrue(hashmap.doesContainObj(i));
+					amazoom::Item extractedItem(hashmap.extractItem(i));
+					checkItemEquals(extractedItem, i, 1.0f);
+				}
+			}
+
+			//frees are no-ops; the memory is still held by the arena
+			Assert::IsTrue(arena.bytesAllocated() > 0);
+		};
+
+		TEST_METHOD(WeightOrderedExtraction) {
+			const int id = 4;
+			const int NUM_ITEMS = 200;
+
+			//the same operations with and without the weight index must pick the same weights
+			amazoom::MultiHashmap<int, amazoom::Item> indexed;
+			amazoom::MultiHashmap<int, amazoom::Item> scanned;
+
+			Assert::IsFalse(indexed.extractLightest(id).has_value());
+
+			auto insertBoth = [&](int i) {
+				const float weight = static_cast<float>((i * 37) % NUM_ITEMS);
+				amazoom::Item first(id, weight);
+				amazoom::Item second(id, weight);
+				indexed.insertItem(id, first);
+				scanned.insertItem(id, second);
+			};
+
+			//half are stored before the index exists, half after
+			for (int i = 0; i < NUM_ITEMS / 2; i++) {
+				insertBoth(i);
+			}
+			indexed.enableWeightIndex();
+			for (int i = NUM_ITEMS / 2; i < NUM_ITEMS; i++) {
+				insertBoth(i);
+			}
+
+			//unlinking through the other extraction paths has to keep the index consistent
+			auto isWeight = [](const amazoom::Item& item) { return item.getWeight() == 100.0f; };
+			Assert::IsTrue(indexed.extractIf(id, isWeight).has_value());
+			Assert::IsTrue(scanned.extractIf(id, isWeight).has_value());
+			Assert::AreEqual(static_cast<std::size_t>(3), indexed.extractItems(id, 3).size());
+			Assert::AreEqual(static_cast<std::size_t>(3), scanned.extractItems(id, 3).size());
+
+			Assert::AreEqual(0.0f, indexed.extractLightest(id)->getWeight());
+			Assert::AreEqual(0.0f, scanned.extractLightest(id)->getWeight());
+			Assert::AreEqual(static_cast<float>(NUM_ITEMS - 1), indexed.extractHeaviest(id)->getWeight());
+			Assert::AreEqual(static_cast<float>(NUM_ITEMS - 1), scanned.extractHeaviest(id)->getWeight());
+			Assert::AreEqual(99.0f, indexed.extractWithWeightAtMost(id, 100.5f)->getWeight());
+			Assert::AreEqual(99.0f, scanned.extractWithWeightAtMost(id, 100.5f)->getWeight());
+			Assert::AreEqual(98.0f, indexed.extractWithWeightAtMost(id, 99.0f)->getWeight());
+			Assert::AreEqual(98.0f, scanned.extractWithWeightAtMost(id, 99.0f)->getWeight());
+			Assert::IsFalse(indexed.extractWithWeightAtMost(id, 0.5f).has_value());
+
+			//drain in weight order; whatever is left must come out sorted
+			float previousWeight = -1.0f;
+			while (std::optional<amazoom::Item> item = indexed.extractLightest(id)) {
+				Assert::IsTrue(item->getWeight() >= previousWeight);
+				previousWeight = item->getWeight();
+				Assert::IsTrue(scanned.extractLightest(id)->getWeight() == previousWeight);
+			}
+			Assert::AreEqual(0, indexed.getNumItems());
+			Assert::AreEqual(0, scanned.getNumItems());
+			Assert::IsFalse(indexed.doesContainObj(id));
+		};
+
+		TEST_METHOD(SnapshotIsPointInTime) {
+			amazoom::MultiHashmap<int, amazoom::Item> hashmap;
+			hashmap.enableWeightIndex();
+			for (int key = 0; key < 10; key++) {
+				for (int i = 0; i < 5; i++) {
+					amazoom::Item item(key, static_cast<float>(i));
+					hashmap.insertItem(key, item);
+				}
+			}
+
+			amazoom::MultiHashmap<int, amazoom::Item>::Snapshot before(hashmap.snapshot());
+
+			//changes after the snapshot: whole keys emptied, new keys, and extractions from the middle of a list
+			Assert::AreEqual(static_cast<std::size_t>(5), hashmap.extractItems(0, 5).size());
+			std::optional<amazoom::Item> heaviest(hashmap.extractHeaviest(1));
+			checkItemEquals(*heaviest, 1, 4.0f);
+			amazoom::Item middle(hashmap.extractItem(2, [](const amazoom::Item& item) { return item.getWeight() == 2.0f; }));
+			checkItemEquals(middle, 2, 2.0f);
+			for (int i = 0; i < 3; i++) {
+				amazoom::Item item(100, 1.0f);
+				hashmap.insertItem(100, item);
+				amazoom::Item other(3, 10.0f);
+				hashmap.insertItem(3, other);
+			}
+			Assert::AreEqual(49, hashmap.getNumItems());
+
+			amazoom::MultiHashmap<int, amazoom::Item>::Snapshot after(hashmap.snapshot());
+			Assert::AreEqual(2, hashmap.getNumSnapshots());
+			Assert::IsTrue(before.getEpoch() < after.getEpoch());
+
+			//the old snapshot still shows exactly what was stored when it was taken, objects intact
+			Assert::AreEqual(50, before.getNumItems());
+			float weights = 0.0f;
+			int visited = 0;
+			before.visitItems([&](int key, const amazoom::Item& item) {
+				Assert::AreEqual(key, item.getID());
+				weights += item.getWeight();
+				visited++;
+			});
+			Assert::AreEqual(50, visited);
+			Assert::AreEqual(100.0f, weights);
+			Assert::AreEqual(5, before.countItems(0));
+			Assert::AreEqual(5, before.countItems(3));
+			Assert::AreEqual(0, before.countItems(100));
+
+			Assert::AreEqual(49, after.getNumItems());
+			visited = 0;
+			after.visitItems([&visited](int, const amazoom::Item&) { visited++; });
+			Assert::AreEqual(49, visited);
+			Assert::AreEqual(0, after.countItems(0));
+			Assert::AreEqual(4, after.countItems(1));
+			Assert::AreEqual(8, after.countItems(3));
+			Assert::AreEqual(3, after.countItems(100));
+
+			//extractions while a snapshot lives still hand out the real values
+			std::optional<amazoom::Item> lightest(hashmap.extractLightest(4));
+			checkItemEquals(*lightest, 4, 0.0f);
+			Assert::AreEqual(5, before.countItems(4));
+			Assert::AreEqual(5, after.countItems(4));
+
+			{
+				amazoom::MultiHashmap<int, amazoom::Item>::Snapshot moved(std::move(before));
+				Assert::AreEqual(2, hashmap.getNumSnapshots());
+			}
+			Assert::AreEqual(1, hashmap.getNumSnapshots());
+			Assert::AreEqual(4, hashmap.countItems(4));
+		};
+
+		TEST_METHOD(SnapshotsConsistentUnderWrites) {
+			amazoom::MultiHashmap<int, amazoom::Item> hashmap;
+			const int NUM_KEYS = 8;
+			const int NUM_WRITERS = 4;
+			const int NUM_OPS = 5000;
+
+			for (int key = 0; key < NUM_KEYS; key++) {
+				for (int i = 0; i < 20; i++) {
+					amazoom::Item item(key, 1.0f);
+					hashmap.insertItem(key, item);
+				}
+			}
+
+			std::atomic<int> numDone{ 0 };
+			std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+			for (int t = 0; t < NUM_WRITERS; t++) {
+				threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&hashmap, &numDone, t, NUM_KEYS, NUM_OPS]() {
+					for (int i = 0; i < NUM_OPS; i++) {
+						const int key = (i * 7 + t) % NUM_KEYS;
+						if (i % 2 == 0) {
+							amazoom::Item item(key, 1.0f);
+							hashmap.insertItem(key, item);
+						}
+						else if (std::optional<amazoom::Item> item = hashmap.tryExtractItem(key)) {
+							Assert::AreEqual(key, item->getID());
+						}
+					}
+					numDone++;
+				})));
+			}
+
+			//every snapshot must add up to the item count at the moment it was taken, with no moved-from objects
+			int numSnapshots = 0;
+			do {
+				amazoom::MultiHashmap<int, amazoom::Item>::Snapshot snapshot(hashmap.snapshot());
+				int visited = 0;
+				snapshot.visitItems([&visited](int key, const amazoom::Item& item) {
+					Assert::AreEqual(key, item.getID());
+					visited++;
+				});
+				Assert::AreEqual(snapshot.getNumItems(), visited);
+				numSnapshots++;
+			} while (numDone < NUM_WRITERS);
+
+			for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+				threadPtr->join();
+			}
+			Assert::IsTrue(numSnapshots > 0);
+			Assert::AreEqual(0, hashmap.getNumSnapshots());
+		};
+
+		TEST_METHOD(ReservationsHoldStock) {
+			amazoom::MultiHashmapImpl hashmap;
+			for (int i = 0; i < 5; i++) {
+				amazoom::Item item(i, 1.0f);
+				hashmap.insertItem(1, item);
+			}
+
+			std::optional<amazoom::MultiHashmapImpl::Reservation> hold = hashmap.reserve(1, 3, std::chrono::minutes(1));
+			Assert::IsTrue(hold.has_value());
+			Assert::IsFalse(hashmap.reserve(1, 3, std::chrono::minutes(1)).has_value());
+			Assert::IsFalse(hashmap.reserve(2, 1, std::chrono::minutes(1)).has_value());
+			Assert::AreEqual(2, hashmap.countAvailable(1));
+			Assert::AreEqual(3, hashmap.countReserved(1));
+			Assert::AreEqual(5, hashmap.getNumItems());
+			Assert::AreEqual(2, hashmap.countItems(1)); //stock checks see only what extraction can take
+
+			//held units stay on the shelf, but only the commit can take them
+			Assert::AreEqual(static_cast<std::size_t>(2), hashmap.extractItems(1, 10).size());
+			Assert::IsFalse(hashmap.tryExtractItem(1).has_value());
+			Assert::AreEqual(3, hashmap.getNumItems());
+
+			Assert::AreEqual(static_cast<std::size_t>(3), hashmap.commitReservation(*hold).size());
+			Assert::AreEqual(0, hashmap.getNumItems());
+			Assert::AreEqual(0, hashmap.countReserved(1));
+			Assert::IsFalse(hashmap.releaseReservation(*hold));
 			bool didExcept = false;
 			try {
-				box.insertItem(items.at(0));
+				hashmap.commitReservation(*hold);
 			}
-			catch(amazoom::BoxOverweightException& e){
+			catch (amazoom::MultiHashMapNoSuchReservation&) {
 				didExcept = true;
 			}
 			Assert::IsTrue(didExcept);
 
+			//a released hold goes to a picker waiting for the key
+			amazoom::Item item(10, 1.0f);
+			hashmap.insertItem(1, item);
+			hold = hashmap.reserve(1, 1, std::chrono::minutes(1));
+			std::future<amazoom::Item> waiting = hashmap.extractItemAsync(1);
+			Assert::IsTrue(waiting.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+			Assert::IsTrue(hashmap.releaseReservation(*hold));
+			Assert::AreEqual(10, waiting.get().getID());
+
+			//an expired hold returns to stock by itself
+			amazoom::Item expiring(11, 1.0f);
+			hashmap.insertItem(1, expiring);
+			hold = hashmap.reserve(1, 1, std::chrono::milliseconds(20));
+			Assert::IsFalse(hashmap.tryExtractItem(1).has_value());
+			boost::this_thread::sleep_for(boost::chrono::milliseconds(40));
+			Assert::AreEqual(1, hashmap.countAvailable(1));
+			Assert::AreEqual(0, hashmap.countReserved(1));
+			Assert::IsFalse(hashmap.releaseReservation(*hold));
+			Assert::IsTrue(hashmap.tryExtractItem(1).has_value());
+		};
+
+		TEST_METHOD(ConcurrentHoldsNeverOversell) {
+			const int NUM_ITEMS = 2000;
+			const int NUM_THREADS = 6;
+			amazoom::MultiHashmap<int, amazoom::Item> hashmap;
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				amazoom::Item item(i, 1.0f);
+				hashmap.insertItem(0, item);
+			}
 
+			std::atomic<int> taken{ 0 };
+			std::atomic<int> shortCommits{ 0 };
+			std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+			for (int t = 0; t < NUM_THREADS; t++) {
+				threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&, t]() {
+					std::mt19937 eng(t);
+					while (hashmap.getNumItems() > 0) {
+						if (t % 3 == 0) { //plain pickers compete with the holds for the same stock
+							taken += static_cast<int>(hashmap.extractItems(0, 2).size());
+							continue;
+						}
+						const int count = 1 + static_cast<int>(eng() % 3);
+						std::optional<amazoom::MultiHashmap<int, amazoom::Item>::Reservation> hold = hashmap.reserve(0, count, std::chrono::minutes(1));
+						if (!hold) {
+							continue;
+						}
+						if (eng() % 2 == 0) {
+							hashmap.releaseReservation(*hold);
+							continue;
+						}
+						const int committed = static_cast<int>(hashmap.commitReservation(*hold).size());
+						if (committed != count) {
+							shortCommits++;
+						}
+						taken += committed;
+					}
+				})));
+			}
+			for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+				threadPtr->join();
+			}
 
-		}
+			Assert::AreEqual(0, shortCommits.load());
+			Assert::AreEqual(NUM_ITEMS, taken.load());
+			Assert::AreEqual(0, hashmap.countAvailable(0));
+			Assert::AreEqual(0, hashmap.countReserved(0));
+			Assert::AreEqual(0, hashmap.getNumReservations());
+		};
+
+		TEST_METHOD(ReleasingSnapshotTakesNoMapLock) {
+			typedef amazoom::MultiHashmap<int, amazoom::Item, std::unordered_map, CountingAllocator<amazoom::Item>> Map;
+			Map hashmap;
+			for (int i = 0; i < 2; i++) {
+				amazoom::Item item(i, 1.0f);
+				hashmap.insertItem(0, item);
+			}
+
+			std::optional<Map::Snapshot> snapshot(hashmap.snapshot());
+			amazoom::Item extracted(hashmap.extractItem(0)); //retired, since the snapshot can still see it
+			Assert::AreEqual(1, snapshot->countItems(0) - hashmap.countItems(0));
+
+			//a reader holding the shared lock can drop a snapshot; that used to wait for the exclusive lock forever
+			hashmap.visitItems([&snapshot](int, const amazoom::Item&) { snapshot.reset(); });
+			Assert::IsFalse(snapshot.has_value());
+			Assert::AreEqual(0, hashmap.getNumSnapshots());
+
+			//the retired node is freed by the next writer: an insertion into an existing key allocates one node
+			const int liveBefore = liveAllocations().load();
+			amazoom::Item next(5, 1.0f);
+			hashmap.insertItem(0, next);
+			Assert::IsTrue(liveAllocations().load() < liveBefore + 1);
+			Assert::AreEqual(2, hashmap.countItems(0));
+		};
 	};
 
-};
 
+	TEST_CLASS(Sharded_Hashmap_Testing) {
+
+		TEST_METHOD(SameKeySameShard) {
+			const int id = 5;
+			const float weight1 = 1.0f;
+			const float weight2 = 10.0f;
+
+			amazoom::Item item(id, weight1);
+			amazoom::Item item2(id, weight2);
+
+			amazoom::ShardedMultiHashmap<int, amazoom::Item> container(4);
+			Assert::AreEqual(4, container.getNumShards());
+
+			container.insertItem(item.getID(), item);
+			container.insertItem(item2.getID(), item2);
+
+			checkItemIsInvalid(item);
+			checkItemIsInvalid(item2);
+			Assert::AreEqual(2, container.getNumItems());
+
+			//same-key objects share a shard, so extraction order matches MultiHashmap
+			amazoom::Item extractedItem(container.extractItem(id));
+			checkItemEquals(extractedItem, id, weight2);
+			amazoom::Item extractedItem2(container.extractItem(id));
+			checkItemEquals(extractedItem2, id, weight1);
+
+			Assert::AreEqual(0, container.getNumItems());
+			Assert::IsFalse(container.doesContainObj(id));
+		};
+
+		TEST_METHOD(ManyKeysAcrossShards) {
+			const int NUM_KEYS = 1000;
+			const float WEIGHT = 3.0f;
+
+			amazoom::ShardedMultiHashmap<int, amazoom::Item> container(8);
+
+			for (int i = 0; i < NUM_KEYS; i++) {
+				amazoom::Item newItem(i, WEIGHT + i);
+				container.insertItem(newItem.getID(), newItem);
+			}
+			Assert::AreEqual(NUM_KEYS, container.getNumItems());
+
+			for (int i = 0; i < NUM_KEYS; i++) {
+				auto comparisonFuncWeight = [WEIGHT, i](const amazoom::Item& item)->bool {
+					return item.getWeight() == WEIGHT + i;
+				};
+				Assert::IsTrue(container.doesContainObj(i, comparisonFuncWeight));
+				amazoom::Item itemRetrieved(container.extractItem(i));
+				checkItemEquals(itemRetrieved, i, WEIGHT + i);
+			}
+			Assert::AreEqual(0, container.getNumItems());
+		};
+
+		TEST_METHOD(ShardedRandomMultithreading) {
+
+			const int NUM_TO_TEST_PER_THREAD = 3000;
+			const int THREADS = 4;
+
+			std::srand(std::time(nullptr)); // use current time as seed for random generator
+			std::random_device rd; // obtain a random number from hardware
+			std::mt19937 eng(rd()); // seed the generator
+
+			std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+			std::vector<std::pair<int, float>> perThreadValues[THREADS];
+
+			amazoom::ShardedMultiHashmapImpl hashmap1(THREADS);
+			amazoom::WorkerAccessibleContainer& hashmap = hashmap1;
+
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.push_back(std::unique_ptr<boost::thread>(
+					new boost::thread(multithreadingInsert,
+									  NUM_TO_TEST_PER_THREAD,
+									  std::ref(hashmap),
+									  std::ref(perThreadValues[i]),
+									  std::ref(eng))));
+			}
+
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.at(i)->join();
+			}
+
+			Assert::AreEqual(NUM_TO_TEST_PER_THREAD * THREADS, hashmap.getNumItems());
+
+			for (int i = 0; i < THREADS; i++) {
+				for (const std::pair<int, float>& toRetrieve : perThreadValues[i]) {
+					const float weight = std::get<float>(toRetrieve);
+					auto comparisonFuncWeightID = [weight](const amazoom::Item& item)->bool {
+						return item.getWeight() == weight;
+					};
+
+					amazoom::Item itemRetrieved(hashmap.extractItem(std::get<int>(toRetrieve), comparisonFuncWeightID));
+					checkItemEquals(itemRetrieved, std::get<int>(toRetrieve), weight);
+				}
+			}
+			Assert::AreEqual(0, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(ShardedBatchInsert) {
+			const int NUM_KEYS = 500;
+
+			std::vector<std::pair<int, amazoom::Item>> pallet;
+			for (int i = 0; i < NUM_KEYS; i++) {
+				pallet.emplace_back(i, amazoom::Item(i, 1.0f));
+				pallet.emplace_back(i, amazoom::Item(i, 2.0f));
+			}
+
+			amazoom::ShardedMultiHashmapImpl hashmap1(8);
+			amazoom::WorkerAccessibleContainer& hashmap = hashmap1;
+			hashmap.insertItems(pallet);
+			Assert::AreEqual(NUM_KEYS * 2, hashmap.getNumItems());
+
+			for (int i = 0; i < NUM_KEYS; i++) {
+				std::vector<amazoom::Item> extracted(hashmap.extractItems(i, 5));
+				Assert::AreEqual(static_cast<std::size_t>(2), extracted.size());
+				Assert::AreEqual(3.0f, extracted.at(0).getWeight() + extracted.at(1).getWeight());
+			}
+			Assert::AreEqual(0, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(SplitKeyKeepsItsItems) {
+			const int id = 7;
+			const int NUM_ITEMS = 100;
+
+			amazoom::ShardedMultiHashmap<int, amazoom::Item> container(4);
+			Assert::IsFalse(container.splitKey(id)); //splitting is not enabled yet
+			container.enableHotKeySplitting(4);
+
+			for (int i = 1; i <= NUM_ITEMS; i++) {
+				amazoom::Item newItem(id, static_cast<float>(i));
+				container.insertItem(id, newItem);
+			}
+
+			Assert::IsTrue(container.splitKey(id));
+			Assert::IsTrue(container.isSplit(id));
+			Assert::IsFalse(container.isSplit(id + 1));
+			Assert::AreEqual(1, container.getNumSplitKeys());
+			Assert::AreEqual(NUM_ITEMS, container.countItems(id));
+			Assert::AreEqual(NUM_ITEMS, container.getNumItems());
+
+			//the weight functions still see every sub-list
+			amazoom::Item lightest(*container.extractLightest(id));
+			checkItemEquals(lightest, id, 1.0f);
+			amazoom::Item heaviest(*container.extractHeaviest(id));
+			checkItemEquals(heaviest, id, static_cast<float>(NUM_ITEMS));
+			amazoom::Item fitting(*container.extractWithWeightAtMost(id, 50.5f));
+			checkItemEquals(fitting, id, 50.0f);
+
+			auto weighs42 = [](const amazoom::Item& item)->bool { return item.getWeight() == 42.0f; };
+			Assert::IsTrue(container.doesContainObj(id, weighs42));
+			amazoom::Item matching(*container.extractIf(id, weighs42));
+			checkItemEquals(matching, id, 42.0f);
+			Assert::IsFalse(container.doesContainObj(id, weighs42));
+
+			Assert::AreEqual(static_cast<std::size_t>(10), container.extractItems(id, 10).size());
+			for (int i = 0; i < 10; i++) {
+				amazoom::Item newItem(id, 1000.0f);
+				container.insertItem(id, newItem);
+			}
+			Assert::AreEqual(NUM_ITEMS - 4, container.countItems(id));
+
+			Assert::IsTrue(container.mergeKey(id));
+			Assert::IsFalse(container.isSplit(id));
+			Assert::IsFalse(container.mergeKey(id));
+			Assert::AreEqual(NUM_ITEMS - 4, container.countItems(id));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_ITEMS - 4), container.extractItems(id, NUM_ITEMS).size());
+			Assert::AreEqual(0, container.getNumItems());
+		};
+
+		TEST_METHOD(HotKeySplitsAndMergesBack) {
+			const int HOT_ID = 5;
+			const int NUM_KEYS = 100;
+			const int NUM_OPS = 200000;
+
+			amazoom::ShardedMultiHashmap<int, amazoom::Item> container(8);
+			container.enableHotKeySplitting(4, amazoom::ShardedMultiHashmap<int, amazoom::Item>::PER_THREAD);
+
+			for (int i = 0; i < NUM_KEYS; i++) {
+				amazoom::Item newItem(i, 1.0f);
+				container.insertItem(i, newItem);
+			}
+
+			//one key takes every pick
+			for (int i = 0; i < NUM_OPS; i++) {
+				amazoom::Item picked(*container.tryExtractItem(HOT_ID));
+				container.insertItem(HOT_ID, picked);
+			}
+			Assert::IsTrue(container.isSplit(HOT_ID));
+			Assert::AreEqual(1, container.countItems(HOT_ID));
+
+			//then traffic spreads evenly over the other keys
+			for (int i = 0; i < NUM_OPS; i++) {
+				const int id = HOT_ID + 1 + i % (NUM_KEYS - HOT_ID - 1);
+				amazoom::Item picked(*container.tryExtractItem(id));
+				container.insertItem(id, picked);
+			}
+			Assert::IsFalse(container.isSplit(HOT_ID));
+			Assert::AreEqual(0, container.getNumSplitKeys());
+			Assert::AreEqual(NUM_KEYS, container.getNumItems());
+			amazoom::Item hotItem(container.extractItem(HOT_ID));
+			checkItemEquals(hotItem, HOT_ID, 1.0f);
+		};
+
+		TEST_METHOD(SplitsAndMergesUnderLoad) {
+			const int id = 3;
+			const int THREADS = 4;
+			const int NUM_ITEMS = 64;
+			const int NUM_OPS_PER_THREAD = 20000;
+
+			amazoom::ShardedMultiHashmap<int, amazoom::Item> container(4);
+			container.enableHotKeySplitting(4);
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				amazoom::Item newItem(id, 1.0f);
+				container.insertItem(id, newItem);
+			}
+
+			//pickers take and put back while the key is split and merged under them; nothing may get lost
+			std::atomic<bool> done(false);
+			boost::thread rearranger([&container, &done, id]() {
+				while (!done) {
+					container.splitKey(id);
+					container.mergeKey(id);
+				}
+			});
+
+			std::vector<std::unique_ptr<boost::thread>> pickers;
+			for (int t = 0; t < THREADS; t++) {
+				pickers.push_back(std::unique_ptr<boost::thread>(new boost::thread([&container, id, NUM_OPS_PER_THREAD]() {
+					for (int i = 0; i < NUM_OPS_PER_THREAD; i++) {
+						std::optional<amazoom::Item> picked(container.tryExtractItem(id));
+						if (picked) {
+							container.insertItem(id, *picked);
+						}
+					}
+				})));
+			}
+			for (auto& picker : pickers) {
+				picker->join();
+			}
+			done = true;
+			rearranger.join();
+
+			container.mergeKey(id);
+			Assert::AreEqual(NUM_ITEMS, container.countItems(id));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_ITEMS), container.extractItems(id, NUM_ITEMS * 2).size());
+		};
+
+		TEST_METHOD(NoMissedStockWhileRearranging) {
+			const int id = 5;
+			const int THREADS = 4;
+			const int QUOTA = 5000;
+
+			amazoom::ShardedMultiHashmap<int, amazoom::Item> container(4);
+			container.enableHotKeySplitting(4);
+			for (int i = 0; i < THREADS * QUOTA; i++) {
+				amazoom::Item newItem(id, static_cast<float>(i % 100));
+				container.insertItem(id, newItem);
+			}
+
+			std::atomic<bool> done(false);
+			boost::thread rearranger([&container, &done, id]() {
+				while (!done) {
+					container.splitKey(id);
+					container.mergeKey(id);
+				}
+			});
+
+			//each picker takes exactly its quota, so while it still needs one, stock is left for it
+			std::atomic<int> misses(0);
+			std::vector<std::unique_ptr<boost::thread>> pickers;
+			for (int t = 0; t < THREADS; t++) {
+				pickers.push_back(std::unique_ptr<boost::thread>(new boost::thread([&container, &misses, id, t, QUOTA]() {
+					for (int i = 0; i < QUOTA; i++) {
+						std::optional<amazoom::Item> picked;
+						switch ((t + i) % 4) {
+						case 0: picked = container.tryExtractItem(id); break;
+						case 1: picked = container.extractLightest(id); break;
+						case 2: {
+							std::vector<amazoom::Item> batch(container.extractItems(id, 1));
+							if (!batch.empty()) {
+								picked = std::move(batch.front());
+							}
+							break;
+						}
+						default:
+							misses += container.doesContainObj(id) ? 0 : 1;
+							picked = container.extractItem(id);
+						}
+						misses += picked ? 0 : 1;
+					}
+				})));
+			}
+			for (auto& picker : pickers) {
+				picker->join();
+			}
+			done = true;
+			rearranger.join();
+
+			Assert::AreEqual(0, misses.load());
+			Assert::AreEqual(0, container.getNumItems());
+		};
+	};
+
+
+	TEST_CLASS(Flat_Hashmap_Testing) {
+
+		TEST_METHOD(FlatSameKeyExtraction) {
+			const int id = 5;
+			const float weight1 = 1.0f;
+			const float weight2 = 10.0f;
+			const float weight3 = 100.0f;
+
+			amazoom::Item item(id, weight1);
+			amazoom::Item item2(id, weight2);
+			amazoom::Item item3(id, weight3);
+
+			amazoom::FlatMultiHashmap<int, amazoom::Item> container;
+
+			container.insertItem(item.getID(), item);
+			container.insertItem(item2.getID(), item2);
+			container.insertItem(item3.getID(), item3);
+
+			checkItemIsInvalid(item);
+			checkItemIsInvalid(item2);
+			checkItemIsInvalid(item3);
+			Assert::AreEqual(3, container.getNumItems());
+
+			//extract from the middle; the last object is swapped into its slot
+			auto isWeight1 = [weight1](const amazoom::Item& item)->bool {
+				return item.getWeight() == weight1;
+			};
+			amazoom::Item extractedItem(container.extractItem(id, isWeight1));
+			checkItemEquals(extractedItem, id, weight1);
+			Assert::IsFalse(container.doesContainObj(id, isWeight1));
+
+			amazoom::Item extractedItem2(container.extractItem(id));
+			checkItemEquals(extractedItem2, id, weight2);
+			amazoom::Item extractedItem3(container.extractItem(id));
+			checkItemEquals(extractedItem3, id, weight3);
+
+			Assert::AreEqual(0, container.getNumItems());
+			Assert::IsFalse(container.doesContainObj(id));
+
+			bool didExcept = false;
+			try {
+				container.extractItem(id);
+			}
+			catch (amazoom::MultiHashMapNoSuchObj& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+		};
+
+		TEST_METHOD(FlatRandomMultithreading) {
+
+			const int NUM_TO_TEST_PER_THREAD = 3000;
+			const int THREADS = 4;
+
+			std::srand(std::time(nullptr)); // use current time as seed for random generator
+			std::random_device rd; // obtain a random number from hardware
+			std::mt19937 eng(rd()); // seed the generator
+
+			std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+			std::vector<std::pair<int, float>> perThreadValues[THREADS];
+
+			amazoom::FlatMultiHashmapImpl hashmap1;
+			amazoom::WorkerAccessibleContainer& hashmap = hashmap1;
+
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.push_back(std::unique_ptr<boost::thread>(
+					new boost::thread(multithreadingInsert,
+									  NUM_TO_TEST_PER_THREAD,
+									  std::ref(hashmap),
+									  std::ref(perThreadValues[i]),
+									  std::ref(eng))));
+			}
+
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.at(i)->join();
+			}
+
+			Assert::AreEqual(NUM_TO_TEST_PER_THREAD * THREADS, hashmap.getNumItems());
+
+			for (int i = 0; i < THREADS; i++) {
+				for (const std::pair<int, float>& toRetrieve : perThreadValues[i]) {
+					const float weight = std::get<float>(toRetrieve);
+					auto comparisonFuncWeightID = [weight](const amazoom::Item& item)->bool {
+						return item.getWeight() == weight;
+					};
+
+					amazoom::Item itemRetrieved(hashmap.extractItem(std::get<int>(toRetrieve), comparisonFuncWeightID));
+					checkItemEquals(itemRetrieved, std::get<int>(toRetrieve), weight);
+				}
+			}
+			Assert::AreEqual(0, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(FlatBatchExtractSpecial) {
+			const int id = 11;
+			const int NUM_ITEMS = 64;
+
+			std::vector<std::pair<int, amazoom::Item>> pallet;
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				pallet.emplace_back(id, amazoom::Item(id, static_cast<float>(i % 2)));
+			}
+
+			amazoom::FlatMultiHashmapImpl hashmap;
+			hashmap.insertItems(pallet);
+			Assert::AreEqual(NUM_ITEMS, hashmap.getNumItems());
+
+			auto isOdd = [](const amazoom::Item& item)->bool { return item.getWeight() == 1.0f; };
+			std::vector<amazoom::Item> odd(hashmap.extractItems(id, NUM_ITEMS, isOdd));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_ITEMS / 2), odd.size());
+			Assert::IsFalse(hashmap.doesContainObj(id, isOdd));
+
+			std::vector<amazoom::Item> even(hashmap.extractItems(id, NUM_ITEMS));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_ITEMS / 2), even.size());
+			for (amazoom::Item& item : even) {
+				checkItemEquals(item, id, 0.0f);
+			}
+			Assert::AreEqual(0, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(WeightOrderedExtraction) {
+			const int id = 2;
+			amazoom::FlatMultiHashmap<int, amazoom::Item> hashmap;
+
+			const float weights[] = { 5.0f, 1.0f, 9.0f, 3.0f, 7.0f };
+			for (float weight : weights) {
+				amazoom::Item item(id, weight);
+				hashmap.insertItem(id, item);
+			}
+
+			Assert::AreEqual(1.0f, hashmap.extractLightest(id)->getWeight());
+			Assert::AreEqual(9.0f, hashmap.extractHeaviest(id)->getWeight());
+			Assert::AreEqual(5.0f, hashmap.extractWithWeightAtMost(id, 6.0f)->getWeight());
+			Assert::IsFalse(hashmap.extractWithWeightAtMost(id, 2.0f).has_value());
+			Assert::AreEqual(2, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(NonArithmeticKeys) {
+			//keys only need hashing, equality and operator<<, as for MultiHashmap
+			amazoom::FlatMultiHashmap<std::string, amazoom::Item> flat;
+			amazoom::ColumnarMultiHashmap<std::string> columnar;
+			amazoom::Item item(1, 1.0f);
+			amazoom::Item item2(1, 1.0f);
+			flat.insertItem("aisle 4", item);
+			columnar.insertItem("aisle 4", item2);
+			amazoom::Item fromFlat(flat.extractItem("aisle 4"));
+			amazoom::Item fromColumnar(columnar.extractItem("aisle 4"));
+			checkItemEquals(fromFlat, 1, 1.0f);
+			checkItemEquals(fromColumnar, 1, 1.0f);
+
+			std::string flatError;
+			std::string columnarError;
+			try {
+				flat.extractItem("aisle 4");
+			}
+			catch (amazoom::MultiHashMapNoSuchObj& e) {
+				flatError = e.what();
+			}
+			try {
+				columnar.extractItem("aisle 4");
+			}
+			catch (amazoom::MultiHashMapNoSuchObj& e) {
+				columnarError = e.what();
+			}
+			Assert::IsTrue(flatError.find("aisle 4") != std::string::npos);
+			Assert::IsTrue(columnarError.find("aisle 4") != std::string::npos);
+		};
+	};
+
+
+	TEST_CLASS(Columnar_Hashmap_Testing) {
+
+		TEST_METHOD(ColumnarSameKeyExtraction) {
+			const int id = 5;
+			const float weight1 = 1.0f;
+			const float weight2 = 10.0f;
+			const float weight3 = 100.0f;
+
+			amazoom::Item item(id, weight1);
+			amazoom::Item item2(id, weight2, true);
+			amazoom::Item item3(id, weight3);
+
+			amazoom::ColumnarMultiHashmap<int> container;
+
+			container.insertItem(item.getID(), item);
+			container.insertItem(item2.getID(), item2);
+			container.insertItem(item3.getID(), item3);
+
+			checkItemIsInvalid(item);
+			checkItemIsInvalid(item2);
+			checkItemIsInvalid(item3);
+			Assert::AreEqual(3, container.getNumItems());
+			Assert::AreEqual(3, container.countItems(id));
+
+			auto isWeight1 = [weight1](const amazoom::Item& item)->bool {
+				return item.getWeight() == weight1;
+			};
+			amazoom::Item extractedItem(container.extractItem(id, isWeight1));
+			checkItemEquals(extractedItem, id, weight1);
+			Assert::IsFalse(container.doesContainObj(id, isWeight1));
+
+			//flags come back out of their own column
+			amazoom::Item extractedItem2(*container.extractLightest(id));
+			checkItemEquals(extractedItem2, id, weight2, true);
+			amazoom::Item extractedItem3(container.extractItem(id));
+			checkItemEquals(extractedItem3, id, weight3);
+
+			Assert::AreEqual(0, container.getNumItems());
+			Assert::IsFalse(container.doesContainObj(id));
+
+			bool didExcept = false;
+			try {
+				container.extractItem(id);
+			}
+			catch (amazoom::MultiHashMapNoSuchObj& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			//an item the columns cannot hold is refused and stays with the caller
+			amazoom::Item tooHeavy(id, amazoom::PackedItem::MAX_WEIGHT * 2.0f);
+			didExcept = false;
+			try {
+				container.insertItem(id, tooHeavy);
+			}
+			catch (std::out_of_range& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			checkItemEquals(tooHeavy, id, amazoom::PackedItem::MAX_WEIGHT * 2.0f);
+			Assert::AreEqual(0, container.getNumItems());
+		};
+
+		TEST_METHOD(ColumnarWeightExtraction) {
+			const int id = 9;
+
+			std::vector<std::pair<int, amazoom::Item>> pallet;
+			for (int i = 1; i <= 9; i++) {
+				pallet.emplace_back(id, amazoom::Item(id, i * 0.5f));
+			}
+
+			amazoom::ColumnarMultiHashmapImpl hashmap;
+			hashmap.insertItems(pallet);
+			checkItemIsInvalid(pallet.front().second);
+			Assert::AreEqual(9, hashmap.getNumItems());
+
+			Assert::AreEqual(0.5f, hashmap.extractLightest(id)->getWeight());
+			Assert::AreEqual(4.5f, hashmap.extractHeaviest(id)->getWeight());
+			Assert::AreEqual(2.5f, hashmap.extractWithWeightAtMost(id, 2.5f)->getWeight());
+			Assert::AreEqual(2.0f, hashmap.extractWithWeightAtMost(id, 2.9f)->getWeight());
+			Assert::IsFalse(hashmap.extractWithWeightAtMost(id, 0.9f).has_value());
+
+			auto isWhole = [](const amazoom::Item& item)->bool { return item.getWeight() == std::floor(item.getWeight()); };
+			std::vector<amazoom::Item> whole(hashmap.extractItems(id, 10, isWhole));
+			Assert::AreEqual(static_cast<std::size_t>(3), whole.size());
+			Assert::AreEqual(2, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(ColumnarPackedBulkMove) {
+			const int id = 21;
+			const int NUM_ITEMS = 1000;
+
+			amazoom::ColumnarMultiHashmapImpl from;
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				amazoom::Item newItem(id, static_cast<float>(i), i % 3 == 0);
+				from.insertItem(id, newItem);
+			}
+
+			//the move never builds an Item
+			amazoom::ColumnarMultiHashmapImpl to;
+			std::vector<amazoom::PackedItem> moved(from.extractPacked(id, NUM_ITEMS / 2));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_ITEMS / 2), moved.size());
+			to.insertPacked(id, moved);
+
+			Assert::AreEqual(NUM_ITEMS / 2, from.getNumItems());
+			Assert::AreEqual(NUM_ITEMS / 2, to.countItems(id));
+
+			//the newest half went, in the order extractItems would have taken it
+			Assert::AreEqual(static_cast<float>(NUM_ITEMS - 1), moved.front().getWeight());
+			int numLarge = 0;
+			to.visitItems([&numLarge](const int key, const amazoom::Item& item) {
+				Assert::IsTrue(item.getWeight() >= NUM_ITEMS / 2);
+				numLarge += item.isLarge() ? 1 : 0;
+			});
+			Assert::AreEqual(167, numLarge);
+
+			std::vector<amazoom::Item> rest(from.extractItems(id, NUM_ITEMS));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_ITEMS / 2), rest.size());
+			Assert::AreEqual(static_cast<float>(NUM_ITEMS / 2 - 1), rest.front().getWeight());
+		};
+
+		TEST_METHOD(ColumnarMixedKeyPallet) {
+			const int NUM_ROUNDS = 50;
+
+			//keys come back after others, so each key's columns are grown for all of its items at once
+			amazoom::ColumnarMultiHashmapImpl hashmap;
+			for (int round = 0; round < NUM_ROUNDS; round++) {
+				std::vector<std::pair<int, amazoom::Item>> pallet;
+				for (int key : { 1, 1, 2, 1, 3, 2 }) {
+					pallet.emplace_back(key, amazoom::Item(key, static_cast<float>(key), key == 2));
+				}
+				hashmap.insertItems(pallet);
+			}
+
+			Assert::AreEqual(6 * NUM_ROUNDS, hashmap.getNumItems());
+			Assert::AreEqual(3 * NUM_ROUNDS, hashmap.countItems(1));
+			Assert::AreEqual(2 * NUM_ROUNDS, hashmap.countItems(2));
+			Assert::AreEqual(NUM_ROUNDS, hashmap.countItems(3));
+			hashmap.visitItems([](const int key, const amazoom::Item& item) {
+				Assert::AreEqual(key, item.getID());
+				Assert::AreEqual(static_cast<float>(key), item.getWeight());
+				Assert::IsTrue(item.isLarge() == (key == 2));
+			});
+		};
+	};
+
+
+	TEST_CLASS(Weight_Aggregates_Testing) {
+
+		TEST_METHOD(VectorKernelsMatchScalar) {
+			std::mt19937 gen(17);
+			std::uniform_int_distribution<std::uint32_t> rawWeight(0, amazoom::PackedItem::MAX_RAW_WEIGHT);
+
+			//every length up to a few vectors, so each kernel also ends in every possible scalar tail
+			for (std::size_t count = 0; count <= 40; count++) {
+				std::vector<std::uint32_t> weights(count);
+				for (std::uint32_t& weight : weights) {
+					weight = count % 2 == 0 ? rawWeight(gen) : rawWeight(gen) % 4096;
+				}
+				weights.push_back(amazoom::PackedItem::MAX_RAW_WEIGHT); //the heaviest weight must not overflow anything
+				const std::uint32_t* data = weights.data();
+				const std::size_t size = weights.size();
+
+				Assert::IsTrue(amazoom::WeightAggregates::sumRawScalar(data, size) == amazoom::WeightAggregates::sumRaw(data, size));
+
+				const std::uint32_t bounds[][2] = { { 0, amazoom::PackedItem::MAX_RAW_WEIGHT }, { 1000, 3000 }, { 2048, 2048 }, { 3000, 1000 } };
+				for (const auto& bound : bounds) {
+					Assert::IsTrue(amazoom::WeightAggregates::countRawBetweenScalar(data, size, bound[0], bound[1])
+						== amazoom::WeightAggregates::countRawBetween(data, size, bound[0], bound[1]));
+				}
+
+				const double widths[] = { 1024.0, 1000.5, 3.0e7, 1.0e-3 };
+				for (double width : widths) {
+					for (int numBins : { 1, 7, 300 }) {
+						std::vector<int> expected(numBins, 0);
+						std::vector<int> actual(numBins, 0);
+						amazoom::WeightAggregates::histogramRawScalar(data, size, width, expected);
+						amazoom::WeightAggregates::histogramRaw(data, size, width, actual);
+						Assert::IsTrue(expected == actual);
+					}
+				}
+			}
+		};
+
+		TEST_METHOD(AggregatesAgreeAcrossContainers) {
+			const int id = 3;
+			const int NUM_ITEMS = 101;
+
+			std::vector<std::unique_ptr<amazoom::WorkerAccessibleContainer>> containers;
+			containers.emplace_back(new amazoom::MultiHashmapImpl());
+			containers.emplace_back(new amazoom::ShardedMultiHashmapImpl(4));
+			containers.emplace_back(new amazoom::FlatMultiHashmapImpl());
+			containers.emplace_back(new amazoom::ColumnarMultiHashmapImpl());
+
+			//quarter kilograms, which every container stores exactly
+			double expectedTotal = 0.0;
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				expectedTotal += i * 0.25;
+			}
+			const std::vector<int> expectedBins = { 20, 20, 20, 41 };
+
+			for (auto& container : containers) {
+				for (int i = 0; i < NUM_ITEMS; i++) {
+					amazoom::Item newItem(id, i * 0.25f);
+					container->insertItem(id, newItem);
+					amazoom::Item otherItem(id + 1, 1000.0f);
+					container->insertItem(id + 1, otherItem);
+				}
+
+				Assert::AreEqual(expectedTotal, container->totalWeight(id));
+				Assert::AreEqual(NUM_ITEMS, container->countWhere(id, 0.0f, 25.0f));
+				Assert::AreEqual(33, container->countWhere(id, 2.1f, 10.25f));
+				Assert::AreEqual(1, container->countWhere(id, 5.0f, 5.0f));
+				Assert::AreEqual(0, container->countWhere(id, 10.0f, 2.0f));
+				Assert::IsTrue(expectedBins == container->weightHistogram(id, 5.0f, 4));
+
+				//other keys are left out, and a missing key has nothing to aggregate
+				Assert::AreEqual(0.0, container->totalWeight(id + 2));
+				Assert::AreEqual(0, container->countWhere(id + 2, 0.0f, 100.0f));
+				Assert::IsTrue(std::vector<int>(4, 0) == container->weightHistogram(id + 2, 5.0f, 4));
+
+				//an aggregate does not take anything out
+				Assert::AreEqual(NUM_ITEMS, container->countItems(id));
+			}
+
+			//a split key is aggregated over all of its sub-lists
+			amazoom::ShardedMultiHashmap<int, amazoom::Item> sharded(4);
+			sharded.enableHotKeySplitting(4);
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				amazoom::Item newItem(id, i * 0.25f);
+				sharded.insertItem(id, newItem);
+				if (i == NUM_ITEMS / 2) {
+					Assert::IsTrue(sharded.splitKey(id));
+				}
+			}
+			Assert::AreEqual(expectedTotal, amazoom::WeightAggregates::totalWeight(sharded, id));
+			Assert::AreEqual(33, amazoom::WeightAggregates::countWhere(sharded, id, 2.1f, 10.25f));
+			Assert::IsTrue(expectedBins == amazoom::WeightAggregates::weightHistogram(sharded, id, 5.0f, 4));
+		};
+
+		TEST_METHOD(HistogramRejectsBadArguments) {
+			amazoom::MultiHashmapImpl hashmap;
+			amazoom::ColumnarMultiHashmapImpl columnar;
+			amazoom::WorkerAccessibleContainer* containers[] = { &hashmap, &columnar };
+
+			const std::pair<float, int> badArguments[] = { { 0.0f, 4 }, { -1.0f, 4 }, { std::nanf(""), 4 }, { 1.0f, 0 } };
+			for (amazoom::WorkerAccessibleContainer* container : containers) {
+				for (const std::pair<float, int>& arguments : badArguments) {
+					bool didExcept = false;
+					try {
+						container->weightHistogram(1, arguments.first, arguments.second);
+					}
+					catch (std::invalid_argument& e) {
+						didExcept = true;
+					}
+					Assert::IsTrue(didExcept);
+				}
+				Assert::AreEqual(static_cast<std::size_t>(1), container->weightHistogram(1, 1.0f, 1).size());
+			}
+		};
+	};
+
+
+	TEST_CLASS(Swiss_Map_Testing) {
+
+		TEST_METHOD(SwissMatchesUnorderedMap) {
+			const int NUM_OPS = 200000;
+			const int MAX_KEY = 20000;
+
+			std::mt19937 eng(12345);
+			auto keyRandomizer = std::uniform_int_distribution<int>(0, MAX_KEY);
+			auto opRandomizer = std::uniform_int_distribution<int>(0, 2);
+
+			amazoom::SwissMap<int, int> swiss;
+			std::unordered_map<int, int> reference;
+
+			//random mix of inserts, lookups and erases, checked against std::unordered_map
+			for (int i = 0; i < NUM_OPS; i++) {
+				const int key = keyRandomizer(eng);
+
+				switch (opRandomizer(eng)) {
+				case 0:
+					Assert::AreEqual(reference.insert(std::make_pair(key, i)).second,
+									 swiss.insert(std::make_pair(key, i)).second);
+					break;
+				case 1:
+					Assert::AreEqual(reference.count(key), swiss.count(key));
+					if (reference.count(key)) {
+						Assert::AreEqual(reference.at(key), swiss.find(key)->second);
+					}
+					break;
+				default:
+					Assert::AreEqual(reference.erase(key), swiss.erase(key));
+				}
+				Assert::AreEqual(reference.size(), swiss.size());
+			}
+
+			std::size_t iterated = 0;
+			for (const auto& keyValue : swiss) {
+				Assert::AreEqual(reference.at(keyValue.first), keyValue.second);
+				iterated++;
+			}
+			Assert::AreEqual(reference.size(), iterated);
+		};
+
+		TEST_METHOD(SwissIndexedMultiHashmap) {
+			const int NUM_KEYS = 3000;
+			const float WEIGHT = 4.0f;
+
+			amazoom::MultiHashmap<int, amazoom::Item, amazoom::SwissMap> container;
+
+			for (int i = 0; i < NUM_KEYS; i++) {
+				amazoom::Item newItem(i, WEIGHT);
+				amazoom::Item newItem2(i, WEIGHT * 2);
+				container.insertItem(newItem.getID(), newItem);
+				container.insertItem(newItem2.getID(), newItem2);
+			}
+			Assert::AreEqual(NUM_KEYS * 2, container.getNumItems());
+
+			for (int i = 0; i < NUM_KEYS; i++) {
+				Assert::IsTrue(container.doesContainObj(i));
+				amazoom::Item extractedItem(container.extractItem(i));
+				checkItemEquals(extractedItem, i, WEIGHT * 2);
+				amazoom::Item extractedItem2(container.extractItem(i));
+				checkItemEquals(extractedItem2, i, WEIGHT);
+				Assert::IsFalse(container.doesContainObj(i));
+			}
+			Assert::IsFalse(container.doesContainObj(NUM_KEYS));
+		};
+	};
+
+
+	TEST_CLASS(Box_Testing) {
+	public:
+		TEST_METHOD(OverweightCheck) {
+
+			
+			
+			const int MIN_ID = 0;
+			const int MAX_ID = 100;
+			const float MIN_MAX_WEIGHT = 2.65f;
+
+			const float BOX_MAX_WEIGHT = 200.0f;
+
+			//number of items to generate to completely fill the box plus an extra to
+			//check overweight
+			int NUM_ITEMS = (int)(std::floor(BOX_MAX_WEIGHT / MIN_MAX_WEIGHT)) + 1;
+
+			typedef std::vector<amazoom::ItemProperties> Properties;
+			typedef std::vector<amazoom::Item> Items;
+
+			//randomly generated items, and properties for future reference
+			std::pair<Properties, Items> gens(getRandomItems(NUM_ITEMS, MIN_ID, MAX_ID, MIN_MAX_WEIGHT, MIN_MAX_WEIGHT));
+
+			//pull out of pairs into single vectors
+			Properties properties(std::get<Properties>(gens));
+			Items items(std::move(std::get<Items>(gens)));
+			
+			//testing object 
+			amazoom::Box box(BOX_MAX_WEIGHT);
+			
+			//information about what props were inserted
+			Properties insertedProps;
+			
+			//number of insertions to do to reach, but not go over the box's weight limit
+			const float limit(std::floor(box.getMaxWeight() / MIN_MAX_WEIGHT));
+
+			for (int i = 0; i < limit; i++) {
+
+				Assert::IsTrue(box.canInsert(items.at(0)));
+
+				//insert item
+				box.insertItem(items.at(0));
+				items.pop_back();
+
+				//record which items were stored
+				insertedProps.push_back(properties.at(0));
+				properties.pop_back();
+			}
+			Assert::IsFalse(box.canInsert(items.at(0)));
+			
+			//should fail
+			bool didExcept = false;
+			try {
+				box.insertItem(items.at(0));
+			}
+			catch(amazoom::BoxOverweightException& e){
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+
+
+		}
+
+		TEST_METHOD(BatchOverweightCheck) {
+			const int id = 3;
+			const float BOX_MAX_WEIGHT = 10.0f;
+
+			amazoom::Box box(BOX_MAX_WEIGHT);
+
+			std::vector<amazoom::Item> tooHeavy;
+			for (int i = 0; i < 11; i++) {
+				tooHeavy.push_back(amazoom::Item(id, 1.0f));
+			}
+
+			//the batch as a whole does not fit, so nothing may be inserted
+			bool didExcept = false;
+			try {
+				box.insertItems(tooHeavy);
+			}
+			catch (amazoom::BoxOverweightException& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			Assert::AreEqual(0.0f, box.currentWeight());
+			Assert::IsFalse(box.doesContainItem(id));
+
+			tooHeavy.pop_back();
+			box.insertItems(tooHeavy);
+			Assert::AreEqual(BOX_MAX_WEIGHT, box.currentWeight());
+
+			std::vector<amazoom::Item> extracted(box.extractItems(id, 4));
+			Assert::AreEqual(static_cast<std::size_t>(4), extracted.size());
+			Assert::AreEqual(BOX_MAX_WEIGHT - 4.0f, box.currentWeight());
+		};
+
+		TEST_METHOD(TryExtractTracksWeight) {
+			const int id = 9;
+			amazoom::Box box(50.0f);
+
+			Assert::IsFalse(box.tryExtractItem(id).has_value());
+
+			amazoom::Item item(id, 12.5f);
+			box.insertItem(item);
+			Assert::AreEqual(12.5f, box.currentWeight());
+
+			std::optional<amazoom::Item> extracted(box.tryExtractItem(id));
+			Assert::IsTrue(extracted.has_value());
+			checkItemEquals(*extracted, id, 12.5f);
+			Assert::AreEqual(0.0f, box.currentWeight());
+			Assert::IsFalse(box.tryExtractItem(id).has_value());
+		};
+
+		TEST_METHOD(InsertBestFit) {
+			const int id = 6;
+			amazoom::Box box(10.0f);
+			amazoom::MultiHashmapImpl shelf;
+			shelf.enableWeightIndex();
+
+			const float weights[] = { 4.0f, 7.0f, 2.0f, 6.0f };
+			for (float weight : weights) {
+				amazoom::Item item(id, weight);
+				shelf.insertItem(id, item);
+			}
+
+			//10 free: 7 is the heaviest that fits, then 2 of the remaining 3
+			Assert::IsTrue(box.insertBestFit(shelf, id));
+			Assert::AreEqual(7.0f, box.currentWeight());
+			Assert::IsTrue(box.insertBestFit(shelf, id));
+			Assert::AreEqual(9.0f, box.currentWeight());
+
+			//1 free, nothing left on the shelf is that light
+			Assert::IsFalse(box.insertBestFit(shelf, id));
+			Assert::AreEqual(9.0f, box.currentWeight());
+			Assert::AreEqual(2, shelf.getNumItems());
+			Assert::IsTrue(box.doesContainItem(id));
+		};
+
+		TEST_METHOD(TryInsertNoDrift) {
+			const float BOX_MAX_WEIGHT = 100.0f;
+			const int id = 8;
+			amazoom::Box box(BOX_MAX_WEIGHT);
+
+			//0.1f is not exact in binary; summed as floats this would overshoot before the last item
+			const int NUM_ITEMS = static_cast<int>(BOX_MAX_WEIGHT * 10);
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				amazoom::Item item(id, 0.1f);
+				Assert::IsTrue(box.tryInsert(item));
+			}
+			Assert::AreEqual(BOX_MAX_WEIGHT, box.currentWeight());
+			Assert::AreEqual(0.0f, box.remainingCapacity());
+
+			amazoom::Item extra(id, 0.1f);
+			Assert::IsFalse(box.tryInsert(extra));
+
+			Assert::AreEqual(static_cast<std::size_t>(NUM_ITEMS), box.extractItems(id, NUM_ITEMS).size());
+			Assert::AreEqual(0.0f, box.currentWeight());
+			Assert::AreEqual(BOX_MAX_WEIGHT, box.remainingCapacity());
+		};
+
+		TEST_METHOD(TryInsertMultithreading) {
+			const float BOX_MAX_WEIGHT = 100.0f;
+			const int id = 3;
+			const int THREADS = 8;
+			const int ATTEMPTS_PER_THREAD = 50;
+			amazoom::Box box(BOX_MAX_WEIGHT);
+
+			//THREADS * ATTEMPTS_PER_THREAD attempts compete for room for only BOX_MAX_WEIGHT of them
+			std::atomic<int> numInserted{ 0 };
+			auto pack = [&box, &numInserted, ATTEMPTS_PER_THREAD, id]() {
+				for (int i = 0; i < ATTEMPTS_PER_THREAD; i++) {
+					amazoom::Item item(id, 1.0f);
+					if (box.tryInsert(item)) {
+						numInserted++;
+					}
+				}
+			};
+
+			std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread(pack)));
+			}
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.at(i)->join();
+			}
+
+			Assert::AreEqual(static_cast<int>(BOX_MAX_WEIGHT), numInserted.load());
+			Assert::AreEqual(BOX_MAX_WEIGHT, box.currentWeight());
+			Assert::AreEqual(static_cast<std::size_t>(BOX_MAX_WEIGHT), box.extractItems(id, THREADS * ATTEMPTS_PER_THREAD).size());
+		};
+
+		TEST_METHOD(ColumnarStorageKeepsAccounting) {
+			std::unique_ptr<amazoom::WorkerAccessibleContainer> storage(new amazoom::ColumnarMultiHashmapImpl());
+			amazoom::Box box(storage, 10.0f);
+
+			//a weight the columns would round is refused, so the box never reserves one weight and releases another
+			amazoom::Item rounded(1, 1.0005f);
+			bool didExcept = false;
+			try {
+				box.insertItem(rounded);
+			}
+			catch (std::out_of_range& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			checkItemEquals(rounded, 1, 1.0005f);
+			Assert::AreEqual(0.0f, box.currentWeight());
+
+			std::vector<amazoom::Item> batch;
+			batch.emplace_back(1, 2.0f);
+			batch.emplace_back(1, 1.0005f);
+			didExcept = false;
+			try {
+				box.insertItems(batch);
+			}
+			catch (std::out_of_range& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			Assert::AreEqual(0.0f, box.currentWeight());
+			Assert::AreEqual(0, box.countItems(1));
+			checkItemEquals(batch[0], 1, 2.0f);
+			checkItemEquals(batch[1], 1, 1.0005f);
+
+			//weights the columns hold exactly go in and come out without drift
+			const float exact = 1.0f + 1.0f / amazoom::PackedItem::WEIGHT_SCALE;
+			for (int i = 0; i < 5; i++) {
+				amazoom::Item item(1, exact);
+				box.insertItem(item);
+				Assert::AreEqual(exact, box.extractItem(1).getWeight());
+			}
+			Assert::AreEqual(0.0f, box.currentWeight());
+			Assert::AreEqual(10.0f, box.remainingCapacity());
+		};
+
+		TEST_METHOD(FailedBatchReturnsRefusedItems) {
+			//storage that keeps the first item of a batch and then runs out of memory
+			class FailingStorage : public amazoom::MultiHashmapImpl {
+			public:
+				void insertItems(std::vector<std::pair<int, amazoom::Item>>& objs) override {
+					std::vector<std::pair<int, amazoom::Item>> first;
+					first.push_back(std::move(objs.front()));
+					amazoom::MultiHashmapImpl::insertItems(first);
+					objs.front().second = std::move(first.front().second);
+					throw std::bad_alloc();
+				}
+			};
+
+			std::unique_ptr<amazoom::WorkerAccessibleContainer> storage(new FailingStorage());
+			amazoom::Box box(storage, 100.0f);
+
+			std::vector<amazoom::Item> batch;
+			batch.emplace_back(1, 2.0f);
+			batch.emplace_back(2, 3.0f);
+			batch.emplace_back(3, 4.0f);
+			bool didExcept = false;
+			try {
+				box.insertItems(batch);
+			}
+			catch (std::bad_alloc& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			//the stored item keeps its weight, the refused ones are the caller's again
+			Assert::AreEqual(1, box.countItems(1));
+			Assert::AreEqual(2.0f, box.currentWeight());
+			checkItemIsInvalid(batch[0]);
+			checkItemEquals(batch[1], 2, 3.0f);
+			checkItemEquals(batch[2], 3, 4.0f);
+		};
+
+		TEST_METHOD(DefaultBatchReportsPartialInsert) {
+			//a container with the default insertItems that refuses anything over 5 kg
+			class Shelf : public amazoom::ItemContainer {
+			public:
+				amazoom::Item extractItem(int key) override { return storage_->extractItem(key); }
+				void insertItem(amazoom::Item& item) override {
+					if (item.getWeight() > 5.0f) {
+						throw amazoom::BoxOverweightException("Item too heavy for the shelf.");
+					}
+					storage_->insertItem(item.getID(), item);
+				}
+			};
+
+			Shelf shelf;
+			std::vector<amazoom::Item> batch;
+			batch.emplace_back(1, 2.0f);
+			batch.emplace_back(2, 9.0f);
+			batch.emplace_back(3, 4.0f);
+			bool didExcept = false;
+			try {
+				shelf.insertItems(batch);
+			}
+			catch (amazoom::BoxOverweightException& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			//the items before the refused one went in, and the batch tells which
+			Assert::AreEqual(1, shelf.countItems(1));
+			Assert::AreEqual(0, shelf.countItems(3));
+			checkItemIsInvalid(batch[0]);
+			checkItemEquals(batch[1], 2, 9.0f);
+			checkItemEquals(batch[2], 3, 4.0f);
+		};
+	};
+
+
+	TEST_CLASS(Box_Packer_Testing) {
+
+		//every item id must end up in exactly one box, and no box may be overfilled
+		void checkPacking(amazoom::BoxPacker::Boxes& boxes, int numItems, float capacity) {
+			for (const amazoom::BoxPacker::BoxPtr& box : boxes) {
+				Assert::IsTrue(box->currentWeight() <= capacity);
+			}
+			for (int id = 0; id < numItems; id++) {
+				int numHolding = 0;
+				for (amazoom::BoxPacker::BoxPtr& box : boxes) {
+					numHolding += box->doesContainItem(id) ? 1 : 0;
+				}
+				Assert::AreEqual(1, numHolding);
+			}
+		}
+
+		TEST_METHOD(PacksTightly) {
+			const float BOX_CAPACITY = 10.0f;
+			const float weights[] = { 3.0f, 5.0f, 2.0f, 6.0f, 5.0f, 4.0f, 1.5f, 3.5f };
+
+			const amazoom::BoxPacker::Strategy strategies[] = {
+				amazoom::BoxPacker::FIRST_FIT_DECREASING, amazoom::BoxPacker::BEST_FIT_DECREASING };
+
+			for (amazoom::BoxPacker::Strategy strategy : strategies) {
+				std::vector<amazoom::Item> items;
+				for (int id = 0; id < 8; id++) {
+					items.push_back(amazoom::Item(id, weights[id]));
+				}
+
+				//30 in total, and 6+4, 5+5, 3.5+3+2+1.5 fills three boxes exactly
+				amazoom::BoxPacker packer(BOX_CAPACITY, strategy);
+				amazoom::BoxPacker::Boxes boxes(packer.pack(items));
+				Assert::AreEqual(static_cast<std::size_t>(3), boxes.size());
+				checkPacking(boxes, 8, BOX_CAPACITY);
+			}
+		};
+
+		TEST_METHOD(OverweightItemRejected) {
+			amazoom::BoxPacker packer(10.0f);
+			std::vector<amazoom::Item> items;
+			items.push_back(amazoom::Item(0, 4.0f));
+			items.push_back(amazoom::Item(1, 10.5f));
+
+			bool didExcept = false;
+			try {
+				packer.pack(items);
+			}
+			catch (amazoom::BoxOverweightException& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			Assert::AreEqual(0, items[0].getID()); //nothing was moved out
+		};
+
+		TEST_METHOD(ParallelOrdersMatchSerial) {
+			const int NUM_ORDERS = 64;
+			const int ITEMS_PER_ORDER = 100;
+			const float BOX_CAPACITY = 25.0f;
+
+			std::mt19937 eng(7);
+			std::uniform_real_distribution<float> weightDist(0.5f, 12.0f);
+
+			std::vector<std::vector<amazoom::Item>> orders(NUM_ORDERS);
+			std::vector<std::vector<amazoom::Item>> sameOrders(NUM_ORDERS);
+			for (int order = 0; order < NUM_ORDERS; order++) {
+				for (int id = 0; id < ITEMS_PER_ORDER; id++) {
+					const float weight = weightDist(eng);
+					orders[order].push_back(amazoom::Item(id, weight));
+					sameOrders[order].push_back(amazoom::Item(id, weight));
+				}
+			}
+
+			amazoom::BoxPacker packer(BOX_CAPACITY, amazoom::BoxPacker::FIRST_FIT_DECREASING);
+			std::vector<amazoom::BoxPacker::Boxes> packed(packer.packOrders(orders, 4));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_ORDERS), packed.size());
+
+			for (int order = 0; order < NUM_ORDERS; order++) {
+				amazoom::BoxPacker::Boxes serial(packer.pack(sameOrders[order]));
+				Assert::AreEqual(serial.size(), packed[order].size());
+				for (std::size_t box = 0; box < serial.size(); box++) {
+					Assert::AreEqual(serial[box]->currentWeight(), packed[order][box]->currentWeight());
+				}
+				checkPacking(packed[order], ITEMS_PER_ORDER, BOX_CAPACITY);
+			}
+		};
+	};
+
+
+	TEST_CLASS(Order_Transaction_Testing) {
+
+		TEST_METHOD(AllOrNothing) {
+			amazoom::Box shelfA(1000.0f);
+			amazoom::Box shelfB(1000.0f);
+			for (int i = 0; i < 3; i++) {
+				amazoom::Item itemA(1, 2.0f);
+				amazoom::Item itemB(2, 5.0f);
+				shelfA.insertItem(itemA);
+				shelfB.insertItem(itemB);
+			}
+
+			//the second line asks for more than is stocked, so the first must not be taken either
+			amazoom::OrderTransaction tooMuch;
+			tooMuch.addLine(shelfA, 1, 2);
+			tooMuch.addLine(shelfB, 2, 4);
+			Assert::IsFalse(tooMuch.tryExecute().has_value());
+
+			bool didExcept = false;
+			try {
+				tooMuch.execute();
+			}
+			catch (amazoom::OrderUnavailableException& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			Assert::AreEqual(3, shelfA.countItems(1));
+			Assert::AreEqual(3, shelfB.countItems(2));
+			Assert::AreEqual(6.0f, shelfA.currentWeight());
+
+			//lines drawing on the same key add up
+			amazoom::OrderTransaction sameKeyTwice;
+			sameKeyTwice.addLine(shelfA, 1, 2);
+			sameKeyTwice.addLine(shelfA, 1, 2);
+			Assert::IsFalse(sameKeyTwice.tryExecute().has_value());
+
+			amazoom::OrderTransaction order;
+			order.addLine(shelfB, 2);
+			order.addLine(shelfA, 1, 2);
+			std::vector<amazoom::Item> picked(order.execute());
+			Assert::AreEqual(static_cast<std::size_t>(3), picked.size());
+			checkItemEquals(picked[0], 2, 5.0f);
+			checkItemEquals(picked[1], 1, 2.0f);
+			checkItemEquals(picked[2], 1, 2.0f);
+
+			Assert::AreEqual(1, shelfA.countItems(1));
+			Assert::AreEqual(2, shelfB.countItems(2));
+			Assert::AreEqual(2.0f, shelfA.currentWeight());
+			Assert::AreEqual(10.0f, shelfB.currentWeight());
+		};
+
+		TEST_METHOD(ConcurrentCrossingOrders) {
+			const int THREADS = 8;
+			const int ORDERS_PER_THREAD = 200;
+			const int STOCK = 500;
+			amazoom::Box shelfA(10000.0f);
+			amazoom::Box shelfB(10000.0f);
+			for (int i = 0; i < STOCK; i++) {
+				amazoom::Item itemA(1, 1.0f);
+				amazoom::Item itemB(2, 1.0f);
+				shelfA.insertItem(itemA);
+				shelfB.insertItem(itemB);
+			}
+
+			//half the threads add lines A then B, the other half B then A; the lock order must not care
+			std::atomic<int> numFilled{ 0 };
+			auto fulfil = [&](int thread) {
+				for (int i = 0; i < ORDERS_PER_THREAD; i++) {
+					amazoom::OrderTransaction order;
+					if (thread % 2 == 0) {
+						order.addLine(shelfA, 1);
+						order.addLine(shelfB, 2, 2);
+					}
+					else {
+						order.addLine(shelfB, 2, 2);
+						order.addLine(shelfA, 1);
+					}
+
+					std::optional<std::vector<amazoom::Item>> picked(order.tryExecute());
+					if (picked) {
+						Assert::AreEqual(static_cast<std::size_t>(3), picked->size());
+						numFilled++;
+					}
+					//plain extractions compete with the transactions
+					shelfA.tryExtractItem(1);
+				}
+			};
+
+			std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread(fulfil, i)));
+			}
+			for (int i = 0; i < THREADS; i++) {
+				threadPtrs.at(i)->join();
+			}
+
+			//B is only drawn by orders, two per filled order, so it tells exactly how many were filled
+			Assert::AreEqual(STOCK - 2 * numFilled.load(), shelfB.countItems(2));
+			Assert::AreEqual(static_cast<float>(shelfB.countItems(2)), shelfB.currentWeight());
+			Assert::AreEqual(static_cast<float>(shelfA.countItems(1)), shelfA.currentWeight());
+			Assert::IsTrue(numFilled.load() > 0);
+		};
+
+		TEST_METHOD(ReservedStockIsNotOrderable) {
+			amazoom::MultiHashmapImpl* shelfStorage = new amazoom::MultiHashmapImpl();
+			std::unique_ptr<amazoom::WorkerAccessibleContainer> storage(shelfStorage);
+			amazoom::Box shelf(storage, 1000.0f);
+			for (int i = 0; i < 3; i++) {
+				amazoom::Item item(7, 1.0f);
+				shelf.insertItem(item);
+			}
+
+			//two of the three units are held for another order, so only one can be picked
+			std::optional<amazoom::MultiHashmapImpl::Reservation> hold = shelfStorage->reserve(7, 2, std::chrono::minutes(1));
+			Assert::IsTrue(hold.has_value());
+			Assert::AreEqual(1, shelf.countItems(7));
+
+			amazoom::OrderTransaction tooMuch;
+			tooMuch.addLine(shelf, 7, 3);
+			bool didExcept = false;
+			try {
+				tooMuch.execute();
+			}
+			catch (amazoom::OrderUnavailableException& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			Assert::AreEqual(3, shelfStorage->getNumItems());
+			Assert::AreEqual(3.0f, shelf.currentWeight());
+
+			amazoom::OrderTransaction order;
+			order.addLine(shelf, 7, 1);
+			Assert::AreEqual(static_cast<std::size_t>(1), order.execute().size());
+
+			//once released, the held units are orderable again
+			Assert::IsTrue(shelfStorage->releaseReservation(*hold));
+			amazoom::OrderTransaction rest;
+			rest.addLine(shelf, 7, 2);
+			Assert::AreEqual(static_cast<std::size_t>(2), rest.execute().size());
+			Assert::AreEqual(0.0f, shelf.currentWeight());
+		};
+
+		TEST_METHOD(ShortLineIsPutBack) {
+			//a box whose stock count promises one unit more than extraction finds, as a split key's count may
+			class OvercountingBox : public amazoom::Box {
+			public:
+				OvercountingBox() : amazoom::Box(1000.0f) {}
+
+			protected:
+				std::vector<amazoom::Item> extractItemsLocked(int key, int count) override {
+					return amazoom::Box::extractItemsLocked(key, count - 1);
+				}
+			};
+
+			amazoom::Box shelfA(1000.0f);
+			OvercountingBox shelfB;
+			for (int i = 0; i < 3; i++) {
+				amazoom::Item itemA(1, 2.0f);
+				amazoom::Item itemB(2, 5.0f);
+				shelfA.insertItem(itemA);
+				shelfB.insertItem(itemB);
+			}
+
+			amazoom::OrderTransaction order;
+			order.addLine(shelfA, 1, 2);
+			order.addLine(shelfB, 2, 2);
+			Assert::IsFalse(order.tryExecute().has_value());
+
+			bool didExcept = false;
+			try {
+				order.execute();
+			}
+			catch (amazoom::OrderUnavailableException& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			//both lines were put back, with their weight
+			Assert::AreEqual(3, shelfA.countItems(1));
+			Assert::AreEqual(3, shelfB.countItems(2));
+			Assert::AreEqual(6.0f, shelfA.currentWeight());
+			Assert::AreEqual(15.0f, shelfB.currentWeight());
+		};
+	};
+
+
+	TEST_CLASS(Warehouse_Testing) {
+
+		TEST_METHOD(IndexTracksInsertAndExtract) {
+			amazoom::Warehouse warehouse;
+			std::vector<int> shelves;
+			for (int i = 0; i < 3; i++) {
+				std::unique_ptr<amazoom::ItemContainer> box(new amazoom::Box(10.0f));
+				shelves.push_back(warehouse.addContainer(box));
+			}
+			Assert::AreEqual(3, warehouse.getNumContainers());
+			Assert::IsFalse(warehouse.doesContainItem(5));
+
+			amazoom::Item first(5, 2.0f);
+			amazoom::Item second(5, 2.0f);
+			amazoom::Item other(6, 1.0f);
+			warehouse.insertItem(shelves[0], first);
+			warehouse.insertItem(shelves[2], second);
+			warehouse.insertItem(shelves[2], other);
+
+			std::vector<amazoom::Warehouse::ItemLocation> locations(warehouse.locateItem(5));
+			Assert::AreEqual(static_cast<std::size_t>(2), locations.size());
+			for (const amazoom::Warehouse::ItemLocation& location : locations) {
+				Assert::IsTrue(location.containerID == shelves[0] || location.containerID == shelves[2]);
+				Assert::AreEqual(1, location.count);
+			}
+			Assert::AreEqual(2, warehouse.countItems(5));
+			Assert::AreEqual(1, warehouse.countItems(6));
+			const amazoom::ItemContainer& shelf = warehouse.getContainer(shelves[2]);
+			Assert::AreEqual(1, shelf.countItems(5));
+			Assert::AreEqual(3.0, shelf.totalWeight(5) + shelf.totalWeight(6));
+
+			//a rejected insertion must not be counted
+			amazoom::Item tooHeavy(5, 20.0f);
+			bool didExcept = false;
+			try {
+				warehouse.insertItem(shelves[1], tooHeavy);
+			}
+			catch (amazoom::BoxOverweightException& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			Assert::AreEqual(2, warehouse.countItems(5));
+
+			amazoom::Item extractedItem(warehouse.extractItem(shelves[0], 5));
+			checkItemEquals(extractedItem, 5, 2.0f);
+			Assert::AreEqual(1, warehouse.countItems(5));
+			Assert::AreEqual(shelves[2], warehouse.locateItem(5).at(0).containerID);
+
+			Assert::IsTrue(warehouse.tryExtractItem(5).has_value());
+			Assert::IsFalse(warehouse.tryExtractItem(5).has_value());
+			Assert::IsFalse(warehouse.doesContainItem(5));
+			Assert::IsTrue(warehouse.doesContainItem(6));
+		};
+
+		TEST_METHOD(BatchesAcrossContainers) {
+			const int NUM_SHELVES = 10;
+			const int PER_SHELF = 20;
+			amazoom::Warehouse warehouse;
+
+			for (int i = 0; i < NUM_SHELVES; i++) {
+				std::unique_ptr<amazoom::ItemContainer> box(new amazoom::Box(1000.0f));
+				const int shelf = warehouse.addContainer(box);
+
+				std::vector<amazoom::Item> pallet;
+				for (int j = 0; j < PER_SHELF; j++) {
+					pallet.push_back(amazoom::Item(j % 2, 1.0f));
+				}
+				warehouse.insertItems(shelf, pallet);
+			}
+			Assert::AreEqual(NUM_SHELVES * PER_SHELF / 2, warehouse.countItems(0));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_SHELVES), warehouse.locateItem(1).size());
+
+			//more than any one shelf holds
+			std::vector<amazoom::Item> picked(warehouse.extractItems(1, PER_SHELF * 2));
+			Assert::AreEqual(static_cast<std::size_t>(PER_SHELF * 2), picked.size());
+			Assert::AreEqual(NUM_SHELVES * PER_SHELF / 2 - PER_SHELF * 2, warehouse.countItems(1));
+
+			std::vector<amazoom::Item> rest(warehouse.extractItems(1, NUM_SHELVES * PER_SHELF));
+			Assert::AreEqual(static_cast<std::size_t>(NUM_SHELVES * PER_SHELF / 2 - PER_SHELF * 2), rest.size());
+			Assert::IsFalse(warehouse.doesContainItem(1));
+			Assert::AreEqual(NUM_SHELVES * PER_SHELF / 2, warehouse.countItems(0));
+		};
+
+		TEST_METHOD(PartialBatchStaysIndexed) {
+			//storage that keeps the first item of a batch and then runs out of memory
+			class FailingStorage : public amazoom::MultiHashmapImpl {
+			public:
+				void insertItems(std::vector<std::pair<int, amazoom::Item>>& objs) override {
+					std::vector<std::pair<int, amazoom::Item>> first;
+					first.push_back(std::move(objs.front()));
+					amazoom::MultiHashmapImpl::insertItems(first);
+					objs.front().second = std::move(first.front().second);
+					throw std::bad_alloc();
+				}
+			};
+
+			amazoom::Warehouse warehouse;
+			std::unique_ptr<amazoom::WorkerAccessibleContainer> storage(new FailingStorage());
+			std::unique_ptr<amazoom::ItemContainer> box(new amazoom::Box(storage, 100.0f));
+			const int shelf = warehouse.addContainer(box);
+
+			std::vector<amazoom::Item> pallet;
+			pallet.emplace_back(5, 1.0f);
+			pallet.emplace_back(5, 1.0f);
+			pallet.emplace_back(6, 1.0f);
+			bool didExcept = false;
+			try {
+				warehouse.insertItems(shelf, pallet);
+			}
+			catch (std::bad_alloc& e) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			//the unit that was stored can still be found and picked
+			Assert::AreEqual(1, warehouse.countItems(5));
+			Assert::AreEqual(0, warehouse.countItems(6));
+			Assert::AreEqual(static_cast<std::size_t>(1), warehouse.locateItem(5).size());
+			Assert::IsTrue(warehouse.tryExtractItem(5).has_value());
+			Assert::AreEqual(0, warehouse.countItems(5));
+		};
+	};
+
+
+	TEST_CLASS(Task_Scheduler_Testing) {
+
+		TEST_METHOD(InsertExtractTasks) {
+			const int NUM_ITEMS = 10000;
+			const int NUM_KEYS = 50;
+			amazoom::TaskScheduler scheduler(4);
+			amazoom::MultiHashmapImpl shelfA;
+			amazoom::ShardedMultiHashmapImpl shelfB;
+
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				amazoom::Item item(i % NUM_KEYS, 1.0f);
+				scheduler.submitInsert(i % 2 == 0 ? static_cast<amazoom::WorkerAccessibleContainer&>(shelfA) : shelfB, item);
+			}
+			scheduler.waitIdle();
+			Assert::AreEqual(NUM_ITEMS, shelfA.getNumItems() + shelfB.getNumItems());
+
+			std::atomic<int> numExtracted{ 0 };
+			for (int i = 0; i < NUM_ITEMS; i++) {
+				scheduler.submitExtract(i % 2 == 0 ? static_cast<amazoom::WorkerAccessibleContainer&>(shelfA) : shelfB, i % NUM_KEYS,
+					[&numExtracted](std::optional<amazoom::Item> item) { numExtracted += item ? 1 : 0; });
+			}
+			scheduler.waitIdle();
+			Assert::AreEqual(NUM_ITEMS, numExtracted.load());
+			Assert::AreEqual(0, shelfA.getNumItems() + shelfB.getNumItems());
+
+			amazoom::TaskScheduler::Stats stats(scheduler.getStats());
+			Assert::AreEqual(static_cast<std::uint64_t>(2 * NUM_ITEMS), stats.tasksSubmitted);
+			Assert::AreEqual(stats.tasksSubmitted, stats.tasksExecuted);
+			Assert::AreEqual(static_cast<std::uint64_t>(0), stats.tasksFailed);
+			Assert::AreEqual(static_cast<std::size_t>(4), stats.tasksPerWorker.size());
+		};
+
+		TEST_METHOD(PackTasks) {
+			const int NUM_ORDERS = 200;
+			amazoom::TaskScheduler scheduler(4);
+			amazoom::BoxPacker packer(10.0f);
+
+			std::atomic<int> numBoxes{ 0 };
+			std::atomic<int> numPacked{ 0 };
+			for (int i = 0; i < NUM_ORDERS; i++) {
+				std::vector<amazoom::Item> order;
+				for (int j = 0; j < 4; j++) {
+					order.emplace_back(i, 4.0f);
+				}
+				scheduler.submitPack(packer, order, [&numBoxes, &numPacked, i](amazoom::BoxPacker::Boxes boxes) {
+					numBoxes += static_cast<int>(boxes.size());
+					for (const amazoom::BoxPacker::BoxPtr& box : boxes) {
+						numPacked += box->countItems(i);
+					}
+				});
+				Assert::IsTrue(order.empty());
+			}
+			scheduler.waitIdle();
+			Assert::AreEqual(2 * NUM_ORDERS, numBoxes.load());
+			Assert::AreEqual(4 * NUM_ORDERS, numPacked.load());
+
+			//an order that cannot be packed fails its task, and onDone is not called
+			std::vector<amazoom::Item> tooHeavy;
+			tooHeavy.emplace_back(1, 20.0f);
+			scheduler.submitPack(packer, tooHeavy, [&numBoxes](amazoom::BoxPacker::Boxes boxes) { numBoxes++; });
+			scheduler.waitIdle();
+			Assert::AreEqual(2 * NUM_ORDERS, numBoxes.load());
+			Assert::AreEqual(static_cast<std::uint64_t>(1), scheduler.getStats().tasksFailed);
+		};
+
+		TEST_METHOD(IdleWorkersSteal) {
+			const int NUM_TASKS = 64;
+			amazoom::TaskScheduler scheduler(4);
+			amazoom::MultiHashmapImpl shelf;
+
+			//every task has the same affinity, so only stealing can spread them out
+			for (int i = 0; i < NUM_TASKS; i++) {
+				scheduler.submit([]() { boost::this_thread::sleep_for(boost::chrono::milliseconds(1)); }, &shelf);
+			}
+			scheduler.waitIdle();
+
+			amazoom::TaskScheduler::Stats stats(scheduler.getStats());
+			Assert::AreEqual(static_cast<std::uint64_t>(NUM_TASKS), stats.tasksExecuted);
+			Assert::IsTrue(stats.tasksStolen > 0);
+
+			int busyWorkers = 0;
+			for (std::uint64_t executed : stats.tasksPerWorker) {
+				busyWorkers += executed > 0 ? 1 : 0;
+			}
+			Assert::IsTrue(busyWorkers > 1);
+			Assert::IsTrue(stats.maxQueueLatencyUs >= stats.meanQueueLatencyUs);
+		};
+
+		TEST_METHOD(DrainsOnDestruction) {
+			const int NUM_PARENTS = 100;
+			const int CHILDREN_PER_PARENT = 10;
+			std::atomic<int> numRun{ 0 };
+
+			{
+				amazoom::TaskScheduler scheduler(3);
+				for (int i = 0; i < NUM_PARENTS; i++) {
+					//tasks may queue more tasks, including while the scheduler is shutting down
+					scheduler.submit([&scheduler, &numRun, CHILDREN_PER_PARENT]() {
+						for (int j = 0; j < CHILDREN_PER_PARENT; j++) {
+							scheduler.submit([&numRun]() { numRun++; });
+						}
+						numRun++;
+					});
+				}
+				scheduler.submit([]() { throw std::runtime_error("failed task"); });
+			}
+			Assert::AreEqual(NUM_PARENTS * (CHILDREN_PER_PARENT + 1), numRun.load());
+		};
+	};
+
+
+	TEST_CLASS(Container_Metrics_Testing) {
+	public:
+		TEST_METHOD(SnapshotFormats) {
+			amazoom::MetricsSnapshot snapshot;
+			snapshot.name = "shelf \"A1\"";
+
+			//durations of 0, 5 and 100 ns land in buckets 0, 3 and 7
+			amazoom::HistogramSnapshot& inserts = snapshot.ops[static_cast<int>(amazoom::MetricsOp::INSERT)].latency;
+			inserts.buckets[0] = 1;
+			inserts.buckets[3] = 1;
+			inserts.buckets[7] = 1;
+			inserts.count = 3;
+			inserts.totalNs = 105;
+			snapshot.ops[static_cast<int>(amazoom::MetricsOp::INSERT)].misses = 1;
+
+			Assert::AreEqual(static_cast<std::uint64_t>(8), inserts.percentileNs(0.5));
+			Assert::AreEqual(static_cast<std::uint64_t>(128), inserts.percentileNs(0.99));
+			Assert::AreEqual(static_cast<std::uint64_t>(0), snapshot.lockWait.percentileNs(0.5));
+
+			std::vector<amazoom::MetricsSnapshot> snapshots;
+			snapshots.push_back(snapshot);
+
+			std::string json(amazoom::MetricsRegistry::toJson(snapshots));
+			Assert::IsTrue(json.find("\"name\":\"shelf \\\"A1\\\"\"") != std::string::npos);
+			Assert::IsTrue(json.find("\"insert\":{\"calls\":3,\"misses\":1,") != std::string::npos);
+			Assert::IsTrue(json.find("\"buckets\":[[1,1],[2,0],[4,0],[8,1],[16,0],[32,0],[64,0],[128,1]]") != std::string::npos);
+
+			std::string prometheus(amazoom::MetricsRegistry::toPrometheus(snapshots));
+			Assert::IsTrue(prometheus.find("amazoom_container_ops_total{container=\"shelf \\\"A1\\\"\",op=\"insert\"} 3\n") != std::string::npos);
+			Assert::IsTrue(prometheus.find("amazoom_container_misses_total{container=\"shelf \\\"A1\\\"\",op=\"insert\"} 1\n") != std::string::npos);
+			Assert::IsTrue(prometheus.find("op=\"insert\",le=\"1.28e-07\"} 3\n") != std::string::npos);
+			Assert::IsTrue(prometheus.find("op=\"insert\",le=\"+Inf\"} 3\n") != std::string::npos);
+		};
+
+		TEST_METHOD(RecordsBoxOperations) {
+			const float BOX_MAX_WEIGHT = 10.0f;
+			amazoom::Box box(BOX_MAX_WEIGHT);
+			box.getMetrics().setName("test box");
+
+			for (int i = 0; i < 5; i++) {
+				amazoom::Item item(i, 2.0f);
+				Assert::IsTrue(box.tryInsert(item));
+			}
+			amazoom::Item tooHeavy(5, 2.0f);
+			Assert::IsFalse(box.tryInsert(tooHeavy));
+
+			Assert::IsTrue(box.tryExtractItem(0).has_value());
+			Assert::IsFalse(box.tryExtractItem(0).has_value());
+			bool didExcept = false;
+			try {
+				box.extractItem(0);
+			}
+			catch (amazoom::MultiHashMapNoSuchObj&) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			std::vector<amazoom::MetricsSnapshot> snapshots(amazoom::MetricsRegistry::snapshot());
+#ifdef AMAZOOM_METRICS
+			auto found = std::find_if(snapshots.begin(), snapshots.end(),
+				[](const amazoom::MetricsSnapshot& snapshot) { return snapshot.name == "test box"; });
+			Assert::IsTrue(found != snapshots.end());
+
+			const amazoom::OpSnapshot& inserts = found->ops[static_cast<int>(amazoom::MetricsOp::INSERT)];
+			const amazoom::OpSnapshot& extracts = found->ops[static_cast<int>(amazoom::MetricsOp::EXTRACT)];
+			Assert::AreEqual(static_cast<std::uint64_t>(6), inserts.latency.count);
+			Assert::AreEqual(static_cast<std::uint64_t>(1), inserts.misses);
+			Assert::AreEqual(static_cast<std::uint64_t>(3), extracts.latency.count);
+			Assert::AreEqual(static_cast<std::uint64_t>(2), extracts.misses);
+
+			//every extraction holds the box's extraction lock once
+			Assert::AreEqual(static_cast<std::uint64_t>(3), found->lockWait.count);
+			Assert::AreEqual(static_cast<std::uint64_t>(3), found->lockHold.count);
+#else
+			//compiled out: nothing is registered or recorded
+			Assert::IsTrue(snapshots.empty());
+#endif
+		};
+	};
+
+
+	TEST_CLASS(Inventory_Snapshot_Testing) {
+	public:
+		TEST_METHOD(RoundTrip) {
+			const std::string path((std::filesystem::temp_directory_path() / "amazoom_round_trip.snap").string());
+			const int NUM_KEYS = 50;
+
+			amazoom::MultiHashmapImpl original;
+			for (int key = 0; key < NUM_KEYS; key++) {
+				for (int i = 0; i <= key; i++) {
+					amazoom::Item item(key, static_cast<float>(i), i % 2 == 0);
+					original.insertItem(key, item);
+				}
+			}
+			amazoom::InventorySnapshot::write(original, path);
+
+			amazoom::InventorySnapshot snapshot(path);
+			Assert::AreEqual(static_cast<std::size_t>(original.getNumItems()), snapshot.getNumItems());
+			Assert::AreEqual(static_cast<std::size_t>(NUM_KEYS), snapshot.getNumKeys());
+
+			//a different backend restores the same items
+			amazoom::FlatMultiHashmapImpl restored;
+			snapshot.loadInto(restored);
+			Assert::AreEqual(original.getNumItems(), restored.getNumItems());
+			for (int key = 0; key < NUM_KEYS; key++) {
+				Assert::AreEqual(key + 1, restored.countItems(key));
+				std::optional<amazoom::Item> heaviest(restored.extractHeaviest(key));
+				checkItemEquals(*heaviest, key, static_cast<float>(key));
+				Assert::AreEqual(key % 2 == 0, heaviest->isLarge());
+			}
+
+			//a box restores its weight along with its items, or refuses the whole snapshot
+			const float BOX_MAX_WEIGHT = 100.0f;
+			amazoom::Box box(BOX_MAX_WEIGHT);
+			for (int i = 0; i < 4; i++) {
+				amazoom::Item item(i, 10.0f);
+				box.insertItem(item);
+			}
+			amazoom::InventorySnapshot::write(box, path);
+
+			amazoom::Box restoredBox(BOX_MAX_WEIGHT);
+			amazoom::InventorySnapshot(path).loadInto(restoredBox);
+			Assert::AreEqual(40.0f, restoredBox.currentWeight());
+			Assert::IsTrue(restoredBox.doesContainItem(3));
+
+			amazoom::Box smallBox(30.0f);
+			bool didExcept = false;
+			try {
+				amazoom::InventorySnapshot(path).loadInto(smallBox);
+			}
+			catch (amazoom::BoxOverweightException&) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			Assert::AreEqual(0.0f, smallBox.currentWeight());
+
+			std::filesystem::remove(path);
+		};
+
+		TEST_METHOD(RejectsDamagedFiles) {
+			const std::string path((std::filesystem::temp_directory_path() / "amazoom_damaged.snap").string());
+
+			amazoom::MultiHashmapImpl original;
+			for (int i = 0; i < 100; i++) {
+				amazoom::Item item(i % 10, 1.0f);
+				original.insertItem(i % 10, item);
+			}
+			amazoom::InventorySnapshot::write(original, path);
+
+			std::vector<char> bytes;
+			{
+				std::ifstream in(path, std::ios::binary);
+				bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			}
+
+			auto isRejected = [&path](const std::vector<char>& contents) {
+				{
+					std::ofstream out(path, std::ios::binary | std::ios::trunc);
+					out.write(contents.data(), contents.size());
+				}
+				try {
+					amazoom::InventorySnapshot snapshot(path);
+				}
+				catch (amazoom::InventorySnapshotException&) {
+					return true;
+				}
+				return false;
+			};
+
+			std::vector<char> flipped(bytes);
+			flipped[flipped.size() / 2] ^= 0x10;
+			Assert::IsTrue(isRejected(flipped));
+
+			std::vector<char> truncated(bytes.begin(), bytes.end() - 12);
+			Assert::IsTrue(isRejected(truncated));
+
+			std::vector<char> notASnapshot(bytes);
+			notASnapshot[0] = 'X';
+			Assert::IsTrue(isRejected(notASnapshot));
+
+			Assert::IsFalse(isRejected(bytes));
+
+			std::filesystem::remove(path);
+			bool didExcept = false;
+			try {
+				amazoom::InventorySnapshot missing(path);
+			}
+			catch (amazoom::InventorySnapshotException&) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+		};
+
+		TEST_METHOD(FailedWriteKeepsOldSnapshot) {
+			const std::string path((std::filesystem::temp_directory_path() / "amazoom_failed_write.snap").string());
+
+			amazoom::MultiHashmapImpl original;
+			amazoom::Item item(1, 1.0f);
+			original.insertItem(1, item);
+			amazoom::InventorySnapshot::write(original, path);
+
+			//a directory in the way of the temporary file makes the next write fail before it touches path
+			std::filesystem::create_directory(path + ".tmp");
+			amazoom::Item second(2, 1.0f);
+			original.insertItem(2, second);
+			bool didExcept = false;
+			try {
+				amazoom::InventorySnapshot::write(original, path);
+			}
+			catch (amazoom::InventorySnapshotException&) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+			Assert::AreEqual(static_cast<std::size_t>(1), amazoom::InventorySnapshot(path).getNumItems());
+
+			std::filesystem::remove(path + ".tmp");
+			amazoom::InventorySnapshot::write(original, path);
+			Assert::AreEqual(static_cast<std::size_t>(2), amazoom::InventorySnapshot(path).getNumItems());
+			Assert::IsFalse(std::filesystem::exists(path + ".tmp"));
+			std::filesystem::remove(path);
+		};
+	};
+
+	TEST_CLASS(Write_Ahead_Log_Testing) {
+	public:
+		TEST_METHOD(RecoversFromSnapshotAndLog) {
+			const std::string snapPath((std::filesystem::temp_directory_path() / "amazoom_recovery.snap").string());
+			const std::string logPath((std::filesystem::temp_directory_path() / "amazoom_recovery.wal").string());
+			std::filesystem::remove(logPath);
+
+			for (amazoom::WriteAheadLog::Durability durability : { amazoom::WriteAheadLog::ASYNC, amazoom::WriteAheadLog::WRITE, amazoom::WriteAheadLog::SYNC }) {
+				{
+					amazoom::WriteAheadLog log(logPath, durability);
+					std::unique_ptr<amazoom::WorkerAccessibleContainer> storage(new amazoom::MultiHashmapImpl());
+					std::unique_ptr<amazoom::WorkerAccessibleContainer> logged(new amazoom::LoggedContainerImpl(storage, log));
+					amazoom::Box box(logged, 1000.0f);
+
+					for (int i = 0; i < 20; i++) {
+						amazoom::Item item(i % 5, 1.0f + i);
+						box.insertItem(item);
+					}
+
+					//checkpoint: what happened so far is in the snapshot, so the log starts over
+					amazoom::InventorySnapshot::write(box, snapPath);
+					log.truncate();
+
+					box.extractItem(0);
+					std::vector<amazoom::Item> batch;
+					for (int i = 0; i < 3; i++) {
+						batch.push_back(amazoom::Item(7, 2.0f, true));
+					}
+					box.insertItems(batch);
+					box.extractItems(1, 2);
+					box.tryExtractItem(7);
+				}
+
+				amazoom::FlatMultiHashmapImpl restored;
+				amazoom::InventorySnapshot(snapPath).loadInto(restored);
+				amazoom::WriteAheadLog::ReplayResult result = amazoom::WriteAheadLog::replay(logPath, restored);
+
+				Assert::AreEqual(static_cast<std::size_t>(3), result.inserts);
+				Assert::AreEqual(static_cast<std::size_t>(4), result.extracts);
+				Assert::AreEqual(static_cast<std::size_t>(0), result.missingExtracts);
+				Assert::IsFalse(result.tornTail);
+
+				Assert::AreEqual(19, restored.getNumItems());
+				Assert::AreEqual(3, restored.countItems(0));
+				Assert::AreEqual(2, restored.countItems(1));
+				Assert::AreEqual(2, restored.countItems(7));
+				Assert::IsTrue(restored.extractItem(7).isLarge());
+
+				std::filesystem::remove(logPath);
+			}
+			std::filesystem::remove(snapPath);
+		};
+
+		TEST_METHOD(RefusedInsertsAreNotReplayed) {
+			const std::string logPath((std::filesystem::temp_directory_path() / "amazoom_refused.wal").string());
+			std::filesystem::remove(logPath);
+
+			{
+				amazoom::WriteAheadLog log(logPath, amazoom::WriteAheadLog::WRITE);
+				std::unique_ptr<amazoom::WorkerAccessibleContainer> storage(new amazoom::ColumnarMultiHashmapImpl());
+				amazoom::LoggedContainerImpl logged(storage, log);
+
+				//the columnar map refuses items too heavy for its weight column, after they were logged
+				amazoom::Item kept(1, 2.0f);
+				logged.insertItem(1, kept);
+				amazoom::Item tooHeavy(1, amazoom::PackedItem::MAX_WEIGHT * 2.0f);
+				bool didExcept = false;
+				try {
+					logged.insertItem(1, tooHeavy);
+				}
+				catch (std::out_of_range&) {
+					didExcept = true;
+				}
+				Assert::IsTrue(didExcept);
+
+				std::vector<std::pair<int, amazoom::Item>> pallet;
+				pallet.emplace_back(2, amazoom::Item(2, 1.0f));
+				pallet.emplace_back(2, amazoom::Item(2, amazoom::PackedItem::MAX_WEIGHT * 2.0f));
+				didExcept = false;
+				try {
+					logged.insertItems(pallet);
+				}
+				catch (std::out_of_range&) {
+					didExcept = true;
+				}
+				Assert::IsTrue(didExcept);
+				Assert::AreEqual(1, logged.getNumItems());
+			}
+
+			amazoom::MultiHashmapImpl restored;
+			amazoom::WriteAheadLog::ReplayResult result = amazoom::WriteAheadLog::replay(logPath, restored);
+			Assert::AreEqual(static_cast<std::size_t>(4), result.inserts);
+			Assert::AreEqual(static_cast<std::size_t>(3), result.extracts);
+			Assert::AreEqual(static_cast<std::size_t>(0), result.missingExtracts);
+			Assert::AreEqual(1, restored.getNumItems());
+			Assert::AreEqual(1, restored.countItems(1));
+			std::filesystem::remove(logPath);
+		};
+
+		TEST_METHOD(GroupCommitAndTornTail) {
+			const std::string logPath((std::filesystem::temp_directory_path() / "amazoom_group_commit.wal").string());
+			std::filesystem::remove(logPath);
+			const int NUM_THREADS = 8;
+			const int NUM_INSERTS = 100;
+
+			{
+				amazoom::WriteAheadLog log(logPath, amazoom::WriteAheadLog::SYNC);
+				std::unique_ptr<amazoom::WorkerAccessibleContainer> storage(new amazoom::MultiHashmapImpl());
+				amazoom::LoggedContainerImpl logged(storage, log);
+
+				std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+				for (int t = 0; t < NUM_THREADS; t++) {
+					threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&logged, t]() {
+						for (int i = 0; i < NUM_INSERTS; i++) {
+							amazoom::Item item(t, static_cast<float>(i));
+							logged.insertItem(t, item);
+						}
+					})));
+				}
+				for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+					threadPtr->join();
+				}
+
+				//every record was synced before its insertion returned, some of them by another thread's commit
+				amazoom::WriteAheadLog::Stats stats = log.getStats();
+				Assert::AreEqual(static_cast<std::uint64_t>(NUM_THREADS * NUM_INSERTS), stats.recordsAppended);
+				Assert::IsTrue(stats.commits <= stats.recordsAppended);
+				Assert::AreEqual(stats.commits, stats.syncs);
+			}
+
+			//a crash in the middle of a commit leaves a partial batch behind
+			{
+				std::ofstream out(logPath, std::ios::binary | std::ios::app);
+				out.write("\x41\x57\x41\x4c\x10\x00\x00\x00partial", 15);
+			}
+
+			amazoom::MultiHashmapImpl restored;
+			amazoom::WriteAheadLog::ReplayResult result = amazoom::WriteAheadLog::replay(logPath, restored);
+			Assert::IsTrue(result.tornTail);
+			Assert::AreEqual(static_cast<std::size_t>(NUM_THREADS * NUM_INSERTS), result.inserts);
+			Assert::AreEqual(NUM_INSERTS, restored.countItems(NUM_THREADS - 1));
+
+			//reopening cuts the partial batch off, so what is logged next is replayed too
+			{
+				amazoom::WriteAheadLog log(logPath, amazoom::WriteAheadLog::WRITE);
+				amazoom::Item item(NUM_THREADS, 1.0f);
+				log.logInsert(NUM_THREADS, item);
+			}
+			amazoom::MultiHashmapImpl restoredAgain;
+			result = amazoom::WriteAheadLog::replay(logPath, restoredAgain);
+			Assert::IsFalse(result.tornTail);
+			Assert::AreEqual(NUM_THREADS * NUM_INSERTS + 1, restoredAgain.getNumItems());
+
+			bool didExcept = false;
+			try {
+				amazoom::WriteAheadLog::replay(logPath + ".missing", restoredAgain);
+			}
+			catch (amazoom::WriteAheadLogException&) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			std::filesystem::remove(logPath);
+		};
+	};
+
+	TEST_CLASS(Inventory_Feed_Loader_Testing) {
+	public:
+		TEST_METHOD(LoadsCsvIntoPartitions) {
+			const std::string path((std::filesystem::temp_directory_path() / "amazoom_feed.csv").string());
+			const int NUM_ROWS = 2000;
+			const int NUM_PARTITIONS = 4;
+			{
+				std::ofstream out(path, std::ios::binary | std::ios::trunc);
+				out << "itemID,weight,isLarge\n";
+				for (int i = 0; i < NUM_ROWS; i++) {
+					out << (i % 50) << "," << (i % 7) + 0.5f << "," << (i % 3 == 0 ? "true" : "0") << (i % 2 == 0 ? "\r\n" : "\n");
+				}
+				out << "\n12,not a weight,1\n-3,2.5,1";
+			}
+
+			//tiny chunks, so that rows straddle windows and every thread gets a share of each window
+			amazoom::InventoryFeedLoader loader(3, 64);
+			std::vector<std::unique_ptr<amazoom::MultiHashmapImpl>> shelves;
+			std::vector<amazoom::Storable*> partitions;
+			for (int p = 0; p < NUM_PARTITIONS; p++) {
+				shelves.push_back(std::unique_ptr<amazoom::MultiHashmapImpl>(new amazoom::MultiHashmapImpl()));
+				partitions.push_back(shelves.back().get());
+			}
+
+			amazoom::InventoryFeedLoader::Stats stats = loader.load(path, amazoom::InventoryFeedLoader::CSV, partitions);
+			Assert::AreEqual(static_cast<std::uint64_t>(NUM_ROWS + 1), stats.rows);
+			Assert::AreEqual(static_cast<std::uint64_t>(2), stats.rejectedRows); //the header and the bad weight
+			Assert::AreEqual(static_cast<std::uint64_t>(std::filesystem::file_size(path)), stats.bytes);
+			Assert::IsTrue(stats.peakBufferedBytes > 0);
+
+			//every key lands in exactly one partition, all of its rows together
+			int total = 0;
+			for (int key = 0; key < 50; key++) {
+				Assert::AreEqual(NUM_ROWS / 50, shelves[key % NUM_PARTITIONS]->countItems(key));
+				total += NUM_ROWS / 50;
+			}
+			for (int p = 0; p < NUM_PARTITIONS; p++) {
+				total -= shelves[p]->getNumItems();
+			}
+			Assert::AreEqual(-1, total);
+
+			amazoom::Item item(shelves[static_cast<unsigned int>(-3) % NUM_PARTITIONS]->extractItem(-3));
+			checkItemEquals(item, -3, 2.5f);
+			Assert::IsTrue(item.isLarge());
+
+			std::filesystem::remove(path);
+		};
+
+		TEST_METHOD(LoadsBinaryFeed) {
+			const std::string path((std::filesystem::temp_directory_path() / "amazoom_feed.bin").string());
+			const int NUM_ROWS = 1000;
+
+			std::vector<amazoom::Item> items;
+			for (int i = 0; i < NUM_ROWS; i++) {
+				items.push_back(amazoom::Item(i % 10, static_cast<float>(i), i % 2 == 0));
+			}
+			amazoom::InventoryFeedLoader::writeBinary(path, items);
+
+			amazoom::InventoryFeedLoader loader(2, 100);
+			amazoom::FlatMultiHashmapImpl storage;
+			amazoom::InventoryFeedLoader::Stats stats = loader.load(path, amazoom::InventoryFeedLoader::BINARY, storage);
+			Assert::AreEqual(static_cast<std::uint64_t>(NUM_ROWS), stats.rows);
+			Assert::AreEqual(NUM_ROWS, storage.getNumItems());
+			Assert::AreEqual(NUM_ROWS / 10, storage.countItems(9));
+			std::optional<amazoom::Item> heaviest(storage.extractHeaviest(9));
+			checkItemEquals(*heaviest, 9, static_cast<float>(NUM_ROWS - 1));
+			Assert::IsFalse(heaviest->isLarge());
+
+			//a feed cut off mid-record, or one that is not a binary feed at all, is refused
+			std::filesystem::resize_file(path, std::filesystem::file_size(path) - 5);
+			bool didExcept = false;
+			try {
+				loader.load(path, amazoom::InventoryFeedLoader::BINARY, storage);
+			}
+			catch (amazoom::InventoryFeedException&) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			{
+				std::ofstream out(path, std::ios::binary | std::ios::trunc);
+				out << "1,1.0,0\n";
+			}
+			didExcept = false;
+			try {
+				loader.load(path, amazoom::InventoryFeedLoader::BINARY, storage);
+			}
+			catch (amazoom::InventoryFeedException&) {
+				didExcept = true;
+			}
+			Assert::IsTrue(didExcept);
+
+			std::filesystem::remove(path);
+		};
+	};
+
+	TEST_CLASS(Stock_Waiters_Testing) {
+	public:
+		TEST_METHOD(InsertCompletesWaitingPickers) {
+			amazoom::MultiHashmapImpl hashmap;
+
+			std::future<amazoom::Item> first = hashmap.extractItemAsync(7);
+			std::future<amazoom::Item> second = hashmap.extractItemAsync(7);
+			std::future<amazoom::Item> other = hashmap.extractItemAsync(8);
+			Assert::IsTrue(first.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+
+			//the oldest waiter is served first, and the item never lands on the shelf
+			amazoom::Item item(100, 1.0f);
+			hashmap.insertItem(7, item);
+			Assert::IsTrue(first.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+			Assert::AreEqual(100, first.get().getID());
+			Assert::IsTrue(second.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+			Assert::AreEqual(0, hashmap.getNumItems());
+
+			std::vector<std::pair<int, amazoom::Item>> batch;
+			batch.emplace_back(7, amazoom::Item(101, 1.0f));
+			batch.emplace_back(8, amazoom::Item(102, 1.0f));
+			batch.emplace_back(7, amazoom::Item(103, 1.0f));
+			hashmap.insertItems(batch);
+			//waiters are served once the whole batch is in, so like any extraction they get the newest item
+			Assert::AreEqual(103, second.get().getID());
+			Assert::AreEqual(102, other.get().getID());
+			Assert::AreEqual(1, hashmap.countItems(7));
+
+			//stock already there is taken without waiting, and a wait for missing stock times out
+			std::optional<amazoom::Item> stocked = hashmap.extractItemWait(7, std::chrono::milliseconds(0));
+			Assert::IsTrue(stocked.has_value());
+			Assert::AreEqual(101, stocked->getID());
+			Assert::IsFalse(hashmap.extractItemWait(9, std::chrono::milliseconds(20)).has_value());
+			Assert::AreEqual(0, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(WaitingPickersGetEveryItem) {
+			const int NUM_PICKERS = 4;
+			const int NUM_STOCKERS = 2;
+			const int NUM_PICKS = 50;
+			const int NUM_KEYS = 5;
+			amazoom::ShardedMultiHashmapImpl hashmap;
+			std::atomic<int> picked{ 0 };
+			std::atomic<int> timedOut{ 0 };
+
+			std::vector<std::unique_ptr<boost::thread>> threadPtrs;
+			for (int t = 0; t < NUM_PICKERS; t++) {
+				threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&]() {
+					for (int i = 0; i < NUM_PICKS; i++) {
+						if (hashmap.extractItemWait(i % NUM_KEYS, std::chrono::seconds(10))) {
+							picked++;
+						}
+						else {
+							timedOut++;
+						}
+					}
+				})));
+			}
+			//stock arrives after the pickers have started, exactly as much as they need
+			for (int t = 0; t < NUM_STOCKERS; t++) {
+				threadPtrs.push_back(std::unique_ptr<boost::thread>(new boost::thread([&hashmap, t]() {
+					for (int i = 0; i < NUM_PICKERS * NUM_PICKS / NUM_STOCKERS; i++) {
+						amazoom::Item item(t * 1000 + i, 1.0f);
+						hashmap.insertItem(i % NUM_KEYS, item);
+					}
+				})));
+			}
+			for (std::unique_ptr<boost::thread>& threadPtr : threadPtrs) {
+				threadPtr->join();
+			}
+
+			Assert::AreEqual(NUM_PICKERS * NUM_PICKS, picked.load());
+			Assert::AreEqual(0, timedOut.load());
+			Assert::AreEqual(0, hashmap.getNumItems());
+		};
+
+		TEST_METHOD(HandOffsAreLogged) {
+			const std::string logPath((std::filesystem::temp_directory_path() / "amazoom_hand_off.wal").string());
+			std::filesystem::remove(logPath);
+
+			{
+				amazoom::WriteAheadLog log(logPath, amazoom::WriteAheadLog::WRITE);
+				std::unique_ptr<amazoom::WorkerAccessibleContainer> storage(new amazoom::MultiHashmapImpl());
+				amazoom::LoggedContainerImpl logged(storage, log);
+
+				std::future<amazoom::Item> waiting = logged.extractItemAsync(3);
+				amazoom::Item item(30, 2.0f);
+				logged.insertItem(3, item);
+				Assert::AreEqual(30, waiting.get().getID());
+				Assert::AreEqual(0, logged.getNumItems());
+			}
+
+			amazoom::MultiHashmapImpl restored;
+			amazoom::WriteAheadLog::ReplayResult result = amazoom::WriteAheadLog::replay(logPath, restored);
+			Assert::AreEqual(static_cast<std::size_t>(1), result.inserts);
+			Assert::AreEqual(static_cast<std::size_t>(1), result.extracts);
+			Assert::AreEqual(0, restored.getNumItems());
+
+			std::filesystem::remove(logPath);
+		};
+	};
+
+};
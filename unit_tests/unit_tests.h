@@ -6,6 +6,9 @@
 #include "warehouse_etc/item_definition.h"
 #include "containers/multi_hashmap.h"
 
+#include <atomic>
+#include <memory>
+
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 void checkItemEquals(amazoom::Item& i, const int itemID, const float weight, const bool isLarge) {
@@ -22,6 +25,37 @@ void checkItemIsInvalid(amazoom::Item& i) {
 	Assert::AreEqual(i.getID(), static_cast<int>(amazoom::Item::INVALID_ITEM));
 }
 
+//blocks handed out by every CountingAllocator and not yet given back
+inline std::atomic<int>& liveAllocations() {
+	static std::atomic<int> live{ 0 };
+	return live;
+}
+
+//std::allocator that counts its live blocks, to see when a container frees its nodes
+template <class T>
+struct CountingAllocator {
+	typedef T value_type;
+
+	CountingAllocator() = default;
+	template <class U>
+	CountingAllocator(const CountingAllocator<U>&) {}
+
+	T* allocate(std::size_t n) {
+		T* block = std::allocator<T>().allocate(n);
+		liveAllocations()++;
+		return block;
+	}
+	void deallocate(T* block, std::size_t n) {
+		liveAllocations()--;
+		std::allocator<T>().deallocate(block, n);
+	}
+
+	template <class U>
+	bool operator==(const CountingAllocator<U>&) const { return true; }
+	template <class U>
+	bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
 static void multithreadingInsert(const int NUM_INSERTIONS,
 	amazoom::WorkerAccessibleContainer& hashmap,
 	std::vector<std::pair<int, float>>& results,